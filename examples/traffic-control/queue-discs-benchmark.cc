@@ -27,7 +27,7 @@
 // n1 ------------------------------------ n2 ----------------------------------- n3
 //   point-to-point (access link)                point-to-point (bottleneck link)
 //   100 Mbps, 0.1 ms                            bandwidth [10 Mbps], delay [5 ms]
-//   qdiscs PfifoFast with capacity              qdiscs queueDiscType in {PfifoFast, ARED, CoDel, FqCoDel, PIE} [PfifoFast]
+//   qdiscs PfifoFast with capacity              qdiscs queueDiscType in {PfifoFast, ARED, CoDel, FqCoDel, PIE, FqPie, PI, STPI, DualPI2, Cake} [PfifoFast]
 //   of 1000 packets                             with capacity of queueDiscSize packets [1000]
 //   netdevices queues with size of 100 packets  netdevices queues with size of netdevicesQueueSize packets [100]
 //   without BQL                                 bql BQL [false]
@@ -112,7 +112,7 @@ int main (int argc, char *argv[])
   CommandLine cmd;
   cmd.AddValue ("bandwidth", "Bottleneck bandwidth", bandwidth);
   cmd.AddValue ("delay", "Bottleneck delay", delay);
-  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type in {PfifoFast, ARED, CoDel, FqCoDel, PIE, prio}", queueDiscType);
+  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type in {PfifoFast, ARED, CoDel, FqCoDel, PIE, FqPie, PI, STPI, DualPI2, Cake, prio}", queueDiscType);
   cmd.AddValue ("queueDiscSize", "Bottleneck queue disc size in packets", queueDiscSize);
   cmd.AddValue ("netdevicesQueueSize", "Bottleneck netdevices queue size in packets", netdevicesQueueSize);
   cmd.AddValue ("bql", "Enable byte queue limits on bottleneck netdevices", bql);
@@ -180,6 +180,36 @@ int main (int argc, char *argv[])
       Config::SetDefault ("ns3::PieQueueDisc::MaxSize",
                           QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, queueDiscSize)));
     }
+  else if (queueDiscType.compare ("FqPie") == 0)
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::FqPieQueueDisc");
+      Config::SetDefault ("ns3::FqPieQueueDisc::MaxSize",
+                          QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, queueDiscSize)));
+    }
+  else if (queueDiscType.compare ("PI") == 0)
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::PiQueueDisc");
+      Config::SetDefault ("ns3::PiQueueDisc::MaxSize",
+                          QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, queueDiscSize)));
+    }
+  else if (queueDiscType.compare ("STPI") == 0)
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::SelfTuningPiQueueDisc");
+      Config::SetDefault ("ns3::SelfTuningPiQueueDisc::MaxSize",
+                          QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, queueDiscSize)));
+    }
+  else if (queueDiscType.compare ("DualPI2") == 0)
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::DualPi2QueueDisc");
+      Config::SetDefault ("ns3::DualPi2QueueDisc::MaxSize",
+                          QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, queueDiscSize)));
+    }
+  else if (queueDiscType.compare ("Cake") == 0)
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::CakeQueueDisc");
+      Config::SetDefault ("ns3::CakeQueueDisc::MaxSize",
+                          QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, queueDiscSize)));
+    }
   else if (queueDiscType.compare ("prio") == 0)
     {
       uint16_t handle = tchBottleneck.SetRootQueueDisc ("ns3::PrioQueueDisc", "Priomap",
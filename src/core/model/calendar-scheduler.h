@@ -22,6 +22,7 @@
 #define CALENDAR_SCHEDULER_H
 
 #include "scheduler.h"
+#include "event-pool.h"
 #include <stdint.h>
 #include <list>
 
@@ -130,8 +131,8 @@ private:
    */
   void DoInsert (const Scheduler::Event &ev);
 
-  /** Calendar bucket type: a list of Events. */
-  typedef std::list<Scheduler::Event> Bucket;
+  /** Calendar bucket type: a list of Events, allocated from the EventPool. */
+  typedef std::list<Scheduler::Event, EventPool::Allocator<Scheduler::Event> > Bucket;
   
   /** Array of buckets. */
   Bucket *m_buckets;
@@ -19,6 +19,7 @@
  */
 
 #include "event-impl.h"
+#include "event-pool.h"
 #include "log.h"
 
 /**
@@ -66,4 +67,16 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void *
+EventImpl::operator new (std::size_t size)
+{
+  return EventPool::Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *buffer, std::size_t size)
+{
+  EventPool::Deallocate (buffer, size);
+}
+
 } // namespace ns3
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +67,25 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate the memory of an event from the EventPool.
+   *
+   * Events are created and destroyed at a very high rate, hence they
+   * are recycled by the free lists of the EventPool rather than being
+   * returned to the system.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory of the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the memory of an event to the EventPool.
+   *
+   * \param [in] buffer The memory of the event.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *buffer, std::size_t size);
+
 protected:
   /**
    * Implementation for Invoke().
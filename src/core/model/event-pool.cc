@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-pool.h"
+#include "thread-local.h"
+#include <new>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventPool implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief The free lists of a thread, one per size class
+ */
+class EventPoolFreeLists
+{
+public:
+  EventPoolFreeLists ();
+  ~EventPoolFreeLists ();
+
+  /** Number of size classes. */
+  static const std::size_t N_CLASSES = EventPool::MAX_SIZE / EventPool::GRANULARITY;
+
+  void *m_head[N_CLASSES];         //!< The first free block of each class
+  std::size_t m_size[N_CLASSES];   //!< The number of free blocks of each class
+  std::thread::id m_owner;         //!< The thread which created the free lists
+};
+
+static NS_THREAD_LOCAL EventPoolFreeLists g_freeLists; //!< The free lists (one per thread, see NS_THREAD_LOCAL)
+/**
+ * Whether the free lists of this thread have been destroyed. The free lists
+ * may be destroyed before the static objects, which may still hold events.
+ */
+static NS_THREAD_LOCAL bool g_freeListsDestroyed = false;
+
+/**
+ * \ingroup events
+ * \brief Get the free lists the calling thread may use
+ *
+ * Unless the free lists are thread local, they are only used by the thread
+ * which created them (the main thread), as the events scheduled by other
+ * threads (e.g., with the realtime simulator) are created by those threads.
+ *
+ * \return the free lists, or a null pointer if the system allocator is to be used
+ */
+static inline EventPoolFreeLists *
+GetFreeLists (void)
+{
+  if (g_freeListsDestroyed)
+    {
+      return 0;
+    }
+#ifndef NS3_MULTITHREADED
+  if (g_freeLists.m_owner != std::this_thread::get_id ())
+    {
+      return 0;
+    }
+#endif
+  return &g_freeLists;
+}
+
+EventPoolFreeLists::EventPoolFreeLists ()
+  : m_owner (std::this_thread::get_id ())
+{
+  for (std::size_t i = 0; i < N_CLASSES; i++)
+    {
+      m_head[i] = 0;
+      m_size[i] = 0;
+    }
+}
+
+EventPoolFreeLists::~EventPoolFreeLists ()
+{
+  for (std::size_t i = 0; i < N_CLASSES; i++)
+    {
+      while (m_head[i] != 0)
+        {
+          void *buffer = m_head[i];
+          m_head[i] = *static_cast<void **> (buffer);
+          ::operator delete (buffer);
+        }
+    }
+  g_freeListsDestroyed = true;
+}
+
+void *
+EventPool::Allocate (std::size_t size)
+{
+  if (size == 0 || size > MAX_SIZE)
+    {
+      return ::operator new (size);
+    }
+  // the pooled blocks always have the size of their class, since they may
+  // be released by a thread whose free lists still exist
+  std::size_t sizeClass = (size - 1) / GRANULARITY;
+  EventPoolFreeLists *lists = GetFreeLists ();
+  if (lists == 0 || lists->m_head[sizeClass] == 0)
+    {
+      return ::operator new ((sizeClass + 1) * GRANULARITY);
+    }
+  void *buffer = lists->m_head[sizeClass];
+  lists->m_head[sizeClass] = *static_cast<void **> (buffer);
+  lists->m_size[sizeClass]--;
+  return buffer;
+}
+
+void
+EventPool::Deallocate (void *buffer, std::size_t size)
+{
+  if (buffer == 0)
+    {
+      return;
+    }
+  EventPoolFreeLists *lists = GetFreeLists ();
+  std::size_t sizeClass = (size - 1) / GRANULARITY;
+  if (size == 0 || size > MAX_SIZE || lists == 0 || lists->m_size[sizeClass] >= MAX_FREE)
+    {
+      ::operator delete (buffer);
+      return;
+    }
+  *static_cast<void **> (buffer) = lists->m_head[sizeClass];
+  lists->m_head[sizeClass] = buffer;
+  lists->m_size[sizeClass]++;
+}
+
+} // namespace ns3
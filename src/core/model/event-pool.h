@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_POOL_H
+#define EVENT_POOL_H
+
+#include <cstddef>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventPool declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief Free list allocator of the simulation events
+ *
+ * The memory blocks of up to MAX_SIZE bytes are rounded up to a multiple
+ * of GRANULARITY bytes and, when released, are kept in the free list of
+ * their size class for reuse, instead of being returned to the system.
+ * With the multithreaded simulator, the free lists belong to the calling
+ * thread (see NS_THREAD_LOCAL), hence no locking is needed and a block may
+ * be released by a different thread than the one which allocated it.
+ * Otherwise, only the main thread uses the free lists and the other threads
+ * use the system allocator. Each free list holds at most MAX_FREE blocks.
+ *
+ * The pool is used by the EventImpl objects created by MakeEvent and by
+ * the containers of the schedulers which allocate one node per event.
+ */
+class EventPool
+{
+public:
+  /**
+   * Allocate a memory block.
+   *
+   * \param [in] size The size of the block.
+   * \returns The block.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * Release a memory block.
+   *
+   * \param [in] buffer The block.
+   * \param [in] size The size passed to Allocate.
+   */
+  static void Deallocate (void *buffer, std::size_t size);
+
+  /**
+   * \brief Standard allocator using the EventPool, for the containers
+   *        of events.
+   *
+   * \tparam T \explicit The type of the allocated objects.
+   */
+  template <typename T>
+  class Allocator
+  {
+  public:
+    /** The type of the allocated objects. */
+    typedef T value_type;
+
+    /** Default constructor. */
+    Allocator () {}
+    /**
+     * Converting constructor (the allocator is stateless).
+     *
+     * \tparam U \deduced The type of the objects of the other allocator.
+     */
+    template <typename U>
+    Allocator (const Allocator<U> &) {}
+
+    /**
+     * Allocate storage for objects.
+     *
+     * \param [in] n The number of objects.
+     * \returns The storage.
+     */
+    T * allocate (std::size_t n)
+    {
+      return static_cast<T *> (EventPool::Allocate (n * sizeof (T)));
+    }
+    /**
+     * Release storage.
+     *
+     * \param [in] p The storage.
+     * \param [in] n The number of objects.
+     */
+    void deallocate (T *p, std::size_t n)
+    {
+      EventPool::Deallocate (p, n * sizeof (T));
+    }
+  };
+
+private:
+  friend class EventPoolFreeLists;
+
+  /** The size of the blocks is rounded up to a multiple of this value. */
+  static const std::size_t GRANULARITY = 16;
+  /** Larger blocks are not pooled. */
+  static const std::size_t MAX_SIZE = 256;
+  /** Maximum number of blocks in a free list. */
+  static const std::size_t MAX_FREE = 4096;
+};
+
+/**
+ * \ingroup events
+ * Compare two EventPool allocators.
+ *
+ * \tparam T \deduced The type of the objects of the first allocator.
+ * \tparam U \deduced The type of the objects of the second allocator.
+ * \returns \c true, since all the allocators share the same pool.
+ */
+template <typename T, typename U>
+bool operator == (const EventPool::Allocator<T> &, const EventPool::Allocator<U> &)
+{
+  return true;
+}
+
+/**
+ * \ingroup events
+ * Compare two EventPool allocators.
+ *
+ * \tparam T \deduced The type of the objects of the first allocator.
+ * \tparam U \deduced The type of the objects of the second allocator.
+ * \returns \c false, since all the allocators share the same pool.
+ */
+template <typename T, typename U>
+bool operator != (const EventPool::Allocator<T> &, const EventPool::Allocator<U> &)
+{
+  return false;
+}
+
+} // namespace ns3
+
+#endif /* EVENT_POOL_H */
@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include <algorithm>
+#include <limits>
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Order the events from the latest to the earliest.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \p a is later than \p b.
+ */
+bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return b.key < a.key;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (std::numeric_limits<uint64_t>::max ()),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_nEvents (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrent (const Rung &rung)
+{
+  return rung.start + rung.current * rung.width;
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  // rung i + 1 spans the bucket of rung i just before its current bucket
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      if (ts >= GetCurrent (m_rungs[i]))
+        {
+          return i;
+        }
+    }
+  return m_nRungs;
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  Events::iterator i = std::upper_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+  m_bottom.insert (i, ev);
+}
+
+void
+LadderScheduler::SortIntoBottom (Events &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  m_bottom.swap (events);
+  std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+}
+
+void
+LadderScheduler::SpawnRung (Events &events, uint64_t start, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << end);
+  NS_ASSERT (m_nRungs < MAX_RUNGS && !events.empty () && end > start);
+
+  Rung &rung = m_rungs[m_nRungs++];
+  uint64_t span = end - start;
+  rung.start = start;
+  rung.width = (span - 1) / events.size () + 1;
+  rung.current = 0;
+  rung.nEvents = events.size ();
+  rung.buckets.resize ((span - 1) / rung.width + 1);
+  for (Events::const_iterator i = events.begin (); i != events.end (); i++)
+    {
+      rung.buckets[(i->key.m_ts - start) / rung.width].push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size () << m_topMin << m_topMax);
+  NS_ASSERT (m_nRungs == 0 && !m_top.empty ());
+
+  m_topStart = m_topMax + 1;
+  if (m_top.size () <= THRESHOLD || m_topMin == m_topMax)
+    {
+      SortIntoBottom (m_top);
+    }
+  else
+    {
+      SpawnRung (m_top, m_topMin, m_topStart);
+    }
+  m_top.clear ();
+  m_topMin = std::numeric_limits<uint64_t>::max ();
+  m_topMax = 0;
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty () && m_nEvents > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.nEvents == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      Events &bucket = rung.buckets[rung.current];
+      uint64_t start = GetCurrent (rung);
+      rung.current++;
+      rung.nEvents -= bucket.size ();
+      if (bucket.size () > THRESHOLD && rung.width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          SpawnRung (bucket, start, start + rung.width);
+        }
+      else
+        {
+          SortIntoBottom (bucket);
+        }
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  m_nEvents++;
+  if (ev.key.m_ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ev.key.m_ts);
+      m_topMax = std::max (m_topMax, ev.key.m_ts);
+    }
+  else
+    {
+      uint32_t i = FindRung (ev.key.m_ts);
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          rung.buckets[(ev.key.m_ts - rung.start) / rung.width].push_back (ev);
+          rung.nEvents++;
+        }
+      else
+        {
+          InsertBottom (ev);
+          // Bottom is too large to be kept sorted: turn it into a new rung
+          // spanning up to the lowest rung
+          if (m_bottom.size () > THRESHOLD && m_nRungs < MAX_RUNGS
+              && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+            {
+              uint64_t start = m_bottom.back ().key.m_ts;
+              uint64_t end = m_nRungs > 0 ? GetCurrent (m_rungs[m_nRungs - 1]) : m_topStart;
+              Events events;
+              events.swap (m_bottom);
+              SpawnRung (events, start, end);
+            }
+        }
+    }
+  FillBottom ();
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_nEvents == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_nEvents--;
+  FillBottom ();
+  NS_LOG_DEBUG ("remove " << ev.key.m_ts << ", " << ev.key.m_uid << ", " << ev.impl);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+
+  Events *events;
+  uint32_t i = m_nRungs;
+  if (ev.key.m_ts >= m_topStart)
+    {
+      events = &m_top;
+    }
+  else
+    {
+      i = FindRung (ev.key.m_ts);
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          events = &rung.buckets[(ev.key.m_ts - rung.start) / rung.width];
+        }
+      else
+        {
+          events = &m_bottom;
+        }
+    }
+
+  for (Events::iterator j = events->begin (); j != events->end (); j++)
+    {
+      if (j->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == j->impl);
+          if (events == &m_bottom)
+            {
+              m_bottom.erase (j);
+            }
+          else
+            {
+              // the order of Top and of the buckets does not matter
+              *j = events->back ();
+              events->pop_back ();
+              if (i < m_nRungs)
+                {
+                  m_rungs[i].nEvents--;
+                }
+            }
+          m_nEvents--;
+          FillBottom ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
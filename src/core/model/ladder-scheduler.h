@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue published in 2005 in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng.
+ *
+ * The events are kept in three tiers:
+ *   - Top, an unsorted array of the events far in the future, i.e.,
+ *     later than all the events of the other tiers;
+ *   - Ladder, up to MAX_RUNGS rungs of buckets. The first rung is created
+ *     from the events of Top, whose time span is split in as many buckets
+ *     as events. When the bucket to dequeue contains more than THRESHOLD
+ *     events, it is split into a new rung of finer buckets instead of
+ *     being sorted;
+ *   - Bottom, a small sorted array of the earliest events.
+ *
+ * Unlike the calendar queue, the ladder queue never needs to be resized
+ * and its bucket widths adapt to the distribution of the events, including
+ * skewed distributions. Insert and RemoveNext take O(1) amortized time.
+ * Remove takes time linear in the size of the tier holding the event.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Array of events. */
+  typedef std::vector<Scheduler::Event> Events;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    std::vector<Events> buckets; //!< The buckets.
+    uint64_t start;              //!< Start time of the first bucket.
+    uint64_t width;              //!< Duration of a bucket.
+    uint32_t current;            //!< Index of the next bucket to dequeue.
+    uint32_t nEvents;            //!< Number of events in the buckets.
+  };
+
+  /**
+   * Get the start time of the next bucket to dequeue from a rung.
+   *
+   * \param [in] rung The rung.
+   * \returns The start time of the current bucket.
+   */
+  static uint64_t GetCurrent (const Rung &rung);
+  /**
+   * Find the rung an event belongs to.
+   *
+   * \param [in] ts The timestamp of the event.
+   * \returns The index of the rung, or m_nRungs if the event belongs
+   *          to Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Insert an event in Bottom, keeping it sorted.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Sort a bucket into the empty Bottom.
+   *
+   * \param [in,out] events The events, moved to Bottom.
+   */
+  void SortIntoBottom (Events &events);
+  /**
+   * Create a new rung spanning a time interval.
+   *
+   * \param [in,out] events The events of the new rung, moved to the rung.
+   * \param [in] start The start of the interval.
+   * \param [in] end The end of the interval (excluded).
+   */
+  void SpawnRung (Events &events, uint64_t start, uint64_t end);
+  /** Move the events of Top to the ladder or to Bottom. */
+  void TransferTop (void);
+  /** Refill Bottom with the earliest events, if it is empty. */
+  void FillBottom (void);
+
+  /** Maximum number of events sorted into Bottom without spawning a rung. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /** Top: the unsorted events later than the ladder and Bottom. */
+  Events m_top;
+  /** Smallest timestamp in Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in Top. */
+  uint64_t m_topMax;
+  /** The events with a timestamp lower than this go to the ladder. */
+  uint64_t m_topStart;
+  /** The rungs (only the first m_nRungs are in use). */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Bottom: the earliest events, sorted from the latest to the earliest. */
+  Events m_bottom;
+  /** Number of events in the scheduler. */
+  uint32_t m_nEvents;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
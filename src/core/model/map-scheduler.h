@@ -22,6 +22,7 @@
 #define MAP_SCHEDULER_H
 
 #include "scheduler.h"
+#include "event-pool.h"
 #include <stdint.h>
 #include <map>
 #include <utility>
@@ -63,12 +64,14 @@ public:
   virtual void Remove (const Scheduler::Event &ev);
 
 private:
-  /** Event list type: a Map from EventKey to EventImpl. */
-  typedef std::map<Scheduler::EventKey, EventImpl*> EventMap;
+  /** Event list type: a Map from EventKey to EventImpl, whose nodes are
+   *  allocated from the EventPool. */
+  typedef std::map<Scheduler::EventKey, EventImpl*, std::less<Scheduler::EventKey>,
+                   EventPool::Allocator<std::pair<const Scheduler::EventKey, EventImpl*> > > EventMap;
   /** EventMap iterator. */
-  typedef std::map<Scheduler::EventKey, EventImpl*>::iterator EventMapI;
+  typedef EventMap::iterator EventMapI;
   /** EventMap const iterator. */
-  typedef std::map<Scheduler::EventKey, EventImpl*>::const_iterator EventMapCI;
+  typedef EventMap::const_iterator EventMapCI;
 
   /** The event list. */
   EventMap m_list;
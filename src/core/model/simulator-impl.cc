@@ -42,4 +42,10 @@ SimulatorImpl::GetTypeId (void)
   return tid;
 }
 
+bool
+SimulatorImpl::IsMultithreaded (void) const
+{
+  return false;
+}
+
 } // namespace ns3
@@ -99,6 +99,12 @@ public:
   virtual uint32_t GetSystemId () const = 0; 
   /** \copydoc Simulator::GetContext */
   virtual uint32_t GetContext (void) const = 0;
+  /**
+   * \copydoc Simulator::IsMultithreaded
+   *
+   * The base class implementation returns false.
+   */
+  virtual bool IsMultithreaded (void) const;
 };
 
 } // namespace ns3
@@ -395,6 +395,19 @@ Simulator::GetSystemId (void)
     }
 }
 
+bool
+Simulator::IsMultithreaded (void)
+{
+  if (*PeekImpl () != 0)
+    {
+      return GetImpl ()->IsMultithreaded ();
+    }
+  else
+    {
+      return false;
+    }
+}
+
 void
 Simulator::SetImplementation (Ptr<SimulatorImpl> impl)
 {
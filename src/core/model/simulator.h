@@ -1321,6 +1321,17 @@ public:
    * @return The system id for this simulator.
    */
   static uint32_t GetSystemId (void);
+
+  /**
+   * Check whether the events of different system ids may be executed
+   * concurrently by different threads (see MultithreadedSimulatorImpl).
+   *
+   * The models can use it to decide whether the objects they share
+   * between nodes of different system ids must be handed off in a
+   * thread safe way.
+   * @return \c true if the simulator runs the system ids in parallel threads.
+   */
+  static bool IsMultithreaded (void);
   
 private:
   /** Default constructor. */
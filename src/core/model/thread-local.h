@@ -0,0 +1,46 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_THREAD_LOCAL_H
+#define NS3_THREAD_LOCAL_H
+
+/**
+ * \file
+ * \ingroup core
+ * NS_THREAD_LOCAL macro definition.
+ */
+
+/**
+ * \ingroup core
+ * \def NS_THREAD_LOCAL
+ * Storage class of the static state of which each thread of a
+ * multithreaded simulation needs its own copy (e.g., the packet uid
+ * counter and the free lists of the packet buffers).
+ *
+ * It expands to \c thread_local only if the multithreaded simulator is
+ * built (--enable-multithreaded-simulator, or --enable-tests unless
+ * --disable-multithreaded-simulator). Otherwise, the state is shared, as
+ * accessing a thread local variable of a shared library is slower than
+ * accessing a static variable.
+ */
+
+#ifdef NS3_MULTITHREADED
+#define NS_THREAD_LOCAL thread_local
+#else
+#define NS_THREAD_LOCAL
+#endif
+
+#endif /* NS3_THREAD_LOCAL_H */
@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/event-pool.h"
+#include "ns3/random-variable-stream.h"
+#include <set>
 
 using namespace ns3;
 
@@ -461,6 +465,213 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that HeapScheduler::Remove keeps the heap ordered when the last
+ * event, which replaces the removed one, is earlier than the parent of
+ * the removed event.
+ */
+class HeapSchedulerRemoveTestCase : public TestCase
+{
+public:
+  HeapSchedulerRemoveTestCase ();
+  virtual void DoRun (void);
+};
+
+HeapSchedulerRemoveTestCase::HeapSchedulerRemoveTestCase ()
+  : TestCase ("Check the removal of an event from the HeapScheduler")
+{
+}
+void
+HeapSchedulerRemoveTestCase::DoRun (void)
+{
+  Ptr<HeapScheduler> scheduler = CreateObject<HeapScheduler> ();
+  // the heap is [1, 10, 2, 11, 12, 3, 4]: 4 replaces 11, below 10
+  uint64_t ts[] = {1, 10, 2, 11, 12, 3, 4};
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      Scheduler::Event ev;
+      ev.impl = 0;
+      ev.key.m_ts = ts[i];
+      ev.key.m_uid = i;
+      ev.key.m_context = 0;
+      scheduler->Insert (ev);
+    }
+  Scheduler::Event removed;
+  removed.impl = 0;
+  removed.key.m_ts = 11;
+  removed.key.m_uid = 3;
+  removed.key.m_context = 0;
+  scheduler->Remove (removed);
+
+  uint64_t expected[] = {1, 2, 3, 4, 10, 12};
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "The scheduler should not be empty");
+      NS_TEST_EXPECT_MSG_EQ (scheduler->RemoveNext ().key.m_ts, expected[i], "Wrong order of the events");
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "The scheduler should be empty");
+}
+
+/**
+ * Check that a scheduler returns the events in the right order when
+ * insertions, removals and cancellations are interleaved and the event
+ * times are drawn from a mix of short and very long delays.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of the events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  std::set<Scheduler::EventKey> expected;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+
+  for (uint32_t i = 0; i < 50000; i++)
+    {
+      double action = rand->GetValue ();
+      if (action < 0.55 || expected.empty ())
+        {
+          // bursts of simultaneous events, short delays and far timeouts
+          uint64_t delay;
+          double kind = rand->GetValue ();
+          if (kind < 0.2)
+            {
+              delay = 0;
+            }
+          else if (kind < 0.9)
+            {
+              delay = rand->GetInteger (1, 100);
+            }
+          else
+            {
+              delay = rand->GetInteger (1000, 1000000);
+            }
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + delay;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          expected.insert (ev.key);
+        }
+      else if (action < 0.9)
+        {
+          Scheduler::Event next = scheduler->PeekNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.begin ()->m_uid, "Wrong next event");
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.begin ()->m_uid, "Wrong removed event");
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_ts, expected.begin ()->m_ts, "Wrong event time");
+          now = ev.key.m_ts;
+          expected.erase (expected.begin ());
+        }
+      else
+        {
+          Scheduler::EventKey key;
+          key.m_ts = now + rand->GetInteger (0, 1000);
+          key.m_uid = 0;
+          std::set<Scheduler::EventKey>::iterator it = expected.lower_bound (key);
+          if (it == expected.end ())
+            {
+              it = expected.begin ();
+            }
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key = *it;
+          scheduler->Remove (ev);
+          expected.erase (it);
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), expected.empty (), "Wrong number of events");
+    }
+
+  while (!expected.empty ())
+    {
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.begin ()->m_uid, "Wrong removed event");
+      expected.erase (expected.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "The scheduler should be empty");
+}
+
+/**
+ * Check that the memory of the events is recycled by the EventPool and
+ * that pooled events can be cancelled and removed.
+ */
+class EventPoolTestCase : public TestCase
+{
+public:
+  EventPoolTestCase ();
+  virtual void DoRun (void);
+  void Count (void);
+  uint32_t m_count;
+};
+
+EventPoolTestCase::EventPoolTestCase ()
+  : TestCase ("Check the allocation of the events from the EventPool")
+{
+}
+void
+EventPoolTestCase::Count (void)
+{
+  m_count++;
+}
+void
+EventPoolTestCase::DoRun (void)
+{
+  // blocks of the same size class are reused
+  void *a = EventPool::Allocate (40);
+  EventPool::Deallocate (a, 40);
+  void *b = EventPool::Allocate (33);
+  NS_TEST_EXPECT_MSG_EQ (a, b, "A released block should be reused");
+  void *c = EventPool::Allocate (48);
+  NS_TEST_EXPECT_MSG_NE (b, c, "A block in use should not be reused");
+  EventPool::Deallocate (b, 33);
+  EventPool::Deallocate (c, 48);
+
+  // the memory of an executed event is reused by the next event
+  m_count = 0;
+  EventId first = Simulator::Schedule (Seconds (1), &EventPoolTestCase::Count, this);
+  EventImpl *impl = first.PeekEventImpl ();
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (first.IsExpired (), true, "The event should have been executed");
+  first = EventId ();
+  EventId second = Simulator::Schedule (Seconds (1), &EventPoolTestCase::Count, this);
+  NS_TEST_EXPECT_MSG_EQ (second.PeekEventImpl (), impl, "The memory of the event should be reused");
+
+  // cancelled and removed events
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      ids.push_back (Simulator::Schedule (MilliSeconds (i), &EventPoolTestCase::Count, this));
+    }
+  for (uint32_t i = 0; i < 1000; i += 4)
+    {
+      ids[i].Cancel ();
+      Simulator::Remove (ids[i + 1]);
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 2 + 500, "Wrong number of executed events");
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (ids[i].IsExpired (), true, "All the events should be expired");
+    }
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -477,5 +688,19 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new HeapSchedulerRemoveTestCase (), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new EventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -20,6 +20,7 @@
 
 #include "ns3/log.h"
 #include "ns3/queue.h"
+#include "ns3/queue-item.h"
 #include "ns3/simulator.h"
 #include "ns3/ethernet-header.h"
 #include "ns3/ethernet-trailer.h"
@@ -997,6 +998,59 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
   return true;
 }
 
+uint32_t
+CsmaNetDevice::SendMany (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  NS_ASSERT (IsLinkUp ());
+
+  //
+  // The state of the send side is checked once for the whole batch. Packets
+  // are then handled as in SendFrom.
+  //
+  if (IsSendEnabled () == false)
+    {
+      for (auto& item : items)
+        {
+          m_macTxDropTrace (item->GetPacket ());
+        }
+      return 0;
+    }
+
+  uint32_t nSent = 0;
+  for (auto& item : items)
+    {
+      Ptr<Packet> packet = item->GetPacket ();
+      NS_LOG_LOGIC ("UID is " << packet->GetUid ());
+
+      AddHeader (packet, m_address, Mac48Address::ConvertFrom (item->GetAddress ()), item->GetProtocol ());
+
+      m_macTxTrace (packet);
+
+      if (m_queue->Enqueue (packet) == false)
+        {
+          m_macTxDropTrace (packet);
+          continue;
+        }
+
+      nSent++;
+
+      //
+      // Only the first packet of the batch may find the device idle
+      //
+      if (m_txMachineState == READY)
+        {
+          m_currentPkt = m_queue->Dequeue ();
+          NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::SendMany(): Enqueue succeeded but no Packet on queue?");
+          m_promiscSnifferTrace (m_currentPkt);
+          m_snifferTrace (m_currentPkt);
+          TransmitStart ();
+        }
+    }
+  return nSent;
+}
+
 Ptr<Node>
 CsmaNetDevice::GetNode (void) const
 {
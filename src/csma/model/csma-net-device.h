@@ -284,6 +284,14 @@ public:
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, 
                          uint16_t protocolNumber);
 
+  /**
+   * Start sending a batch of packets down the channel.
+   * \param items the packets to send, along with their layer 2 destination
+   *              address and protocol number
+   * \return the number of packets successfully queued
+   */
+  virtual uint32_t SendMany (const std::vector<Ptr<QueueDiscItem> > &items);
+
   /**
    * Get the node to which this device is attached.
    *
@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/csma-helper.h"
+#include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-item.h"
+#include "ns3/node-container.h"
+#include "ns3/string.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup csma
+ * \ingroup tests
+ *
+ * \brief Queue disc item used to pass packets to SendMany
+ */
+class CsmaTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param p the packet
+   * \param addr the destination address
+   */
+  CsmaTestItem (Ptr<Packet> p, const Address & addr);
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+};
+
+CsmaTestItem::CsmaTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0x800)
+{
+}
+
+void
+CsmaTestItem::AddHeader (void)
+{
+}
+
+bool
+CsmaTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup csma
+ * \ingroup tests
+ *
+ * \brief Test class for the SendMany method of CsmaNetDevice
+ *
+ * A batch larger than the room left in the device queue is passed to
+ * SendMany. The packets that fit are accepted and received in order, the
+ * others are dropped, the transmission queue is stopped and then woken up
+ * when the device queue drains.
+ */
+class CsmaSendManyTest : public TestCase
+{
+public:
+  CsmaSendManyTest ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a batch of packets to a device
+   *
+   * \param device the device
+   * \param dest the destination address
+   * \param nPackets the number of packets of the batch
+   */
+  void SendBatch (Ptr<NetDevice> device, Address dest, uint32_t nPackets);
+  /**
+   * \brief Record a packet passed to the device for transmission
+   * \param p the packet
+   */
+  void MacTx (Ptr<const Packet> p);
+  /**
+   * \brief Record a packet dropped by the device
+   * \param p the packet
+   */
+  void MacTxDrop (Ptr<const Packet> p);
+  /**
+   * \brief Record a packet received by the peer device
+   * \param p the packet
+   */
+  void MacRx (Ptr<const Packet> p);
+  /**
+   * \brief Record the wake up of the transmission queue
+   */
+  void Wake (void);
+
+  std::vector<uint64_t> m_sent;      //!< UIDs of the packets of the batch
+  uint32_t m_accepted;               //!< Number of packets accepted by SendMany
+  bool m_stopped;                    //!< Whether the transmission queue was stopped after SendMany
+  std::vector<uint64_t> m_macTx;     //!< UIDs of the packets traced by MacTx
+  std::vector<uint64_t> m_macTxDrop; //!< UIDs of the packets traced by MacTxDrop
+  std::vector<uint64_t> m_macRx;     //!< UIDs of the packets received by the peer
+  uint32_t m_wakes;                  //!< Number of times the transmission queue was woken up
+};
+
+CsmaSendManyTest::CsmaSendManyTest ()
+  : TestCase ("Check the SendMany method of the CSMA device"),
+    m_accepted (0),
+    m_stopped (false),
+    m_wakes (0)
+{
+}
+
+void
+CsmaSendManyTest::SendBatch (Ptr<NetDevice> device, Address dest, uint32_t nPackets)
+{
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      m_sent.push_back (p->GetUid ());
+      items.push_back (Create<CsmaTestItem> (p, dest));
+    }
+  m_accepted = device->SendMany (items);
+  m_stopped = device->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->IsStopped ();
+}
+
+void
+CsmaSendManyTest::MacTx (Ptr<const Packet> p)
+{
+  m_macTx.push_back (p->GetUid ());
+}
+
+void
+CsmaSendManyTest::MacTxDrop (Ptr<const Packet> p)
+{
+  m_macTxDrop.push_back (p->GetUid ());
+}
+
+void
+CsmaSendManyTest::MacRx (Ptr<const Packet> p)
+{
+  m_macRx.push_back (p->GetUid ());
+}
+
+void
+CsmaSendManyTest::Wake (void)
+{
+  m_wakes++;
+}
+
+void
+CsmaSendManyTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  CsmaHelper csma;
+  csma.SetChannelAttribute ("DataRate", StringValue ("8Mbps"));
+  csma.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  csma.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("3p"));
+  NetDeviceContainer devices = csma.Install (nodes);
+
+  Ptr<NetDevice> devA = devices.Get (0);
+  Ptr<NetDevice> devB = devices.Get (1);
+  devA->TraceConnectWithoutContext ("MacTx", MakeCallback (&CsmaSendManyTest::MacTx, this));
+  devA->TraceConnectWithoutContext ("MacTxDrop", MakeCallback (&CsmaSendManyTest::MacTxDrop, this));
+  devB->TraceConnectWithoutContext ("MacRx", MakeCallback (&CsmaSendManyTest::MacRx, this));
+  devA->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->SetWakeCallback (MakeCallback (&CsmaSendManyTest::Wake, this));
+
+  // the first packet is transmitted at once, the device queue can store
+  // three more packets, hence the last packet of the batch is dropped
+  Simulator::Schedule (Seconds (1.0), &CsmaSendManyTest::SendBatch, this, devA, devB->GetAddress (), 5);
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_accepted, 4, "SendMany should accept the packets that fit in the device queue");
+  NS_TEST_EXPECT_MSG_EQ (m_stopped, true, "The transmission queue should be stopped when the device queue is full");
+  NS_TEST_EXPECT_MSG_EQ (m_wakes, 1, "The transmission queue should be woken up once the device queue drains");
+  NS_TEST_EXPECT_MSG_EQ (devA->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->IsStopped (), false,
+                         "The transmission queue should not be stopped at the end");
+
+  NS_TEST_ASSERT_MSG_EQ (m_macTx.size (), 5, "Every packet of the batch should be traced by MacTx");
+  NS_TEST_ASSERT_MSG_EQ (m_macTxDrop.size (), 1, "One packet should be traced by MacTxDrop");
+  NS_TEST_EXPECT_MSG_EQ (m_macTxDrop[0], m_sent[4], "The last packet of the batch should be dropped");
+  NS_TEST_ASSERT_MSG_EQ (m_macRx.size (), 4, "The accepted packets should be received");
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_macTx[i], m_sent[i], "The packets should be traced by MacTx in order");
+    }
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_macRx[i], m_sent[i], "The packets should be received in order");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup csma
+ * \ingroup tests
+ *
+ * \brief CSMA device test suite
+ */
+static class CsmaNetDeviceTestSuite : public TestSuite
+{
+public:
+  CsmaNetDeviceTestSuite ()
+    : TestSuite ("devices-csma", UNIT)
+  {
+    AddTestCase (new CsmaSendManyTest (), TestCase::QUICK);
+  }
+} g_csmaNetDeviceTestSuite; ///< the test suite
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Compare the fluid model of N TCP flows through an AQM bottleneck with the
+ * packet level simulation of the same scenario.
+ *
+ *          100Mb/s, 1ms            10Mb/s, 48ms
+ *   n0 ---------------------- r ---------------------- n1
+ *   (N senders)            (AQM)                  (N sinks)
+ *
+ * The queue disc installed on the bottleneck device of r is sampled every
+ * 10 ms by a QueueDiscSampler and the same queue disc is passed to the fluid
+ * model, which therefore runs the same control law with the same parameters.
+ * The time series are written to <prefix>-packet.csv and <prefix>-fluid.csv,
+ * and the average queue length and drop probability over the second half of
+ * the simulation are printed.
+ *
+ * Usage:
+ *   ./waf --run "fluid-vs-packet --queueDiscType=PIE --nFlows=20"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/fluid-model-module.h"
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FluidVsPacket");
+
+/**
+ * Print the average queue length and drop probability of the samples taken
+ * over the second half of the simulation
+ *
+ * \param name the name of the model
+ * \param samples the samples
+ * \param simTime the simulation time
+ */
+static void
+PrintAverages (std::string name, const std::vector<QueueDiscSampler::Sample> &samples, Time simTime)
+{
+  double q = 0;
+  double p = 0;
+  uint32_t n = 0;
+  for (const auto &s : samples)
+    {
+      if (s.time >= (simTime / 2).GetNanoSeconds ())
+        {
+          q += s.nPackets;
+          p += s.probability;
+          n++;
+        }
+    }
+  std::cout << name << ": average queue length " << (n ? q / n : 0) << " packets, "
+            << "average drop probability " << (n ? p / n : 0) << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string queueDiscType = "PIE";
+  uint32_t nFlows = 20;
+  std::string bottleneckRate = "10Mbps";
+  Time bottleneckDelay = MilliSeconds (48);
+  Time accessDelay = MilliSeconds (1);
+  uint32_t segmentSize = 1000;
+  Time simTime = Seconds (50);
+  std::string prefix = "fluid-vs-packet";
+
+  CommandLine cmd;
+  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type: PIE, RED or PI", queueDiscType);
+  cmd.AddValue ("nFlows", "Number of TCP flows", nFlows);
+  cmd.AddValue ("bottleneckRate", "Rate of the bottleneck link", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the bottleneck link", bottleneckDelay);
+  cmd.AddValue ("simTime", "Simulation time", simTime);
+  cmd.AddValue ("prefix", "Prefix of the output files", prefix);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (segmentSize));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (1));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (1 << 22));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (1 << 22));
+
+  NodeContainer nodes;
+  nodes.Create (3);
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  access.SetChannelAttribute ("Delay", TimeValue (accessDelay));
+  NetDeviceContainer accessDevices = access.Install (nodes.Get (0), nodes.Get (1));
+
+  // the device queue holds a single packet, so that the queue builds up in
+  // the queue disc
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue (bottleneckRate));
+  bottleneck.SetChannelAttribute ("Delay", TimeValue (bottleneckDelay));
+  bottleneck.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
+  NetDeviceContainer bottleneckDevices = bottleneck.Install (nodes.Get (1), nodes.Get (2));
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  TrafficControlHelper tch;
+  if (queueDiscType == "PIE")
+    {
+      tch.SetRootQueueDisc ("ns3::PieQueueDisc", "MaxSize", StringValue ("1000p"));
+    }
+  else if (queueDiscType == "RED")
+    {
+      tch.SetRootQueueDisc ("ns3::RedQueueDisc",
+                            "MinTh", DoubleValue (20),
+                            "MaxTh", DoubleValue (80),
+                            "LInterm", DoubleValue (10),
+                            "MaxSize", StringValue ("200p"),
+                            "LinkBandwidth", StringValue (bottleneckRate),
+                            "LinkDelay", TimeValue (bottleneckDelay));
+    }
+  else if (queueDiscType == "PI")
+    {
+      tch.SetRootQueueDisc ("ns3::PiQueueDisc",
+                            "QueueRef", StringValue ("50p"),
+                            "MaxSize", StringValue ("400p"));
+    }
+  else
+    {
+      NS_ABORT_MSG ("Invalid queue disc type: " << queueDiscType);
+    }
+  QueueDiscContainer qdiscs = tch.Install (bottleneckDevices.Get (0));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (accessDevices);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer bottleneckInterfaces = address.Assign (bottleneckDevices);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 5000;
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  sink.Install (nodes.Get (2)).Start (Seconds (0));
+
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (bottleneckInterfaces.GetAddress (1), port));
+  Ptr<UniformRandomVariable> start = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      source.Install (nodes.Get (0)).Start (Seconds (start->GetValue (0, 1)));
+    }
+
+  Ptr<QueueDiscSampler> sampler = CreateObject<QueueDiscSampler> ();
+  sampler->SetAttribute ("BufferSize", UintegerValue (simTime.GetMilliSeconds () / 10 + 1));
+  sampler->SetQueueDisc (qdiscs.Get (0));
+  sampler->Start (Seconds (0));
+
+  Simulator::Stop (simTime);
+  Simulator::Run ();
+
+  std::vector<QueueDiscSampler::Sample> packetSamples;
+  for (uint32_t i = 0; i < sampler->GetNSamples (); i++)
+    {
+      packetSamples.push_back (sampler->GetSample (i));
+    }
+
+  // IP packets carry TCP (32 bytes, with the timestamp option), IP (20 bytes)
+  // and PPP (2 bytes) headers
+  Ptr<AqmFluidModel> fluid = CreateObject<AqmFluidModel> ();
+  fluid->SetAttribute ("NFlows", UintegerValue (nFlows));
+  fluid->SetAttribute ("Capacity", StringValue (bottleneckRate));
+  fluid->SetAttribute ("PropagationDelay", TimeValue (2 * (accessDelay + bottleneckDelay)));
+  fluid->SetAttribute ("PacketSize", UintegerValue (segmentSize + 54));
+  fluid->SetQueueDisc (qdiscs.Get (0));
+  fluid->Run (simTime);
+  fluid->Write (prefix + "-fluid.csv");
+
+  std::ofstream file ((prefix + "-packet.csv").c_str ());
+  file << "time,packets,bytes,delay,probability" << std::endl;
+  for (const auto &s : packetSamples)
+    {
+      file << s.time << ',' << s.nPackets << ',' << s.nBytes << ','
+           << s.queueDelay << ',' << s.probability << '\n';
+    }
+  file.close ();
+
+  PrintAverages ("Packet", packetSamples, simTime);
+  PrintAverages ("Fluid", fluid->GetSamples (), simTime);
+
+  Simulator::Destroy ();
+  return 0;
+}
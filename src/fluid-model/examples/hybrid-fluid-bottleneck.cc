@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * A few foreground TCP flows share an AQM bottleneck with a large number of
+ * background TCP flows, which are modelled as a fluid by a
+ * HybridFluidQueueDisc and hence do not generate any event.
+ *
+ *          100Mb/s, 1ms            10Mb/s, 48ms
+ *   n0 ---------------------- r ---------------------- n1
+ *   (foreground senders)  (hybrid AQM)        (foreground sinks)
+ *
+ * The total queue delay and the drop probability are sampled every 10 ms by
+ * a QueueDiscSampler and written to <prefix>-queue.csv. The goodput of each
+ * foreground flow and the average queue delay over the second half of the
+ * simulation are printed.
+ *
+ * Usage:
+ *   ./waf --run "hybrid-fluid-bottleneck --aqm=PIE --nFluidFlows=1000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/fluid-model-module.h"
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("HybridFluidBottleneck");
+
+/**
+ * Record the bytes received by the sinks
+ *
+ * \param sinks the sinks
+ * \param rx the bytes received by each sink
+ */
+static void
+RecordRx (ApplicationContainer sinks, std::vector<uint64_t> *rx)
+{
+  for (uint32_t i = 0; i < sinks.GetN (); i++)
+    {
+      (*rx)[i] = DynamicCast<PacketSink> (sinks.Get (i))->GetTotalRx ();
+    }
+}
+
+/**
+ * Add the current queue delay to the sum of the sampled queue delays
+ *
+ * \param qd the queue disc
+ * \param sum the sum of the sampled queue delays in seconds
+ * \param n the number of samples
+ */
+static void
+SampleDelay (Ptr<QueueDisc> qd, double *sum, uint32_t *n)
+{
+  *sum += qd->GetControllerState ().queueDelay.GetSeconds ();
+  (*n)++;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string aqm = "PIE";
+  uint32_t nFlows = 2;
+  uint32_t nFluidFlows = 20;
+  std::string bottleneckRate = "10Mbps";
+  Time bottleneckDelay = MilliSeconds (48);
+  Time accessDelay = MilliSeconds (1);
+  uint32_t segmentSize = 1000;
+  Time simTime = Seconds (30);
+  std::string prefix = "hybrid-fluid-bottleneck";
+
+  CommandLine cmd;
+  cmd.AddValue ("aqm", "Bottleneck AQM: PIE, RED or PI", aqm);
+  cmd.AddValue ("nFlows", "Number of foreground TCP flows", nFlows);
+  cmd.AddValue ("nFluidFlows", "Number of background TCP flows modelled as a fluid", nFluidFlows);
+  cmd.AddValue ("bottleneckRate", "Rate of the bottleneck link", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the bottleneck link", bottleneckDelay);
+  cmd.AddValue ("simTime", "Simulation time", simTime);
+  cmd.AddValue ("prefix", "Prefix of the output file", prefix);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (segmentSize));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (1));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (1 << 22));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (1 << 22));
+
+  NodeContainer nodes;
+  nodes.Create (3);
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  access.SetChannelAttribute ("Delay", TimeValue (accessDelay));
+  NetDeviceContainer accessDevices = access.Install (nodes.Get (0), nodes.Get (1));
+
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue (bottleneckRate));
+  bottleneck.SetChannelAttribute ("Delay", TimeValue (bottleneckDelay));
+  bottleneck.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
+  NetDeviceContainer bottleneckDevices = bottleneck.Install (nodes.Get (1), nodes.Get (2));
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  // the AQM queue disc only provides the control law and its parameters
+  ObjectFactory factory;
+  if (aqm == "PIE")
+    {
+      factory.SetTypeId ("ns3::PieQueueDisc");
+      factory.Set ("MaxSize", StringValue ("1000p"));
+    }
+  else if (aqm == "RED")
+    {
+      factory.SetTypeId ("ns3::RedQueueDisc");
+      factory.Set ("MinTh", DoubleValue (20));
+      factory.Set ("MaxTh", DoubleValue (80));
+      factory.Set ("LInterm", DoubleValue (10));
+      factory.Set ("MaxSize", StringValue ("200p"));
+    }
+  else if (aqm == "PI")
+    {
+      factory.SetTypeId ("ns3::PiQueueDisc");
+      factory.Set ("QueueRef", StringValue ("50p"));
+      factory.Set ("MaxSize", StringValue ("400p"));
+    }
+  else
+    {
+      NS_ABORT_MSG ("Invalid AQM: " << aqm);
+    }
+
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::HybridFluidQueueDisc",
+                        "Aqm", PointerValue (factory.Create<QueueDisc> ()),
+                        "NFlows", UintegerValue (nFluidFlows),
+                        "PropagationDelay", TimeValue (2 * (accessDelay + bottleneckDelay)),
+                        "LinkBandwidth", StringValue (bottleneckRate),
+                        "PacketSize", UintegerValue (segmentSize + 54));
+  QueueDiscContainer qdiscs = tch.Install (bottleneckDevices.Get (0));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (accessDevices);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer bottleneckInterfaces = address.Assign (bottleneckDevices);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  ApplicationContainer sinks;
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      uint16_t port = 5000 + i;
+      PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      sinks.Add (sink.Install (nodes.Get (2)));
+      BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (bottleneckInterfaces.GetAddress (1), port));
+      source.Install (nodes.Get (0)).Start (Seconds (0.1 * i));
+    }
+  sinks.Start (Seconds (0));
+
+  Ptr<QueueDiscSampler> sampler = CreateObject<QueueDiscSampler> ();
+  sampler->SetAttribute ("FileName", StringValue (prefix + "-queue.csv"));
+  sampler->SetQueueDisc (qdiscs.Get (0));
+  sampler->Start (Seconds (0));
+  sampler->Stop (simTime);
+
+  // record the received bytes and the average queue delay over the second
+  // half of the simulation
+  std::vector<uint64_t> rxHalf (nFlows);
+  Simulator::Schedule (simTime / 2, &RecordRx, sinks, &rxHalf);
+  double delaySum = 0;
+  uint32_t nDelaySamples = 0;
+  for (Time t = simTime / 2; t < simTime; t += MilliSeconds (10))
+    {
+      Simulator::Schedule (t, &SampleDelay, qdiscs.Get (0), &delaySum, &nDelaySamples);
+    }
+
+  Simulator::Stop (simTime);
+  Simulator::Run ();
+
+  double interval = (simTime / 2).GetSeconds ();
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      uint64_t rx = DynamicCast<PacketSink> (sinks.Get (i))->GetTotalRx () - rxHalf[i];
+      std::cout << "Flow " << i << ": goodput " << rx * 8 / interval / 1e6 << " Mbps" << std::endl;
+    }
+  std::cout << "Average queue delay " << (nDelaySamples ? delaySum / nDelaySamples * 1000 : 0) << " ms, "
+            << "fluid window " << DynamicCast<HybridFluidQueueDisc> (qdiscs.Get (0))->GetFluidWindow ()
+            << " packets" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
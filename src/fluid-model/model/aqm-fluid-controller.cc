@@ -0,0 +1,373 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aqm-fluid-controller.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/red-queue-disc.h"
+#include "ns3/pi-queue-disc.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AqmFluidController");
+
+NS_OBJECT_ENSURE_REGISTERED (AqmFluidController);
+
+TypeId
+AqmFluidController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AqmFluidController")
+    .SetParent<Object> ()
+    .SetGroupName ("FluidModel")
+    .AddConstructor<AqmFluidController> ()
+  ;
+  return tid;
+}
+
+AqmFluidController::AqmFluidController ()
+  : Object (),
+    m_controller (RED),
+    m_limit (0),
+    m_c (0),
+    m_lastUpdate (0),
+    m_tUpdate (0),
+    m_dropProb (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AqmFluidController::~AqmFluidController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AqmFluidController::SetQueueDisc (Ptr<QueueDisc> qd)
+{
+  NS_LOG_FUNCTION (this << qd);
+
+  // the queue disc is not initialized, as some queue discs (e.g., PI and
+  // PIE) would then start their periodic updates
+
+  UintegerValue uv;
+  DoubleValue dv;
+  BooleanValue bv;
+  TimeValue tv;
+
+  // the controllers work in packets, hence sizes in bytes are converted by
+  // using the mean packet size configured on the queue disc
+  qd->GetAttribute ("MeanPktSize", uv);
+  double meanPktSize = uv.Get ();
+  QueueSize maxSize = qd->GetMaxSize ();
+  m_limit = (maxSize.GetUnit () == QueueSizeUnit::BYTES ? maxSize.GetValue () / meanPktSize
+                                                       : maxSize.GetValue ());
+
+  if (DynamicCast<RedQueueDisc> (qd))
+    {
+      m_controller = RED;
+
+      bool adaptive = false;
+      const char* adaptiveAttributes[] = {"ARED", "AdaptMaxP", "FengAdaptive"};
+      for (const char* name : adaptiveAttributes)
+        {
+          qd->GetAttribute (name, bv);
+          adaptive |= bv.Get ();
+        }
+      NS_ABORT_MSG_IF (adaptive, "Adaptive RED is not supported by the fluid model");
+
+      DataRateValue rv;
+      qd->GetAttribute ("LinkBandwidth", rv);
+      double ptc = rv.Get ().GetBitRate () / (8.0 * meanPktSize);
+
+      qd->GetAttribute ("MinTh", dv);
+      m_minTh = dv.Get ();
+      qd->GetAttribute ("MaxTh", dv);
+      m_maxTh = dv.Get ();
+      if (m_minTh == 0 && m_maxTh == 0)
+        {
+          // automatic setting, as done by RedQueueDisc::InitializeParams
+          qd->GetAttribute ("TargetDelay", tv);
+          m_minTh = std::max (5.0, tv.Get ().GetSeconds () * ptc / 2.0);
+          m_maxTh = 3 * m_minTh;
+        }
+      else if (maxSize.GetUnit () == QueueSizeUnit::BYTES)
+        {
+          m_minTh /= meanPktSize;
+          m_maxTh /= meanPktSize;
+        }
+
+      qd->GetAttribute ("LInterm", dv);
+      m_maxP = 1.0 / dv.Get ();
+      qd->GetAttribute ("Gentle", bv);
+      m_gentle = bv.Get ();
+      qd->GetAttribute ("NLRED", bv);
+      m_nonlinear = bv.Get ();
+
+      qd->GetAttribute ("QW", dv);
+      m_qW = dv.Get ();
+      if (m_qW == 0.0)
+        {
+          m_qW = 1.0 - std::exp (-1.0 / ptc);
+        }
+      else if (m_qW == -1.0)
+        {
+          qd->GetAttribute ("LinkDelay", tv);
+          double rtt = std::max (0.1, 3.0 * (tv.Get ().GetSeconds () + 1.0 / ptc));
+          m_qW = 1.0 - std::exp (-1.0 / (10 * rtt * ptc));
+        }
+      else if (m_qW == -2.0)
+        {
+          m_qW = 1.0 - std::exp (-10.0 / ptc);
+        }
+    }
+  else if (DynamicCast<PieQueueDisc> (qd))
+    {
+      m_controller = PIE;
+      qd->GetAttribute ("A", dv);
+      m_a = dv.Get ();
+      qd->GetAttribute ("B", dv);
+      m_b = dv.Get ();
+      qd->GetAttribute ("Tupdate", tv);
+      m_tUpdate = tv.Get ().GetSeconds ();
+      qd->GetAttribute ("QueueDelayReference", tv);
+      m_qRef = tv.Get ().GetSeconds ();
+      qd->GetAttribute ("MaxBurstAllowance", tv);
+      m_maxBurst = tv.Get ().GetSeconds ();
+    }
+  else if (DynamicCast<PiQueueDisc> (qd))
+    {
+      m_controller = PI;
+      qd->GetAttribute ("A", dv);
+      m_a = dv.Get ();
+      qd->GetAttribute ("B", dv);
+      m_b = dv.Get ();
+      qd->GetAttribute ("W", dv);
+      m_tUpdate = 1.0 / dv.Get ();
+      QueueSizeValue qv;
+      qd->GetAttribute ("QueueRef", qv);
+      m_qRef = (qv.Get ().GetUnit () == QueueSizeUnit::BYTES ? qv.Get ().GetValue () / meanPktSize
+                                                            : qv.Get ().GetValue ());
+    }
+  else
+    {
+      NS_ABORT_MSG ("The fluid model supports RED, PIE and PI queue discs only");
+    }
+}
+
+double
+AqmFluidController::RedProbability (double avg) const
+{
+  if (avg < m_minTh)
+    {
+      return 0;
+    }
+
+  // same as RedQueueDisc::CalculatePNew
+  double p;
+  if (avg >= m_maxTh)
+    {
+      p = (m_gentle ? (1.0 - m_maxP) / m_maxTh * avg + 2.0 * m_maxP - 1.0 : 1.0);
+    }
+  else
+    {
+      double thDiff = (m_maxTh > m_minTh ? m_maxTh - m_minTh : 1.0);
+      p = (avg - m_minTh) / thDiff;
+      if (m_nonlinear)
+        {
+          p *= p * 1.5;
+        }
+      p *= m_maxP;
+    }
+  return std::min (p, 1.0);
+}
+
+void
+AqmFluidController::PieUpdate (double qDelay)
+{
+  // same as PieQueueDisc::CalculateP, with a queue delay given by the queue
+  // length divided by the capacity
+  double p = 0.0;
+  if (m_burstAllowance > 0)
+    {
+      m_dropProb = 0;
+    }
+  else
+    {
+      p = m_a * (qDelay - m_qRef) + m_b * (qDelay - m_qOld);
+      if (m_dropProb < 0.001)
+        {
+          p /= 32;
+        }
+      else if (m_dropProb < 0.01)
+        {
+          p /= 8;
+        }
+      else if (m_dropProb < 0.1)
+        {
+          p /= 2;
+        }
+      else if (m_dropProb < 1)
+        {
+          p /= 0.5;
+        }
+      else if (m_dropProb < 10)
+        {
+          p /= 0.125;
+        }
+      else
+        {
+          p /= 0.03125;
+        }
+      if ((m_dropProb >= 0.1) && (p > 0.02))
+        {
+          p = 0.02;
+        }
+    }
+
+  p += m_dropProb;
+
+  if (qDelay == 0 && m_qOld == 0)
+    {
+      p *= 0.98;
+    }
+  else if (qDelay > 0.2)
+    {
+      p += 0.02;
+    }
+
+  m_dropProb = (p > 0) ? p : 0;
+  m_burstAllowance = (m_burstAllowance < m_tUpdate ? 0 : m_burstAllowance - m_tUpdate);
+
+  uint32_t burstResetLimit = static_cast<uint32_t> (BURST_RESET_TIMEOUT / m_tUpdate);
+  if (qDelay < 0.5 * m_qRef && m_qOld < 0.5 * m_qRef && m_dropProb == 0 && m_burstAllowance == 0)
+    {
+      if (m_burstState == PieQueueDisc::IN_BURST_PROTECTING)
+        {
+          m_burstState = PieQueueDisc::IN_BURST;
+          m_burstReset = 0;
+        }
+      else if (m_burstState == PieQueueDisc::IN_BURST)
+        {
+          m_burstReset++;
+          if (m_burstReset > burstResetLimit)
+            {
+              m_burstReset = 0;
+              m_burstState = PieQueueDisc::NO_BURST;
+            }
+        }
+    }
+  else if (m_burstState == PieQueueDisc::IN_BURST)
+    {
+      m_burstReset = 0;
+    }
+
+  m_qOld = qDelay;
+}
+
+void
+AqmFluidController::Reset (double t, double capacity)
+{
+  NS_LOG_FUNCTION (this << t << capacity);
+  NS_ABORT_MSG_IF (m_limit == 0, "No queue disc set");
+
+  m_c = capacity;
+  m_lastUpdate = t;
+  m_qAvg = 0;
+  m_qOld = 0;
+  m_dropProb = 0;
+  m_nextUpdate = t + m_tUpdate;
+  m_burstAllowance = 0;
+  m_burstState = PieQueueDisc::NO_BURST;
+  m_burstReset = 0;
+}
+
+void
+AqmFluidController::Update (double t, double q)
+{
+  switch (m_controller)
+    {
+    case RED:
+      // the average is updated at every packet arrival, i.e., about C times
+      // per second
+      m_qAvg = q + (m_qAvg - q) * std::pow (1 - m_qW, m_c * (t - m_lastUpdate));
+      m_dropProb = RedProbability (m_qAvg);
+      break;
+    case PIE:
+      while (t >= m_nextUpdate)
+        {
+          PieUpdate (q / m_c);
+          m_nextUpdate += m_tUpdate;
+        }
+      break;
+    case PI:
+      // same as PiQueueDisc::CalculateP
+      while (t >= m_nextUpdate)
+        {
+          double p = m_a * (q - m_qRef) - m_b * (m_qOld - m_qRef) + m_dropProb;
+          m_dropProb = std::min (std::max (p, 0.0), 1.0);
+          m_qOld = q;
+          m_nextUpdate += m_tUpdate;
+        }
+      break;
+    }
+  m_lastUpdate = t;
+}
+
+double
+AqmFluidController::GetDropProbability (double q)
+{
+  if (m_controller != PIE)
+    {
+      return m_dropProb;
+    }
+
+  // same as PieQueueDisc::DropEarly
+  if (m_burstAllowance > 0)
+    {
+      return 0;
+    }
+  if (m_burstState == PieQueueDisc::NO_BURST)
+    {
+      m_burstState = PieQueueDisc::IN_BURST_PROTECTING;
+      m_burstAllowance = m_maxBurst;
+    }
+  if ((m_qOld < 0.5 * m_qRef && m_dropProb < 0.2) || q <= 2)
+    {
+      return 0;
+    }
+  return std::min (m_dropProb, 1.0);
+}
+
+double
+AqmFluidController::GetProbability (void) const
+{
+  return m_dropProb;
+}
+
+double
+AqmFluidController::GetLimit (void) const
+{
+  return m_limit;
+}
+
+} // namespace ns3
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AQM_FLUID_CONTROLLER_H
+#define AQM_FLUID_CONTROLLER_H
+
+#include "ns3/object.h"
+#include "ns3/pie-queue-disc.h"
+
+namespace ns3 {
+
+class QueueDisc;
+
+/**
+ * \ingroup fluid-model
+ *
+ * \brief Control law of an AQM queue disc applied to a fluid queue
+ *
+ * This class computes the drop probability of a RedQueueDisc, a PieQueueDisc
+ * or a PiQueueDisc as a function of a queue length that evolves continuously
+ * rather than at packet arrivals and departures. The control law and its
+ * parameters are taken from the queue disc passed to SetQueueDisc. Queue
+ * lengths are expressed in packets and the queue delay is the queue length
+ * divided by the capacity.
+ */
+class AqmFluidController : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief AqmFluidController constructor
+   */
+  AqmFluidController ();
+
+  virtual ~AqmFluidController ();
+
+  /**
+   * \brief Set the queue disc whose control law and attributes are used
+   *
+   * The queue disc is only used to read its type and its attributes, hence
+   * it does not need to be installed on a device, and it is not initialized.
+   *
+   * \param qd the queue disc (a RedQueueDisc, a PieQueueDisc or a PiQueueDisc)
+   */
+  void SetQueueDisc (Ptr<QueueDisc> qd);
+
+  /**
+   * \brief Reset the state of the controller
+   * \param t the current time in seconds
+   * \param capacity the capacity of the queue in packets per second
+   */
+  void Reset (double t, double capacity);
+
+  /**
+   * \brief Update the state of the controller
+   * \param t the current time in seconds
+   * \param q the current queue length in packets
+   */
+  void Update (double t, double q);
+
+  /**
+   * \brief Get the drop probability applied to the packets entering the queue
+   * \param q the current queue length in packets
+   * \return the drop probability
+   */
+  double GetDropProbability (double q);
+
+  /**
+   * \brief Get the drop probability computed by the control law
+   * \return the drop probability
+   */
+  double GetProbability (void) const;
+
+  /**
+   * \brief Get the maximum queue length
+   * \return the maximum size of the queue disc in packets
+   */
+  double GetLimit (void) const;
+
+private:
+  /// Control laws
+  enum Controller
+  {
+    RED,
+    PIE,
+    PI
+  };
+
+  /**
+   * \brief Compute the drop probability of RED
+   * \param avg the average queue length in packets
+   * \return the drop probability
+   */
+  double RedProbability (double avg) const;
+  /**
+   * \brief Update the drop probability of PIE, as PieQueueDisc::CalculateP
+   * \param qDelay the current queue delay in seconds
+   */
+  void PieUpdate (double qDelay);
+
+  Controller m_controller;        //!< Control law
+  double m_limit;                 //!< Maximum queue length in packets
+  double m_c;                     //!< Capacity in packets per second
+  double m_lastUpdate;            //!< Time of the last update in seconds
+
+  // RED parameters and state
+  double m_minTh;                 //!< Minimum threshold in packets
+  double m_maxTh;                 //!< Maximum threshold in packets
+  double m_maxP;                  //!< Maximum drop probability
+  double m_qW;                    //!< Queue weight of the EWMA
+  bool m_gentle;                  //!< Gentle mode
+  bool m_nonlinear;               //!< Nonlinear RED
+  double m_qAvg;                  //!< Average queue length in packets
+
+  // PIE and PI parameters
+  double m_a;                     //!< Parameter alpha
+  double m_b;                     //!< Parameter beta
+  double m_tUpdate;               //!< Time between two updates in seconds
+  double m_qRef;                  //!< Reference queue delay (PIE, s) or length (PI, packets)
+
+  // PIE and PI state
+  double m_nextUpdate;            //!< Time of the next update in seconds
+  double m_qOld;                  //!< Queue delay (PIE) or length (PI) at the previous update
+  double m_maxBurst;              //!< Maximum burst allowance in seconds (PIE)
+  double m_burstAllowance;        //!< Current burst allowance in seconds (PIE)
+  PieQueueDisc::BurstStateT m_burstState;  //!< Burst state (PIE)
+  uint32_t m_burstReset;          //!< Number of updates with low delay (PIE)
+
+  double m_dropProb;              //!< Drop probability computed by the controller
+};
+
+} // namespace ns3
+
+#endif /* AQM_FLUID_CONTROLLER_H */
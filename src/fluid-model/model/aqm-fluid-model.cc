@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aqm-fluid-model.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AqmFluidModel");
+
+NS_OBJECT_ENSURE_REGISTERED (AqmFluidModel);
+
+TypeId
+AqmFluidModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AqmFluidModel")
+    .SetParent<Object> ()
+    .SetGroupName ("FluidModel")
+    .AddConstructor<AqmFluidModel> ()
+    .AddAttribute ("NFlows",
+                   "Number of TCP flows.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&AqmFluidModel::m_nFlows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Capacity",
+                   "Capacity of the bottleneck.",
+                   DataRateValue (DataRate ("10Mbps")),
+                   MakeDataRateAccessor (&AqmFluidModel::m_capacity),
+                   MakeDataRateChecker ())
+    .AddAttribute ("PropagationDelay",
+                   "Round trip propagation delay of the flows.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&AqmFluidModel::m_propDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketSize",
+                   "Size of the packets in bytes.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&AqmFluidModel::m_pktSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Step",
+                   "Integration step.",
+                   TimeValue (MicroSeconds (100)),
+                   MakeTimeAccessor (&AqmFluidModel::m_step),
+                   MakeTimeChecker ())
+    .AddAttribute ("SamplingInterval",
+                   "Time between two samples of the queue length and of the controller state.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&AqmFluidModel::m_samplingInterval),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+AqmFluidModel::AqmFluidModel ()
+  : Object ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AqmFluidModel::~AqmFluidModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AqmFluidModel::SetQueueDisc (Ptr<QueueDisc> qd)
+{
+  NS_LOG_FUNCTION (this << qd);
+  m_controller = CreateObject<AqmFluidController> ();
+  m_controller->SetQueueDisc (qd);
+}
+
+void
+AqmFluidModel::Run (Time duration)
+{
+  NS_LOG_FUNCTION (this << duration);
+  NS_ABORT_MSG_IF (!m_controller, "No queue disc set");
+
+  double c = m_capacity.GetBitRate () / (8.0 * m_pktSize);
+  double h = m_step.GetSeconds ();
+  double tp = m_propDelay.GetSeconds ();
+  double limit = m_controller->GetLimit ();
+
+  m_controller->Reset (0, c);
+
+  // the history of the window, of the queue length and of the drop probability
+  // is kept for the maximum round trip time
+  uint32_t nHistory = static_cast<uint32_t> (std::ceil ((limit / c + tp) / h)) + 2;
+  std::vector<double> histW (nHistory, 1.0);
+  std::vector<double> histQ (nHistory, 0.0);
+  std::vector<double> histP (nHistory, 0.0);
+
+  uint64_t nSteps = static_cast<uint64_t> (duration.GetSeconds () / h);
+  uint64_t samplingSteps = std::max<uint64_t> (1, static_cast<uint64_t> (std::round (m_samplingInterval.GetSeconds () / h)));
+  m_samples.clear ();
+  m_samples.reserve (nSteps / samplingSteps + 1);
+
+  double w = 1.0;
+  double q = 0.0;
+
+  for (uint64_t k = 0; k <= nSteps; k++)
+    {
+      double t = k * h;
+      double r = q / c + tp;
+
+      m_controller->Update (t, q);
+      double p = m_controller->GetDropProbability (q);
+
+      // the traffic exceeding the capacity is dropped when the queue is full
+      double rate = m_nFlows * w / r;
+      if (q >= limit && rate > c)
+        {
+          p += (1 - p) * (1 - c / rate);
+        }
+
+      histW[k % nHistory] = w;
+      histQ[k % nHistory] = q;
+      histP[k % nHistory] = p;
+
+      if (k % samplingSteps == 0)
+        {
+          QueueDiscSampler::Sample sample;
+          sample.time = Seconds (t).GetNanoSeconds ();
+          sample.nPackets = static_cast<uint32_t> (std::round (q));
+          sample.nBytes = static_cast<uint32_t> (std::round (q * m_pktSize));
+          sample.queueDelay = Seconds (q / c).GetNanoSeconds ();
+          sample.probability = m_controller->GetProbability ();
+          m_samples.push_back (sample);
+        }
+
+      // values one round trip time ago, linearly interpolated
+      double wd = 1.0;
+      double qd = 0.0;
+      double pd = 0.0;
+      double kd = k - r / h;
+      if (kd >= 0)
+        {
+          uint64_t i = static_cast<uint64_t> (kd);
+          double frac = kd - i;
+          uint32_t i0 = i % nHistory;
+          uint32_t i1 = (i + 1 <= k ? i + 1 : i) % nHistory;
+          wd = (1 - frac) * histW[i0] + frac * histW[i1];
+          qd = (1 - frac) * histQ[i0] + frac * histQ[i1];
+          pd = (1 - frac) * histP[i0] + frac * histP[i1];
+        }
+      double rd = qd / c + tp;
+
+      double dw = 1.0 / r - w * wd / (2 * rd) * pd;
+      double dq = rate - c;
+
+      w = std::max (1.0, w + h * dw);
+      q = std::min (limit, std::max (0.0, q + h * dq));
+    }
+}
+
+const std::vector<QueueDiscSampler::Sample>&
+AqmFluidModel::GetSamples (void) const
+{
+  return m_samples;
+}
+
+void
+AqmFluidModel::Write (std::string fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  std::ofstream file (fileName.c_str ());
+  NS_ABORT_MSG_UNLESS (file.is_open (), "Cannot open file " << fileName);
+
+  QueueDiscSampler::WriteCsvHeader (file);
+  QueueDiscSampler::WriteCsv (file, m_samples.data (), m_samples.size ());
+}
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AQM_FLUID_MODEL_H
+#define AQM_FLUID_MODEL_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/queue-disc-sampler.h"
+#include "aqm-fluid-controller.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class QueueDisc;
+
+/**
+ * \defgroup fluid-model Fluid model of TCP/AQM dynamics
+ *
+ * Numerical solution of the fluid model of TCP flows sharing a bottleneck
+ * managed by an AQM queue disc.
+ */
+
+/**
+ * \ingroup fluid-model
+ *
+ * \brief Fluid model of N TCP flows through a bottleneck managed by an AQM
+ *
+ * This class integrates the fluid model of Misra, Gong and Towsley for
+ * NFlows long-lived TCP Reno flows with round trip propagation delay
+ * PropagationDelay sharing a bottleneck of the given Capacity:
+ *
+ * dW/dt = 1/R(t) - W(t) W(t-R(t)) / (2 R(t-R(t))) p(t-R(t))
+ *
+ * dq/dt = N W(t) / R(t) - C
+ *
+ * where W is the congestion window and q the queue length (in packets),
+ * R(t) = q(t)/C + Tp is the round trip time and p is the drop probability
+ * computed by the AQM controller. The controller runs the same control law
+ * as the queue disc passed to SetQueueDisc (RedQueueDisc, PieQueueDisc or
+ * PiQueueDisc), whose attributes are used as the parameters of the
+ * controller. The queue length is limited to the maximum size of the queue
+ * disc, beyond which the excess traffic is dropped.
+ *
+ * The equations are integrated by the Euler method with a fixed Step.
+ * The queue length and the state of the controller are sampled every
+ * SamplingInterval, in the same format as the QueueDiscSampler, so that the
+ * time series can be compared to those of a packet level simulation.
+ */
+class AqmFluidModel : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief AqmFluidModel constructor
+   */
+  AqmFluidModel ();
+
+  virtual ~AqmFluidModel ();
+
+  /**
+   * \brief Set the queue disc whose control law and attributes are used
+   *
+   * The queue disc is only used to read its type and its attributes, hence
+   * it does not need to be installed on a device.
+   *
+   * \param qd the queue disc (a RedQueueDisc, a PieQueueDisc or a PiQueueDisc)
+   */
+  void SetQueueDisc (Ptr<QueueDisc> qd);
+
+  /**
+   * \brief Integrate the model from time zero, starting with an empty queue
+   *        and a congestion window of one packet
+   * \param duration the duration of the integration
+   */
+  void Run (Time duration);
+
+  /**
+   * \brief Get the samples taken during the last run
+   * \return the samples
+   */
+  const std::vector<QueueDiscSampler::Sample>& GetSamples (void) const;
+
+  /**
+   * \brief Write the samples taken during the last run to a CSV file, in the
+   *        same format as the QueueDiscSampler
+   * \param fileName the name of the file
+   */
+  void Write (std::string fileName) const;
+
+private:
+  uint32_t m_nFlows;              //!< Number of TCP flows
+  DataRate m_capacity;            //!< Capacity of the bottleneck
+  Time m_propDelay;               //!< Round trip propagation delay
+  uint32_t m_pktSize;             //!< Packet size in bytes
+  Time m_step;                    //!< Integration step
+  Time m_samplingInterval;        //!< Time between two samples
+
+  Ptr<AqmFluidController> m_controller;  //!< AQM controller
+
+  std::vector<QueueDiscSampler::Sample> m_samples;  //!< Samples of the last run
+};
+
+} // namespace ns3
+
+#endif /* AQM_FLUID_MODEL_H */
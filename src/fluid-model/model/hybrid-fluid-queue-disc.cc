@@ -0,0 +1,361 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "hybrid-fluid-queue-disc.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/drop-tail-queue.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HybridFluidQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (HybridFluidQueueDisc);
+
+TypeId
+HybridFluidQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HybridFluidQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("FluidModel")
+    .AddConstructor<HybridFluidQueueDisc> ()
+    .AddAttribute ("Aqm",
+                   "The queue disc (RED, PIE or PI) providing the control law, its parameters and the maximum size.",
+                   PointerValue (),
+                   MakePointerAccessor (&HybridFluidQueueDisc::m_aqm),
+                   MakePointerChecker<QueueDisc> ())
+    .AddAttribute ("NFlows",
+                   "Number of TCP flows of the fluid background load.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&HybridFluidQueueDisc::m_nFlows),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PropagationDelay",
+                   "Round trip propagation delay of the fluid flows.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&HybridFluidQueueDisc::m_propDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("LinkBandwidth",
+                   "The link bandwidth serving the queue disc.",
+                   DataRateValue (DataRate ("10Mbps")),
+                   MakeDataRateAccessor (&HybridFluidQueueDisc::m_linkBandwidth),
+                   MakeDataRateChecker ())
+    .AddAttribute ("PacketSize",
+                   "Size of the packets of the fluid flows in bytes.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&HybridFluidQueueDisc::m_pktSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Step",
+                   "Time between two updates of the rate of the fluid flows.",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&HybridFluidQueueDisc::m_step),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+HybridFluidQueueDisc::HybridFluidQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE),
+    m_c (0),
+    m_limit (0),
+    m_w (1),
+    m_rate (0),
+    m_backlog (0),
+    m_arrived (0),
+    m_served (0),
+    m_nUpdates (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+}
+
+HybridFluidQueueDisc::~HybridFluidQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+HybridFluidQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = 0;
+  m_aqm = 0;
+  m_controller = 0;
+  Simulator::Remove (m_updateEvent);
+  Simulator::Remove (m_wakeEvent);
+  QueueDisc::DoDispose ();
+}
+
+int64_t
+HybridFluidQueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+double
+HybridFluidQueueDisc::GetFluidBacklog (void)
+{
+  NS_LOG_FUNCTION (this);
+  ServeFluid ();
+  return m_backlog;
+}
+
+double
+HybridFluidQueueDisc::GetFluidWindow (void) const
+{
+  return m_w;
+}
+
+QueueDisc::ControllerState
+HybridFluidQueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ServeFluid ();
+  ControllerState state;
+  state.queueDelay = Seconds ((m_backlog + GetInternalQueue (0)->GetNPackets ()) / m_c);
+  state.probability = m_controller->GetProbability ();
+  return state;
+}
+
+void
+HybridFluidQueueDisc::ServeFluid (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  if (now <= m_lastServe)
+    {
+      return;
+    }
+
+  // the fluid enters the queue at a constant rate between two updates and
+  // the fluid exceeding the limit is dropped
+  double dt = (now - m_lastServe).GetSeconds ();
+  double room = std::max (0.0, m_limit - GetInternalQueue (0)->GetNPackets () - m_backlog);
+  double arrivals = std::min (m_rate * dt, room);
+  m_backlog += arrivals;
+  m_arrived += arrivals;
+
+  // the fluid is served when the link is not transmitting packets
+  if (now > m_busyUntil)
+    {
+      double idle = (now - std::max (m_lastServe, m_busyUntil)).GetSeconds ();
+      double served = std::min (m_backlog, idle * m_c);
+      m_backlog -= served;
+      m_served += served;
+    }
+
+  m_lastServe = now;
+}
+
+void
+HybridFluidQueueDisc::UpdateFluid (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  ServeFluid ();
+
+  double t = Simulator::Now ().GetSeconds ();
+  double h = m_step.GetSeconds ();
+  double tp = m_propDelay.GetSeconds ();
+  double q = m_backlog + GetInternalQueue (0)->GetNPackets ();
+  double r = q / m_c + tp;
+
+  m_controller->Update (t, q);
+  double p = m_controller->GetDropProbability (q);
+
+  // the traffic exceeding the capacity is dropped when the queue is full
+  double rate = m_nFlows * m_w / r;
+  if (q >= m_limit && rate > m_c)
+    {
+      p += (1 - p) * (1 - m_c / rate);
+    }
+
+  uint32_t nHistory = m_histW.size ();
+  m_histW[m_nUpdates % nHistory] = m_w;
+  m_histQ[m_nUpdates % nHistory] = q;
+  m_histP[m_nUpdates % nHistory] = p;
+
+  // values one round trip time ago, linearly interpolated (see AqmFluidModel)
+  double wd = 1.0;
+  double qd = 0.0;
+  double pd = 0.0;
+  double kd = m_nUpdates - r / h;
+  if (kd >= 0)
+    {
+      uint64_t i = static_cast<uint64_t> (kd);
+      double frac = kd - i;
+      uint32_t i0 = i % nHistory;
+      uint32_t i1 = (i + 1 <= m_nUpdates ? i + 1 : i) % nHistory;
+      wd = (1 - frac) * m_histW[i0] + frac * m_histW[i1];
+      qd = (1 - frac) * m_histQ[i0] + frac * m_histQ[i1];
+      pd = (1 - frac) * m_histP[i0] + frac * m_histP[i1];
+    }
+  double rd = qd / m_c + tp;
+
+  m_w = std::max (1.0, m_w + h * (1.0 / r - m_w * wd / (2 * rd) * pd));
+  m_rate = m_nFlows * m_w / r * (1 - p);
+  m_nUpdates++;
+
+  NS_LOG_DEBUG ("Fluid backlog " << m_backlog << " window " << m_w << " rate " << m_rate
+                << " probability " << m_controller->GetProbability ());
+
+  m_updateEvent = Simulator::Schedule (m_step, &HybridFluidQueueDisc::UpdateFluid, this);
+}
+
+bool
+HybridFluidQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  ServeFluid ();
+  double q = m_backlog + GetInternalQueue (0)->GetNPackets ();
+
+  if (q + 1 > m_limit)
+    {
+      NS_LOG_DEBUG ("\t Dropping due to queue limit: " << q);
+      DropBeforeEnqueue (item, FORCED_DROP);
+      return false;
+    }
+
+  if (m_uv->GetValue () < m_controller->GetDropProbability (q))
+    {
+      NS_LOG_DEBUG ("\t Dropping due to the drop probability");
+      DropBeforeEnqueue (item, UNFORCED_DROP);
+      return false;
+    }
+
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // the packet can be dequeued once all the fluid entered so far is served
+  if (retval)
+    {
+      m_marks.push_back (m_arrived);
+    }
+
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("\t fluidBacklog  " << m_backlog);
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+HybridFluidQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  ServeFluid ();
+
+  double ahead = m_marks.front () - m_served;
+  if (ahead > 1e-9)
+    {
+      // wake up when the fluid ahead of the packet has been served
+      if (m_wakeEvent.IsExpired ())
+        {
+          Time delay = NanoSeconds (static_cast<int64_t> (std::ceil (ahead / m_c * 1e9)));
+          m_wakeEvent = Simulator::Schedule (delay, &QueueDisc::Run, this);
+          NS_LOG_LOGIC ("Packet blocked by " << ahead << " packets of fluid, waking up in " << delay);
+        }
+      return 0;
+    }
+
+  Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+  m_marks.pop_front ();
+  m_busyUntil = std::max (Simulator::Now (), m_busyUntil) + m_linkBandwidth.CalculateBytesTxTime (item->GetSize ());
+
+  return item;
+}
+
+bool
+HybridFluidQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("HybridFluidQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("HybridFluidQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (!m_aqm)
+    {
+      NS_LOG_ERROR ("HybridFluidQueueDisc needs an AQM queue disc");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // add a DropTail queue with the maximum size of the AQM queue disc
+      SetMaxSize (m_aqm->GetMaxSize ());
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> >
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("HybridFluidQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  return true;
+}
+
+void
+HybridFluidQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_controller = CreateObject<AqmFluidController> ();
+  m_controller->SetQueueDisc (m_aqm);
+  m_limit = m_controller->GetLimit ();
+  m_c = m_linkBandwidth.GetBitRate () / (8.0 * m_pktSize);
+  m_controller->Reset (Simulator::Now ().GetSeconds (), m_c);
+
+  // the history is kept for the maximum round trip time
+  double h = m_step.GetSeconds ();
+  uint32_t nHistory = static_cast<uint32_t> (std::ceil ((m_limit / m_c + m_propDelay.GetSeconds ()) / h)) + 2;
+  m_histW.assign (nHistory, 1.0);
+  m_histQ.assign (nHistory, 0.0);
+  m_histP.assign (nHistory, 0.0);
+
+  m_w = 1;
+  m_rate = 0;
+  m_backlog = 0;
+  m_arrived = 0;
+  m_served = 0;
+  m_nUpdates = 0;
+  m_lastServe = Simulator::Now ();
+  m_busyUntil = Simulator::Now ();
+  m_updateEvent = Simulator::ScheduleNow (&HybridFluidQueueDisc::UpdateFluid, this);
+}
+
+} // namespace ns3
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HYBRID_FLUID_QUEUE_DISC_H
+#define HYBRID_FLUID_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+#include "aqm-fluid-controller.h"
+#include <deque>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup fluid-model
+ *
+ * \brief AQM queue disc shared by packets and a fluid background load
+ *
+ * This queue disc stores the packets it receives in a FIFO queue shared with
+ * the fluid backlog of NFlows long-lived TCP Reno flows, which are not
+ * simulated at the packet level. The rate of the fluid flows is computed
+ * every Step by the fluid model of Misra, Gong and Towsley (see
+ * AqmFluidModel), hence the background load reacts to the drop probability
+ * of the queue disc and to the round trip time R = q/C + PropagationDelay,
+ * where q is the total queue length (fluid and packets) and C is the
+ * LinkBandwidth.
+ *
+ * The drop probability is computed on the total queue length by an
+ * AqmFluidController running the control law of the queue disc set as the
+ * Aqm attribute (a RedQueueDisc, a PieQueueDisc or a PiQueueDisc), whose
+ * maximum size is also the limit on the total queue length. The same
+ * probability is applied to the packets entering the queue disc and to the
+ * fluid arrivals.
+ *
+ * The fluid is served at the LinkBandwidth whenever the link is not busy
+ * transmitting a packet. Packets leave the queue disc in FIFO order with
+ * respect to the fluid, i.e., a packet cannot be dequeued until the fluid
+ * that arrived before it has been served. Hence, packets experience the
+ * queueing delay and the drops caused by the background load, while only
+ * the foreground flows generate events.
+ */
+class HybridFluidQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief HybridFluidQueueDisc constructor
+   */
+  HybridFluidQueueDisc ();
+
+  virtual ~HybridFluidQueueDisc ();
+
+  /**
+   * \brief Get the fluid backlog
+   * \return the amount of fluid in the queue, in packets of size PacketSize
+   */
+  double GetFluidBacklog (void);
+
+  /**
+   * \brief Get the congestion window of the fluid flows
+   * \return the congestion window in packets
+   */
+  double GetFluidWindow (void) const;
+
+  /**
+   * \brief Get the state of the AQM controller
+   *
+   * The queue delay is the total queue length divided by the LinkBandwidth.
+   *
+   * \return the state of the controller
+   */
+  virtual ControllerState GetControllerState (void);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  // Reasons for dropping packets
+  static constexpr const char* UNFORCED_DROP = "Unforced drop";  //!< Early probability drops
+  static constexpr const char* FORCED_DROP = "Forced drop";      //!< Drops due to queue limit
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Advance the fluid arrivals and departures to the current time
+   */
+  void ServeFluid (void);
+  /**
+   * \brief Update the controller and the rate of the fluid flows, and
+   *        schedule the next update
+   */
+  void UpdateFluid (void);
+
+  // ** Variables supplied by user
+  Ptr<QueueDisc> m_aqm;                   //!< Queue disc providing the control law
+  uint32_t m_nFlows;                      //!< Number of fluid flows
+  Time m_propDelay;                       //!< Round trip propagation delay of the fluid flows
+  DataRate m_linkBandwidth;               //!< Link bandwidth
+  uint32_t m_pktSize;                     //!< Size of the fluid packets in bytes
+  Time m_step;                            //!< Time between two updates of the fluid rate
+
+  // ** Variables maintained by the queue disc
+  Ptr<AqmFluidController> m_controller;   //!< AQM controller
+  double m_c;                             //!< Link bandwidth in packets per second
+  double m_limit;                         //!< Maximum total queue length in packets
+  double m_w;                             //!< Congestion window of the fluid flows
+  double m_rate;                          //!< Rate of the fluid entering the queue in packets per second
+  double m_backlog;                       //!< Fluid backlog in packets
+  double m_arrived;                       //!< Fluid entered the queue since the initialization
+  double m_served;                        //!< Fluid served since the initialization
+  Time m_lastServe;                       //!< Time of the last update of the fluid backlog
+  Time m_busyUntil;                       //!< Time the link completes the transmission of the dequeued packets
+  std::deque<double> m_marks;             //!< Fluid arrived before each of the queued packets
+  uint64_t m_nUpdates;                    //!< Number of updates of the fluid rate
+  std::vector<double> m_histW;            //!< History of the congestion window
+  std::vector<double> m_histQ;            //!< History of the total queue length
+  std::vector<double> m_histP;            //!< History of the drop probability
+  EventId m_updateEvent;                  //!< Event used to update the fluid rate
+  EventId m_wakeEvent;                    //!< Event used to dequeue a packet once the fluid ahead is served
+  Ptr<UniformRandomVariable> m_uv;        //!< Rng stream
+};
+
+} // namespace ns3
+
+#endif /* HYBRID_FLUID_QUEUE_DISC_H */
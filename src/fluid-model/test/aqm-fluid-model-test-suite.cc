@@ -0,0 +1,253 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/aqm-fluid-model.h"
+#include "ns3/aqm-fluid-controller.h"
+#include "ns3/simulator.h"
+#include "ns3/red-queue-disc.h"
+#include "ns3/pie-queue-disc.h"
+#include "ns3/pi-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include <fstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup fluid-model
+ * \defgroup fluid-model-test fluid-model module tests
+ */
+
+/**
+ * \ingroup fluid-model-test
+ * \ingroup tests
+ *
+ * \brief AQM Fluid Model Test Case
+ *
+ * In the equilibrium of the fluid model, the window of each flow is
+ * W0 = R0 C / N and the drop probability is p0 = 2 / W0^2, while the
+ * equilibrium queue length depends on the control law.
+ */
+class AqmFluidModelTestCase : public TestCase
+{
+public:
+  AqmFluidModelTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Run the fluid model and compute the average queue length and drop
+   * probability over the last 20 seconds
+   * \param qd the queue disc
+   * \param nFlows the number of flows
+   * \param capacity the capacity in packets per second
+   * \param tp the round trip propagation delay
+   * \param q the average queue length in packets
+   * \param p the average drop probability
+   */
+  void RunModel (Ptr<QueueDisc> qd, uint32_t nFlows, double capacity, Time tp, double &q, double &p);
+  /**
+   * Check the equilibrium of TCP flows with a PI controller
+   */
+  void RunPiTest (void);
+  /**
+   * Check the equilibrium of TCP flows with PIE
+   */
+  void RunPieTest (void);
+  /**
+   * Check the equilibrium of TCP flows with RED
+   */
+  void RunRedTest (void);
+};
+
+AqmFluidModelTestCase::AqmFluidModelTestCase ()
+  : TestCase ("Sanity check on the equilibrium of the AQM fluid model")
+{
+}
+
+void
+AqmFluidModelTestCase::RunModel (Ptr<QueueDisc> qd, uint32_t nFlows, double capacity, Time tp, double &q, double &p)
+{
+  Ptr<AqmFluidModel> model = CreateObject<AqmFluidModel> ();
+  model->SetAttribute ("NFlows", UintegerValue (nFlows));
+  model->SetAttribute ("Capacity", DataRateValue (DataRate (static_cast<uint64_t> (capacity * 8000))));
+  model->SetAttribute ("PacketSize", UintegerValue (1000));
+  model->SetAttribute ("PropagationDelay", TimeValue (tp));
+  model->SetQueueDisc (qd);
+  model->Run (Seconds (100));
+
+  const std::vector<QueueDiscSampler::Sample> &samples = model->GetSamples ();
+  NS_TEST_ASSERT_MSG_EQ (samples.size (), 10001, "Wrong number of samples");
+
+  q = p = 0;
+  uint32_t n = 0;
+  for (const auto &s : samples)
+    {
+      if (s.time >= Seconds (80).GetNanoSeconds ())
+        {
+          q += s.queueDelay * 1e-9 * capacity;
+          p += s.probability;
+          n++;
+        }
+    }
+  q /= n;
+  p /= n;
+}
+
+void
+AqmFluidModelTestCase::RunPiTest (void)
+{
+  // the configuration of Hollot et al., with a queue reference of 200 packets
+  Ptr<PiQueueDisc> qd = CreateObject<PiQueueDisc> ();
+  qd->SetAttribute ("QueueRef", QueueSizeValue (QueueSize ("200p")));
+  qd->SetAttribute ("MaxSize", QueueSizeValue (QueueSize ("800p")));
+
+  double q, p;
+  RunModel (qd, 60, 3750, MilliSeconds (200), q, p);
+
+  double w0 = (q / 3750 + 0.2) * 3750 / 60;
+  NS_TEST_EXPECT_MSG_EQ_TOL (q, 200, 10, "The PI controller should keep the queue at the reference");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p, 2 / (w0 * w0), 0.1 * 2 / (w0 * w0), "Wrong equilibrium drop probability");
+}
+
+void
+AqmFluidModelTestCase::RunPieTest (void)
+{
+  Ptr<PieQueueDisc> qd = CreateObject<PieQueueDisc> ();
+  qd->SetAttribute ("QueueDelayReference", TimeValue (MilliSeconds (15)));
+  qd->SetAttribute ("MaxSize", QueueSizeValue (QueueSize ("1000p")));
+
+  double q, p;
+  RunModel (qd, 20, 1250, MilliSeconds (100), q, p);
+
+  double w0 = (q / 1250 + 0.1) * 1250 / 20;
+  NS_TEST_EXPECT_MSG_EQ_TOL (q / 1250, 0.015, 0.0015, "PIE should keep the queue delay at the reference");
+  // PIE does not drop packets while the queue delay is below half the
+  // reference, hence its drop probability oscillates above p0
+  NS_TEST_EXPECT_MSG_GT (p, 2 / (w0 * w0), "Wrong equilibrium drop probability");
+}
+
+void
+AqmFluidModelTestCase::RunRedTest (void)
+{
+  Ptr<RedQueueDisc> qd = CreateObject<RedQueueDisc> ();
+  qd->SetAttribute ("MinTh", DoubleValue (20));
+  qd->SetAttribute ("MaxTh", DoubleValue (80));
+  qd->SetAttribute ("LInterm", DoubleValue (10));
+  qd->SetAttribute ("MaxSize", QueueSizeValue (QueueSize ("200p")));
+
+  double q, p;
+  RunModel (qd, 20, 1250, MilliSeconds (100), q, p);
+
+  // the equilibrium queue is where the RED curve meets the TCP curve
+  double w0 = (q / 1250 + 0.1) * 1250 / 20;
+  NS_TEST_EXPECT_MSG_GT (q, 20, "The queue should exceed the minimum threshold");
+  NS_TEST_EXPECT_MSG_LT (q, 80, "The queue should not exceed the maximum threshold");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p, (q - 20) / 60 * 0.1, 0.1 * p, "The drop probability should follow the RED curve");
+  NS_TEST_EXPECT_MSG_EQ_TOL (p, 2 / (w0 * w0), 0.1 * 2 / (w0 * w0), "Wrong equilibrium drop probability");
+}
+
+void
+AqmFluidModelTestCase::DoRun (void)
+{
+  RunPiTest ();
+  RunPieTest ();
+  RunRedTest ();
+}
+
+/**
+ * \ingroup fluid-model-test
+ * \ingroup tests
+ *
+ * \brief Check the use of the queue disc passed to the fluid model
+ *
+ * The queue disc only provides the control law and its parameters, hence
+ * it must not schedule any event (e.g., the periodic updates of PI and
+ * PIE). The samples of the fluid model are written in the CSV format of
+ * the QueueDiscSampler.
+ */
+class AqmFluidModelQueueDiscTestCase : public TestCase
+{
+public:
+  AqmFluidModelQueueDiscTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check that setting a queue disc on a controller schedules no event
+   * \param qd the queue disc
+   */
+  void CheckNoEvents (Ptr<QueueDisc> qd);
+};
+
+AqmFluidModelQueueDiscTestCase::AqmFluidModelQueueDiscTestCase ()
+  : TestCase ("Check the queue disc and the output of the AQM fluid model")
+{
+}
+
+void
+AqmFluidModelQueueDiscTestCase::CheckNoEvents (Ptr<QueueDisc> qd)
+{
+  Simulator::Destroy ();
+  Ptr<AqmFluidController> controller = CreateObject<AqmFluidController> ();
+  controller->SetQueueDisc (qd);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), true,
+                         "The queue disc " << qd->GetInstanceTypeId ().GetName () << " should not schedule events");
+  Simulator::Destroy ();
+}
+
+void
+AqmFluidModelQueueDiscTestCase::DoRun (void)
+{
+  CheckNoEvents (CreateObject<PiQueueDisc> ());
+  CheckNoEvents (CreateObjectWithAttributes<PieQueueDisc> ("MaxSize", QueueSizeValue (QueueSize ("1000p"))));
+  CheckNoEvents (CreateObjectWithAttributes<RedQueueDisc> ("MaxSize", QueueSizeValue (QueueSize ("200p"))));
+
+  Ptr<AqmFluidModel> model = CreateObject<AqmFluidModel> ();
+  model->SetQueueDisc (CreateObject<PiQueueDisc> ());
+  model->Run (Seconds (1));
+  std::string fileName = CreateTempDirFilename ("aqm-fluid-model.csv");
+  model->Write (fileName);
+
+  std::ifstream file (fileName.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (file.is_open (), true, "Cannot open " << fileName);
+  std::string line;
+  std::getline (file, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "time,packets,bytes,delay,probability", "Wrong CSV header");
+  uint32_t nLines = 0;
+  while (std::getline (file, line))
+    {
+      nLines++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nLines, model->GetSamples ().size (), "There should be a line per sample");
+}
+
+/**
+ * \ingroup fluid-model-test
+ * \ingroup tests
+ *
+ * \brief AQM Fluid Model Test Suite
+ */
+static class AqmFluidModelTestSuite : public TestSuite
+{
+public:
+  AqmFluidModelTestSuite ()
+    : TestSuite ("aqm-fluid-model", UNIT)
+  {
+    AddTestCase (new AqmFluidModelTestCase (), TestCase::QUICK);
+    AddTestCase (new AqmFluidModelQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_aqmFluidModelTestSuite; ///< the test suite
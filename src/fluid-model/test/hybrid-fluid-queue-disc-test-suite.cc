@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/hybrid-fluid-queue-disc.h"
+#include "ns3/pi-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup fluid-model-test
+ * \ingroup tests
+ *
+ * \brief Hybrid Fluid Queue Disc Test Item
+ */
+class HybridFluidQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   */
+  HybridFluidQueueDiscTestItem (Ptr<Packet> p, const Address & addr);
+  virtual ~HybridFluidQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  HybridFluidQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  HybridFluidQueueDiscTestItem (const HybridFluidQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  HybridFluidQueueDiscTestItem &operator = (const HybridFluidQueueDiscTestItem &);
+};
+
+HybridFluidQueueDiscTestItem::HybridFluidQueueDiscTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0)
+{
+}
+
+HybridFluidQueueDiscTestItem::~HybridFluidQueueDiscTestItem ()
+{
+}
+
+void
+HybridFluidQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+HybridFluidQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup fluid-model-test
+ * \ingroup tests
+ *
+ * \brief Hybrid Fluid Queue Disc Test Case
+ *
+ * 60 fluid flows with a round trip propagation delay of 200 ms share a
+ * 30 Mbps link managed by a PI controller with a queue reference of 200
+ * packets. Packets are enqueued once per second after the fluid reached
+ * the equilibrium.
+ */
+class HybridFluidQueueDiscTestCase : public TestCase
+{
+public:
+  HybridFluidQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Sample the total queue length
+   * \param qd the queue disc
+   */
+  void Sample (Ptr<HybridFluidQueueDisc> qd);
+  /**
+   * Enqueue a packet and record the fluid backlog it finds
+   * \param qd the queue disc
+   */
+  void Enqueue (Ptr<HybridFluidQueueDisc> qd);
+  /**
+   * Record the delay of a packet sent by the queue disc
+   * \param item the packet
+   */
+  void Send (Ptr<QueueDiscItem> item);
+
+  double m_qSum;                 //!< Sum of the sampled queue lengths
+  uint32_t m_nSamples;           //!< Number of samples
+  std::vector<double> m_backlog; //!< Fluid backlog found by each enqueued packet
+  std::vector<Time> m_enqueue;   //!< Enqueue time of each enqueued packet
+  uint32_t m_nSent;              //!< Number of packets sent
+};
+
+HybridFluidQueueDiscTestCase::HybridFluidQueueDiscTestCase ()
+  : TestCase ("Sanity check on the hybrid fluid queue disc"),
+    m_qSum (0),
+    m_nSamples (0),
+    m_nSent (0)
+{
+}
+
+void
+HybridFluidQueueDiscTestCase::Sample (Ptr<HybridFluidQueueDisc> qd)
+{
+  m_qSum += qd->GetFluidBacklog () + qd->GetNPackets ();
+  m_nSamples++;
+}
+
+void
+HybridFluidQueueDiscTestCase::Enqueue (Ptr<HybridFluidQueueDisc> qd)
+{
+  Address dest;
+  double backlog = qd->GetFluidBacklog ();
+  Ptr<Packet> p = Create<Packet> (1000);
+  if (qd->Enqueue (Create<HybridFluidQueueDiscTestItem> (p, dest)))
+    {
+      m_backlog.push_back (backlog);
+      m_enqueue.push_back (Simulator::Now ());
+    }
+  qd->Run ();
+}
+
+void
+HybridFluidQueueDiscTestCase::Send (Ptr<QueueDiscItem> item)
+{
+  // the packet is sent once the fluid found in the queue has been served
+  // at the link bandwidth of 3750 packets per second
+  NS_TEST_ASSERT_MSG_LT (m_nSent, m_enqueue.size (), "Unexpected packet");
+  Time delay = Simulator::Now () - m_enqueue[m_nSent];
+  NS_TEST_EXPECT_MSG_EQ_TOL (delay.GetSeconds (), m_backlog[m_nSent] / 3750, 1e-6, "Wrong packet delay");
+  m_nSent++;
+}
+
+void
+HybridFluidQueueDiscTestCase::DoRun (void)
+{
+  Ptr<PiQueueDisc> pi = CreateObject<PiQueueDisc> ();
+  pi->SetAttribute ("QueueRef", QueueSizeValue (QueueSize ("200p")));
+  pi->SetAttribute ("MaxSize", QueueSizeValue (QueueSize ("800p")));
+
+  Ptr<HybridFluidQueueDisc> qd = CreateObject<HybridFluidQueueDisc> ();
+  qd->SetAttribute ("Aqm", PointerValue (pi));
+  qd->SetAttribute ("NFlows", UintegerValue (60));
+  qd->SetAttribute ("PropagationDelay", TimeValue (MilliSeconds (200)));
+  qd->SetAttribute ("LinkBandwidth", DataRateValue (DataRate ("30Mbps")));
+  qd->SetAttribute ("PacketSize", UintegerValue (1000));
+  qd->AssignStreams (1);
+  qd->SetSendCallback ([this] (Ptr<QueueDiscItem> item) { Send (item); });
+  qd->Initialize ();
+
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Simulator::Schedule (Seconds (80) + MilliSeconds (10 * i), &HybridFluidQueueDiscTestCase::Sample, this, qd);
+    }
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (Seconds (80 + i) + MicroSeconds (500), &HybridFluidQueueDiscTestCase::Enqueue, this, qd);
+    }
+
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+
+  // the fluid flows reach the equilibrium where the queue is at the reference
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_qSum / m_nSamples, 200, 10, "The PI controller should keep the queue at the reference");
+  NS_TEST_EXPECT_MSG_GT (m_enqueue.size (), 0, "No packet was enqueued");
+  NS_TEST_EXPECT_MSG_EQ (m_nSent, m_enqueue.size (), "All the enqueued packets should have been sent");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup fluid-model-test
+ * \ingroup tests
+ *
+ * \brief Hybrid Fluid Queue Disc Test Suite
+ */
+static class HybridFluidQueueDiscTestSuite : public TestSuite
+{
+public:
+  HybridFluidQueueDiscTestSuite ()
+    : TestSuite ("hybrid-fluid-queue-disc", UNIT)
+  {
+    AddTestCase (new HybridFluidQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_hybridFluidQueueDiscTestSuite; ///< the test suite
@@ -712,8 +712,10 @@ GlobalRouteManagerImpl::InitializeRoutes ()
         node->GetObject<GlobalRouter> ();
 
       uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      // Ignore nodes that are not assigned to our systemId (distributed sim).
+      // Without MPI, all the nodes are simulated by this process (possibly
+      // by different threads, see MultithreadedSimulatorImpl)
+      if (MpiInterface::IsEnabled () && node->GetSystemId () != systemId)
         {
           continue;
         }
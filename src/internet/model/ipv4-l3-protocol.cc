@@ -35,6 +35,8 @@
 #include "ns3/traffic-control-layer.h"
 
 #include "loopback-net-device.h"
+#include "ipv4-queue-disc-item.h"
+#include "ns3/link-estimator.h"
 #include "arp-l3-protocol.h"
 #include "arp-cache.h"
 #include "ipv4-l3-protocol.h"
@@ -297,6 +299,7 @@ Ipv4L3Protocol::DoDispose (void)
     }
   m_interfaces.clear ();
   m_reverseInterfacesContainer.clear ();
+  m_linkEstimators.clear ();
 
   m_sockets.clear ();
   m_node = 0;
@@ -321,6 +324,20 @@ Ipv4L3Protocol::DoDispose (void)
   Object::DoDispose ();
 }
 
+void
+Ipv4L3Protocol::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // a link estimator may have been aggregated to a device after the
+  // interface was added
+  for (uint32_t i = 0; i < m_interfaces.size (); i++)
+    {
+      m_linkEstimators[i] = m_interfaces[i]->GetDevice ()->GetObject<LinkEstimator> ();
+    }
+  Ipv4::DoInitialize ();
+}
+
 void
 Ipv4L3Protocol::SetupLoopback (void)
 {
@@ -398,6 +415,7 @@ Ipv4L3Protocol::AddIpv4Interface (Ptr<Ipv4Interface>interface)
   uint32_t index = m_interfaces.size ();
   m_interfaces.push_back (interface);
   m_reverseInterfacesContainer[interface->GetDevice ()] = index;
+  m_linkEstimators.push_back (interface->GetDevice ()->GetObject<LinkEstimator> ());
   return index;
 }
 
@@ -592,6 +610,12 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
       return;
     }
 
+  // let the link estimator of the device, if any, match the TCP timestamp echoes
+  if (m_linkEstimators[interface])
+    {
+      m_linkEstimators[interface]->NotifyIngress (Create<Ipv4QueueDiscItem> (packet, from, PROT_NUMBER, ipHeader));
+    }
+
   // the packet is valid, we update the ARP cache entry (if present)
   Ptr<ArpCache> arpCache = ipv4Interface->GetArpCache ();
   if (arpCache)
@@ -1061,6 +1085,9 @@ Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uin
 {
   NS_LOG_FUNCTION (this << packet << &ip << iif);
   Ptr<Packet> p = packet->Copy (); // need to pass a non-const packet up
+  // the flow hash is not valid anymore if the packet is sent again by the
+  // upper layers (e.g., echoed back)
+  p->SetFlowHash (0);
   Ipv4Header ipHeader = ip;
 
   if ( !ipHeader.IsLastFragment () || ipHeader.GetFragmentOffset () != 0 )
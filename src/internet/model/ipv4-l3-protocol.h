@@ -51,6 +51,7 @@ class Socket;
 class Ipv4RawSocketImpl;
 class IpL4Protocol;
 class Icmpv4L4Protocol;
+class LinkEstimator;
 
 /**
  * \ingroup ipv4
@@ -263,6 +264,10 @@ public:
 protected:
 
   virtual void DoDispose (void);
+  /**
+   * Look up the link estimator of the device of each interface
+   */
+  virtual void DoInitialize (void);
   /**
    * This function will notify other components connected to the node that a new stack member is now connected
    * This will be used to notify Layer 3 protocol of layer 4 protocol stack to connect them together.
@@ -461,6 +466,7 @@ private:
   bool m_weakEsModel;    //!< Weak ES model state
   L4List_t m_protocols;  //!< List of transport protocol.
   Ipv4InterfaceList m_interfaces; //!< List of IPv4 interfaces.
+  std::vector<Ptr<LinkEstimator> > m_linkEstimators; //!< Link estimator of the device of each interface, if any
   Ipv4InterfaceReverseContainer m_reverseInterfacesContainer; //!< Container of NetDevice / Interface index associations.
   uint8_t m_defaultTtl;  //!< Default TTL
   std::map<std::pair<uint64_t, uint8_t>, uint16_t> m_identification; //!< Identification (for each {src, dst, proto} tuple)
@@ -20,11 +20,130 @@
 #include "ipv4-queue-disc-item.h"
 #include "ns3/tcp-header.h"
 #include "ns3/udp-header.h"
+#include "ns3/tcp-option-ts.h"
+#include "ns3/tcp-option-sack.h"
+#include <cstring>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4QueueDiscItem");
 
+namespace {
+/**
+ * \brief Check whether a packet carries a pure TCP acknowledgment
+ * \param p the packet, starting with the TCP header
+ * \param tcpHdr the TCP header of the packet
+ * \return true if the TCP segment carries no payload and no flag other than
+ *         ACK, ECE and CWR
+ */
+bool
+IsPureAck (Ptr<const Packet> p, const TcpHeader &tcpHdr)
+{
+  uint8_t flags = tcpHdr.GetFlags ();
+  return (flags & TcpHeader::ACK)
+         && !(flags & ~(TcpHeader::ACK | TcpHeader::ECE | TcpHeader::CWR))
+         && p->GetSize () == tcpHdr.GetSerializedSize ();
+}
+
+/**
+ * \brief Compare the SACK blocks carried by two TCP acknowledgments
+ *
+ * Same as cake_tcph_sack_compare in Linux.
+ *
+ * \param older the TCP header of the older acknowledgment
+ * \param newer the TCP header of the newer acknowledgment
+ * \return -1 if a SACK block of the older acknowledgment is not covered by
+ *         a SACK block of the newer acknowledgment, 1 if the newer
+ *         acknowledgment covers strictly more bytes than the older one, 0 otherwise
+ */
+int
+CompareSack (const TcpHeader &older, const TcpHeader &newer)
+{
+  TcpOptionSack::SackList olderList, newerList;
+  if (older.HasOption (TcpOption::SACK))
+    {
+      olderList = DynamicCast<const TcpOptionSack> (older.GetOption (TcpOption::SACK))->GetSackList ();
+    }
+  if (newer.HasOption (TcpOption::SACK))
+    {
+      newerList = DynamicCast<const TcpOptionSack> (newer.GetOption (TcpOption::SACK))->GetSackList ();
+    }
+
+  uint32_t olderBytes = 0;
+  for (TcpOptionSack::SackList::const_iterator a = olderList.begin (); a != olderList.end (); a++)
+    {
+      bool covered = false;
+      for (TcpOptionSack::SackList::const_iterator b = newerList.begin (); b != newerList.end (); b++)
+        {
+          if (b->first <= a->first && a->second <= b->second)
+            {
+              covered = true;
+              break;
+            }
+        }
+      if (!covered)
+        {
+          return -1;
+        }
+      olderBytes += a->second - a->first;
+    }
+
+  uint32_t newerBytes = 0;
+  for (TcpOptionSack::SackList::const_iterator b = newerList.begin (); b != newerList.end (); b++)
+    {
+      newerBytes += b->second - b->first;
+    }
+
+  return newerBytes > olderBytes ? 1 : 0;
+}
+
+/**
+ * \brief Check whether the acknowledgment number and the SACK blocks of the
+ *        newer acknowledgment make the older acknowledgment redundant
+ *
+ * The older acknowledgment is redundant if the newer one acknowledges more
+ * data or, in case of equal acknowledgment numbers, if the newer one carries
+ * strictly more SACK information. Hence, a duplicate acknowledgment is never
+ * redundant, so that the sender can still detect losses.
+ *
+ * \param older the TCP header of the older acknowledgment
+ * \param newer the TCP header of the newer acknowledgment
+ * \return true if the older acknowledgment is redundant
+ */
+bool
+RedundantAckNumber (const TcpHeader &older, const TcpHeader &newer)
+{
+  int sack = CompareSack (older, newer);
+  if (sack < 0)
+    {
+      return false;
+    }
+  if (older.GetAckNumber () == newer.GetAckNumber ())
+    {
+      return sack > 0;
+    }
+  return older.GetAckNumber () < newer.GetAckNumber ();
+}
+
+/**
+ * \brief Compute an identifier of a TCP connection which does not depend on
+ *        the direction of the packet
+ * \param src the serialized source address and port
+ * \param dest the serialized destination address and port
+ * \return the identifier of the connection
+ */
+uint32_t
+ConnectionHash (const uint8_t *src, const uint8_t *dest)
+{
+  // serialize the endpoint with the lowest address and port first
+  uint8_t buf[12];
+  bool swap = (std::memcmp (src, dest, 6) > 0);
+  std::memcpy (buf, swap ? dest : src, 6);
+  std::memcpy (buf + 6, swap ? src : dest, 6);
+  return Hash32 ((char*) buf, 12);
+}
+}
+
 Ipv4QueueDiscItem::Ipv4QueueDiscItem (Ptr<Packet> p, const Address& addr,
                                       uint16_t protocol, const Ipv4Header & header)
   : QueueDiscItem (p, addr, protocol),
@@ -116,54 +235,164 @@ Ipv4QueueDiscItem::Hash (uint32_t perturbation) const
 {
   NS_LOG_FUNCTION (this << perturbation);
 
-  Ipv4Address src = m_header.GetSource ();
-  Ipv4Address dest = m_header.GetDestination ();
-  uint8_t prot = m_header.GetProtocol ();
-  uint16_t fragOffset = m_header.GetFragmentOffset ();
+  // The hash of the 5-tuple is computed once and carried by the packet, so
+  // that the following hops do not need to parse the headers again
+  uint32_t hash = GetPacket ()->GetFlowHash ();
 
-  TcpHeader tcpHdr;
-  UdpHeader udpHdr;
-  uint16_t srcPort = 0;
-  uint16_t destPort = 0;
+  if (hash == 0)
+    {
+      Ipv4Address src = m_header.GetSource ();
+      Ipv4Address dest = m_header.GetDestination ();
+      uint8_t prot = m_header.GetProtocol ();
+      uint16_t fragOffset = m_header.GetFragmentOffset ();
+
+      TcpHeader tcpHdr;
+      UdpHeader udpHdr;
+      uint16_t srcPort = 0;
+      uint16_t destPort = 0;
+
+      if (prot == 6 && fragOffset == 0) // TCP
+        {
+          GetPacket ()->PeekHeader (tcpHdr);
+          srcPort = tcpHdr.GetSourcePort ();
+          destPort = tcpHdr.GetDestinationPort ();
+        }
+      else if (prot == 17 && fragOffset == 0) // UDP
+        {
+          GetPacket ()->PeekHeader (udpHdr);
+          srcPort = udpHdr.GetSourcePort ();
+          destPort = udpHdr.GetDestinationPort ();
+        }
+      if (prot != 6 && prot != 17)
+        {
+          NS_LOG_WARN ("Unknown transport protocol, no port number included in hash computation");
+        }
+
+      /* serialize the 5-tuple in buf; the perturbation bytes are left to zero,
+       * so that the hash is unchanged when no perturbation is used */
+      uint8_t buf[17];
+      src.Serialize (buf);
+      dest.Serialize (buf + 4);
+      buf[8] = prot;
+      buf[9] = (srcPort >> 8) & 0xff;
+      buf[10] = srcPort & 0xff;
+      buf[11] = (destPort >> 8) & 0xff;
+      buf[12] = destPort & 0xff;
+      buf[13] = 0;
+      buf[14] = 0;
+      buf[15] = 0;
+      buf[16] = 0;
+
+      // Linux calculates jhash2 (jenkins hash), we calculate murmur3 because it is
+      // already available in ns-3
+      hash = Hash32 ((char*) buf, 17);
 
-  if (prot == 6 && fragOffset == 0) // TCP
+      GetPacket ()->SetFlowHash (hash);
+    }
+
+  if (perturbation != 0)
     {
-      GetPacket ()->PeekHeader (tcpHdr);
-      srcPort = tcpHdr.GetSourcePort ();
-      destPort = tcpHdr.GetDestinationPort ();
+      /* serialize the flow hash and the perturbation in buf */
+      uint8_t buf[8];
+      buf[0] = (hash >> 24) & 0xff;
+      buf[1] = (hash >> 16) & 0xff;
+      buf[2] = (hash >> 8) & 0xff;
+      buf[3] = hash & 0xff;
+      buf[4] = (perturbation >> 24) & 0xff;
+      buf[5] = (perturbation >> 16) & 0xff;
+      buf[6] = (perturbation >> 8) & 0xff;
+      buf[7] = perturbation & 0xff;
+      hash = Hash32 ((char*) buf, 8);
     }
-  else if (prot == 17 && fragOffset == 0) // UDP
+
+  NS_LOG_DEBUG ("Hash value " << hash);
+
+  return hash;
+}
+
+uint32_t
+Ipv4QueueDiscItem::HostHash (bool source, uint32_t perturbation) const
+{
+  NS_LOG_FUNCTION (this << source << perturbation);
+
+  /* serialize the address and the perturbation in buf */
+  uint8_t buf[8];
+  if (source)
     {
-      GetPacket ()->PeekHeader (udpHdr);
-      srcPort = udpHdr.GetSourcePort ();
-      destPort = udpHdr.GetDestinationPort ();
+      m_header.GetSource ().Serialize (buf);
     }
-  if (prot != 6 && prot != 17)
+  else
     {
-      NS_LOG_WARN ("Unknown transport protocol, no port number included in hash computation");
+      m_header.GetDestination ().Serialize (buf);
     }
+  buf[4] = (perturbation >> 24) & 0xff;
+  buf[5] = (perturbation >> 16) & 0xff;
+  buf[6] = (perturbation >> 8) & 0xff;
+  buf[7] = perturbation & 0xff;
 
-  /* serialize the 5-tuple and the perturbation in buf */
-  uint8_t buf[17];
-  src.Serialize (buf);
-  dest.Serialize (buf + 4);
-  buf[8] = prot;
-  buf[9] = (srcPort >> 8) & 0xff;
-  buf[10] = srcPort & 0xff;
-  buf[11] = (destPort >> 8) & 0xff;
-  buf[12] = destPort & 0xff;
-  buf[13] = (perturbation >> 24) & 0xff;
-  buf[14] = (perturbation >> 16) & 0xff;
-  buf[15] = (perturbation >> 8) & 0xff;
-  buf[16] = perturbation & 0xff;
+  return Hash32 ((char*) buf, 8);
+}
 
-  // Linux calculates jhash2 (jenkins hash), we calculate murmur3 because it is
-  // already available in ns-3
-  uint32_t hash = Hash32 ((char*) buf, 17);
+bool
+Ipv4QueueDiscItem::IsRedundantAck (Ptr<const QueueDiscItem> ack) const
+{
+  NS_LOG_FUNCTION (this << ack);
 
-  NS_LOG_DEBUG ("Hash value " << hash);
+  Ptr<const Ipv4QueueDiscItem> other = DynamicCast<const Ipv4QueueDiscItem> (ack);
 
-  return hash;
+  if (!other
+      || m_header.GetProtocol () != 6 || other->m_header.GetProtocol () != 6
+      || m_header.GetFragmentOffset () != 0 || other->m_header.GetFragmentOffset () != 0
+      || m_header.GetSource () != other->m_header.GetSource ()
+      || m_header.GetDestination () != other->m_header.GetDestination ())
+    {
+      return false;
+    }
+
+  TcpHeader tcpHdr, otherTcpHdr;
+  GetPacket ()->PeekHeader (tcpHdr);
+  other->GetPacket ()->PeekHeader (otherTcpHdr);
+
+  return tcpHdr.GetSourcePort () == otherTcpHdr.GetSourcePort ()
+         && tcpHdr.GetDestinationPort () == otherTcpHdr.GetDestinationPort ()
+         && tcpHdr.GetFlags () == otherTcpHdr.GetFlags ()
+         && IsPureAck (GetPacket (), tcpHdr)
+         && IsPureAck (other->GetPacket (), otherTcpHdr)
+         && RedundantAckNumber (tcpHdr, otherTcpHdr);
+}
+
+bool
+Ipv4QueueDiscItem::GetTcpTimestamp (uint32_t &connection, uint32_t &tsval, uint32_t &tsecr) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_header.GetProtocol () != 6 || m_header.GetFragmentOffset () != 0)
+    {
+      return false;
+    }
+
+  TcpHeader tcpHdr;
+  GetPacket ()->PeekHeader (tcpHdr);
+
+  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (tcpHdr.GetOption (TcpOption::TS));
+  if (!ts)
+    {
+      return false;
+    }
+
+  uint8_t src[6];
+  uint8_t dest[6];
+  m_header.GetSource ().Serialize (src);
+  m_header.GetDestination ().Serialize (dest);
+  src[4] = (tcpHdr.GetSourcePort () >> 8) & 0xff;
+  src[5] = tcpHdr.GetSourcePort () & 0xff;
+  dest[4] = (tcpHdr.GetDestinationPort () >> 8) & 0xff;
+  dest[5] = tcpHdr.GetDestinationPort () & 0xff;
+
+  connection = ConnectionHash (src, dest);
+  tsval = ts->GetTimestamp ();
+  tsecr = ts->GetEcho ();
+  return true;
 }
 
 } // namespace ns3
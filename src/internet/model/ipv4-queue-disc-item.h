@@ -94,6 +94,41 @@ public:
    */
   virtual uint32_t Hash (uint32_t perturbation) const;
 
+  /**
+   * \brief Computes the hash of the source or of the destination IPv4 address
+   *
+   * \param source true to hash the source address, false to hash the destination address
+   * \param perturbation hash perturbation value
+   * \return the hash of the source or of the destination address
+   */
+  virtual uint32_t HostHash (bool source, uint32_t perturbation) const;
+
+  /**
+   * \brief Check whether this item is a TCP acknowledgment made redundant by the given item
+   *
+   * Both items must be IPv4 packets carrying a TCP segment with no payload, no
+   * flag other than ACK, ECE and CWR and no SACK option. They must belong to the
+   * same connection, carry the same flags and the acknowledgment number of the
+   * given item must not be lower than that of this item.
+   *
+   * \param ack the most recent acknowledgment
+   * \return true if this item is made redundant by the given item
+   */
+  virtual bool IsRedundantAck (Ptr<const QueueDiscItem> ack) const;
+
+  /**
+   * \brief Get the TCP timestamp option carried by the packet
+   *
+   * The connection identifier is the hash of the IPv4 addresses and of the
+   * ports, serialized in an order which does not depend on the direction.
+   *
+   * \param connection the identifier of the TCP connection
+   * \param tsval the timestamp value
+   * \param tsecr the timestamp echo reply
+   * \return true if the packet carries a TCP segment with the timestamp option
+   */
+  virtual bool GetTcpTimestamp (uint32_t &connection, uint32_t &tsval, uint32_t &tsecr) const;
+
 private:
   /**
    * \brief Default constructor
@@ -33,6 +33,8 @@
 #include "ns3/traffic-control-layer.h"
 
 #include "loopback-net-device.h"
+#include "ipv6-queue-disc-item.h"
+#include "ns3/link-estimator.h"
 #include "ipv6-l3-protocol.h"
 #include "ipv6-interface.h"
 #include "ipv6-raw-socket-impl.h"
@@ -152,6 +154,7 @@ void Ipv6L3Protocol::DoDispose ()
     }
   m_interfaces.clear ();
   m_reverseInterfacesContainer.clear ();
+  m_linkEstimators.clear ();
 
   /* remove raw sockets */
   for (SocketList::iterator it = m_sockets.begin (); it != m_sockets.end (); ++it)
@@ -175,6 +178,18 @@ void Ipv6L3Protocol::DoDispose ()
   Object::DoDispose ();
 }
 
+void Ipv6L3Protocol::DoInitialize ()
+{
+  NS_LOG_FUNCTION (this);
+
+  /* a link estimator may have been aggregated to a device after the interface was added */
+  for (uint32_t i = 0; i < m_interfaces.size (); i++)
+    {
+      m_linkEstimators[i] = m_interfaces[i]->GetDevice ()->GetObject<LinkEstimator> ();
+    }
+  Ipv6::DoInitialize ();
+}
+
 void Ipv6L3Protocol::SetRoutingProtocol (Ptr<Ipv6RoutingProtocol> routingProtocol)
 {
   NS_LOG_FUNCTION (this << routingProtocol);
@@ -217,6 +232,7 @@ uint32_t Ipv6L3Protocol::AddIpv6Interface (Ptr<Ipv6Interface> interface)
 
   m_interfaces.push_back (interface);
   m_reverseInterfacesContainer[interface->GetDevice ()] = index;
+  m_linkEstimators.push_back (interface->GetDevice ()->GetObject<LinkEstimator> ());
   m_nInterfaces++;
   return index;
 }
@@ -969,6 +985,12 @@ void Ipv6L3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16
       packet->RemoveAtEnd (packet->GetSize () - hdr.GetPayloadLength ());
     }
 
+  // let the link estimator of the device, if any, match the TCP timestamp echoes
+  if (m_linkEstimators[interface])
+    {
+      m_linkEstimators[interface]->NotifyIngress (Create<Ipv6QueueDiscItem> (packet, from, PROT_NUMBER, hdr));
+    }
+
   // the packet is valid, we update the NDISC cache entry (if present)
   Ptr<NdiscCache> ndiscCache = ipv6Interface->GetNdiscCache ();
   if (ndiscCache)
@@ -1338,6 +1360,9 @@ void Ipv6L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv6Header const& i
 {
   NS_LOG_FUNCTION (this << packet << ip << iif);
   Ptr<Packet> p = packet->Copy ();
+  // the flow hash is not valid anymore if the packet is sent again by the
+  // upper layers (e.g., echoed back)
+  p->SetFlowHash (0);
   Ptr<IpL4Protocol> protocol = 0;
   Ptr<Ipv6ExtensionDemux> ipv6ExtensionDemux = m_node->GetObject<Ipv6ExtensionDemux> ();
   Ptr<Ipv6Extension> ipv6Extension = 0;
@@ -42,6 +42,7 @@ class Ipv6Route;
 class Ipv6MulticastRoute;
 class Ipv6RawSocketImpl;
 class Icmpv6L4Protocol;
+class LinkEstimator;
 class Ipv6AutoconfiguredPrefix;
 
 /**
@@ -454,6 +455,11 @@ protected:
    */
   virtual void DoDispose ();
 
+  /**
+   * \brief Look up the link estimator of the device of each interface.
+   */
+  virtual void DoInitialize ();
+
   /**
    * \brief Notify other components connected to the node that a new stack member is now connected.
    *
@@ -696,6 +702,11 @@ private:
    */
   Ipv6InterfaceList m_interfaces;
 
+  /**
+   * \brief Link estimator of the device of each interface, if any.
+   */
+  std::vector<Ptr<LinkEstimator> > m_linkEstimators;
+
   /**
    * Container of NetDevice / Interface index associations.
    */
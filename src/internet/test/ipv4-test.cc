@@ -29,6 +29,10 @@
 #include "ns3/arp-l3-protocol.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/loopback-net-device.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/udp-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
 
 using namespace ns3;
 
@@ -135,6 +139,139 @@ Ipv4L3ProtocolTestCase::DoRun (void)
 }
 
   
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the flow hash of an IPv4 packet is computed once and
+ * carried by the packet
+ */
+class Ipv4FlowHashTestCase : public TestCase
+{
+public:
+  Ipv4FlowHashTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4FlowHashTestCase::Ipv4FlowHashTestCase ()
+  : TestCase ("Verify the flow hash of IPv4 packets")
+{
+}
+
+void
+Ipv4FlowHashTestCase::DoRun (void)
+{
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.0.0.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.0.0.2"));
+  ipHeader.SetProtocol (17);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (1000);
+  udpHeader.SetDestinationPort (2000);
+
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (udpHeader);
+  Ptr<Ipv4QueueDiscItem> item = Create<Ipv4QueueDiscItem> (p, Address (), 0, ipHeader);
+  uint32_t hash = item->Hash (0);
+  NS_TEST_EXPECT_MSG_EQ (p->GetFlowHash (), hash, "The flow hash should be carried by the packet");
+  NS_TEST_EXPECT_MSG_NE (item->Hash (1), hash, "The perturbation should change the hash");
+
+  // a packet of another flow has another hash
+  Ptr<Packet> q = Create<Packet> (100);
+  q->AddHeader (udpHeader);
+  ipHeader.SetDestination (Ipv4Address ("10.0.0.3"));
+  Ptr<Ipv4QueueDiscItem> other = Create<Ipv4QueueDiscItem> (q, Address (), 0, ipHeader);
+  NS_TEST_EXPECT_MSG_NE (other->Hash (0), hash, "Different flows should have different hashes");
+
+  // the next hops reuse the flow hash carried by the packet and its copies,
+  // without parsing the headers again (the IP header now has the destination
+  // of the other flow, yet the hash of the first flow is used)
+  Ptr<Ipv4QueueDiscItem> nextHop = Create<Ipv4QueueDiscItem> (p->Copy (), Address (), 0, ipHeader);
+  NS_TEST_EXPECT_MSG_EQ (nextHop->Hash (0), hash, "The flow hash carried by the packet should be used");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check which TCP acknowledgments carried by IPv4 packets are made
+ * redundant by a more recent acknowledgment
+ */
+class Ipv4RedundantAckTestCase : public TestCase
+{
+public:
+  Ipv4RedundantAckTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a queue disc item carrying a pure TCP acknowledgment
+   * \param ack the acknowledgment number
+   * \param sack the SACK blocks, if any
+   * \return the queue disc item
+   */
+  Ptr<Ipv4QueueDiscItem> CreateAck (uint32_t ack, TcpOptionSack::SackList sack = TcpOptionSack::SackList ());
+};
+
+Ipv4RedundantAckTestCase::Ipv4RedundantAckTestCase ()
+  : TestCase ("Verify the redundant TCP acknowledgments carried by IPv4 packets")
+{
+}
+
+Ptr<Ipv4QueueDiscItem>
+Ipv4RedundantAckTestCase::CreateAck (uint32_t ack, TcpOptionSack::SackList sack)
+{
+  TcpHeader tcpHeader;
+  tcpHeader.SetSourcePort (1000);
+  tcpHeader.SetDestinationPort (2000);
+  tcpHeader.SetFlags (TcpHeader::ACK);
+  tcpHeader.SetAckNumber (SequenceNumber32 (ack));
+  if (!sack.empty ())
+    {
+      Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+      for (TcpOptionSack::SackList::const_iterator it = sack.begin (); it != sack.end (); it++)
+        {
+          option->AddSackBlock (*it);
+        }
+      tcpHeader.AppendOption (option);
+    }
+
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (tcpHeader);
+
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.0.0.2"));
+  ipHeader.SetDestination (Ipv4Address ("10.0.0.1"));
+  ipHeader.SetProtocol (6);
+  return Create<Ipv4QueueDiscItem> (p, Address (), 0, ipHeader);
+}
+
+void
+Ipv4RedundantAckTestCase::DoRun (void)
+{
+  TcpOptionSack::SackList sack1, sack12, sack2;
+  sack1.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (2000), SequenceNumber32 (3000)));
+  sack12.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (2000), SequenceNumber32 (4000)));
+  sack2.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (5000), SequenceNumber32 (6000)));
+
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000)->IsRedundantAck (CreateAck (2000)), true,
+                         "An acknowledgment of more data makes the older one redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (2000)->IsRedundantAck (CreateAck (1000)), false,
+                         "An acknowledgment of less data does not make the older one redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000)->IsRedundantAck (CreateAck (1000)), false,
+                         "A duplicate acknowledgment does not make the older one redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000, sack1)->IsRedundantAck (CreateAck (1000, sack1)), false,
+                         "A duplicate acknowledgment with the same SACK blocks does not make the older one redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000)->IsRedundantAck (CreateAck (1000, sack1)), true,
+                         "A duplicate acknowledgment with more SACK information makes the older one redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000, sack1)->IsRedundantAck (CreateAck (1000, sack12)), true,
+                         "A duplicate acknowledgment with more SACK information makes the older one redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000, sack1)->IsRedundantAck (CreateAck (1000, sack2)), false,
+                         "An acknowledgment not covering the SACK blocks of the older one does not make it redundant");
+  NS_TEST_EXPECT_MSG_EQ (CreateAck (1000, sack1)->IsRedundantAck (CreateAck (2000, sack2)), false,
+                         "An acknowledgment not covering the SACK blocks of the older one does not make it redundant");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -148,6 +285,8 @@ public:
     TestSuite ("ipv4-protocol", UNIT)
   {
     AddTestCase (new Ipv4L3ProtocolTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv4FlowHashTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv4RedundantAckTestCase (), TestCase::QUICK);
   }
 };
 
@@ -0,0 +1,742 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/system-thread.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/// The largest timestamp
+static const uint64_t MAX_TS = 0x7fffffffffffffffLL;
+
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+
+MultithreadedSimulatorImpl::EventQueue::EventQueue ()
+{
+  m_head = m_tail = new Node;
+  m_head->next.store (0, std::memory_order_relaxed);
+}
+
+MultithreadedSimulatorImpl::EventQueue::~EventQueue ()
+{
+  Scheduler::Event ev;
+  while (Pop (ev))
+    {
+      ev.impl->Unref ();
+    }
+  delete m_head;
+}
+
+void
+MultithreadedSimulatorImpl::EventQueue::Push (const Scheduler::Event &ev)
+{
+  Node *node = new Node;
+  node->ev = ev;
+  node->next.store (0, std::memory_order_relaxed);
+  m_tail->next.store (node, std::memory_order_release);
+  m_tail = node;
+}
+
+bool
+MultithreadedSimulatorImpl::EventQueue::Pop (Scheduler::Event &ev)
+{
+  Node *next = m_head->next.load (std::memory_order_acquire);
+  if (next == 0)
+    {
+      return false;
+    }
+  ev = next->ev;
+  delete m_head;
+  m_head = next;
+  return true;
+}
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_lookAhead (TimeStep (MAX_TS)),
+    m_grantedTs (0),
+    m_stopTs (MAX_TS),
+    m_finished (false),
+    m_nWindows (0),
+    m_barrierCount (0),
+    m_barrierGeneration (0)
+{
+  NS_LOG_FUNCTION (this);
+
+  // before ::Run is entered, all the events are inserted in partition 0
+  Partition *p = new Partition ();
+  p->id = 0;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  p->uid = 4;
+  p->currentUid = 0;
+  p->currentTs = 0;
+  p->currentContext = Simulator::NO_CONTEXT;
+  p->unscheduledEvents = 0;
+  p->stop = false;
+  p->stopTs = MAX_TS;
+  p->nextTs = MAX_TS;
+  m_partitions.push_back (p);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Partition *p = *i;
+      for (std::vector<EventQueue *>::iterator q = p->inbox.begin (); q != p->inbox.end (); q++)
+        {
+          delete *q;
+        }
+      while (p->events != 0 && !p->events->IsEmpty ())
+        {
+          Scheduler::Event next = p->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete p;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (void) const
+{
+  return m_current != 0 ? m_current : m_partitions[0];
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context < m_contextPartition.size ())
+    {
+      return m_partitions[m_contextPartition[context]];
+    }
+  return m_partitions[0];
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t nPartitions = m_partitions.size ();
+  m_contextPartition.resize (NodeList::GetNNodes ());
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      uint32_t systemId = NodeList::GetNode (i)->GetSystemId ();
+      m_contextPartition[i] = systemId;
+      nPartitions = std::max (nPartitions, systemId + 1);
+    }
+
+  while (m_partitions.size () < nPartitions)
+    {
+      Partition *p = new Partition ();
+      p->id = m_partitions.size ();
+      p->events = m_schedulerFactory.Create<Scheduler> ();
+      p->uid = 4;
+      p->currentUid = 0;
+      p->currentTs = m_partitions[0]->currentTs;
+      p->currentContext = Simulator::NO_CONTEXT;
+      p->unscheduledEvents = 0;
+      p->stop = false;
+      p->stopTs = MAX_TS;
+      p->nextTs = MAX_TS;
+      m_partitions.push_back (p);
+    }
+  for (uint32_t i = 0; i < nPartitions; i++)
+    {
+      Partition *p = m_partitions[i];
+      while (p->inbox.size () < nPartitions)
+        {
+          p->inbox.push_back (p->inbox.size () == i ? 0 : new EventQueue);
+        }
+    }
+
+  // move the events scheduled for the nodes of the other partitions out of
+  // partition 0, keeping their keys because EventIds may refer to them
+  Partition *p0 = m_partitions[0];
+  Ptr<Scheduler> events = m_schedulerFactory.Create<Scheduler> ();
+  while (!p0->events->IsEmpty ())
+    {
+      Scheduler::Event ev = p0->events->RemoveNext ();
+      Partition *p = GetPartition (ev.key.m_context);
+      if (p != p0)
+        {
+          p->events->Insert (ev);
+          p->uid = std::max (p->uid, p0->uid);
+          p->unscheduledEvents++;
+          p0->unscheduledEvents--;
+        }
+      else
+        {
+          events->Insert (ev);
+        }
+    }
+  p0->events = events;
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_lookAhead = GetMaximumSimulationTime ();
+  if (m_partitions.size () <= 1)
+    {
+      return;
+    }
+
+  for (NodeList::Iterator node = NodeList::Begin (); node != NodeList::End (); node++)
+    {
+      for (uint32_t i = 0; i < (*node)->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> localNetDevice = (*node)->GetDevice (i);
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (std::size_t j = 0; j < channel->GetNDevices (); j++)
+            {
+              Ptr<Node> remoteNode = channel->GetDevice (j)->GetNode ();
+              // if it's not remote, don't consider it
+              if (remoteNode == 0 || remoteNode->GetSystemId () == (*node)->GetSystemId ())
+                {
+                  continue;
+                }
+              NS_ABORT_MSG_UNLESS (localNetDevice->IsPointToPoint (),
+                                   "Only point-to-point links can connect nodes of different partitions");
+
+              // compare delay on the channel with current value of
+              // m_lookAhead.  if delay on channel is smaller, make
+              // it the new lookAhead.
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              if (delay.Get () < m_lookAhead)
+                {
+                  m_lookAhead = delay.Get ();
+                }
+            }
+        }
+    }
+
+  NS_ABORT_MSG_UNLESS (m_lookAhead.IsStrictlyPositive (),
+                       "The links connecting nodes of different partitions must have a positive delay");
+  NS_LOG_DEBUG ("lookahead " << m_lookAhead);
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->events != 0)
+        {
+          while (!(*i)->events->IsEmpty ())
+            {
+              Scheduler::Event next = (*i)->events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      (*i)->events = scheduler;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Insert (Partition *p, Scheduler::Event &ev)
+{
+  ev.key.m_uid = p->uid;
+  p->uid++;
+  p->unscheduledEvents++;
+  p->events->Insert (ev);
+}
+
+void
+MultithreadedSimulatorImpl::ReceiveEvents (Partition *p)
+{
+  // the events are received in the order of the source partitions, so that
+  // their uids do not depend on the scheduling of the threads
+  for (std::vector<EventQueue *>::iterator i = p->inbox.begin (); i != p->inbox.end (); i++)
+    {
+      Scheduler::Event ev;
+      while (*i != 0 && (*i)->Pop (ev))
+        {
+          Insert (p, ev);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Synchronize (bool window)
+{
+  uint32_t generation = m_barrierGeneration.load (std::memory_order_acquire);
+  if (m_barrierCount.fetch_add (1, std::memory_order_acq_rel) + 1 == m_partitions.size ())
+    {
+      // the last thread reaching the barrier releases the others
+      if (window)
+        {
+          ComputeWindow ();
+        }
+      m_barrierCount.store (0, std::memory_order_relaxed);
+      m_barrierGeneration.store (generation + 1, std::memory_order_release);
+    }
+  else
+    {
+      while (m_barrierGeneration.load (std::memory_order_acquire) == generation)
+        {
+          std::this_thread::yield ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ComputeWindow (void)
+{
+  uint64_t nextTs = MAX_TS;
+  bool stop = false;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      nextTs = std::min (nextTs, (*i)->nextTs);
+      m_stopTs = std::min (m_stopTs, (*i)->stopTs);
+      stop |= (*i)->stop;
+    }
+
+  if (stop)
+    {
+      m_finished = true;
+      return;
+    }
+
+  if (nextTs >= m_stopTs)
+    {
+      // all the events scheduled before the stop time have been executed
+      for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+        {
+          (*i)->currentTs = m_stopTs;
+          (*i)->stopTs = MAX_TS;
+        }
+      m_stopTs = MAX_TS;
+      m_finished = true;
+      return;
+    }
+
+  if (nextTs == MAX_TS)
+    {
+      m_finished = true;
+      return;
+    }
+
+  uint64_t lookAhead = m_lookAhead.GetTimeStep ();
+  m_grantedTs = (lookAhead >= MAX_TS - nextTs) ? MAX_TS : nextTs + lookAhead;
+  m_nWindows++;
+  NS_LOG_LOGIC ("window [" << nextTs << ", " << m_grantedTs << ")");
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *p)
+{
+  m_current = p;
+  while (true)
+    {
+      // the events sent during the last window are all available, because
+      // all the partitions went through the barrier at the end of the window
+      ReceiveEvents (p);
+      p->nextTs = (p->stop || p->events->IsEmpty ()) ? MAX_TS : p->events->PeekNext ().key.m_ts;
+
+      Synchronize (true);
+      if (m_finished)
+        {
+          break;
+        }
+
+      while (!p->stop && !p->events->IsEmpty ())
+        {
+          uint64_t endTs = std::min (m_grantedTs, std::min (m_stopTs, p->stopTs));
+          if (p->events->PeekNext ().key.m_ts >= endTs)
+            {
+              break;
+            }
+          Scheduler::Event next = p->events->RemoveNext ();
+
+          NS_ASSERT (next.key.m_ts >= p->currentTs);
+          p->unscheduledEvents--;
+
+          NS_LOG_LOGIC ("handle " << next.key.m_ts);
+          p->currentTs = next.key.m_ts;
+          p->currentContext = next.key.m_context;
+          p->currentUid = next.key.m_uid;
+          next.impl->Invoke ();
+          next.impl->Unref ();
+        }
+
+      Synchronize (false);
+    }
+  m_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::DoRunPartition (MultithreadedSimulatorImpl *impl, Partition *p)
+{
+  impl->RunPartition (p);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  CreatePartitions ();
+  CalculateLookAhead ();
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      (*i)->stop = false;
+    }
+  m_finished = false;
+  m_nWindows = 0;
+  m_grantedTs = 0;
+
+  // partition 0 is simulated by the calling thread
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_partitions.size (); i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::DoRunPartition,
+                                                                  this, m_partitions[i])));
+      threads.back ()->Start ();
+    }
+  RunPartition (m_partitions[0]);
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); i++)
+    {
+      (*i)->Join ();
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      NS_ASSERT (!(*i)->events->IsEmpty () || (*i)->unscheduledEvents == 0);
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return GetPartition ()->id;
+}
+
+bool
+MultithreadedSimulatorImpl::IsMultithreaded (void) const
+{
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  GetPartition ()->stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+
+  Partition *p = GetPartition ();
+  p->stopTs = std::min (p->stopTs, p->currentTs + delay.GetTimeStep ());
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+
+  Partition *p = GetPartition ();
+  Time tAbsolute = delay + TimeStep (p->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (p->currentTs));
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = static_cast<uint64_t> (tAbsolute.GetTimeStep ());
+  ev.key.m_context = p->currentContext;
+  Insert (p, ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  Partition *p = GetPartition ();
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << p->currentTs << event);
+
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = p->currentTs + delay.GetTimeStep ();
+  ev.key.m_context = context;
+
+  Partition *dst = GetPartition (context);
+  if (m_current == 0 || dst == p)
+    {
+      Insert (dst, ev);
+    }
+  else
+    {
+      NS_ABORT_MSG_IF (ev.key.m_ts < m_grantedTs, "Event for partition " << dst->id
+                       << " scheduled within the lookahead of partition " << p->id);
+      dst->inbox[p->id]->Push (ev);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+
+  Partition *p = GetPartition ();
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = p->currentTs;
+  ev.key.m_context = p->currentContext;
+  Insert (p, ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+
+  EventId id (Ptr<EventImpl> (event, false), GetPartition ()->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetPartition (id.GetContext ())->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *p = GetPartition (id.GetContext ());
+  NS_ASSERT_MSG (m_current == 0 || m_current == p, "Cannot remove an event of partition " << p->id);
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  p->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  p->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  Partition *p = GetPartition (id.GetContext ());
+  if (id.PeekEventImpl () == 0
+      || id.GetTs () < p->currentTs
+      || (id.GetTs () == p->currentTs
+          && id.GetUid () <= p->currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_current != 0)
+    {
+      return m_current->events->IsEmpty () || m_current->stop;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); i++)
+    {
+      if ((*i)->stop)
+        {
+          return true;
+        }
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (MAX_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetPartition ()->currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetNPartitions (void) const
+{
+  return m_partitions.size ();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return m_lookAhead;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetNWindows (void) const
+{
+  return m_nWindows;
+}
+
+} // namespace ns3
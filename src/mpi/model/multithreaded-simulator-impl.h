@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Shared memory parallel simulator implementation using lookahead
+ *
+ * The nodes are partitioned according to their system id and each partition
+ * is simulated by a thread of the same process: partition 0 is simulated by
+ * the thread calling Simulator::Run and the other partitions by threads
+ * started by Run. Each partition has its own scheduler, clock and event uids.
+ *
+ * The partitions are synchronized by the same granted time window algorithm
+ * as the DistributedSimulatorImpl. The lookahead is the smallest delay of
+ * the point-to-point channels connecting nodes of different partitions.
+ * At the beginning of each window, the partitions agree on the smallest
+ * timestamp T of their next events and then concurrently execute their
+ * events with timestamp lower than T + lookahead. Events scheduled for a
+ * node of a different partition are handed off through a lock-free single
+ * producer single consumer queue per pair of partitions and are inserted
+ * in the scheduler of the destination partition at the end of the window,
+ * in the order of the source partitions. The execution is hence
+ * deterministic and does not depend on the number of cores.
+ *
+ * Packets are handed off to a different partition by the
+ * PointToPointChannel as deep copies (see Packet::CreateFullCopy), so
+ * that no packet data is shared by two threads. Packet metadata must not
+ * be enabled and no other state (objects, trace sinks, etc.) must be
+ * shared by nodes of different partitions. Only point-to-point links
+ * may connect nodes of different partitions.
+ *
+ * Simulator::Stop (delay) stops all the partitions at the same time, unless
+ * it is called by an event with a delay shorter than the lookahead, in which
+ * case the other partitions may execute the events of the current window
+ * beyond the stop time. Simulator::Stop () stops the calling partition
+ * immediately and the other partitions at the end of the current window.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual bool IsMultithreaded (void) const;
+
+  /**
+   * \brief Get the number of partitions (i.e., of threads) of the last run
+   * \return the number of partitions
+   */
+  uint32_t GetNPartitions (void) const;
+
+  /**
+   * \brief Get the lookahead of the last run
+   * \return the lookahead
+   */
+  Time GetLookAhead (void) const;
+
+  /**
+   * \brief Get the number of time windows of the last run
+   * \return the number of time windows
+   */
+  uint64_t GetNWindows (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * \brief Lock-free unbounded queue of events with a single producer
+   *        and a single consumer
+   */
+  class EventQueue
+  {
+public:
+    EventQueue ();
+    ~EventQueue ();
+    /**
+     * \brief Push an event (producer only)
+     * \param ev the event
+     */
+    void Push (const Scheduler::Event &ev);
+    /**
+     * \brief Pop an event (consumer only)
+     * \param ev the event
+     * \return false if the queue is empty
+     */
+    bool Pop (Scheduler::Event &ev);
+private:
+    /// Element of the queue
+    struct Node
+    {
+      Scheduler::Event ev;        //!< the event
+      std::atomic<Node *> next;   //!< the next element
+    };
+    Node *m_head;                 //!< the last popped element (consumer)
+    Node *m_tail;                 //!< the last pushed element (producer)
+  };
+
+  /// State of a partition
+  struct Partition
+  {
+    uint32_t id;                  //!< the partition (system) id
+    Ptr<Scheduler> events;        //!< the events of the partition
+    uint32_t uid;                 //!< the next event uid
+    uint32_t currentUid;          //!< the uid of the current event
+    uint64_t currentTs;           //!< the timestamp of the current event
+    uint32_t currentContext;      //!< the context of the current event
+    int unscheduledEvents;        //!< the number of events not yet executed
+    bool stop;                    //!< whether Stop () was called
+    uint64_t stopTs;              //!< the time requested by Stop (delay)
+    uint64_t nextTs;              //!< the timestamp of the next event
+    std::vector<EventQueue *> inbox;  //!< the events coming from each partition
+  };
+
+  /**
+   * \brief Get the partition of the calling thread
+   * \return the partition (partition 0 if the simulation is not running)
+   */
+  Partition * GetPartition (void) const;
+  /**
+   * \brief Get the partition a context belongs to
+   * \param context the context
+   * \return the partition
+   */
+  Partition * GetPartition (uint32_t context) const;
+  /**
+   * \brief Create the partitions and distribute the events among them
+   */
+  void CreatePartitions (void);
+  /**
+   * \brief Compute the lookahead from the delay of the point-to-point
+   *        channels connecting nodes of different partitions
+   */
+  void CalculateLookAhead (void);
+  /**
+   * \brief Insert an event into the scheduler of a partition
+   * \param p the partition
+   * \param ev the event (its uid is set by this method)
+   */
+  void Insert (Partition *p, Scheduler::Event &ev);
+  /**
+   * \brief Insert the events coming from the other partitions
+   * \param p the partition
+   */
+  void ReceiveEvents (Partition *p);
+  /**
+   * \brief Simulate a partition until the end of the simulation
+   * \param p the partition
+   */
+  void RunPartition (Partition *p);
+  /**
+   * \brief Entry point of the threads simulating a partition
+   * \param impl the simulator
+   * \param p the partition
+   */
+  static void DoRunPartition (MultithreadedSimulatorImpl *impl, Partition *p);
+  /**
+   * \brief Wait until all the partitions reach the barrier
+   * \param window whether the next window has to be computed
+   */
+  void Synchronize (bool window);
+  /**
+   * \brief Compute the next time window (called by a single thread)
+   */
+  void ComputeWindow (void);
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;          //!< the destroy events
+  SystemMutex m_destroyEventsMutex;       //!< mutex protecting the destroy events
+  ObjectFactory m_schedulerFactory;       //!< the factory of the schedulers
+  std::vector<Partition *> m_partitions;  //!< the partitions
+  std::vector<uint32_t> m_contextPartition;  //!< the partition of each context
+  Time m_lookAhead;                       //!< the lookahead
+  uint64_t m_grantedTs;                   //!< the end of the current window
+  uint64_t m_stopTs;                      //!< the time the simulation stops at
+  bool m_finished;                        //!< whether the simulation is over
+  uint64_t m_nWindows;                    //!< the number of windows
+  std::atomic<uint32_t> m_barrierCount;   //!< the threads waiting at the barrier
+  std::atomic<uint32_t> m_barrierGeneration;  //!< the barrier generation
+
+  static thread_local Partition *m_current;  //!< the partition of the calling thread
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
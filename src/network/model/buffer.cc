@@ -50,7 +50,7 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+NS_THREAD_LOCAL uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -59,7 +59,8 @@ uint32_t Buffer::g_recommendedStart = 0;
  *    on-demand when the first buffer is created)
  *  - initialized means that the free list exists and is valid
  *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
+ *    (or the thread local destructors of this thread) have run so, the free
+ *    list has been cleared from its content
  * The key is that in destroyed state, we are careful not re-create it
  * which is a typical weakness of lazy evaluation schemes which use 
  * '0' as a special value to indicate both un-initialized and destroyed.
@@ -75,9 +76,9 @@ uint32_t Buffer::g_recommendedStart = 0;
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
 #define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
 #define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+NS_THREAD_LOCAL uint32_t Buffer::g_maxSize = 0;
+NS_THREAD_LOCAL Buffer::FreeList *Buffer::g_freeList = 0;
+NS_THREAD_LOCAL struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
@@ -99,11 +100,11 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
   g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
+  /* feed into free list (the free list of this thread is uninitialized
+   * if the data was created by another thread) */
   if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
+      !IS_INITIALIZED (g_freeList) ||
       g_freeList->size () > 1000)
     {
       Buffer::Deallocate (data);
@@ -123,6 +124,8 @@ Buffer::Create (uint32_t dataSize)
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
+      // make sure the destructor of the free list of this thread is registered
+      (void) &g_localStaticDestructor;
     }
   else if (IS_INITIALIZED (g_freeList))
     {
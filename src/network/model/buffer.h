@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "ns3/thread-local.h"
 
 #define BUFFER_FREE_LIST 1
 
@@ -767,7 +768,7 @@ private:
    * writing data. i.e., m_start should be initialized to this 
    * value.
    */
-  static uint32_t g_recommendedStart;
+  static NS_THREAD_LOCAL uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -798,9 +799,11 @@ private:
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  // the free list is kept per thread (see NS_THREAD_LOCAL), so that packets
+  // can be created and destroyed by the threads of a multithreaded simulation
+  static NS_THREAD_LOCAL uint32_t g_maxSize; //!< Max observed data size
+  static NS_THREAD_LOCAL FreeList *g_freeList; //!< Buffer data container
+  static NS_THREAD_LOCAL struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
 
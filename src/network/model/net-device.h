@@ -22,6 +22,7 @@
 #define NET_DEVICE_H
 
 #include <stdint.h>
+#include <vector>
 #include "ns3/callback.h"
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -34,6 +35,7 @@ namespace ns3 {
 
 class Node;
 class Channel;
+class QueueDiscItem;
 
 /**
  * \ingroup network
@@ -260,6 +262,19 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) = 0;
+  /**
+   * \param items packets sent from above down to Network Device, each
+   *        along with the (already resolved) mac address of its destination
+   *        and the protocol number of its payload
+   *
+   *  Called from higher layer (typically the root queue disc) to send a
+   *  batch of packets into Network Device, in order. The default
+   *  implementation calls Send for each packet. Devices may override
+   *  this method to save the per-packet checks performed by Send.
+   *
+   * \return the number of packets whose Send operation succeeded
+   */
+  virtual uint32_t SendMany (const std::vector<Ptr<QueueDiscItem> > &items);
   /**
    * \returns the node base class which contains this network
    *          interface.
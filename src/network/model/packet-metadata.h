@@ -27,6 +27,7 @@
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
 #include "buffer.h"
+#include "ns3/thread-local.h"
 
 namespace ns3 {
 
@@ -661,7 +662,13 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  static NS_THREAD_LOCAL DataFreeList m_freeList; //!< the metadata data storage (one per thread, see NS_THREAD_LOCAL)
+  /**
+   * Whether the free list of this thread has been destroyed. Thread local
+   * objects are destroyed before the static objects, which may still hold
+   * packets.
+   */
+  static NS_THREAD_LOCAL bool m_freeListDestroyed;
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -670,9 +677,9 @@ public:
    * m_enable is false; used to detect enabling of metadata in the
    * middle of a simulation, which isn't allowed.
    */
-  static bool m_metadataSkipped;
+  static NS_THREAD_LOCAL bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
+  static NS_THREAD_LOCAL uint32_t m_maxSize; //!< maximum metadata size (one per thread, see NS_THREAD_LOCAL)
   static uint16_t m_chunkUid; //!< Chunk Uid
 
   struct Data *m_data; //!< Metadata storage
@@ -20,15 +20,17 @@
 #include "packet.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/simulator.h"
 #include <string>
+#include <vector>
 #include <cstdarg>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+NS_THREAD_LOCAL uint32_t Packet::m_globalUid = 0;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -126,6 +128,57 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::CreateFullCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  // the buffer, the metadata and the nix-vector are copied by serializing
+  // the packet, as done to send it to another MPI process
+  uint32_t serializedSize = GetSerializedSize ();
+  std::vector<uint32_t> data ((serializedSize + 3) / 4);
+  uint8_t *buffer = reinterpret_cast<uint8_t *> (data.data ());
+  Serialize (buffer, serializedSize);
+  Ptr<Packet> p = Create<Packet> (buffer, serializedSize, true);
+  p->m_flowHash = m_flowHash;
+
+  ByteTagIterator bi = GetByteTagIterator ();
+  while (bi.HasNext ())
+    {
+      ByteTagIterator::Item item = bi.Next ();
+      Callback<ObjectBase *> constructor = item.GetTypeId ().GetConstructor ();
+      NS_ABORT_MSG_IF (constructor.IsNull (), "Tag " << item.GetTypeId ().GetName () << " has no constructor");
+      Tag *tag = dynamic_cast<Tag *> (constructor ());
+      NS_ASSERT (tag != 0);
+      item.GetTag (*tag);
+      TagBuffer tagBuffer = p->m_byteTagList.Add (item.GetTypeId (), tag->GetSerializedSize (),
+                                                  item.GetStart (), item.GetEnd ());
+      tag->Serialize (tagBuffer);
+      delete tag;
+    }
+
+  // packet tags are added in reverse order to preserve their order
+  std::vector<Tag *> tags;
+  PacketTagIterator pi = GetPacketTagIterator ();
+  while (pi.HasNext ())
+    {
+      PacketTagIterator::Item item = pi.Next ();
+      Callback<ObjectBase *> constructor = item.GetTypeId ().GetConstructor ();
+      NS_ABORT_MSG_IF (constructor.IsNull (), "Tag " << item.GetTypeId ().GetName () << " has no constructor");
+      Tag *tag = dynamic_cast<Tag *> (constructor ());
+      NS_ASSERT (tag != 0);
+      item.GetTag (*tag);
+      tags.push_back (tag);
+    }
+  for (std::vector<Tag *>::reverse_iterator it = tags.rbegin (); it != tags.rend (); it++)
+    {
+      p->AddPacketTag (**it);
+      delete *it;
+    }
+
+  return p;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -137,7 +190,8 @@ Packet::Packet ()
      * global UID
      */
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   m_globalUid++;
 }
@@ -146,7 +200,8 @@ Packet::Packet (const Packet &o)
   : m_buffer (o.m_buffer),
     m_byteTagList (o.m_byteTagList),
     m_packetTagList (o.m_packetTagList),
-    m_metadata (o.m_metadata)
+    m_metadata (o.m_metadata),
+    m_flowHash (o.m_flowHash)
 {
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
@@ -163,6 +218,7 @@ Packet::operator = (const Packet &o)
   m_byteTagList = o.m_byteTagList;
   m_packetTagList = o.m_packetTagList;
   m_metadata = o.m_metadata;
+  m_flowHash = o.m_flowHash;
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy () 
     : m_nixVector = 0;
   return *this;
@@ -179,7 +235,8 @@ Packet::Packet (uint32_t size)
      * global UID
      */
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   m_globalUid++;
 }
@@ -188,7 +245,8 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
     m_byteTagList (),
     m_packetTagList (),
     m_metadata (0,0),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   NS_ASSERT (magic);
   Deserialize (buffer, size);
@@ -205,7 +263,8 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * global UID
      */
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
   m_globalUid++;
   m_buffer.AddAtStart (size);
@@ -219,7 +278,8 @@ Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList,
     m_byteTagList (byteTagList),
     m_packetTagList (packetTagList),
     m_metadata (metadata),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_flowHash (0)
 {
 }
 
@@ -237,6 +297,7 @@ Packet::CreateFragment (uint32_t start, uint32_t length) const
   // through Create because it is private.
   Ptr<Packet> ret = Ptr<Packet> (new Packet (buffer, byteTagList, m_packetTagList, metadata), false);
   ret->SetNixVector (GetNixVector ());
+  ret->SetFlowHash (m_flowHash);
   return ret;
 }
 
@@ -252,6 +313,18 @@ Packet::GetNixVector (void) const
   return m_nixVector;
 } 
 
+void
+Packet::SetFlowHash (uint32_t hash)
+{
+  m_flowHash = hash;
+}
+
+uint32_t
+Packet::GetFlowHash (void) const
+{
+  return m_flowHash;
+}
+
 void
 Packet::AddHeader (const Header &header)
 {
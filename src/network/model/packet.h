@@ -34,6 +34,7 @@
 #include "ns3/assert.h"
 #include "ns3/ptr.h"
 #include "ns3/deprecated.h"
+#include "ns3/thread-local.h"
 
 namespace ns3 {
 
@@ -453,6 +454,20 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet which does not share any dataset
+   * with the original packet.
+   *
+   * The datasets shared by COW copies are not protected against
+   * concurrent accesses, hence a deep copy is required to hand a
+   * packet over to a different thread (e.g., by the
+   * MultithreadedSimulatorImpl). The byte tags and the packet tags
+   * are copied by means of the constructor of their TypeId.
+   */
+  Ptr<Packet> CreateFullCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -685,6 +700,28 @@ public:
    */
   Ptr<NixVector> GetNixVector (void) const; 
 
+  /**
+   * \brief Set the flow hash of the packet.
+   *
+   * The flow hash is computed by the first component that needs it (e.g.,
+   * the first queue disc classifying the packet) and is carried by the
+   * packet, its copies and its fragments, like the hash of a Linux sk_buff,
+   * so that the following hops do not need to parse the headers again.
+   * The flow hash is cleared when the packet is delivered to the upper
+   * layers and is not serialized.
+   *
+   * \param hash the flow hash (zero to clear the flow hash)
+   */
+  void SetFlowHash (uint32_t hash);
+  /**
+   * \brief Get the flow hash of the packet.
+   *
+   * See the comment on SetFlowHash
+   *
+   * \returns the flow hash, or zero if no flow hash has been set
+   */
+  uint32_t GetFlowHash (void) const;
+
   /**
    * TracedCallback signature for Ptr<Packet>
    *
@@ -765,8 +802,9 @@ private:
 
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
+  uint32_t m_flowHash;        //!< the packet's flow hash (zero if not set)
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static NS_THREAD_LOCAL uint32_t m_globalUid; //!< Counter of packets Uid (one per thread, see NS_THREAD_LOCAL)
 };
 
 /**
@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/object-factory.h"
 
 using namespace ns3;
 
@@ -83,6 +85,199 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((packet == 0), true, "There are really no packets in there");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * DropTailQueue unit tests with the ring buffer storage.
+ */
+class DropTailQueueRingBufferTestCase : public TestCase
+{
+public:
+  DropTailQueueRingBufferTestCase ();
+  virtual void DoRun (void);
+};
+
+DropTailQueueRingBufferTestCase::DropTailQueueRingBufferTestCase ()
+  : TestCase ("Check the drop tail queue with the ring buffer storage")
+{
+}
+
+void
+DropTailQueueRingBufferTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue<Packet> > queue = CreateObjectWithAttributes<DropTailQueue<Packet> >
+      ("MaxSize", StringValue ("100p"), "UseRingBuffer", BooleanValue (true));
+
+  std::list<Ptr<Packet> > expected;
+
+  // Interleave enqueues and dequeues so that the buffer grows and the
+  // absolute indices wrap around its capacity several times
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      uint32_t nEnqueues = (i % 7) + 1;
+      for (uint32_t j = 0; j < nEnqueues; j++)
+        {
+          Ptr<Packet> p = Create<Packet> (i % 100 + 1);
+          if (queue->Enqueue (p))
+            {
+              expected.push_back (p);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (queue->GetNPackets (), expected.size (), "Unexpected number of packets");
+      NS_TEST_ASSERT_MSG_EQ (queue->Peek (), expected.front (), "Unexpected packet at the head");
+
+      uint32_t nDequeues = (i % 5) + 1;
+      for (uint32_t j = 0; j < nDequeues && !expected.empty (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (queue->Dequeue (), expected.front (), "Packets are not dequeued in FIFO order");
+          expected.pop_front ();
+        }
+    }
+
+  NS_TEST_EXPECT_MSG_EQ ((queue->GetTotalDroppedPackets () > 0), true, "The queue should have been full");
+
+  queue->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "There should be no packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 0, "There should be no bytes in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (), 0, "There are really no packets in there");
+
+  queue->SetUseRingBuffer (false);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetUseRingBuffer (), false, "The storage of an empty queue can be changed");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Queue storing packets in the order given by their size, which inserts and
+ * removes packets at arbitrary positions.
+ */
+class SortedTestQueue : public Queue<Packet>
+{
+public:
+  virtual bool Enqueue (Ptr<Packet> item);
+  virtual Ptr<Packet> Dequeue (void);
+  virtual Ptr<Packet> Remove (void);
+  virtual Ptr<const Packet> Peek (void) const;
+
+  /**
+   * Remove all the packets of the given size while browsing the queue
+   * \param size the size of the packets to remove
+   * \return the number of packets removed
+   */
+  uint32_t RemoveAll (uint32_t size);
+};
+
+bool
+SortedTestQueue::Enqueue (Ptr<Packet> item)
+{
+  auto it = Head ();
+  while (it != Tail () && (*it)->GetSize () <= item->GetSize ())
+    {
+      it++;
+    }
+  return DoEnqueue (it, item);
+}
+
+Ptr<Packet>
+SortedTestQueue::Dequeue (void)
+{
+  return DoDequeue (Head ());
+}
+
+Ptr<Packet>
+SortedTestQueue::Remove (void)
+{
+  return DoRemove (Head ());
+}
+
+Ptr<const Packet>
+SortedTestQueue::Peek (void) const
+{
+  return DoPeek (Head ());
+}
+
+uint32_t
+SortedTestQueue::RemoveAll (uint32_t size)
+{
+  uint32_t count = 0;
+  for (auto it = Head (); it != Tail (); )
+    {
+      if ((*it)->GetSize () == size)
+        {
+          auto curr = it++;
+          DoRemove (curr);
+          count++;
+        }
+      else
+        {
+          it++;
+        }
+    }
+  return count;
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that subclasses can insert and remove items at arbitrary positions
+ * with both the linked list and the ring buffer storage.
+ */
+class QueueIteratorTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param useRingBuffer whether the queue uses the ring buffer storage
+   */
+  QueueIteratorTestCase (bool useRingBuffer);
+  virtual void DoRun (void);
+
+private:
+  bool m_useRingBuffer;  //!< whether the queue uses the ring buffer storage
+};
+
+QueueIteratorTestCase::QueueIteratorTestCase (bool useRingBuffer)
+  : TestCase (std::string ("Check positional operations on a queue using the ")
+              + (useRingBuffer ? "ring buffer" : "linked list") + " storage"),
+    m_useRingBuffer (useRingBuffer)
+{
+}
+
+void
+QueueIteratorTestCase::DoRun (void)
+{
+  Ptr<SortedTestQueue> queue = CreateObject<SortedTestQueue> ();
+  queue->SetMaxSize (QueueSize ("1000p"));
+  queue->SetUseRingBuffer (m_useRingBuffer);
+
+  // Sizes are inserted in a scrambled order, so that packets are stored
+  // at the head, at the tail and in the middle of the queue
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      queue->Enqueue (Create<Packet> ((i * 37) % 10 + 1));
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 100, "There should be 100 packets in there");
+
+  NS_TEST_EXPECT_MSG_EQ (queue->RemoveAll (5), 10, "Unexpected number of removed packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->RemoveAll (1), 10, "Unexpected number of removed packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->RemoveAll (10), 10, "Unexpected number of removed packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 70, "There should be 70 packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 30, "Removed packets should be dropped");
+
+  uint32_t last = 0;
+  while (!queue->IsEmpty ())
+    {
+      Ptr<Packet> p = queue->Dequeue ();
+      NS_TEST_ASSERT_MSG_EQ ((p->GetSize () >= last), true, "Packets are not sorted");
+      NS_TEST_ASSERT_MSG_EQ ((p->GetSize () != 1 && p->GetSize () != 5 && p->GetSize () != 10),
+                             true, "A removed packet is still in the queue");
+      last = p->GetSize ();
+    }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -96,6 +291,9 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueRingBufferTestCase (), TestCase::QUICK);
+    AddTestCase (new QueueIteratorTestCase (false), TestCase::QUICK);
+    AddTestCase (new QueueIteratorTestCase (true), TestCase::QUICK);
   }
 };
 
@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/link-estimator.h"
+#include "ns3/queue-item.h"
+#include "ns3/net-device-queue-interface.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Link Estimator Test Item
+ *
+ * The item carries the given TCP timestamp option.
+ */
+class LinkEstimatorTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param connection the identifier of the TCP connection
+   * \param tsval the timestamp value
+   * \param tsecr the timestamp echo reply
+   */
+  LinkEstimatorTestItem (uint32_t connection, uint32_t tsval, uint32_t tsecr);
+  virtual ~LinkEstimatorTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool GetTcpTimestamp (uint32_t &connection, uint32_t &tsval, uint32_t &tsecr) const;
+
+private:
+  LinkEstimatorTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  LinkEstimatorTestItem (const LinkEstimatorTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  LinkEstimatorTestItem &operator = (const LinkEstimatorTestItem &);
+  uint32_t m_connection;  //!< identifier of the TCP connection
+  uint32_t m_tsval;       //!< timestamp value
+  uint32_t m_tsecr;       //!< timestamp echo reply
+};
+
+LinkEstimatorTestItem::LinkEstimatorTestItem (uint32_t connection, uint32_t tsval, uint32_t tsecr)
+  : QueueDiscItem (Create<Packet> (100), Address (), 0),
+    m_connection (connection),
+    m_tsval (tsval),
+    m_tsecr (tsecr)
+{
+}
+
+LinkEstimatorTestItem::~LinkEstimatorTestItem ()
+{
+}
+
+void
+LinkEstimatorTestItem::AddHeader (void)
+{
+}
+
+bool
+LinkEstimatorTestItem::Mark (void)
+{
+  return false;
+}
+
+bool
+LinkEstimatorTestItem::GetTcpTimestamp (uint32_t &connection, uint32_t &tsval, uint32_t &tsecr) const
+{
+  connection = m_connection;
+  tsval = m_tsval;
+  tsecr = m_tsecr;
+  return true;
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Link Estimator Test Case
+ */
+class LinkEstimatorTestCase : public TestCase
+{
+public:
+  LinkEstimatorTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Send a burst of packets on a device
+   * \param dev the device
+   * \param nPackets the number of packets
+   */
+  void SendPackets (Ptr<NetDevice> dev, uint32_t nPackets);
+  /**
+   * Notify the estimator of a packet sent
+   * \param estimator the link estimator
+   * \param connection the identifier of the TCP connection
+   * \param tsval the timestamp value
+   */
+  void Egress (Ptr<LinkEstimator> estimator, uint32_t connection, uint32_t tsval);
+  /**
+   * Notify the estimator of a packet received
+   * \param estimator the link estimator
+   * \param connection the identifier of the TCP connection
+   * \param tsecr the timestamp echo reply
+   */
+  void Ingress (Ptr<LinkEstimator> estimator, uint32_t connection, uint32_t tsecr);
+  /**
+   * Check the drain rate estimated from the transmissions of a device
+   */
+  void RunDrainRateTest (void);
+  /**
+   * Check the RTT estimated from the TCP timestamps
+   */
+  void RunRttTest (void);
+};
+
+LinkEstimatorTestCase::LinkEstimatorTestCase ()
+  : TestCase ("Sanity check on the link estimator")
+{
+}
+
+void
+LinkEstimatorTestCase::SendPackets (Ptr<NetDevice> dev, uint32_t nPackets)
+{
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      dev->Send (Create<Packet> (1000), dev->GetBroadcast (), 0x800);
+    }
+}
+
+void
+LinkEstimatorTestCase::Egress (Ptr<LinkEstimator> estimator, uint32_t connection, uint32_t tsval)
+{
+  estimator->NotifyEgress (Create<LinkEstimatorTestItem> (connection, tsval, 0));
+}
+
+void
+LinkEstimatorTestCase::Ingress (Ptr<LinkEstimator> estimator, uint32_t connection, uint32_t tsecr)
+{
+  estimator->NotifyIngress (Create<LinkEstimatorTestItem> (connection, 0, tsecr));
+}
+
+void
+LinkEstimatorTestCase::RunDrainRateTest (void)
+{
+  NodeContainer n;
+  n.Create (1);
+
+  SimpleNetDeviceHelper simple;
+  simple.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("1Mbps")));
+  Ptr<NetDevice> dev = simple.Install (n.Get (0)).Get (0);
+
+  Ptr<LinkEstimator> estimator = CreateObject<LinkEstimator> ();
+  dev->GetObject<NetDeviceQueueInterface> ()->AggregateObject (estimator);
+
+  // the transmission of a packet takes 8 ms. A sample is taken every 17
+  // packets transmitted while the device queue is backlogged
+  Simulator::Schedule (Seconds (0.1), &LinkEstimatorTestCase::SendPackets, this, dev, 40);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetDrainRate (), DataRate ("1Mbps"), "Wrong drain rate");
+
+  // packets sent while the device is idle do not affect the estimate
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Simulator::Schedule (MilliSeconds (10 * i), &LinkEstimatorTestCase::SendPackets, this, dev, 1);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetDrainRate (), DataRate ("1Mbps"), "Idle periods should be ignored");
+
+  // the estimate follows a rate increase
+  dev->SetAttribute ("DataRate", DataRateValue (DataRate ("2Mbps")));
+  Simulator::Schedule (Seconds (0.1), &LinkEstimatorTestCase::SendPackets, this, dev, 80);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_GT (estimator->GetDrainRate (), DataRate ("1.8Mbps"), "The estimate should follow the rate increase");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (estimator->GetDrainRate (), DataRate ("2Mbps"), "The estimate should not exceed the rate");
+
+  Simulator::Destroy ();
+}
+
+void
+LinkEstimatorTestCase::RunRttTest (void)
+{
+  Ptr<LinkEstimator> estimator = CreateObject<LinkEstimator> ();
+  estimator->SetAttribute ("MaxTimestamps", UintegerValue (3));
+
+  // only the first packet carrying a timestamp value is considered
+  Simulator::Schedule (Seconds (0), &LinkEstimatorTestCase::Egress, this, estimator, 1, 100);
+  Simulator::Schedule (MilliSeconds (10), &LinkEstimatorTestCase::Egress, this, estimator, 1, 100);
+  // echoes of other connections are ignored
+  Simulator::Schedule (MilliSeconds (20), &LinkEstimatorTestCase::Ingress, this, estimator, 2, 100);
+  Simulator::Schedule (MilliSeconds (50), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 100);
+  // the second echo of the same timestamp is ignored
+  Simulator::Schedule (MilliSeconds (60), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 100);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetRtt (), MilliSeconds (50), "The first sample should set the RTT");
+
+  Simulator::Schedule (MilliSeconds (100), &LinkEstimatorTestCase::Egress, this, estimator, 1, 200);
+  Simulator::Schedule (MilliSeconds (200), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 200);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetRtt (), MicroSeconds (56250), "Wrong moving average of the RTT");
+
+  // the oldest timestamps are forgotten
+  for (uint32_t tsval = 300; tsval < 305; tsval++)
+    {
+      Simulator::Schedule (MilliSeconds (tsval - 300), &LinkEstimatorTestCase::Egress, this, estimator, 1, tsval);
+    }
+  Simulator::Schedule (MilliSeconds (100), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 300);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetRtt (), MicroSeconds (56250), "The timestamp should have been forgotten");
+
+  Simulator::Schedule (Seconds (0), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 304);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetRtt (), NanoSeconds (61218750), "Wrong moving average of the RTT");
+
+  // the echoed timestamps are forgotten at once, hence a timestamp value sent
+  // again after its echo is not forgotten in place of the echoed one
+  estimator = CreateObject<LinkEstimator> ();
+  estimator->SetAttribute ("MaxTimestamps", UintegerValue (2));
+  Simulator::Schedule (Seconds (0), &LinkEstimatorTestCase::Egress, this, estimator, 1, 100);
+  Simulator::Schedule (MilliSeconds (10), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 100);
+  Simulator::Schedule (MilliSeconds (20), &LinkEstimatorTestCase::Egress, this, estimator, 1, 100);
+  Simulator::Schedule (MilliSeconds (30), &LinkEstimatorTestCase::Egress, this, estimator, 1, 200);
+  Simulator::Schedule (MilliSeconds (60), &LinkEstimatorTestCase::Ingress, this, estimator, 1, 100);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (estimator->GetRtt (), MicroSeconds (13750), "The timestamp sent again should be matched");
+
+  Simulator::Destroy ();
+}
+
+void
+LinkEstimatorTestCase::DoRun (void)
+{
+  RunDrainRateTest ();
+  RunRttTest ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Link Estimator Test Suite
+ */
+static class LinkEstimatorTestSuite : public TestSuite
+{
+public:
+  LinkEstimatorTestSuite ()
+    : TestSuite ("link-estimator", UNIT)
+  {
+    AddTestCase (new LinkEstimatorTestCase (), TestCase::QUICK);
+  }
+} g_linkEstimatorTestSuite; ///< the test suite
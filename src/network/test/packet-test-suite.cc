@@ -737,6 +737,19 @@ PacketTest::DoRun (void)
     ALargeTestTag a;
     tmp->AddPacketTag (a); 
   }
+
+  /* Test the flow hash */
+  {
+    Ptr<Packet> tmp = Create<Packet> (100);
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetFlowHash (), 0, "A new packet should have no flow hash");
+    tmp->SetFlowHash (1234);
+    NS_TEST_EXPECT_MSG_EQ (tmp->Copy ()->GetFlowHash (), 1234, "The flow hash should be copied");
+    NS_TEST_EXPECT_MSG_EQ (tmp->CreateFragment (10, 50)->GetFlowHash (), 1234,
+                           "The flow hash should be carried by fragments");
+    Ptr<Packet> other = Create<Packet> (10);
+    *other = *tmp;
+    NS_TEST_EXPECT_MSG_EQ (other->GetFlowHash (), 1234, "The flow hash should be assigned");
+  }
 }
 
 /**
@@ -20,6 +20,7 @@
 #define DROPTAIL_H
 
 #include "ns3/queue.h"
+#include "ns3/boolean.h"
 
 namespace ns3 {
 
@@ -75,6 +76,13 @@ DropTailQueue<Item>::GetTypeId (void)
     .SetParent<Queue<Item> > ()
     .SetGroupName ("Network")
     .template AddConstructor<DropTailQueue<Item> > ()
+    .AddAttribute ("UseRingBuffer",
+                   "True to store the items in a ring buffer that grows geometrically, "
+                   "false to store the items in a linked list",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Queue<Item>::SetUseRingBuffer,
+                                        &Queue<Item>::GetUseRingBuffer),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
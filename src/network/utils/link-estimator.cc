@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "link-estimator.h"
+#include "queue-item.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include <cmath>
+#include <iterator>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LinkEstimator");
+
+NS_OBJECT_ENSURE_REGISTERED (LinkEstimator);
+
+TypeId
+LinkEstimator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LinkEstimator")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LinkEstimator> ()
+    .AddAttribute ("DequeueThreshold",
+                   "Number of bytes transmitted while the device queue is backlogged "
+                   "to take a sample of the drain rate",
+                   UintegerValue (16384),
+                   MakeUintegerAccessor (&LinkEstimator::m_dqThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("RateWeight",
+                   "Weight of a new sample in the moving average of the drain rate",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&LinkEstimator::m_rateWeight),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("RttWeight",
+                   "Weight of a new sample in the moving average of the RTT",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&LinkEstimator::m_rttWeight),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxTimestamps",
+                   "Maximum number of TCP timestamps waiting for an echo",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&LinkEstimator::m_maxTimestamps),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("DrainRate",
+                     "Estimated drain rate",
+                     MakeTraceSourceAccessor (&LinkEstimator::m_drainRateTrace),
+                     "ns3::LinkEstimator::DataRateTracedCallback")
+    .AddTraceSource ("Rtt",
+                     "Estimated RTT",
+                     MakeTraceSourceAccessor (&LinkEstimator::m_rtt),
+                     "ns3::TracedValueCallback::Time")
+  ;
+  return tid;
+}
+
+LinkEstimator::LinkEstimator ()
+  : Object (),
+    m_drainRate (0),
+    m_dqBytes (0),
+    m_lastBytes (0),
+    m_backlogged (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LinkEstimator::~LinkEstimator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LinkEstimator::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_timestamps.clear ();
+  m_timestampOrder.clear ();
+  Object::DoDispose ();
+}
+
+void
+LinkEstimator::NotifyTransmittedBytes (uint32_t bytes, bool backlogged)
+{
+  NS_LOG_FUNCTION (this << bytes << backlogged);
+
+  Time now = Simulator::Now ();
+
+  // the device has been busy since the last transmission if the device queue
+  // was not empty after the last transmission
+  if (m_backlogged)
+    {
+      m_dqBytes += m_lastBytes;
+      m_dqTime += now - m_lastTx;
+    }
+
+  m_lastTx = now;
+  m_lastBytes = bytes;
+  m_backlogged = backlogged;
+
+  if (m_dqBytes >= m_dqThreshold && m_dqTime.IsStrictlyPositive ())
+    {
+      double sample = m_dqBytes * 8 / m_dqTime.GetSeconds ();
+      double rate = static_cast<double> (m_drainRate.GetBitRate ());
+      rate = (rate == 0 ? sample : (1 - m_rateWeight) * rate + m_rateWeight * sample);
+      m_drainRate = DataRate (static_cast<uint64_t> (std::round (rate)));
+      NS_LOG_LOGIC ("Drain rate sample " << sample << "bps, estimate " << m_drainRate);
+      m_drainRateTrace (m_drainRate);
+
+      m_dqBytes = 0;
+      m_dqTime = Time (0);
+    }
+}
+
+void
+LinkEstimator::NotifyEgress (Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t connection, tsval, tsecr;
+  if (!item->GetTcpTimestamp (connection, tsval, tsecr))
+    {
+      return;
+    }
+
+  // only store the first packet carrying a timestamp value
+  uint64_t key = (static_cast<uint64_t> (connection) << 32) | tsval;
+  if (m_timestamps.find (key) != m_timestamps.end ())
+    {
+      return;
+    }
+
+  m_timestampOrder.push_back (key);
+  m_timestamps[key] = {Simulator::Now (), std::prev (m_timestampOrder.end ())};
+  if (m_timestampOrder.size () > m_maxTimestamps)
+    {
+      // forget the oldest timestamp waiting for an echo
+      m_timestamps.erase (m_timestampOrder.front ());
+      m_timestampOrder.pop_front ();
+    }
+}
+
+void
+LinkEstimator::NotifyIngress (Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t connection, tsval, tsecr;
+  if (!item->GetTcpTimestamp (connection, tsval, tsecr))
+    {
+      return;
+    }
+
+  uint64_t key = (static_cast<uint64_t> (connection) << 32) | tsecr;
+  auto it = m_timestamps.find (key);
+  if (it == m_timestamps.end ())
+    {
+      return;
+    }
+
+  Time sample = Simulator::Now () - it->second.time;
+  m_timestampOrder.erase (it->second.order);
+  m_timestamps.erase (it);
+
+  if (m_rtt.Get ().IsZero ())
+    {
+      m_rtt = sample;
+    }
+  else
+    {
+      m_rtt = Time (static_cast<int64_t> (std::round ((1 - m_rttWeight) * m_rtt.Get ().GetTimeStep ()
+                                                      + m_rttWeight * sample.GetTimeStep ())));
+    }
+  NS_LOG_LOGIC ("RTT sample " << sample << ", estimate " << m_rtt);
+}
+
+DataRate
+LinkEstimator::GetDrainRate (void) const
+{
+  return m_drainRate;
+}
+
+Time
+LinkEstimator::GetRtt (void) const
+{
+  return m_rtt;
+}
+
+} // namespace ns3
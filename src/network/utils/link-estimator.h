@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINK_ESTIMATOR_H
+#define LINK_ESTIMATOR_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include <unordered_map>
+#include <list>
+
+namespace ns3 {
+
+class QueueDiscItem;
+
+/**
+ * \ingroup network
+ *
+ * \brief Online estimator of the drain rate and of the RTT of a device
+ *
+ * A LinkEstimator object is aggregated to the NetDeviceQueueInterface object
+ * of a device and shared by all the queue discs installed on the device, which
+ * can query it by means of QueueDisc::GetLinkEstimator.
+ *
+ * The drain rate is measured from the transmissions notified by the device
+ * queues (NetDeviceQueue::NotifyTransmittedBytes). The time between two
+ * transmissions is only accounted for if the device queue was not empty after
+ * the first one, so that idle periods do not bias the estimate. A sample is
+ * taken every time DequeueThreshold bytes have been transmitted and the drain
+ * rate is the moving average of such samples.
+ *
+ * The RTT is estimated passively from the TCP timestamp option. The time at
+ * which a timestamp value is first sent on the device (NotifyEgress) is stored
+ * until the timestamp is echoed by a packet of the same connection received
+ * on the device (NotifyIngress). The RTT is the moving average of such samples
+ * and includes the time spent in the queue discs of the device.
+ *
+ * For multi-queue devices, the transmissions of all the device queues
+ * contribute to the same drain rate estimate.
+ */
+class LinkEstimator : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief LinkEstimator constructor
+   */
+  LinkEstimator ();
+
+  virtual ~LinkEstimator ();
+
+  /**
+   * \brief Notify the transmission of some bytes by the device
+   *
+   * \param bytes the number of bytes transmitted
+   * \param backlogged true if the device queue is not empty after the transmission
+   */
+  void NotifyTransmittedBytes (uint32_t bytes, bool backlogged);
+
+  /**
+   * \brief Notify a packet to be sent on the device
+   *
+   * \param item the item to be sent
+   */
+  void NotifyEgress (Ptr<const QueueDiscItem> item);
+
+  /**
+   * \brief Notify a packet received on the device
+   *
+   * \param item an item storing the received packet and its network header
+   */
+  void NotifyIngress (Ptr<const QueueDiscItem> item);
+
+  /**
+   * \brief Get the estimated drain rate
+   * \return the estimated drain rate, or zero if no sample has been taken yet
+   */
+  DataRate GetDrainRate (void) const;
+
+  /**
+   * \brief Get the estimated RTT
+   * \return the estimated RTT, or zero if no sample has been taken yet
+   */
+  Time GetRtt (void) const;
+
+  /**
+   * TracedCallback signature for drain rate estimates
+   *
+   * \param [in] rate The drain rate
+   */
+  typedef void (* DataRateTracedCallback)(DataRate rate);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  uint32_t m_dqThreshold;       //!< Number of bytes to transmit to take a drain rate sample
+  double m_rateWeight;          //!< Weight of a new sample in the drain rate moving average
+  double m_rttWeight;           //!< Weight of a new sample in the RTT moving average
+  uint32_t m_maxTimestamps;     //!< Maximum number of timestamps waiting for an echo
+
+  DataRate m_drainRate;         //!< Estimated drain rate
+  uint64_t m_dqBytes;           //!< Bytes transmitted in the current measurement cycle
+  Time m_dqTime;                //!< Duration of the current measurement cycle
+  Time m_lastTx;                //!< Time of the last transmission
+  uint32_t m_lastBytes;         //!< Bytes of the last transmission
+  bool m_backlogged;            //!< Whether the device queue was backlogged after the last transmission
+
+  /// A timestamp value waiting for an echo
+  struct SentTimestamp
+  {
+    Time time;                               //!< Time at which the timestamp value was sent
+    std::list<uint64_t>::iterator order;     //!< Position of the timestamp in m_timestampOrder
+  };
+
+  TracedValue<Time> m_rtt;      //!< Estimated RTT
+  /// Timestamp values waiting for an echo, indexed by connection and timestamp
+  std::unordered_map<uint64_t, SentTimestamp> m_timestamps;
+  std::list<uint64_t> m_timestampOrder;  //!< Timestamps waiting for an echo, in the order they were sent
+
+  TracedCallback<DataRate> m_drainRateTrace;  //!< Trace of the drain rate estimates
+};
+
+} // namespace ns3
+
+#endif /* LINK_ESTIMATOR_H */
@@ -22,6 +22,7 @@
 #include "ns3/abort.h"
 #include "ns3/queue-limits.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/link-estimator.h"
 #include "ns3/simulator.h"
 
 namespace ns3 {
@@ -102,6 +103,10 @@ void
 NetDeviceQueue::NotifyTransmittedBytes (uint32_t bytes)
 {
   NS_LOG_FUNCTION (this << bytes);
+  if (m_linkEstimator)
+    {
+      m_linkEstimator->NotifyTransmittedBytes (bytes, m_deviceQueue && !m_deviceQueue->IsEmpty ());
+    }
   if ((!m_queueLimits) || (!bytes))
     {
       return;
@@ -145,6 +150,45 @@ NetDeviceQueue::GetQueueLimits ()
   return m_queueLimits;
 }
 
+void
+NetDeviceQueue::SetDeviceQueue (Ptr<QueueBase> queue)
+{
+  NS_LOG_FUNCTION (this << queue);
+  m_deviceQueue = queue;
+}
+
+void
+NetDeviceQueue::SetLinkEstimator (Ptr<LinkEstimator> estimator)
+{
+  NS_LOG_FUNCTION (this << estimator);
+  m_linkEstimator = estimator;
+}
+
+bool
+NetDeviceQueue::WouldStop (uint32_t nPackets, uint32_t nBytes, uint32_t mtu) const
+{
+  NS_LOG_FUNCTION (this << nPackets << nBytes << mtu);
+
+  if (m_queueLimits && m_queueLimits->Available () < static_cast<int64_t> (nBytes))
+    {
+      return true;
+    }
+
+  if (m_deviceQueue)
+    {
+      // as in NetDeviceQueue::PacketEnqueued, the queue is stopped if it cannot
+      // store another packet of size mtu
+      uint32_t maxSize = m_deviceQueue->GetMaxSize ().GetValue ();
+      if (m_deviceQueue->GetMaxSize ().GetUnit () == QueueSizeUnit::PACKETS)
+        {
+          return m_deviceQueue->GetNPackets () + nPackets + 1 > maxSize;
+        }
+      return m_deviceQueue->GetNBytes () + nBytes + mtu > maxSize;
+    }
+
+  return false;
+}
+
 
 NS_OBJECT_ENSURE_REGISTERED (NetDeviceQueueInterface);
 
@@ -210,9 +254,26 @@ NetDeviceQueueInterface::DoDispose (void)
 
   m_traceMap.clear ();
   m_txQueuesVector.clear ();
+  m_linkEstimator = 0;
   Object::DoDispose ();
 }
 
+void
+NetDeviceQueueInterface::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_linkEstimator)
+    {
+      m_linkEstimator = GetObject<LinkEstimator> ();
+      for (auto& txq : m_txQueuesVector)
+        {
+          txq->SetLinkEstimator (m_linkEstimator);
+        }
+    }
+  Object::NotifyNewAggregate ();
+}
+
 void
 NetDeviceQueueInterface::SetNTxQueues (std::size_t numTxQueues)
 {
@@ -225,6 +286,7 @@ NetDeviceQueueInterface::SetNTxQueues (std::size_t numTxQueues)
   for (std::size_t i = 0; i < numTxQueues; i++)
     {
       m_txQueuesVector.push_back (Create<NetDeviceQueue> ());
+      m_txQueuesVector.back ()->SetLinkEstimator (m_linkEstimator);
     }
 }
 
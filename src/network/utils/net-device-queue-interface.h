@@ -34,6 +34,7 @@ namespace ns3 {
 
 class QueueLimits;
 class NetDeviceQueueInterface;
+class LinkEstimator;
 
 // This header file is included by all the queue discs and all the netdevices
 // using a Queue object. The following explicit template instantiation
@@ -137,6 +138,38 @@ public:
    */
   Ptr<QueueLimits> GetQueueLimits ();
 
+  /**
+   * \brief Set the device queue associated with this transmission queue
+   * \param queue the device queue
+   *
+   * Called by NetDeviceQueueInterface::ConnectQueueTraces, so that the room
+   * left in the device queue can be taken into account by WouldStop.
+   */
+  void SetDeviceQueue (Ptr<QueueBase> queue);
+
+  /**
+   * \brief Set the link estimator notified of the transmissions of this queue
+   * \param estimator the link estimator
+   *
+   * Called by NetDeviceQueueInterface when a LinkEstimator object is aggregated to it.
+   */
+  void SetLinkEstimator (Ptr<LinkEstimator> estimator);
+
+  /**
+   * \brief Check whether sending a batch of packets would stop this transmission queue
+   * \param nPackets the number of packets of the batch
+   * \param nBytes the number of bytes of the batch
+   * \param mtu the MTU of the device
+   * \return true if this transmission queue would be stopped after the batch is enqueued
+   *
+   * Called by queue discs performing bulk dequeue to determine how many packets
+   * can be sent to the device at once. The same conditions used by flow control
+   * (room for a packet of size mtu in the device queue, if known) and by queue
+   * limits (available bytes) are applied. This plays the role of the
+   * qdisc_avail_bulklimit function of the Linux kernel.
+   */
+  bool WouldStop (uint32_t nPackets, uint32_t nBytes, uint32_t mtu) const;
+
   /**
    * \brief Perform the actions required by flow control and dynamic queue
    *        limits when a packet is enqueued in the queue of a netdevice
@@ -198,6 +231,8 @@ private:
   bool m_stoppedByQueueLimits;    //!< True if the queue has been stopped by a queue limits object
   Ptr<QueueLimits> m_queueLimits; //!< Queue limits object
   WakeCallback m_wakeCallback;    //!< Wake callback
+  Ptr<QueueBase> m_deviceQueue;   //!< Device queue, if known
+  Ptr<LinkEstimator> m_linkEstimator;  //!< Link estimator, if any
 };
 
 
@@ -295,9 +330,14 @@ protected:
    * \brief Dispose of the object
    */
   virtual void DoDispose (void);
+  /**
+   * \brief Set the link estimator, if any, on the transmission queues
+   */
+  virtual void NotifyNewAggregate (void);
 
 private:
   std::vector< Ptr<NetDeviceQueue> > m_txQueuesVector;   //!< Device transmission queues
+  Ptr<LinkEstimator> m_linkEstimator;   //!< Link estimator aggregated to this object, if any
   SelectQueueCallback m_selectQueueCallback;   //!< Select queue callback
   std::map<Ptr<QueueBase>, std::vector<CallbackBase> > m_traceMap;   //!< Map storing all the connected traces
 };
@@ -314,6 +354,8 @@ NetDeviceQueueInterface::ConnectQueueTraces (Ptr<Queue<Item> > queue, uint8_t tx
   NS_ASSERT (queue != 0);
   NS_ASSERT (txq < GetNTxQueues ());
 
+  GetTxQueue (txq)->SetDeviceQueue (queue);
+
   m_traceMap.emplace (queue, std::initializer_list<CallbackBase> {
                                MakeBoundCallback (&NetDeviceQueue::PacketEnqueued<Item>, queue, this, txq),
                                MakeBoundCallback (&NetDeviceQueue::PacketDequeued<Item>, queue, this, txq),
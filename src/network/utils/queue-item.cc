@@ -146,4 +146,23 @@ QueueDiscItem::Hash (uint32_t perturbation) const
   return 0;
 }
 
+uint32_t
+QueueDiscItem::HostHash (bool source, uint32_t perturbation) const
+{
+  NS_LOG_WARN ("The HostHash method should be redefined by subclasses");
+  return 0;
+}
+
+bool
+QueueDiscItem::IsRedundantAck (Ptr<const QueueDiscItem> ack) const
+{
+  return false;
+}
+
+bool
+QueueDiscItem::GetTcpTimestamp (uint32_t &connection, uint32_t &tsval, uint32_t &tsecr) const
+{
+  return false;
+}
+
 } // namespace ns3
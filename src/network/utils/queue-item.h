@@ -226,6 +226,53 @@ public:
    */
   virtual uint32_t Hash (uint32_t perturbation = 0) const;
 
+  /**
+   * \brief Computes the hash of the source or of the destination address of the packet
+   *
+   * This method just returns 0, i.e., all the packets are deemed to be exchanged
+   * between the same pair of hosts. Subclasses should hash the source or the
+   * destination address of their protocol type, so that queue discs can
+   * provide fairness among hosts.
+   *
+   * \param source true to hash the source address, false to hash the destination address
+   * \param perturbation hash perturbation value
+   * \return the hash of the source or of the destination address
+   */
+  virtual uint32_t HostHash (bool source, uint32_t perturbation = 0) const;
+
+  /**
+   * \brief Check whether this item is a TCP acknowledgment made redundant by the given item
+   *
+   * This item is redundant if both this item and the given item are pure TCP
+   * acknowledgments (i.e., they carry no payload) of the same connection, the
+   * SACK blocks of this item are covered by those of the given item and the
+   * given item acknowledges more data than this item or, in case of equal
+   * acknowledgment numbers, carries strictly more SACK information (hence, a
+   * duplicate acknowledgment is not redundant). This method just returns
+   * false. Subclasses carrying TCP segments
+   * should redefine it, so that queue discs can filter redundant acknowledgments.
+   *
+   * \param ack the most recent acknowledgment
+   * \return true if this item is made redundant by the given item
+   */
+  virtual bool IsRedundantAck (Ptr<const QueueDiscItem> ack) const;
+
+  /**
+   * \brief Get the TCP timestamp option carried by the packet
+   *
+   * The connection identifier is the same for the packets of both directions
+   * of a TCP connection, so that the timestamps of the packets sent in one
+   * direction can be matched with the echoes carried by the packets sent in
+   * the opposite direction. This method just returns false. Subclasses
+   * carrying TCP segments should redefine it.
+   *
+   * \param connection the identifier of the TCP connection
+   * \param tsval the timestamp value
+   * \param tsecr the timestamp echo reply
+   * \return true if the packet carries a TCP segment with the timestamp option
+   */
+  virtual bool GetTcpTimestamp (uint32_t &connection, uint32_t &tsval, uint32_t &tsecr) const;
+
 private:
   /**
    * \brief Default constructor
@@ -29,10 +29,12 @@
 #include "ns3/traced-value.h"
 #include "ns3/unused.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/queue-size.h"
 #include <string>
 #include <sstream>
 #include <list>
+#include <vector>
 
 namespace ns3 {
 
@@ -294,10 +296,103 @@ public:
    */
   void Flush (void);
 
+  /**
+   * \brief Select the storage used for the items in the queue
+   *
+   * By default, items are stored in a linked list. If the ring buffer storage
+   * is selected, items are stored in a contiguous circular buffer whose
+   * capacity is doubled whenever it is full and never shrinks, so that no
+   * memory is allocated once the buffer has grown to the largest occupancy
+   * of the queue. The storage can only be changed while the queue is empty.
+   *
+   * \param useRingBuffer true to store items in a ring buffer, false to store
+   *        items in a linked list
+   */
+  void SetUseRingBuffer (bool useRingBuffer);
+
+  /**
+   * \brief Check whether items are stored in a ring buffer
+   * \return true if items are stored in a ring buffer, false if they are
+   *         stored in a linked list
+   */
+  bool GetUseRingBuffer (void) const;
+
+private:
+  /**
+   * \brief Contiguous circular buffer storing the items of the queue
+   *
+   * Items are addressed by an absolute index which wraps around on overflow;
+   * the slot of the item with absolute index i is i & (capacity - 1), which
+   * requires the capacity to be a power of two. Insertions and removals in
+   * the middle of the buffer only shift the items that precede the affected
+   * position, hence the absolute index of the items that follow (and of the
+   * end of the buffer) is left unchanged.
+   */
+  struct RingBuffer
+  {
+    std::vector<Ptr<Item> > slots;   //!< the buffer
+    uint32_t head = 0;               //!< absolute index of the first item
+    uint32_t tail = 0;               //!< absolute index past the last item
+  };
+
 protected:
 
-  /// Const iterator.
-  typedef typename std::list<Ptr<Item> >::const_iterator ConstIterator;
+  /**
+   * \brief Const iterator.
+   *
+   * An iterator refers either to an item stored in the linked list or to an
+   * item stored in the ring buffer. In both cases, iterators referring to the
+   * items that follow the position where an item is inserted or removed
+   * remain valid, which allows subclasses to remove items while browsing the
+   * queue.
+   */
+  class ConstIterator
+  {
+  public:
+    ConstIterator ();
+
+    /**
+     * \return the item this iterator refers to
+     */
+    const Ptr<Item> & operator* (void) const;
+    /**
+     * \return a pointer to the item this iterator refers to
+     */
+    const Ptr<Item> * operator-> (void) const;
+    /**
+     * \return this iterator, advanced to the next item
+     */
+    ConstIterator & operator++ (void);
+    /**
+     * \return a copy of this iterator before advancing it to the next item
+     */
+    ConstIterator operator++ (int);
+    /**
+     * \return this iterator, moved to the previous item
+     */
+    ConstIterator & operator-- (void);
+    /**
+     * \return a copy of this iterator before moving it to the previous item
+     */
+    ConstIterator operator-- (int);
+    /**
+     * \param other the iterator to compare to
+     * \return true if both iterators refer to the same position
+     */
+    bool operator== (const ConstIterator &other) const;
+    /**
+     * \param other the iterator to compare to
+     * \return true if the iterators refer to different positions
+     */
+    bool operator!= (const ConstIterator &other) const;
+
+  private:
+    friend class Queue<Item>;
+
+    typename std::list<Ptr<Item> >::const_iterator m_listIt;  //!< position in the list
+    const RingBuffer *m_ring;                                   //!< the ring buffer, if used
+    uint32_t m_index;                                           //!< absolute index in the ring buffer
+  };
 
   /**
    * \brief Get a const iterator which refers to the first item in the queue.
@@ -381,7 +476,22 @@ protected:
   void DropAfterDequeue (Ptr<Item> item);
 
 private:
+  /**
+   * Store an item in the ring buffer, doubling its capacity if it is full
+   * \param pos the position where the item is inserted
+   * \param item the item to store
+   */
+  void RingInsert (ConstIterator pos, Ptr<Item> item);
+
+  /**
+   * Remove an item from the ring buffer
+   * \param pos the position of the item to remove
+   */
+  void RingErase (ConstIterator pos);
+
   std::list<Ptr<Item> > m_packets;          //!< the items in the queue
+  bool m_useRingBuffer;                     //!< true if items are stored in the ring buffer
+  RingBuffer m_ring;                        //!< the items in the queue, if the ring buffer is used
   NS_LOG_TEMPLATE_DECLARE;                  //!< the log component
 
   /// Traced callback: fired when a packet is enqueued
@@ -430,7 +540,8 @@ Queue<Item>::GetTypeId (void)
 
 template <typename Item>
 Queue<Item>::Queue ()
-  : NS_LOG_TEMPLATE_DEFINE ("Queue")
+  : m_useRingBuffer (false),
+    NS_LOG_TEMPLATE_DEFINE ("Queue")
 {
 }
 
@@ -452,7 +563,14 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
       return false;
     }
 
-  m_packets.insert (pos, item);
+  if (m_useRingBuffer)
+    {
+      RingInsert (pos, item);
+    }
+  else
+    {
+      m_packets.insert (pos.m_listIt, item);
+    }
 
   uint32_t size = item->GetSize ();
   m_nBytes += size;
@@ -480,7 +598,14 @@ Queue<Item>::DoDequeue (ConstIterator pos)
     }
 
   Ptr<Item> item = *pos;
-  m_packets.erase (pos);
+  if (m_useRingBuffer)
+    {
+      RingErase (pos);
+    }
+  else
+    {
+      m_packets.erase (pos.m_listIt);
+    }
 
   if (item != 0)
     {
@@ -509,7 +634,14 @@ Queue<Item>::DoRemove (ConstIterator pos)
     }
 
   Ptr<Item> item = *pos;
-  m_packets.erase (pos);
+  if (m_useRingBuffer)
+    {
+      RingErase (pos);
+    }
+  else
+    {
+      m_packets.erase (pos.m_listIt);
+    }
 
   if (item != 0)
     {
@@ -554,16 +686,195 @@ Queue<Item>::DoPeek (ConstIterator pos) const
   return *pos;
 }
 
+template <typename Item>
+void
+Queue<Item>::SetUseRingBuffer (bool useRingBuffer)
+{
+  NS_LOG_FUNCTION (this << useRingBuffer);
+  NS_ABORT_MSG_IF (m_packets.size () != 0 || m_ring.head != m_ring.tail,
+                   "Cannot change the storage of a non-empty queue");
+  m_useRingBuffer = useRingBuffer;
+}
+
+template <typename Item>
+bool
+Queue<Item>::GetUseRingBuffer (void) const
+{
+  return m_useRingBuffer;
+}
+
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::Head (void) const
 {
-  return m_packets.cbegin ();
+  ConstIterator it;
+  if (m_useRingBuffer)
+    {
+      it.m_ring = &m_ring;
+      it.m_index = m_ring.head;
+    }
+  else
+    {
+      it.m_listIt = m_packets.cbegin ();
+    }
+  return it;
 }
 
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::Tail (void) const
 {
-  return m_packets.cend ();
+  ConstIterator it;
+  if (m_useRingBuffer)
+    {
+      it.m_ring = &m_ring;
+      it.m_index = m_ring.tail;
+    }
+  else
+    {
+      it.m_listIt = m_packets.cend ();
+    }
+  return it;
+}
+
+template <typename Item>
+void
+Queue<Item>::RingInsert (ConstIterator pos, Ptr<Item> item)
+{
+  uint32_t size = m_ring.tail - m_ring.head;
+
+  if (size == m_ring.slots.size ())
+    {
+      // Double the capacity. Items keep their absolute index, hence
+      // iterators are not invalidated
+      std::vector<Ptr<Item> > slots (m_ring.slots.empty () ? 16 : 2 * m_ring.slots.size ());
+      for (uint32_t i = m_ring.head; i != m_ring.tail; i++)
+        {
+          slots[i & (slots.size () - 1)] = m_ring.slots[i & (m_ring.slots.size () - 1)];
+        }
+      m_ring.slots.swap (slots);
+    }
+
+  uint32_t mask = m_ring.slots.size () - 1;
+
+  if (pos.m_index == m_ring.tail)
+    {
+      m_ring.slots[m_ring.tail++ & mask] = item;
+      return;
+    }
+
+  // Move the items preceding pos one slot backward and store the item in
+  // the slot freed before pos
+  m_ring.head--;
+  for (uint32_t i = m_ring.head; i != pos.m_index - 1; i++)
+    {
+      m_ring.slots[i & mask] = m_ring.slots[(i + 1) & mask];
+    }
+  m_ring.slots[(pos.m_index - 1) & mask] = item;
+}
+
+template <typename Item>
+void
+Queue<Item>::RingErase (ConstIterator pos)
+{
+  NS_ASSERT (m_ring.head != m_ring.tail);
+  uint32_t mask = m_ring.slots.size () - 1;
+
+  // Move the items preceding pos one slot forward
+  for (uint32_t i = pos.m_index; i != m_ring.head; i--)
+    {
+      m_ring.slots[i & mask] = m_ring.slots[(i - 1) & mask];
+    }
+  m_ring.slots[m_ring.head++ & mask] = 0;
+}
+
+template <typename Item>
+Queue<Item>::ConstIterator::ConstIterator ()
+  : m_ring (0),
+    m_index (0)
+{
+}
+
+template <typename Item>
+const Ptr<Item> &
+Queue<Item>::ConstIterator::operator* (void) const
+{
+  if (m_ring != 0)
+    {
+      return m_ring->slots[m_index & (m_ring->slots.size () - 1)];
+    }
+  return *m_listIt;
+}
+
+template <typename Item>
+const Ptr<Item> *
+Queue<Item>::ConstIterator::operator-> (void) const
+{
+  return &(**this);
+}
+
+template <typename Item>
+typename Queue<Item>::ConstIterator &
+Queue<Item>::ConstIterator::operator++ (void)
+{
+  if (m_ring != 0)
+    {
+      m_index++;
+    }
+  else
+    {
+      ++m_listIt;
+    }
+  return *this;
+}
+
+template <typename Item>
+typename Queue<Item>::ConstIterator
+Queue<Item>::ConstIterator::operator++ (int)
+{
+  ConstIterator tmp = *this;
+  ++(*this);
+  return tmp;
+}
+
+template <typename Item>
+typename Queue<Item>::ConstIterator &
+Queue<Item>::ConstIterator::operator-- (void)
+{
+  if (m_ring != 0)
+    {
+      m_index--;
+    }
+  else
+    {
+      --m_listIt;
+    }
+  return *this;
+}
+
+template <typename Item>
+typename Queue<Item>::ConstIterator
+Queue<Item>::ConstIterator::operator-- (int)
+{
+  ConstIterator tmp = *this;
+  --(*this);
+  return tmp;
+}
+
+template <typename Item>
+bool
+Queue<Item>::ConstIterator::operator== (const ConstIterator &other) const
+{
+  if (m_ring != 0 || other.m_ring != 0)
+    {
+      return m_ring == other.m_ring && m_index == other.m_index;
+    }
+  return m_listIt == other.m_listIt;
+}
+
+template <typename Item>
+bool
+Queue<Item>::ConstIterator::operator!= (const ConstIterator &other) const
+{
+  return !(*this == other);
 }
 
 template <typename Item>
@@ -22,6 +22,7 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/node.h"
 
 namespace ns3 {
 
@@ -80,6 +81,17 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+
+      for (uint32_t i = 0; i < N_DEVICES; i++)
+        {
+          Ptr<Node> src = m_link[i].m_src->GetNode ();
+          Ptr<Node> dst = m_link[i].m_dst->GetNode ();
+          if (src != 0 && dst != 0)
+            {
+              m_link[i].m_dstContext = dst->GetId ();
+              m_link[i].m_crossSystem = (src->GetSystemId () != dst->GetSystemId ());
+            }
+        }
     }
 }
 
@@ -97,6 +109,19 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
+  if (m_link[wire].m_crossSystem && Simulator::IsMultithreaded ())
+    {
+      // The nodes are simulated by different threads (see the
+      // MultithreadedSimulatorImpl): the receiver gets a deep copy of the
+      // packet and the event does not take a reference to the remote
+      // device, because reference counts are not thread safe. As for the
+      // PointToPointRemoteChannel, the TxRxPointToPoint trace is not fired.
+      Simulator::ScheduleWithContext (m_link[wire].m_dstContext,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst), p->CreateFullCopy ());
+      return true;
+    }
+
   Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p->Copy ());
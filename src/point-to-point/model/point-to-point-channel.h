@@ -194,11 +194,13 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_dstContext (0), m_crossSystem (false) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    uint32_t                   m_dstContext;  //!< Context (node id) of the second NetDevice
+    bool                       m_crossSystem; //!< Whether the nodes of the NetDevices have different system ids
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
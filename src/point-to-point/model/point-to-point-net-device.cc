@@ -18,6 +18,7 @@
 
 #include "ns3/log.h"
 #include "ns3/queue.h"
+#include "ns3/queue-item.h"
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
 #include "ns3/llc-snap-header.h"
@@ -556,6 +557,56 @@ PointToPointNetDevice::Send (
   return false;
 }
 
+uint32_t
+PointToPointNetDevice::SendMany (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  //
+  // The link state is checked once for the whole batch. Packets are then
+  // handled as in Send.
+  //
+  if (IsLinkUp () == false)
+    {
+      for (auto& item : items)
+        {
+          m_macTxDropTrace (item->GetPacket ());
+        }
+      return 0;
+    }
+
+  uint32_t nSent = 0;
+  for (auto& item : items)
+    {
+      Ptr<Packet> packet = item->GetPacket ();
+      NS_LOG_LOGIC ("UID is " << packet->GetUid ());
+
+      AddHeader (packet, item->GetProtocol ());
+
+      m_macTxTrace (packet);
+
+      if (!m_queue->Enqueue (packet))
+        {
+          m_macTxDropTrace (packet);
+          continue;
+        }
+
+      nSent++;
+
+      //
+      // Only the first packet of the batch may find the channel ready
+      //
+      if (m_txMachineState == READY)
+        {
+          packet = m_queue->Dequeue ();
+          m_snifferTrace (packet);
+          m_promiscSnifferTrace (packet);
+          TransmitStart (packet);
+        }
+    }
+  return nSent;
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
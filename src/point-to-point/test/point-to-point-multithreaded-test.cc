@@ -0,0 +1,464 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/mac48-address.h"
+#include "ns3/data-rate.h"
+#include "ns3/tag.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Tag carrying the sequence number of a packet
+ */
+class PointToPointMultithreadedTestTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+  uint32_t m_seq; //!< the sequence number
+};
+
+TypeId
+PointToPointMultithreadedTestTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PointToPointMultithreadedTestTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("PointToPoint")
+    .AddConstructor<PointToPointMultithreadedTestTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+PointToPointMultithreadedTestTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+PointToPointMultithreadedTestTag::GetSerializedSize (void) const
+{
+  return 4;
+}
+
+void
+PointToPointMultithreadedTestTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_seq);
+}
+
+void
+PointToPointMultithreadedTestTag::Deserialize (TagBuffer i)
+{
+  m_seq = i.ReadU32 ();
+}
+
+void
+PointToPointMultithreadedTestTag::Print (std::ostream &os) const
+{
+  os << "seq=" << m_seq;
+}
+
+/**
+ * \brief Test class for the MultithreadedSimulatorImpl
+ *
+ * Packets are exchanged by the two ends of a chain of nodes connected by
+ * point-to-point links, each node belonging to a different partition.
+ * The intermediate nodes forward the packets. The arrival times and the
+ * tags of the packets received by the two ends must be the same as those
+ * obtained with the DefaultSimulatorImpl.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /// Packet received by one of the two ends of the chain
+  struct Arrival
+  {
+    int64_t time;         //!< the arrival time
+    uint32_t size;        //!< the packet size
+    uint32_t packetTag;   //!< the sequence number in the packet tag
+    uint32_t byteTag;     //!< the sequence number in the byte tag
+    uint32_t systemId;    //!< the system id in the packet uid
+  };
+
+  /**
+   * \brief Simulate the chain of nodes
+   * \param systemIds whether the nodes have different system ids
+   */
+  void RunChain (bool systemIds);
+  /**
+   * \brief Send a packet
+   * \param device the device
+   * \param seq the sequence number of the packet
+   */
+  void Send (Ptr<PointToPointNetDevice> device, uint32_t seq);
+  /**
+   * \brief Receive a packet and forward it to the other device of the node,
+   *        if any
+   * \param device the device
+   * \param packet the packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  static const uint32_t N_NODES = 4;           //!< the number of nodes
+  std::vector<std::vector<Arrival> > m_arrivals;  //!< the arrivals at each node
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("Multithreaded simulation of a chain of point-to-point links")
+{
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<PointToPointNetDevice> device, uint32_t seq)
+{
+  Ptr<Packet> p = Create<Packet> (100 + (seq * 37) % 1400);
+  PointToPointMultithreadedTestTag tag;
+  tag.m_seq = seq;
+  p->AddPacketTag (tag);
+  tag.m_seq = seq + 1;
+  p->AddByteTag (tag);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  if (node->GetNDevices () == 2)
+    {
+      Ptr<NetDevice> other = node->GetDevice (device == node->GetDevice (0) ? 1 : 0);
+      other->Send (packet->Copy (), other->GetBroadcast (), protocol);
+      return true;
+    }
+
+  Arrival arrival;
+  arrival.time = Simulator::Now ().GetTimeStep ();
+  arrival.size = packet->GetSize ();
+  PointToPointMultithreadedTestTag tag;
+  arrival.packetTag = packet->PeekPacketTag (tag) ? tag.m_seq : 0;
+  arrival.byteTag = packet->FindFirstMatchingByteTag (tag) ? tag.m_seq : 0;
+  arrival.systemId = packet->GetUid () >> 32;
+  m_arrivals[node->GetId ()].push_back (arrival);
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::RunChain (bool systemIds)
+{
+  m_arrivals.assign (N_NODES, std::vector<Arrival> ());
+
+  std::vector<Ptr<PointToPointNetDevice> > ends;
+  Ptr<PointToPointNetDevice> left;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> (systemIds ? i : 0);
+      if (left != 0)
+        {
+          Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+          channel->SetAttribute ("Delay", TimeValue (MilliSeconds (i)));
+          Ptr<PointToPointNetDevice> right = CreateObject<PointToPointNetDevice> ();
+          left->Attach (channel);
+          node->AddDevice (right);
+          right->SetAddress (Mac48Address::Allocate ());
+          right->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+          right->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+          right->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+          right->Attach (channel);
+          if (i == N_NODES - 1)
+            {
+              ends.push_back (right);
+              break;
+            }
+        }
+      left = CreateObject<PointToPointNetDevice> ();
+      node->AddDevice (left);
+      left->SetAddress (Mac48Address::Allocate ());
+      left->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+      left->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+      left->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+      if (i == 0)
+        {
+          ends.push_back (left);
+        }
+    }
+
+  // the two ends send bursts of packets to each other
+  for (uint32_t seq = 0; seq < 400; seq++)
+    {
+      Time t = MicroSeconds (2000 * seq + (seq % 7) * 300);
+      Simulator::ScheduleWithContext (0, t, &PointToPointMultithreadedTest::Send, this, ends[0], 2 * seq);
+      Simulator::ScheduleWithContext (N_NODES - 1, t, &PointToPointMultithreadedTest::Send, this, ends[1], 2 * seq + 1);
+    }
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (1), "The simulation should stop at the stop time");
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  Simulator::Destroy ();
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+  RunChain (false);
+  std::vector<std::vector<Arrival> > expected = m_arrivals;
+  Simulator::Destroy ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  Simulator::SetImplementation (impl);
+  RunChain (true);
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (impl->GetNPartitions (), N_NODES, "There should be a partition per node");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLookAhead (), MilliSeconds (1), "The lookahead is the smallest link delay");
+  NS_TEST_EXPECT_MSG_GT (impl->GetNWindows (), 1, "The simulation should take several windows");
+
+  for (uint32_t node = 0; node < N_NODES; node += N_NODES - 1)
+    {
+      NS_TEST_ASSERT_MSG_EQ (expected[node].size (), 400, "All the packets should have been received");
+      NS_TEST_ASSERT_MSG_EQ (m_arrivals[node].size (), expected[node].size (), "Wrong number of packets");
+      for (uint32_t i = 0; i < expected[node].size (); i++)
+        {
+          const Arrival &a = m_arrivals[node][i];
+          const Arrival &e = expected[node][i];
+          NS_TEST_EXPECT_MSG_EQ (a.time, e.time, "Wrong arrival time");
+          NS_TEST_EXPECT_MSG_EQ (a.size, e.size, "Wrong packet size");
+          NS_TEST_EXPECT_MSG_EQ (a.packetTag, e.packetTag, "Wrong packet tag");
+          NS_TEST_EXPECT_MSG_EQ (a.byteTag, e.packetTag + 1, "Wrong byte tag");
+          // the uid of a packet is allocated by the partition of its source
+          NS_TEST_EXPECT_MSG_EQ (a.systemId, N_NODES - 1 - node, "Wrong system id in the packet uid");
+        }
+    }
+}
+
+/**
+ * \brief Stress test of the packet handoff between partitions
+ *
+ * The nodes of a ring, each belonging to a different partition, send many
+ * packets of various sizes with tags to their two neighbours. The packets
+ * are allocated by the sending thread and released by the receiving
+ * thread, which also creates copies and fragments of them, so that the
+ * free lists of the packet buffers, metadata and tags of all the threads
+ * are exercised concurrently. Every packet must be received intact.
+ */
+class PointToPointMultithreadedRingTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedRingTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a packet
+   * \param device the device
+   * \param seq the sequence number of the packet
+   */
+  void Send (Ptr<PointToPointNetDevice> device, uint32_t seq);
+  /**
+   * \brief Receive a packet and check it
+   * \param device the device
+   * \param packet the packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  /**
+   * \brief Get the size of a packet
+   * \param seq the sequence number of the packet
+   * \return the size of the packet
+   */
+  static uint32_t GetPacketSize (uint32_t seq);
+
+  static const uint32_t N_NODES = 6;        //!< the number of nodes
+  static const uint32_t N_PACKETS = 2000;   //!< the number of packets sent on each device
+  std::vector<uint32_t> m_received;         //!< the number of packets received by each node
+  std::vector<uint32_t> m_errors;           //!< the number of corrupted packets received by each node
+};
+
+PointToPointMultithreadedRingTest::PointToPointMultithreadedRingTest ()
+  : TestCase ("Multithreaded simulation of a ring exchanging many packets")
+{
+}
+
+uint32_t
+PointToPointMultithreadedRingTest::GetPacketSize (uint32_t seq)
+{
+  return 64 + (seq * 97) % 1400;
+}
+
+void
+PointToPointMultithreadedRingTest::Send (Ptr<PointToPointNetDevice> device, uint32_t seq)
+{
+  Ptr<Packet> p = Create<Packet> (GetPacketSize (seq));
+  PointToPointMultithreadedTestTag tag;
+  tag.m_seq = seq;
+  p->AddPacketTag (tag);
+  p->AddByteTag (tag);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedRingTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                            uint16_t protocol, const Address &from)
+{
+  // the test macros are not thread safe, hence errors are counted and
+  // checked after the simulation
+  uint32_t node = device->GetNode ()->GetId ();
+  m_received[node]++;
+
+  PointToPointMultithreadedTestTag packetTag;
+  PointToPointMultithreadedTestTag byteTag;
+  if (!packet->PeekPacketTag (packetTag) || !packet->FindFirstMatchingByteTag (byteTag)
+      || packetTag.m_seq != byteTag.m_seq || packet->GetSize () != GetPacketSize (packetTag.m_seq))
+    {
+      m_errors[node]++;
+      return true;
+    }
+
+  // churn the free lists of the receiving thread
+  Ptr<Packet> copy = packet->Copy ();
+  copy->RemoveAtStart (32);
+  Ptr<Packet> fragment = copy->CreateFragment (0, copy->GetSize () / 2);
+  fragment->AddAtEnd (copy);
+  if (fragment->GetSize () != copy->GetSize () / 2 + copy->GetSize ()
+      || !fragment->FindFirstMatchingByteTag (byteTag) || byteTag.m_seq != packetTag.m_seq)
+    {
+      m_errors[node]++;
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedRingTest::DoRun (void)
+{
+  Simulator::Destroy ();
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  Simulator::SetImplementation (impl);
+
+  m_received.assign (N_NODES, 0);
+  m_errors.assign (N_NODES, 0);
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes.push_back (CreateObject<Node> (i));
+    }
+
+  // device d of node i is connected to node (i + 1) % N_NODES if d is 0
+  // and to node (i - 1) % N_NODES if d is 1
+  std::vector<Ptr<PointToPointNetDevice> > devices;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+      Ptr<Node> ends[2] = {nodes[i], nodes[(i + 1) % N_NODES]};
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          ends[j]->AddDevice (device);
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+          device->SetAttribute ("DataRate", DataRateValue (DataRate ("1Gbps")));
+          device->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedRingTest::Receive, this));
+          device->Attach (channel);
+          devices.push_back (device);
+        }
+    }
+
+  for (uint32_t d = 0; d < devices.size (); d++)
+    {
+      uint32_t node = devices[d]->GetNode ()->GetId ();
+      for (uint32_t seq = 0; seq < N_PACKETS; seq++)
+        {
+          Simulator::ScheduleWithContext (node, MicroSeconds (50 * seq + d), &PointToPointMultithreadedRingTest::Send,
+                                          this, devices[d], seq);
+        }
+    }
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (impl->GetNPartitions (), N_NODES, "There should be a partition per node");
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], 2 * N_PACKETS, "All the packets sent to node " << i << " should be received");
+      NS_TEST_EXPECT_MSG_EQ (m_errors[i], 0, "Node " << i << " received corrupted packets");
+    }
+}
+
+/**
+ * \brief TestSuite for the MultithreadedSimulatorImpl
+ */
+class PointToPointMultithreadedTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  PointToPointMultithreadedTestSuite ();
+};
+
+PointToPointMultithreadedTestSuite::PointToPointMultithreadedTestSuite ()
+  : TestSuite ("devices-point-to-point-multithreaded", UNIT)
+{
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedRingTest, TestCase::QUICK);
+}
+
+static PointToPointMultithreadedTestSuite g_pointToPointMultithreadedTestSuite; //!< The testsuite
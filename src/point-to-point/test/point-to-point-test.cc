@@ -23,7 +23,11 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-helper.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-item.h"
+#include "ns3/node-container.h"
+#include "ns3/string.h"
 
 using namespace ns3;
 
@@ -94,6 +98,278 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Queue disc item used to pass packets to SendMany
+ */
+class PointToPointTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param p the packet
+   * \param addr the destination address
+   */
+  PointToPointTestItem (Ptr<Packet> p, const Address & addr);
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+};
+
+PointToPointTestItem::PointToPointTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0x800)
+{
+}
+
+void
+PointToPointTestItem::AddHeader (void)
+{
+}
+
+bool
+PointToPointTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \brief Test class for the SendMany method of PointToPointNetDevice
+ *
+ * A batch larger than the room left in the device queue is passed to
+ * SendMany. The packets that fit are accepted and received in order, the
+ * others are dropped, the transmission queue is stopped and then woken up
+ * when the device queue drains.
+ */
+class PointToPointSendManyTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointSendManyTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a batch of packets to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param nPackets the number of packets of the batch
+   */
+  void SendBatch (Ptr<NetDevice> device, uint32_t nPackets);
+  /**
+   * \brief Record a packet passed to the device for transmission
+   * \param p the packet
+   */
+  void MacTx (Ptr<const Packet> p);
+  /**
+   * \brief Record a packet dropped by the device
+   * \param p the packet
+   */
+  void MacTxDrop (Ptr<const Packet> p);
+  /**
+   * \brief Record a packet received by the peer device
+   * \param p the packet
+   */
+  void MacRx (Ptr<const Packet> p);
+  /**
+   * \brief Record the wake up of the transmission queue
+   */
+  void Wake (void);
+
+  std::vector<uint64_t> m_sent;      //!< UIDs of the packets of the batch
+  uint32_t m_accepted;               //!< Number of packets accepted by SendMany
+  bool m_stopped;                    //!< Whether the transmission queue was stopped after SendMany
+  std::vector<uint64_t> m_macTx;     //!< UIDs of the packets traced by MacTx
+  std::vector<uint64_t> m_macTxDrop; //!< UIDs of the packets traced by MacTxDrop
+  std::vector<uint64_t> m_macRx;     //!< UIDs of the packets received by the peer
+  uint32_t m_wakes;                  //!< Number of times the transmission queue was woken up
+};
+
+PointToPointSendManyTest::PointToPointSendManyTest ()
+  : TestCase ("PointToPoint SendMany"),
+    m_accepted (0),
+    m_stopped (false),
+    m_wakes (0)
+{
+}
+
+void
+PointToPointSendManyTest::SendBatch (Ptr<NetDevice> device, uint32_t nPackets)
+{
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      m_sent.push_back (p->GetUid ());
+      items.push_back (Create<PointToPointTestItem> (p, device->GetBroadcast ()));
+    }
+  m_accepted = device->SendMany (items);
+  m_stopped = device->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->IsStopped ();
+}
+
+void
+PointToPointSendManyTest::MacTx (Ptr<const Packet> p)
+{
+  m_macTx.push_back (p->GetUid ());
+}
+
+void
+PointToPointSendManyTest::MacTxDrop (Ptr<const Packet> p)
+{
+  m_macTxDrop.push_back (p->GetUid ());
+}
+
+void
+PointToPointSendManyTest::MacRx (Ptr<const Packet> p)
+{
+  m_macRx.push_back (p->GetUid ());
+}
+
+void
+PointToPointSendManyTest::Wake (void)
+{
+  m_wakes++;
+}
+
+void
+PointToPointSendManyTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("8Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("3p"));
+  NetDeviceContainer devices = p2p.Install (nodes);
+
+  Ptr<NetDevice> devA = devices.Get (0);
+  Ptr<NetDevice> devB = devices.Get (1);
+  devA->TraceConnectWithoutContext ("MacTx", MakeCallback (&PointToPointSendManyTest::MacTx, this));
+  devA->TraceConnectWithoutContext ("MacTxDrop", MakeCallback (&PointToPointSendManyTest::MacTxDrop, this));
+  devB->TraceConnectWithoutContext ("MacRx", MakeCallback (&PointToPointSendManyTest::MacRx, this));
+  devA->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->SetWakeCallback (MakeCallback (&PointToPointSendManyTest::Wake, this));
+
+  // the first packet is transmitted at once, the device queue can store
+  // three more packets, hence the last packet of the batch is dropped
+  Simulator::Schedule (Seconds (1.0), &PointToPointSendManyTest::SendBatch, this, devA, 5);
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_accepted, 4, "SendMany should accept the packets that fit in the device queue");
+  NS_TEST_EXPECT_MSG_EQ (m_stopped, true, "The transmission queue should be stopped when the device queue is full");
+  NS_TEST_EXPECT_MSG_EQ (m_wakes, 1, "The transmission queue should be woken up once the device queue drains");
+  NS_TEST_EXPECT_MSG_EQ (devA->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->IsStopped (), false,
+                         "The transmission queue should not be stopped at the end");
+
+  NS_TEST_ASSERT_MSG_EQ (m_macTx.size (), 5, "Every packet of the batch should be traced by MacTx");
+  NS_TEST_ASSERT_MSG_EQ (m_macTxDrop.size (), 1, "One packet should be traced by MacTxDrop");
+  NS_TEST_EXPECT_MSG_EQ (m_macTxDrop[0], m_sent[4], "The last packet of the batch should be dropped");
+  NS_TEST_ASSERT_MSG_EQ (m_macRx.size (), 4, "The accepted packets should be received");
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_macTx[i], m_sent[i], "The packets should be traced by MacTx in order");
+    }
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_macRx[i], m_sent[i], "The packets should be received in order");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for links between nodes of different system ids
+ *
+ * Unless the simulator runs the system ids in parallel threads, a link
+ * between nodes of different system ids behaves as the other links: the
+ * packets are received and the TxRxPointToPoint trace is fired.
+ */
+class PointToPointCrossSystemTest : public TestCase
+{
+public:
+  PointToPointCrossSystemTest ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one packet
+   * \param device the sending device
+   * \param dest the destination address
+   */
+  void SendOnePacket (Ptr<NetDevice> device, Address dest);
+  /**
+   * \brief Record a packet transmitted on the channel
+   * \param p the packet
+   * \param tx the sender
+   * \param rx the receiver
+   * \param txTime the transmission time
+   * \param rxTime the reception time
+   */
+  void TxRx (Ptr<const Packet> p, Ptr<NetDevice> tx, Ptr<NetDevice> rx, Time txTime, Time rxTime);
+  /**
+   * \brief Record a packet received by the peer device
+   * \param p the packet
+   */
+  void MacRx (Ptr<const Packet> p);
+
+  uint32_t m_txRx;  //!< Number of packets traced by TxRxPointToPoint
+  uint32_t m_macRx; //!< Number of packets received by the peer
+};
+
+PointToPointCrossSystemTest::PointToPointCrossSystemTest ()
+  : TestCase ("Check a link between nodes of different system ids"),
+    m_txRx (0),
+    m_macRx (0)
+{
+}
+
+void
+PointToPointCrossSystemTest::SendOnePacket (Ptr<NetDevice> device, Address dest)
+{
+  device->Send (Create<Packet> (100), dest, 0x800);
+}
+
+void
+PointToPointCrossSystemTest::TxRx (Ptr<const Packet> p, Ptr<NetDevice> tx, Ptr<NetDevice> rx, Time txTime, Time rxTime)
+{
+  m_txRx++;
+}
+
+void
+PointToPointCrossSystemTest::MacRx (Ptr<const Packet> p)
+{
+  m_macRx++;
+}
+
+void
+PointToPointCrossSystemTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Add (CreateObject<Node> (0));
+  nodes.Add (CreateObject<Node> (1));
+
+  PointToPointHelper p2p;
+  NetDeviceContainer devices = p2p.Install (nodes);
+  Ptr<NetDevice> devA = devices.Get (0);
+  Ptr<NetDevice> devB = devices.Get (1);
+  devA->GetChannel ()->TraceConnectWithoutContext ("TxRxPointToPoint", MakeCallback (&PointToPointCrossSystemTest::TxRx, this));
+  devB->TraceConnectWithoutContext ("MacRx", MakeCallback (&PointToPointCrossSystemTest::MacRx, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointCrossSystemTest::SendOnePacket, this, devA, devB->GetAddress ());
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsMultithreaded (), false, "The default simulator is not multithreaded");
+  NS_TEST_EXPECT_MSG_EQ (m_macRx, 1, "The packet should be received");
+  NS_TEST_EXPECT_MSG_EQ (m_txRx, 1, "The TxRxPointToPoint trace should be fired");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -110,6 +386,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointSendManyTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCrossSystemTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
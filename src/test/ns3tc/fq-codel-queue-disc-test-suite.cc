@@ -33,6 +33,8 @@
 #include "ns3/udp-header.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 
 using namespace ns3;
 
@@ -80,6 +82,50 @@ Ipv4TestPacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
   return 0;
 }
 
+/**
+ * Simple test packet filter classifying IPv4 packets based on their size
+ *
+ */
+class Ipv4SizeTestPacketFilter : public Ipv4PacketFilter {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  Ipv4SizeTestPacketFilter ();
+  virtual ~Ipv4SizeTestPacketFilter ();
+
+private:
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+};
+
+TypeId
+Ipv4SizeTestPacketFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4SizeTestPacketFilter")
+    .SetParent<Ipv4PacketFilter> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4SizeTestPacketFilter> ()
+  ;
+  return tid;
+}
+
+Ipv4SizeTestPacketFilter::Ipv4SizeTestPacketFilter ()
+{
+}
+
+Ipv4SizeTestPacketFilter::~Ipv4SizeTestPacketFilter ()
+{
+}
+
+int32_t
+Ipv4SizeTestPacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  return item->GetPacket ()->GetSize ();
+}
+
 /**
  * This class tests packets for which there is no suitable filter
  */
@@ -513,6 +559,130 @@ FqCoDelQueueDiscUDPFlowsSeparation::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * This class tests the set associative hash
+ */
+class FqCoDelQueueDiscSetAssociativeHash : public TestCase
+{
+public:
+  FqCoDelQueueDiscSetAssociativeHash ();
+  virtual ~FqCoDelQueueDiscSetAssociativeHash ();
+
+private:
+  virtual void DoRun (void);
+  void AddPacket (Ptr<FqCoDelQueueDisc> queue, uint32_t hash);
+};
+
+FqCoDelQueueDiscSetAssociativeHash::FqCoDelQueueDiscSetAssociativeHash ()
+  : TestCase ("Test the set associative hash")
+{
+}
+
+FqCoDelQueueDiscSetAssociativeHash::~FqCoDelQueueDiscSetAssociativeHash ()
+{
+}
+
+void
+FqCoDelQueueDiscSetAssociativeHash::AddPacket (Ptr<FqCoDelQueueDisc> queue, uint32_t hash)
+{
+  // the test packet filter uses the size of the packet as the hash of the flow
+  Ptr<Packet> p = Create<Packet> (hash);
+  Address dest;
+  Ipv4Header hdr;
+  hdr.SetPayloadSize (hash);
+  Ptr<Ipv4QueueDiscItem> item = Create<Ipv4QueueDiscItem> (p, dest, 0, hdr);
+  queue->Enqueue (item);
+}
+
+void
+FqCoDelQueueDiscSetAssociativeHash::DoRun (void)
+{
+  // Without the set associative hash, flows whose hashes are congruent modulo
+  // the number of flows share the same flow queue
+  Ptr<FqCoDelQueueDisc> queueDisc = CreateObjectWithAttributes<FqCoDelQueueDisc> ("Flows", UintegerValue (16));
+  queueDisc->AddPacketFilter (CreateObject<Ipv4SizeTestPacketFilter> ());
+  queueDisc->SetQuantum (1500);
+  queueDisc->Initialize ();
+
+  for (uint32_t k = 0; k < 9; k++)
+    {
+      AddPacket (queueDisc, k * 16);
+    }
+  AddPacket (queueDisc, 8);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 2, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 9, "unexpected number of packets in the first flow queue");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the second flow queue");
+
+  // With the set associative hash, such flows are assigned distinct queues of
+  // the same set, as long as the set has queues available
+  queueDisc = CreateObjectWithAttributes<FqCoDelQueueDisc> ("Flows", UintegerValue (16),
+                                                            "EnableSetAssociativeHash", BooleanValue (true),
+                                                            "SetWays", UintegerValue (8));
+  queueDisc->AddPacketFilter (CreateObject<Ipv4SizeTestPacketFilter> ());
+  queueDisc->SetQuantum (1500);
+  queueDisc->Initialize ();
+
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      AddPacket (queueDisc, k * 16);
+    }
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 8, "unexpected number of flow queues");
+
+  // Another packet of an existing flow is stored in the queue of that flow
+  AddPacket (queueDisc, 48);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 8, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (3)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the fourth flow queue");
+
+  // All the queues of the set are busy, hence the first queue of the set is used
+  AddPacket (queueDisc, 128);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 8, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 2, "unexpected number of packets in the first flow queue");
+
+  // A flow of another set is assigned a queue of that set
+  AddPacket (queueDisc, 8);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 9, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (8)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the flow queue");
+
+  // Once all the flows are inactive, a new flow reuses the first queue of the set
+  while (queueDisc->Dequeue ())
+    {
+    }
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 0, "the queue disc should be empty");
+  AddPacket (queueDisc, 144);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 9, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 1, "unexpected number of packets in the first flow queue");
+
+  // A flow keeps its queue even if an inactive queue precedes it in the set
+  queueDisc = CreateObjectWithAttributes<FqCoDelQueueDisc> ("Flows", UintegerValue (16),
+                                                            "EnableSetAssociativeHash", BooleanValue (true),
+                                                            "SetWays", UintegerValue (8));
+  queueDisc->AddPacketFilter (CreateObject<Ipv4SizeTestPacketFilter> ());
+  queueDisc->SetQuantum (1500);
+  queueDisc->Initialize ();
+
+  AddPacket (queueDisc, 16);
+  for (uint32_t k = 0; k < 200; k++)
+    {
+      AddPacket (queueDisc, 32);
+    }
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 2, "unexpected number of flow queues");
+  Ptr<FqCoDelFlow> first = StaticCast<FqCoDelFlow> (queueDisc->GetQueueDiscClass (0));
+  Ptr<FqCoDelFlow> second = StaticCast<FqCoDelFlow> (queueDisc->GetQueueDiscClass (1));
+  // serve the flows until the queue of the first flow becomes inactive
+  while (first->GetStatus () != FqCoDelFlow::INACTIVE && queueDisc->Dequeue ())
+    {
+    }
+  NS_TEST_ASSERT_MSG_EQ (first->GetStatus (), FqCoDelFlow::INACTIVE, "the first flow queue should be inactive");
+  uint32_t nPackets = second->GetQueueDisc ()->GetNPackets ();
+  NS_TEST_ASSERT_MSG_GT (nPackets, 0, "the second flow should still have packets");
+  AddPacket (queueDisc, 32);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 2, "unexpected number of flow queues");
+  NS_TEST_ASSERT_MSG_EQ (first->GetQueueDisc ()->GetNPackets (), 0, "the inactive flow queue should not be used");
+  NS_TEST_ASSERT_MSG_EQ (second->GetQueueDisc ()->GetNPackets (), nPackets + 1, "all the packets of a flow should be in one queue");
+
+  Simulator::Destroy ();
+}
+
 class FqCoDelQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -527,6 +697,7 @@ FqCoDelQueueDiscTestSuite::FqCoDelQueueDiscTestSuite ()
   AddTestCase (new FqCoDelQueueDiscDeficit, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscTCPFlowsSeparation, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscUDPFlowsSeparation, TestCase::QUICK);
+  AddTestCase (new FqCoDelQueueDiscSetAssociativeHash, TestCase::QUICK);
 }
 
 static FqCoDelQueueDiscTestSuite fqCoDelQueueDiscTestSuite;
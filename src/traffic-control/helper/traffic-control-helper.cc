@@ -352,16 +352,9 @@ TrafficControlHelper::SetQueueLimits (std::string type,
   m_queueLimitsFactory.Set (n08, v08);
 }
 
-QueueDiscContainer
-TrafficControlHelper::Install (Ptr<NetDevice> d)
+Ptr<QueueDisc>
+TrafficControlHelper::CreateQueueDiscs (void)
 {
-  QueueDiscContainer container;
-
-  // A TrafficControlLayer object is aggregated by the InternetStackHelper, but check
-  // anyway because a queue disc has no effect without a TrafficControlLayer object
-  Ptr<TrafficControlLayer> tc = d->GetNode ()->GetObject<TrafficControlLayer> ();
-  NS_ASSERT (tc != 0);
-
   // Start from an empty vector of queue discs
   m_queueDiscs.clear ();
   m_queueDiscs.resize (m_queueDiscFactory.size ());
@@ -372,11 +365,29 @@ TrafficControlHelper::Install (Ptr<NetDevice> d)
       m_queueDiscs[i] = m_queueDiscFactory[i].CreateQueueDisc (m_queueDiscs);
     }
 
+  if (m_queueDiscs.empty ())
+    {
+      return 0;
+    }
+  return m_queueDiscs[0];
+}
+
+QueueDiscContainer
+TrafficControlHelper::Install (Ptr<NetDevice> d)
+{
+  QueueDiscContainer container;
+
+  // A TrafficControlLayer object is aggregated by the InternetStackHelper, but check
+  // anyway because a queue disc has no effect without a TrafficControlLayer object
+  Ptr<TrafficControlLayer> tc = d->GetNode ()->GetObject<TrafficControlLayer> ();
+  NS_ASSERT (tc != 0);
+
   // Set the root queue disc (if any has been created) on the device
-  if (!m_queueDiscs.empty () && m_queueDiscs[0])
+  Ptr<QueueDisc> root = CreateQueueDiscs ();
+  if (root)
     {
-      tc->SetRootQueueDiscOnDevice (d, m_queueDiscs[0]);
-      container.Add (m_queueDiscs[0]);
+      tc->SetRootQueueDiscOnDevice (d, root);
+      container.Add (root);
     }
 
   // Queue limits objects can only be installed if a netdevice queue interface
@@ -437,5 +448,55 @@ TrafficControlHelper::Uninstall (NetDeviceContainer c)
     }
 }
 
+QueueDiscContainer
+TrafficControlHelper::InstallIngress (Ptr<NetDevice> d)
+{
+  QueueDiscContainer container;
+
+  Ptr<TrafficControlLayer> tc = d->GetNode ()->GetObject<TrafficControlLayer> ();
+  NS_ASSERT (tc != 0);
+
+  // Set the root queue disc (if any has been created) on the ingress of the device
+  Ptr<QueueDisc> root = CreateQueueDiscs ();
+  if (root)
+    {
+      tc->SetIngressQueueDiscOnDevice (d, root);
+      container.Add (root);
+    }
+
+  return container;
+}
+
+QueueDiscContainer
+TrafficControlHelper::InstallIngress (NetDeviceContainer c)
+{
+  QueueDiscContainer container;
+
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      container.Add (InstallIngress (*i));
+    }
+
+  return container;
+}
+
+void
+TrafficControlHelper::UninstallIngress (Ptr<NetDevice> d)
+{
+  Ptr<TrafficControlLayer> tc = d->GetNode ()->GetObject<TrafficControlLayer> ();
+  NS_ASSERT (tc != 0);
+
+  tc->DeleteIngressQueueDiscOnDevice (d);
+}
+
+void
+TrafficControlHelper::UninstallIngress (NetDeviceContainer c)
+{
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      UninstallIngress (*i);
+    }
+}
+
 
 } // namespace ns3
@@ -490,7 +490,50 @@ public:
    */
   void Uninstall (Ptr<NetDevice> d);
 
+  /**
+   * \param c set of devices
+   * \returns a QueueDisc container with the queue discs installed on the ingress of the devices
+   *
+   * This method creates the queue discs (along with their packet filters,
+   * internal queues, classes) configured with the methods provided by this
+   * class and installs them on the ingress of each device in the given
+   * container. The packets received by a device are enqueued into its ingress
+   * queue disc and passed to the upper layers when they are dequeued. Queue
+   * limits objects are not installed.
+   */
+  QueueDiscContainer InstallIngress (NetDeviceContainer c);
+
+  /**
+   * \param d device
+   * \returns a QueueDisc container with the queue disc installed on the ingress of the device
+   *
+   * This method creates the queue discs (along with their packet filters,
+   * internal queues, classes) configured with the methods provided by this
+   * class and installs them on the ingress of the given device.
+   */
+  QueueDiscContainer InstallIngress (Ptr<NetDevice> d);
+
+  /**
+   * \param c set of devices
+   *
+   * This method removes the queue discs installed on the ingress of the given devices.
+   */
+  void UninstallIngress (NetDeviceContainer c);
+
+  /**
+   * \param d device
+   *
+   * This method removes the queue disc installed on the ingress of the given device.
+   */
+  void UninstallIngress (Ptr<NetDevice> d);
+
 private:
+  /**
+   * \brief Create the queue discs configured with the methods provided by this class
+   * \return the root queue disc, if any has been created
+   */
+  Ptr<QueueDisc> CreateQueueDiscs (void);
+
   /// QueueDisc factory, stores the configuration of all the queue discs
   std::vector<QueueDiscFactory> m_queueDiscFactory;
   /// Vector of all the created queue discs
@@ -0,0 +1,811 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the structure of the Linux CAKE queue disc
+ * (net/sched/sch_cake.c) by Jonathan Morton and Toke Hoeiland-Joergensen.
+ * Flow queues are managed by CoDel, rather than by COBALT.
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/integer.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/hash.h"
+#include "cake-queue-disc.h"
+#include "codel-queue-disc.h"
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CakeQueueDisc");
+
+namespace {
+/// Entry of the flow table for a flow queue that has not been created yet
+const uint32_t NO_FLOW_QUEUE = std::numeric_limits<uint32_t>::max ();
+
+/// Largest packet size used to compute flow quanta and CoDel targets
+const uint32_t CAKE_MTU = 1514;
+
+/// Tin of each DiffServ codepoint in diffserv3 mode (0: Bulk, 1: Best Effort, 2: Voice)
+const uint8_t DIFFSERV3_TINS[64] = {
+  1, 0, 1, 1, 1, 1, 1, 1,   // LE
+  0, 1, 1, 1, 1, 1, 1, 1,   // CS1
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 2, 1, 2, 1,   // VA, EF
+  2, 1, 1, 1, 1, 1, 1, 1,   // CS6
+  2, 1, 1, 1, 1, 1, 1, 1    // CS7
+};
+
+/// Tin of each DiffServ codepoint in diffserv4 mode (0: Bulk, 1: Best Effort, 2: Video, 3: Voice)
+const uint8_t DIFFSERV4_TINS[64] = {
+  1, 0, 1, 1, 1, 1, 1, 1,   // LE
+  0, 1, 1, 1, 1, 1, 1, 1,   // CS1
+  2, 1, 2, 1, 2, 1, 2, 1,   // CS2, AF2x
+  2, 1, 2, 1, 2, 1, 2, 1,   // CS3, AF3x
+  3, 1, 2, 1, 2, 1, 2, 1,   // CS4, AF4x
+  3, 1, 1, 1, 3, 1, 3, 1,   // CS5, VA, EF
+  3, 1, 1, 1, 1, 1, 1, 1,   // CS6
+  3, 1, 1, 1, 1, 1, 1, 1    // CS7
+};
+}
+
+NS_OBJECT_ENSURE_REGISTERED (CakeFlow);
+
+TypeId CakeFlow::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CakeFlow")
+    .SetParent<FqCoDelFlow> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<CakeFlow> ()
+  ;
+  return tid;
+}
+
+CakeFlow::CakeFlow ()
+  : m_tin (0),
+    m_srcHost (0),
+    m_dstHost (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CakeFlow::~CakeFlow ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CakeFlow::SetTin (uint32_t tin)
+{
+  NS_LOG_FUNCTION (this << tin);
+  m_tin = tin;
+}
+
+uint32_t
+CakeFlow::GetTin (void) const
+{
+  return m_tin;
+}
+
+void
+CakeFlow::SetHosts (uint32_t srcHost, uint32_t dstHost)
+{
+  NS_LOG_FUNCTION (this << srcHost << dstHost);
+  m_srcHost = srcHost;
+  m_dstHost = dstHost;
+}
+
+uint32_t
+CakeFlow::GetSrcHost (void) const
+{
+  return m_srcHost;
+}
+
+uint32_t
+CakeFlow::GetDstHost (void) const
+{
+  return m_dstHost;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (CakeFlowQueue);
+
+TypeId CakeFlowQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CakeFlowQueue")
+    .SetParent<Queue<QueueDiscItem> > ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<CakeFlowQueue> ()
+  ;
+  return tid;
+}
+
+CakeFlowQueue::CakeFlowQueue ()
+  : NS_LOG_TEMPLATE_DEFINE ("CakeQueueDisc")
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CakeFlowQueue::~CakeFlowQueue ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+CakeFlowQueue::Enqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  return DoEnqueue (Tail (), item);
+}
+
+Ptr<QueueDiscItem>
+CakeFlowQueue::Dequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+  return DoDequeue (Head ());
+}
+
+Ptr<QueueDiscItem>
+CakeFlowQueue::Remove (void)
+{
+  NS_LOG_FUNCTION (this);
+  return DoRemove (Head ());
+}
+
+Ptr<const QueueDiscItem>
+CakeFlowQueue::Peek (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return DoPeek (Head ());
+}
+
+Ptr<QueueDiscItem>
+CakeFlowQueue::DequeueRedundantAck (Ptr<const QueueDiscItem> ack)
+{
+  NS_LOG_FUNCTION (this << ack);
+
+  for (auto it = Head (); it != Tail (); it++)
+    {
+      if ((*it)->IsRedundantAck (ack))
+        {
+          NS_LOG_DEBUG ("Found an acknowledgment made redundant by " << ack);
+          return DoDequeue (it);
+        }
+    }
+  return 0;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (CakeQueueDisc);
+
+TypeId CakeQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CakeQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<CakeQueueDisc> ()
+    .AddAttribute ("MaxSize",
+                   "The maximum number of packets accepted by this queue disc",
+                   QueueSizeValue (QueueSize ("10240p")),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+    .AddAttribute ("Bandwidth",
+                   "The rate of the shaper (0 to disable the shaper)",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&CakeQueueDisc::m_bandwidth),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Overhead",
+                   "The number of bytes added to the size of each packet by the shaper",
+                   IntegerValue (0),
+                   MakeIntegerAccessor (&CakeQueueDisc::m_overhead),
+                   MakeIntegerChecker<int32_t> (-64, 256))
+    .AddAttribute ("Mpu",
+                   "The minimum packet size (in bytes) considered by the shaper",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CakeQueueDisc::m_mpu),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DiffServMode",
+                   "The set of tins packets are classified into",
+                   EnumValue (DIFFSERV3),
+                   MakeEnumAccessor (&CakeQueueDisc::m_diffServMode),
+                   MakeEnumChecker (BESTEFFORT, "Besteffort",
+                                    DIFFSERV3, "Diffserv3",
+                                    DIFFSERV4, "Diffserv4"))
+    .AddAttribute ("FlowMode",
+                   "The criteria used to isolate traffic",
+                   EnumValue (TRIPLE_ISOLATE),
+                   MakeEnumAccessor (&CakeQueueDisc::m_flowMode),
+                   MakeEnumChecker (FLOWS, "Flows",
+                                    SRC_HOST, "SrcHost",
+                                    DST_HOST, "DstHost",
+                                    HOSTS, "Hosts",
+                                    DUAL_SRC, "DualSrcHost",
+                                    DUAL_DST, "DualDstHost",
+                                    TRIPLE_ISOLATE, "TripleIsolate"))
+    .AddAttribute ("AckFilter",
+                   "Whether to drop the TCP acknowledgments made redundant by a newly arrived acknowledgment",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CakeQueueDisc::m_ackFilter),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Flows",
+                   "The number of flow queues of each tin",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&CakeQueueDisc::m_flows),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SetWays",
+                   "The size of a set of flow queues used by the set associative hash",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&CakeQueueDisc::m_setWays),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Target",
+                   "The CoDel algorithm target queue delay for each flow queue",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&CakeQueueDisc::m_target),
+                   MakeTimeChecker ())
+    .AddAttribute ("Interval",
+                   "The CoDel algorithm interval for each flow queue",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&CakeQueueDisc::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("Perturbation",
+                   "The salt used as an additional input to the hash functions used to classify packets",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&CakeQueueDisc::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+CakeQueueDisc::CakeQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::MULTIPLE_QUEUES),
+    m_curTin (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CakeQueueDisc::~CakeQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CakeQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Remove (m_id);
+  m_tins.clear ();
+  QueueDisc::DoDispose ();
+}
+
+uint32_t
+CakeQueueDisc::GetNTins (void) const
+{
+  return m_tins.size ();
+}
+
+uint32_t
+CakeQueueDisc::ClassifyTin (Ptr<const QueueDiscItem> item) const
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint8_t tos;
+  if (m_diffServMode == BESTEFFORT || !item->GetUint8Value (QueueItem::IP_DSFIELD, tos))
+    {
+      return (m_diffServMode == BESTEFFORT ? 0 : 1);
+    }
+
+  uint8_t dscp = tos >> 2;
+  return (m_diffServMode == DIFFSERV3 ? DIFFSERV3_TINS[dscp] : DIFFSERV4_TINS[dscp]);
+}
+
+uint32_t
+CakeQueueDisc::GetAdjustedSize (Ptr<const QueueDiscItem> item) const
+{
+  int64_t size = static_cast<int64_t> (item->GetSize ()) + m_overhead;
+  return std::max<int64_t> (std::max<int64_t> (size, m_mpu), 1);
+}
+
+uint32_t
+CakeQueueDisc::SetAssociativeHostHash (std::vector<uint32_t> &tags, const std::vector<uint32_t> &load,
+                                       uint32_t hostHash) const
+{
+  NS_LOG_FUNCTION (this << hostHash);
+
+  uint32_t h = hostHash % m_flows;
+  uint32_t outerHash = h - h % m_setWays;
+
+  for (uint32_t i = outerHash; i < outerHash + m_setWays; i++)
+    {
+      if (tags[i] == hostHash && load[i] > 0)
+        {
+          return i;
+        }
+    }
+
+  for (uint32_t i = outerHash; i < outerHash + m_setWays; i++)
+    {
+      if (load[i] == 0)
+        {
+          tags[i] = hostHash;
+          return i;
+        }
+    }
+
+  // all the entries of the set are used. Share the first entry of the set
+  return outerHash;
+}
+
+bool
+CakeQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t t = ClassifyTin (item);
+  Tin &tin = m_tins[t];
+
+  uint32_t srcHash = 0, dstHash = 0, flowHash;
+
+  if (m_flowMode != FLOWS)
+    {
+      srcHash = item->HostHash (true, m_perturbation);
+      dstHash = item->HostHash (false, m_perturbation);
+    }
+
+  if (m_flowMode == SRC_HOST)
+    {
+      flowHash = srcHash;
+    }
+  else if (m_flowMode == DST_HOST)
+    {
+      flowHash = dstHash;
+    }
+  else if (m_flowMode == HOSTS)
+    {
+      uint32_t buf[2] = {srcHash, dstHash};
+      flowHash = Hash32 ((char*) buf, sizeof (buf));
+    }
+  else
+    {
+      flowHash = item->Hash (m_perturbation);
+    }
+
+  uint32_t h = FqCoDelQueueDisc::SetAssociativeHash (this, tin.flowsIndices, tin.flowTags, m_setWays, flowHash);
+
+  Ptr<CakeFlow> flow;
+  if (tin.flowsIndices[h] == NO_FLOW_QUEUE)
+    {
+      NS_LOG_DEBUG ("Creating a new flow queue with index " << h << " in tin " << t);
+      flow = m_flowFactory.Create<CakeFlow> ();
+      flow->SetTin (t);
+      Ptr<QueueDisc> qd = tin.queueDiscFactory.Create<QueueDisc> ();
+      Ptr<CakeFlowQueue> queue = CreateObject<CakeFlowQueue> ();
+      queue->SetMaxSize (GetMaxSize ());
+      qd->AddInternalQueue (queue);
+      qd->Initialize ();
+      flow->SetQueueDisc (qd);
+      AddQueueDiscClass (flow);
+
+      tin.flowsIndices[h] = GetNQueueDiscClasses () - 1;
+    }
+  else
+    {
+      flow = StaticCast<CakeFlow> (GetQueueDiscClass (tin.flowsIndices[h]));
+    }
+
+  if (GetNPackets () == 0 && m_timeNext < Simulator::Now ())
+    {
+      // the shaper does not accumulate credit while the queue disc is idle
+      m_timeNext = Simulator::Now ();
+    }
+
+  if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
+    {
+      uint32_t srcHost = SetAssociativeHostHash (tin.srcHostTags, tin.srcHostLoad, srcHash);
+      uint32_t dstHost = SetAssociativeHostHash (tin.dstHostTags, tin.dstHostLoad, dstHash);
+      tin.srcHostLoad[srcHost]++;
+      tin.dstHostLoad[dstHost]++;
+      flow->SetHosts (srcHost, dstHost);
+
+      flow->SetStatus (FqCoDelFlow::NEW_FLOW);
+      flow->SetDeficit (GetFlowQuantum (tin, flow));
+      tin.newFlows.push_back (flow);
+    }
+  else if (m_ackFilter)
+    {
+      Ptr<QueueDisc> qd = flow->GetQueueDisc ();
+      Ptr<QueueDiscItem> ack = StaticCast<CakeFlowQueue> (qd->GetInternalQueue (0))->DequeueRedundantAck (item);
+      if (ack)
+        {
+          DropAfterDequeue (ack, ACK_FILTER_DROP);
+        }
+    }
+
+  flow->GetQueueDisc ()->Enqueue (item);
+
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h << " of tin " << t << "; flow index " << tin.flowsIndices[h]);
+
+  while (GetCurrentSize () > GetMaxSize ())
+    {
+      CakeDrop ();
+    }
+
+  return true;
+}
+
+uint32_t
+CakeQueueDisc::GetFlowQuantum (const Tin &tin, Ptr<CakeFlow> flow) const
+{
+  uint32_t load = 1;
+
+  switch (m_flowMode)
+    {
+    case DUAL_SRC:
+      load = tin.srcHostLoad[flow->GetSrcHost ()];
+      break;
+    case DUAL_DST:
+      load = tin.dstHostLoad[flow->GetDstHost ()];
+      break;
+    case TRIPLE_ISOLATE:
+      load = std::max (tin.srcHostLoad[flow->GetSrcHost ()], tin.dstHostLoad[flow->GetDstHost ()]);
+      break;
+    default:
+      break;
+    }
+
+  return std::max<uint32_t> (tin.flowQuantum / std::max<uint32_t> (load, 1), 1);
+}
+
+void
+CakeQueueDisc::DeactivateFlow (Tin &tin, Ptr<CakeFlow> flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+
+  NS_ASSERT (tin.srcHostLoad[flow->GetSrcHost ()] > 0 && tin.dstHostLoad[flow->GetDstHost ()] > 0);
+  tin.srcHostLoad[flow->GetSrcHost ()]--;
+  tin.dstHostLoad[flow->GetDstHost ()]--;
+  flow->SetStatus (FqCoDelFlow::INACTIVE);
+}
+
+int32_t
+CakeQueueDisc::SelectTin (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_bandwidth.GetBitRate () == 0)
+    {
+      // deficit round robin among tins
+      bool wrapped = false, empty = true;
+
+      while (m_tins[m_curTin].deficit < 0
+             || (m_tins[m_curTin].newFlows.empty () && m_tins[m_curTin].oldFlows.empty ()))
+        {
+          Tin &tin = m_tins[m_curTin];
+          if (tin.deficit <= 0)
+            {
+              tin.deficit += tin.quantum;
+            }
+          if (!tin.newFlows.empty () || !tin.oldFlows.empty ())
+            {
+              empty = false;
+            }
+
+          if (++m_curTin == m_tins.size ())
+            {
+              m_curTin = 0;
+              if (wrapped && empty)
+                {
+                  return -1;
+                }
+              wrapped = true;
+            }
+        }
+      return m_curTin;
+    }
+
+  // serve the highest priority tin below its threshold or, if none, the tin
+  // scheduled the earliest
+  Time now = Simulator::Now ();
+  Time bestTime = Time::Max ();
+  int32_t bestTin = -1;
+
+  for (uint32_t i = 0; i < m_tins.size (); i++)
+    {
+      if (!m_tins[i].newFlows.empty () || !m_tins[i].oldFlows.empty ())
+        {
+          Time timeToPkt = m_tins[i].timeNext - now;
+          if (!timeToPkt.IsStrictlyPositive () || timeToPkt <= bestTime)
+            {
+              bestTime = timeToPkt;
+              bestTin = i;
+            }
+        }
+    }
+  return bestTin;
+}
+
+Ptr<QueueDiscItem>
+CakeQueueDisc::DequeueFromTin (Tin &tin)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<CakeFlow> flow;
+  Ptr<QueueDiscItem> item;
+
+  do
+    {
+      bool found = false;
+
+      while (!found && !tin.newFlows.empty ())
+        {
+          flow = tin.newFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (GetFlowQuantum (tin, flow));
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              tin.oldFlows.push_back (flow);
+              tin.newFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found a new flow with positive deficit");
+              found = true;
+            }
+        }
+
+      while (!found && !tin.oldFlows.empty ())
+        {
+          flow = tin.oldFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (GetFlowQuantum (tin, flow));
+              tin.oldFlows.push_back (flow);
+              tin.oldFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found an old flow with positive deficit");
+              found = true;
+            }
+        }
+
+      if (!found)
+        {
+          NS_LOG_DEBUG ("No flow found to dequeue a packet");
+          return 0;
+        }
+
+      item = flow->GetQueueDisc ()->Dequeue ();
+
+      if (!item)
+        {
+          NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
+          if (!tin.newFlows.empty ())
+            {
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              tin.oldFlows.push_back (flow);
+              tin.newFlows.pop_front ();
+            }
+          else
+            {
+              DeactivateFlow (tin, flow);
+              tin.oldFlows.pop_front ();
+            }
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Dequeued packet " << item->GetPacket ());
+        }
+    } while (item == 0);
+
+  flow->IncreaseDeficit (-static_cast<int32_t> (GetAdjustedSize (item)));
+
+  return item;
+}
+
+Ptr<QueueDiscItem>
+CakeQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetNPackets () == 0)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Time now = Simulator::Now ();
+  bool shaped = (m_bandwidth.GetBitRate () > 0);
+
+  if (shaped && m_timeNext > now)
+    {
+      if (!m_id.IsRunning ())
+        {
+          m_id = Simulator::Schedule (m_timeNext - now, &QueueDisc::Run, this);
+          NS_LOG_LOGIC ("Waking Event Scheduled in " << m_timeNext - now);
+        }
+      return 0;
+    }
+
+  int32_t t;
+  while ((t = SelectTin ()) >= 0)
+    {
+      Tin &tin = m_tins[t];
+      Ptr<QueueDiscItem> item = DequeueFromTin (tin);
+
+      if (!item)
+        {
+          // all the flows of the tin turned out to be empty
+          continue;
+        }
+
+      uint32_t len = GetAdjustedSize (item);
+
+      if (shaped)
+        {
+          // charge the packet to the tin and to the shaper
+          Time tinDur = tin.rate.CalculateBytesTxTime (len);
+          if (tin.timeNext < now)
+            {
+              tin.timeNext += tinDur;
+            }
+          else if (tin.timeNext < now + tinDur)
+            {
+              tin.timeNext = now + tinDur;
+            }
+          m_timeNext += m_bandwidth.CalculateBytesTxTime (len);
+        }
+      else
+        {
+          tin.deficit -= len;
+        }
+
+      NS_LOG_LOGIC ("Dequeued packet from tin " << t);
+      return item;
+    }
+
+  NS_LOG_LOGIC ("Queue empty");
+  return 0;
+}
+
+void
+CakeQueueDisc::CakeDrop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t maxBacklog = 0, index = 0;
+  Ptr<QueueDisc> qd;
+
+  /* Queue is full! Find the fat flow and drop a packet from it */
+  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      qd = GetQueueDiscClass (i)->GetQueueDisc ();
+      uint32_t bytes = qd->GetNBytes ();
+      if (bytes > maxBacklog)
+        {
+          maxBacklog = bytes;
+          index = i;
+        }
+    }
+
+  qd = GetQueueDiscClass (index)->GetQueueDisc ();
+  Ptr<QueueDiscItem> item = qd->GetInternalQueue (0)->Dequeue ();
+  NS_ASSERT (item);
+  DropAfterDequeue (item, OVERLIMIT_DROP);
+}
+
+bool
+CakeQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("CakeQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("CakeQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("CakeQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  if (m_setWays == 0 || m_flows == 0 || m_flows % m_setWays != 0)
+    {
+      NS_LOG_ERROR ("The number of flow queues must be a positive multiple of the size of the sets");
+      return false;
+    }
+
+  return true;
+}
+
+void
+CakeQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flowFactory.SetTypeId ("ns3::CakeFlow");
+
+  // bandwidth thresholds (as right shifts of the bandwidth) and DRR quanta
+  // of the tins, in increasing order of priority
+  std::vector<std::pair<uint8_t, uint32_t> > tins;
+  switch (m_diffServMode)
+    {
+    case BESTEFFORT:
+      tins = {{0, 65535}};
+      break;
+    case DIFFSERV3:
+      tins = {{4, 16}, {0, 256}, {2, 64}};
+      break;
+    case DIFFSERV4:
+      tins = {{4, 64}, {0, 1024}, {1, 512}, {2, 256}};
+      break;
+    }
+
+  m_tins.assign (tins.size (), Tin ());
+  m_curTin = 0;
+  m_timeNext = Time (0);
+
+  for (uint32_t i = 0; i < m_tins.size (); i++)
+    {
+      Tin &tin = m_tins[i];
+      tin.rate = DataRate (m_bandwidth.GetBitRate () >> tins[i].first);
+      tin.quantum = tins[i].second;
+      tin.deficit = 0;
+      tin.timeNext = Time (0);
+
+      Time target = m_target;
+      Time interval = m_interval;
+      tin.flowQuantum = CAKE_MTU;
+
+      if (tin.rate.GetBitRate () > 0)
+        {
+          // the target must allow at least 1.5 MTU-sized packets to be sent
+          Time mtuTime = tin.rate.CalculateBytesTxTime (CAKE_MTU);
+          target = std::max (mtuTime + mtuTime / 2, m_target);
+          interval = std::max (m_interval + target - m_target, target * 2);
+          tin.flowQuantum = std::min<uint64_t> (std::max<uint64_t> ((tin.rate.GetBitRate () / 8) >> 12, 300),
+                                                CAKE_MTU);
+        }
+
+      tin.queueDiscFactory.SetTypeId ("ns3::CoDelQueueDisc");
+      tin.queueDiscFactory.Set ("MaxSize", QueueSizeValue (GetMaxSize ()));
+      tin.queueDiscFactory.Set ("Target", TimeValue (target));
+      tin.queueDiscFactory.Set ("Interval", TimeValue (interval));
+
+      tin.flowsIndices.assign (m_flows, NO_FLOW_QUEUE);
+      tin.flowTags.assign (m_flows, 0);
+      tin.srcHostTags.assign (m_flows, 0);
+      tin.srcHostLoad.assign (m_flows, 0);
+      tin.dstHostTags.assign (m_flows, 0);
+      tin.dstHostLoad.assign (m_flows, 0);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,329 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the structure of the Linux CAKE queue disc
+ * (net/sched/sch_cake.c) by Jonathan Morton and Toke Hoeiland-Joergensen.
+ * Flow queues are managed by CoDel, rather than by COBALT.
+ */
+
+#ifndef CAKE_QUEUE_DISC_H
+#define CAKE_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/queue.h"
+#include "ns3/object-factory.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "fq-codel-queue-disc.h"
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A flow queue used by the Cake queue disc
+ *
+ * In addition to the deficit and the status of the flow queue, a Cake flow
+ * stores the tin it belongs to and the entries of the host tables of its
+ * tin assigned to the source and destination hosts of the flow.
+ */
+class CakeFlow : public FqCoDelFlow {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief CakeFlow constructor
+   */
+  CakeFlow ();
+
+  virtual ~CakeFlow ();
+
+  /**
+   * \brief Set the tin this flow belongs to
+   * \param tin the index of the tin
+   */
+  void SetTin (uint32_t tin);
+  /**
+   * \brief Get the tin this flow belongs to
+   * \return the index of the tin
+   */
+  uint32_t GetTin (void) const;
+  /**
+   * \brief Set the entries of the host tables assigned to this flow
+   * \param srcHost the entry of the table of source hosts
+   * \param dstHost the entry of the table of destination hosts
+   */
+  void SetHosts (uint32_t srcHost, uint32_t dstHost);
+  /**
+   * \brief Get the entry of the table of source hosts assigned to this flow
+   * \return the entry of the table of source hosts
+   */
+  uint32_t GetSrcHost (void) const;
+  /**
+   * \brief Get the entry of the table of destination hosts assigned to this flow
+   * \return the entry of the table of destination hosts
+   */
+  uint32_t GetDstHost (void) const;
+
+private:
+  uint32_t m_tin;       //!< the tin this flow belongs to
+  uint32_t m_srcHost;   //!< the entry of the table of source hosts
+  uint32_t m_dstHost;   //!< the entry of the table of destination hosts
+};
+
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief FIFO queue used as the internal queue of the CoDel queue disc of a Cake flow
+ *
+ * In addition to the FIFO operations, this queue allows to extract the
+ * acknowledgments made redundant by a newly arrived acknowledgment.
+ */
+class CakeFlowQueue : public Queue<QueueDiscItem> {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief CakeFlowQueue constructor
+   */
+  CakeFlowQueue ();
+
+  virtual ~CakeFlowQueue ();
+
+  virtual bool Enqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> Dequeue (void);
+  virtual Ptr<QueueDiscItem> Remove (void);
+  virtual Ptr<const QueueDiscItem> Peek (void) const;
+
+  /**
+   * \brief Dequeue the oldest item made redundant by the given acknowledgment
+   *
+   * The item is counted as dequeued, hence the caller is in charge of dropping it.
+   *
+   * \param ack the newly arrived acknowledgment
+   * \return the redundant item, if any, or 0 otherwise
+   */
+  Ptr<QueueDiscItem> DequeueRedundantAck (Ptr<const QueueDiscItem> ack);
+
+private:
+  NS_LOG_TEMPLATE_DECLARE;     //!< redefinition of the log component
+};
+
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A Cake (Common Applications Kept Enhanced) packet queue disc
+ *
+ * Cake integrates in a single queue disc a shaper, a classifier of packets
+ * into tins based on their DiffServ codepoint and, within each tin, a
+ * flow queuing scheduler providing fairness among flows and among hosts.
+ *
+ * The shaper works in deficit mode: after a packet is dequeued, the time at
+ * which the next packet can be dequeued is advanced by the transmission time
+ * of the packet at the configured bandwidth. Hence, unlike a token bucket,
+ * the shaper does not accumulate tokens while the queue disc is idle and does
+ * not release bursts. When the bandwidth is not set, the shaper is disabled.
+ *
+ * Each tin has a bandwidth threshold. When the shaper is enabled, the tin with
+ * the highest priority among those below their threshold is served; if all the
+ * tins are above their thresholds, the tin that is scheduled the earliest is
+ * served. When the shaper is disabled, tins are served by a deficit round robin
+ * scheduler with weights proportional to their thresholds.
+ *
+ * Within a tin, flows are mapped to flow queues by a set associative hash and
+ * scheduled as in FqCoDel. In the dual and triple isolation modes, the quantum
+ * of a flow is divided by the number of active flows of its source and/or
+ * destination host, so that hosts get a fair share of the bandwidth regardless
+ * of the number of their flows.
+ */
+class CakeQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief CakeQueueDisc constructor
+   */
+  CakeQueueDisc ();
+
+  virtual ~CakeQueueDisc ();
+
+  /**
+   * \enum DiffServMode
+   * \brief The sets of tins packets are classified into
+   */
+  enum DiffServMode
+  {
+    BESTEFFORT,   //!< a single tin
+    DIFFSERV3,    //!< Bulk, Best Effort and Voice tins
+    DIFFSERV4     //!< Bulk, Best Effort, Video and Voice tins
+  };
+
+  /**
+   * \enum FlowMode
+   * \brief The criteria used to isolate traffic
+   */
+  enum FlowMode
+  {
+    FLOWS,          //!< fairness among flows
+    SRC_HOST,       //!< fairness among source hosts
+    DST_HOST,       //!< fairness among destination hosts
+    HOSTS,          //!< fairness among pairs of hosts
+    DUAL_SRC,       //!< fairness among source hosts, then among their flows
+    DUAL_DST,       //!< fairness among destination hosts, then among their flows
+    TRIPLE_ISOLATE  //!< fairness among both source and destination hosts, then among their flows
+  };
+
+  /**
+   * \brief Get the number of tins
+   * \return the number of tins
+   */
+  uint32_t GetNTins (void) const;
+
+  // Reasons for dropping packets
+  static constexpr const char* OVERLIMIT_DROP = "Overlimit drop";      //!< Overlimit dropped packets
+  static constexpr const char* ACK_FILTER_DROP = "Ack filter drop";    //!< Redundant acknowledgments
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief A class of traffic, with its own bandwidth threshold and flow queues
+   */
+  struct Tin
+  {
+    DataRate rate;                          //!< Bandwidth threshold of the tin (0 if the shaper is disabled)
+    uint32_t quantum;                       //!< Deficit assigned to the tin at each round (shaper disabled)
+    int32_t deficit;                        //!< Deficit of the tin (shaper disabled)
+    Time timeNext;                          //!< Time at which the tin falls below its threshold (shaper enabled)
+    uint32_t flowQuantum;                   //!< Deficit assigned to the flows of the tin at each round
+    ObjectFactory queueDiscFactory;         //!< Factory to create the CoDel queue discs of the flows
+    std::list<Ptr<CakeFlow> > newFlows;     //!< The list of new flows
+    std::list<Ptr<CakeFlow> > oldFlows;     //!< The list of old flows
+    std::vector<uint32_t> flowsIndices;     //!< Index of the class of each flow queue, if created
+    std::vector<uint32_t> flowTags;         //!< Hash of the flow assigned to each flow queue
+    std::vector<uint32_t> srcHostTags;      //!< Hash of the host assigned to each entry of the source host table
+    std::vector<uint32_t> srcHostLoad;      //!< Number of active flows of each source host
+    std::vector<uint32_t> dstHostTags;      //!< Hash of the host assigned to each entry of the destination host table
+    std::vector<uint32_t> dstHostLoad;      //!< Number of active flows of each destination host
+  };
+
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Classify a packet into a tin based on its DiffServ codepoint
+   * \param item the packet
+   * \return the index of the tin
+   */
+  uint32_t ClassifyTin (Ptr<const QueueDiscItem> item) const;
+
+  /**
+   * \brief Select the entry of a host table by means of the set associative hash
+   * \param tags the hashes of the hosts assigned to the entries of the table
+   * \param load the number of active flows of the hosts assigned to the entries of the table
+   * \param hostHash the hash of the host
+   * \return the index of the entry
+   */
+  uint32_t SetAssociativeHostHash (std::vector<uint32_t> &tags, const std::vector<uint32_t> &load,
+                                   uint32_t hostHash) const;
+
+  /**
+   * \brief Select the tin to serve
+   * \return the index of the tin, or -1 if no tin has active flows
+   */
+  int32_t SelectTin (void);
+
+  /**
+   * \brief Dequeue a packet from the flows of the given tin
+   * \param tin the tin
+   * \return the dequeued packet, or 0 if the tin has no packet
+   */
+  Ptr<QueueDiscItem> DequeueFromTin (Tin &tin);
+
+  /**
+   * \brief Get the deficit assigned to a flow at each round
+   *
+   * The quantum of the tin is divided by the number of active flows of the
+   * source and/or destination host of the flow, depending on the flow mode.
+   *
+   * \param tin the tin of the flow
+   * \param flow the flow
+   * \return the deficit assigned to the flow
+   */
+  uint32_t GetFlowQuantum (const Tin &tin, Ptr<CakeFlow> flow) const;
+
+  /**
+   * \brief Mark a flow as inactive and update the load of its hosts
+   * \param tin the tin of the flow
+   * \param flow the flow
+   */
+  void DeactivateFlow (Tin &tin, Ptr<CakeFlow> flow);
+
+  /**
+   * \brief Get the size of a packet, as seen by the shaper and the schedulers
+   * \param item the packet
+   * \return the size of the packet, adjusted by the overhead and the MPU
+   */
+  uint32_t GetAdjustedSize (Ptr<const QueueDiscItem> item) const;
+
+  /**
+   * \brief Drop a packet from the head of the flow queue with the largest current byte count
+   */
+  void CakeDrop (void);
+
+  DataRate m_bandwidth;          //!< Rate of the shaper (0 to disable the shaper)
+  int32_t m_overhead;            //!< Overhead added to the size of each packet
+  uint32_t m_mpu;                //!< Minimum packet size
+  DiffServMode m_diffServMode;   //!< Set of tins packets are classified into
+  FlowMode m_flowMode;           //!< Criteria used to isolate traffic
+  bool m_ackFilter;              //!< Whether to drop redundant TCP acknowledgments
+  uint32_t m_flows;              //!< Number of flow queues of each tin
+  uint32_t m_setWays;            //!< Size of a set of flow queues
+  Time m_target;                 //!< CoDel target
+  Time m_interval;               //!< CoDel interval
+  uint32_t m_perturbation;       //!< hash perturbation value
+
+  std::vector<Tin> m_tins;       //!< The tins
+  uint32_t m_curTin;             //!< The tin being served (shaper disabled)
+  Time m_timeNext;               //!< Time at which the shaper allows the next dequeue
+  EventId m_id;                  //!< EventId used to wake up the queue disc when the shaper allows a dequeue
+  ObjectFactory m_flowFactory;   //!< Factory to create a new flow
+};
+
+} // namespace ns3
+
+#endif /* CAKE_QUEUE_DISC_H */
@@ -0,0 +1,360 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the pseudo-code of the DualQ Coupled AQM
+ * described in draft-ietf-tsvwg-aqm-dualq-coupled (Appendix A).
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "dual-pi2-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DualPi2QueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (DualPi2PacketFilter);
+
+TypeId DualPi2PacketFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DualPi2PacketFilter")
+    .SetParent<PacketFilter> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<DualPi2PacketFilter> ()
+  ;
+  return tid;
+}
+
+DualPi2PacketFilter::DualPi2PacketFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DualPi2PacketFilter::~DualPi2PacketFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+DualPi2PacketFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
+{
+  NS_LOG_FUNCTION (this << item);
+  uint8_t tos;
+  return item->GetUint8Value (QueueItem::IP_DSFIELD, tos);
+}
+
+int32_t
+DualPi2PacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  NS_LOG_FUNCTION (this << item);
+  uint8_t tos;
+  item->GetUint8Value (QueueItem::IP_DSFIELD, tos);
+  // ECT(1) (01) and CE (11) packets are L4S packets
+  return ((tos & 0x01) == 0x01) ? 1 : 0;
+}
+
+// ------------------------------------------------------------------------- //
+
+NS_OBJECT_ENSURE_REGISTERED (DualPi2QueueDisc);
+
+TypeId DualPi2QueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DualPi2QueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<DualPi2QueueDisc> ()
+    .AddAttribute ("A",
+                   "Value of alpha (in Hz)",
+                   DoubleValue (0.16),
+                   MakeDoubleAccessor (&DualPi2QueueDisc::m_a),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("B",
+                   "Value of beta (in Hz)",
+                   DoubleValue (3.2),
+                   MakeDoubleAccessor (&DualPi2QueueDisc::m_b),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Tupdate",
+                   "Time period to calculate the base probability",
+                   TimeValue (Seconds (0.016)),
+                   MakeTimeAccessor (&DualPi2QueueDisc::m_tUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueDelayReference",
+                   "Desired queue delay of the classic queue",
+                   TimeValue (Seconds (0.015)),
+                   MakeTimeAccessor (&DualPi2QueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("CouplingFactor",
+                   "Coupling factor between the classic and the L4S queue",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&DualPi2QueueDisc::m_k),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("L4sMarkThreshold",
+                   "Sojourn time above which L4S packets are always marked",
+                   TimeValue (Seconds (0.001)),
+                   MakeTimeAccessor (&DualPi2QueueDisc::m_minTh),
+                   MakeTimeChecker ())
+    .AddAttribute ("TimeShift",
+                   "Time shift applied to the classic queue by the scheduler",
+                   TimeValue (Seconds (0.03)),
+                   MakeTimeAccessor (&DualPi2QueueDisc::m_tShift),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxSize",
+                   "The maximum number of packets accepted by this queue disc",
+                   QueueSizeValue (QueueSize ("10000p")),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+  ;
+
+  return tid;
+}
+
+DualPi2QueueDisc::DualPi2QueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::MULTIPLE_QUEUES)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+}
+
+DualPi2QueueDisc::~DualPi2QueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DualPi2QueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = 0;
+  Simulator::Remove (m_rtrsEvent);
+  QueueDisc::DoDispose ();
+}
+
+Time
+DualPi2QueueDisc::GetQueueDelay (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_qDelay;
+}
+
+double
+DualPi2QueueDisc::GetBaseProbability (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_baseProb;
+}
+
+QueueDisc::ControllerState
+DualPi2QueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ControllerState state;
+  // the classic and L4S probabilities are both derived from the base probability
+  state.queueDelay = m_qDelay;
+  state.probability = m_baseProb;
+  return state;
+}
+
+int64_t
+DualPi2QueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+bool
+DualPi2QueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  if (GetCurrentSize () + item > GetMaxSize ())
+    {
+      // Drops due to queue limit: reactive
+      DropBeforeEnqueue (item, FORCED_DROP);
+      return false;
+    }
+
+  // Packets not matched by any filter are treated as classic packets
+  uint32_t queue = (Classify (item) == 1) ? 1 : 0;
+
+  bool retval = GetInternalQueue (queue)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
+  // internal queue because QueueDisc::AddInternalQueue sets the trace callback
+
+  NS_LOG_LOGIC ("Packet enqueued into " << (queue == 1 ? "L4S" : "classic") << " queue");
+  NS_LOG_LOGIC ("\t packetsInClassicQueue  " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("\t packetsInL4sQueue  " << GetInternalQueue (1)->GetNPackets ());
+
+  return retval;
+}
+
+void
+DualPi2QueueDisc::InitializeParams (void)
+{
+  m_baseProb = 0;
+  m_qDelay = Time (Seconds (0));
+  m_qDelayOld = Time (Seconds (0));
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &DualPi2QueueDisc::CalculateP, this);
+}
+
+bool
+DualPi2QueueDisc::SelectL4s (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (1)->IsEmpty ())
+    {
+      return false;
+    }
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      return true;
+    }
+
+  // Serve the queue whose head packet arrived first, after shifting the
+  // arrival times of the classic packets by m_tShift
+  Time lHead = GetInternalQueue (1)->Peek ()->GetTimeStamp ();
+  Time cHead = GetInternalQueue (0)->Peek ()->GetTimeStamp ();
+
+  return lHead - m_tShift <= cHead;
+}
+
+void DualPi2QueueDisc::CalculateP ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      m_qDelay = Time (Seconds (0));
+    }
+  else
+    {
+      m_qDelay = Simulator::Now () - GetInternalQueue (0)->Peek ()->GetTimeStamp ();
+    }
+
+  double p = m_baseProb
+    + m_a * m_tUpdate.GetSeconds () * (m_qDelay.GetSeconds () - m_qDelayRef.GetSeconds ())
+    + m_b * m_tUpdate.GetSeconds () * (m_qDelay.GetSeconds () - m_qDelayOld.GetSeconds ());
+
+  m_baseProb = std::min (std::max (p, 0.0), 1.0);
+  m_qDelayOld = m_qDelay;
+
+  NS_LOG_DEBUG ("\t qDelay " << m_qDelay.GetSeconds () << " baseProb " << m_baseProb);
+
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &DualPi2QueueDisc::CalculateP, this);
+}
+
+Ptr<QueueDiscItem>
+DualPi2QueueDisc::DoDequeue ()
+{
+  NS_LOG_FUNCTION (this);
+
+  double pC = m_baseProb * m_baseProb;
+  double pCL = std::min (m_k * m_baseProb, 1.0);
+
+  while (!GetInternalQueue (0)->IsEmpty () || !GetInternalQueue (1)->IsEmpty ())
+    {
+      if (SelectL4s ())
+        {
+          Ptr<QueueDiscItem> item = GetInternalQueue (1)->Dequeue ();
+
+          // Overload: the coupled probability is saturated, hence L4S packets
+          // are dropped as classic packets to protect the classic queue
+          if (pCL >= 1 && m_uv->GetValue () < pC)
+            {
+              DropAfterDequeue (item, UNFORCED_L4S_DROP);
+              continue;
+            }
+
+          if (Simulator::Now () - item->GetTimeStamp () > m_minTh || m_uv->GetValue () < pCL)
+            {
+              if (!Mark (item, UNFORCED_L4S_MARK))
+                {
+                  DropAfterDequeue (item, UNFORCED_L4S_DROP);
+                  continue;
+                }
+            }
+          return item;
+        }
+      else
+        {
+          Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+
+          if (m_uv->GetValue () < pC)
+            {
+              if (!Mark (item, UNFORCED_CLASSIC_MARK))
+                {
+                  DropAfterDequeue (item, UNFORCED_CLASSIC_DROP);
+                  continue;
+                }
+            }
+          return item;
+        }
+    }
+
+  NS_LOG_LOGIC ("Queue empty");
+  return 0;
+}
+
+bool
+DualPi2QueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("DualPi2QueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () == 0)
+    {
+      // classify packets based on their ECN codepoint
+      AddPacketFilter (CreateObject<DualPi2PacketFilter> ());
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // add the classic and the L4S DropTail queues
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> >
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> >
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+    }
+
+  if (GetNInternalQueues () != 2)
+    {
+      NS_LOG_ERROR ("DualPi2QueueDisc needs 2 internal queues");
+      return false;
+    }
+
+  if (!m_tUpdate.IsStrictlyPositive ())
+    {
+      NS_LOG_ERROR ("The update period must be positive");
+      return false;
+    }
+
+  return true;
+}
+
+} //namespace ns3
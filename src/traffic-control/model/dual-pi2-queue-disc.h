@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the pseudo-code of the DualQ Coupled AQM
+ * described in draft-ietf-tsvwg-aqm-dualq-coupled (Appendix A).
+ */
+
+#ifndef DUAL_PI2_QUEUE_DISC_H
+#define DUAL_PI2_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/packet-filter.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Packet filter classifying packets based on their ECN codepoint
+ *
+ * Packets whose ECN field is set to ECT(1) or CE are classified as L4S
+ * packets (the filter returns 1), all the other packets are classified as
+ * classic packets (the filter returns 0). The filter is able to classify
+ * all the items that expose the IP DS field.
+ */
+class DualPi2PacketFilter : public PacketFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  DualPi2PacketFilter ();
+  virtual ~DualPi2PacketFilter ();
+
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const;
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+};
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Implements the DualPI2 Coupled Active Queue Management discipline
+ *
+ * DualPI2 has two internal queues: the classic queue (index 0), which stores
+ * the packets of Reno/Cubic-like flows, and the L4S queue (index 1), which
+ * stores the packets of scalable congestion controls. Packets are classified
+ * by the packet filters of the queue disc (a DualPi2PacketFilter is added if
+ * no filter is configured): a filter returning 1 selects the L4S queue, any
+ * other value selects the classic queue.
+ *
+ * A PI controller, the same as PIE without the auto-tuning heuristics, drives
+ * a base probability p' from the queue delay of the classic queue. Classic
+ * packets are dropped (or marked, if ECN capable) with probability p'^2, while
+ * L4S packets are marked with the coupled probability k * p' or, if their
+ * sojourn time exceeds a step threshold, unconditionally. The two queues are
+ * served by a time-shifted FIFO scheduler.
+ */
+class DualPi2QueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief DualPi2QueueDisc Constructor
+   */
+  DualPi2QueueDisc ();
+
+  /**
+   * \brief DualPi2QueueDisc Destructor
+   */
+  virtual ~DualPi2QueueDisc ();
+
+  /**
+   * \brief Get the queue delay of the classic queue, as used by the PI controller.
+   *
+   * \returns The current queue delay of the classic queue.
+   */
+  Time GetQueueDelay (void);
+
+  /**
+   * \brief Get the base probability p' computed by the PI controller.
+   *
+   * \returns The current base probability.
+   */
+  double GetBaseProbability (void);
+
+  /**
+   * \brief Get the state of the controller.
+   *
+   * \returns The current queue delay and drop probability.
+   */
+  virtual ControllerState GetControllerState (void);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  // Reasons for dropping packets
+  static constexpr const char* UNFORCED_CLASSIC_DROP = "Unforced drop in classic queue";  //!< Early probability drops in the classic queue
+  static constexpr const char* UNFORCED_L4S_DROP = "Unforced drop in L4S queue";          //!< Early drops of L4S packets that could not be marked or during overload
+  static constexpr const char* FORCED_DROP = "Forced drop";                               //!< Drops due to queue limit: reactive
+  // Reasons for marking packets
+  static constexpr const char* UNFORCED_CLASSIC_MARK = "Unforced mark in classic queue";  //!< Early probability marks in the classic queue
+  static constexpr const char* UNFORCED_L4S_MARK = "Unforced mark in L4S queue";          //!< Coupled probability or step threshold marks in the L4S queue
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+
+  /**
+   * \brief Initialize the queue parameters.
+   */
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Time-shifted FIFO scheduler between the two queues
+   * \returns true if the L4S queue must be served, false otherwise
+   */
+  bool SelectL4s (void);
+
+  /**
+   * Periodically update the base probability based on the delay of the
+   * classic queue
+   */
+  void CalculateP ();
+
+  // ** Variables supplied by user
+  double m_a;                                   //!< Parameter alpha (in Hz) of the PI controller
+  double m_b;                                   //!< Parameter beta (in Hz) of the PI controller
+  Time m_tUpdate;                               //!< Time period after which CalculateP () is called
+  Time m_qDelayRef;                             //!< Desired queue delay of the classic queue
+  double m_k;                                   //!< Coupling factor between the classic and the L4S queue
+  Time m_minTh;                                 //!< Sojourn time above which L4S packets are always marked
+  Time m_tShift;                                //!< Time shift of the classic queue used by the scheduler
+
+  // ** Variables maintained by DualPI2
+  double m_baseProb;                            //!< Base probability p' computed by the PI controller
+  Time m_qDelay;                                //!< Current queue delay of the classic queue
+  Time m_qDelayOld;                             //!< Queue delay of the classic queue at the previous update
+  EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
+};
+
+};   // namespace ns3
+
+#endif
@@ -21,15 +21,22 @@
 
 #include "ns3/log.h"
 #include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/queue.h"
 #include "fq-codel-queue-disc.h"
 #include "codel-queue-disc.h"
 #include "ns3/net-device-queue-interface.h"
+#include <limits>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("FqCoDelQueueDisc");
 
+namespace {
+/// Entry of the flow table for a flow queue that has not been created yet
+const uint32_t NO_FLOW_QUEUE = std::numeric_limits<uint32_t>::max ();
+}
+
 NS_OBJECT_ENSURE_REGISTERED (FqCoDelFlow);
 
 TypeId FqCoDelFlow::GetTypeId (void)
@@ -129,6 +136,16 @@ TypeId FqCoDelQueueDisc::GetTypeId (void)
                    UintegerValue (0),
                    MakeUintegerAccessor (&FqCoDelQueueDisc::m_perturbation),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EnableSetAssociativeHash",
+                   "Enable/Disable the set associative hash",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FqCoDelQueueDisc::m_enableSetAssociativeHash),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SetWays",
+                   "The size of a set of flow queues used by the set associative hash",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_setWays),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -163,11 +180,11 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  uint32_t h = 0;
+  uint32_t flowHash, h;
 
   if (GetNPacketFilters () == 0)
     {
-      h = item->Hash (m_perturbation) % m_flows;
+      flowHash = item->Hash (m_perturbation);
     }
   else
     {
@@ -175,7 +192,7 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 
       if (ret != PacketFilter::PF_NO_MATCH)
         {
-          h = ret % m_flows;
+          flowHash = static_cast<uint32_t> (ret);
         }
       else
         {
@@ -185,8 +202,17 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
         }
     }
 
+  if (m_enableSetAssociativeHash)
+    {
+      h = SetAssociativeHash (this, m_flowsIndices, m_tags, m_setWays, flowHash);
+    }
+  else
+    {
+      h = flowHash % m_flows;
+    }
+
   Ptr<FqCoDelFlow> flow;
-  if (m_flowsIndices.find (h) == m_flowsIndices.end ())
+  if (m_flowsIndices[h] == NO_FLOW_QUEUE)
     {
       NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
       flow = m_flowFactory.Create<FqCoDelFlow> ();
@@ -320,6 +346,18 @@ FqCoDelQueueDisc::CheckConfig (void)
 
   // we are at initialization time. If the user has not set a quantum value,
   // set the quantum to the MTU of the device (if any)
+  if (m_flows == 0)
+    {
+      NS_LOG_ERROR ("The number of flow queues cannot be null");
+      return false;
+    }
+
+  if (m_enableSetAssociativeHash && (m_setWays == 0 || m_flows % m_setWays != 0))
+    {
+      NS_LOG_ERROR ("The number of flow queues must be a multiple of the size of the sets");
+      return false;
+    }
+
   if (!m_quantum)
     {
       Ptr<NetDeviceQueueInterface> ndqi = GetNetDeviceQueueInterface ();
@@ -353,6 +391,46 @@ FqCoDelQueueDisc::InitializeParams (void)
   m_queueDiscFactory.Set ("MaxSize", QueueSizeValue (GetMaxSize ()));
   m_queueDiscFactory.Set ("Interval", StringValue (m_interval));
   m_queueDiscFactory.Set ("Target", StringValue (m_target));
+
+  m_flowsIndices.assign (m_flows, NO_FLOW_QUEUE);
+  if (m_enableSetAssociativeHash)
+    {
+      m_tags.assign (m_flows, 0);
+    }
+}
+
+uint32_t
+FqCoDelQueueDisc::SetAssociativeHash (Ptr<const QueueDisc> qd, const std::vector<uint32_t> &flowsIndices,
+                                      std::vector<uint32_t> &tags, uint32_t setWays, uint32_t flowHash)
+{
+  NS_LOG_FUNCTION (qd << flowHash);
+
+  uint32_t h = flowHash % flowsIndices.size ();
+  uint32_t outerHash = h - h % setWays;
+
+  for (uint32_t i = outerHash; i < outerHash + setWays; i++)
+    {
+      if (flowsIndices[i] != NO_FLOW_QUEUE && tags[i] == flowHash)
+        {
+          // this queue is assigned to this flow
+          return i;
+        }
+    }
+
+  for (uint32_t i = outerHash; i < outerHash + setWays; i++)
+    {
+      if (flowsIndices[i] == NO_FLOW_QUEUE
+          || StaticCast<FqCoDelFlow> (qd->GetQueueDiscClass (flowsIndices[i]))->GetStatus () == FqCoDelFlow::INACTIVE)
+        {
+          // this queue has not been created yet or is inactive, hence we can use it
+          tags[i] = flowHash;
+          return i;
+        }
+    }
+
+  // all the queues of the set are used. Use the first queue of the set
+  tags[outerHash] = flowHash;
+  return outerHash;
 }
 
 uint32_t
@@ -25,7 +25,7 @@
 #include "ns3/queue-disc.h"
 #include "ns3/object-factory.h"
 #include <list>
-#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -126,6 +126,32 @@ public:
     */
    uint32_t GetQuantum (void) const;
 
+  /**
+   * \brief Select the flow queue of a flow by means of the set associative hash
+   *
+   * The flow queues are grouped into sets of setWays queues. The hash of the
+   * flow selects a set, and the flow is assigned the queue of the set that is
+   * already tagged with the hash of the flow, if any. Otherwise, the flow is
+   * assigned the first queue of the set which has not been created yet or is
+   * inactive. If all the queues of the set are active and assigned to other
+   * flows, the first queue of the set is used. The whole set is searched for
+   * the tag before a queue is reassigned, so that the packets of a flow are
+   * never split across two queues.
+   *
+   * This function is shared by the queue discs whose classes are FqCoDelFlow
+   * objects (FqCoDelQueueDisc, CakeQueueDisc and FqPieQueueDisc).
+   *
+   * \param qd the queue disc owning the flow queues
+   * \param flowsIndices the index of the queue disc class of each flow queue,
+   *        or the largest uint32_t value if the flow queue has not been created
+   * \param tags the hash of the flow assigned to each flow queue
+   * \param setWays the number of flow queues of a set
+   * \param flowHash the hash of the flow
+   * \return the index of the flow queue
+   */
+  static uint32_t SetAssociativeHash (Ptr<const QueueDisc> qd, const std::vector<uint32_t> &flowsIndices,
+                                      std::vector<uint32_t> &tags, uint32_t setWays, uint32_t flowHash);
+
   // Reasons for dropping packets
   static constexpr const char* UNCLASSIFIED_DROP = "Unclassified drop";  //!< No packet filter able to classify packet
   static constexpr const char* OVERLIMIT_DROP = "Overlimit drop";        //!< Overlimit dropped packets
@@ -148,11 +174,14 @@ private:
   uint32_t m_flows;          //!< Number of flow queues
   uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
   uint32_t m_perturbation;   //!< hash perturbation value
+  bool m_enableSetAssociativeHash;  //!< whether to enable the set associative hash
+  uint32_t m_setWays;        //!< size of a set of flow queues (used by the set associative hash)
 
   std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
   std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
 
-  std::map<uint32_t, uint32_t> m_flowsIndices;    //!< Map with the index of class for each flow
+  std::vector<uint32_t> m_flowsIndices;    //!< Index of the class of each flow queue, if created
+  std::vector<uint32_t> m_tags;            //!< Hash of the flow assigned to each flow queue (set associative hash)
 
   ObjectFactory m_flowFactory;         //!< Factory to create a new flow
   ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
@@ -0,0 +1,425 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "fq-pie-queue-disc.h"
+#include "ns3/net-device-queue-interface.h"
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FqPieQueueDisc");
+
+namespace {
+/// Entry of the flow table for a flow queue that has not been created yet
+const uint32_t NO_FLOW_QUEUE = std::numeric_limits<uint32_t>::max ();
+}
+
+NS_OBJECT_ENSURE_REGISTERED (FqPieQueueDisc);
+
+TypeId FqPieQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqPieQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqPieQueueDisc> ()
+    .AddAttribute ("Controller",
+                   "The AQM controller run on each flow queue",
+                   EnumValue (PIE),
+                   MakeEnumAccessor (&FqPieQueueDisc::m_controller),
+                   MakeEnumChecker (PIE, "PIE",
+                                    SELF_TUNING_PI, "SELF_TUNING_PI"))
+    .AddAttribute ("MaxSize",
+                   "The maximum number of packets accepted by this queue disc",
+                   QueueSizeValue (QueueSize ("10240p")),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&FqPieQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Tupdate",
+                   "Time period to calculate drop probability",
+                   TimeValue (MilliSeconds (15)),
+                   MakeTimeAccessor (&FqPieQueueDisc::m_tUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueDelayReference",
+                   "Desired queue delay",
+                   TimeValue (MilliSeconds (15)),
+                   MakeTimeAccessor (&FqPieQueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("DequeueThreshold",
+                   "Minimum queue size in bytes before dequeue rate is measured",
+                   UintegerValue (16384),
+                   MakeUintegerAccessor (&FqPieQueueDisc::m_dqThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("A",
+                   "Value of alpha (PIE)",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&FqPieQueueDisc::m_a),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("B",
+                   "Value of beta (PIE)",
+                   DoubleValue (1.25),
+                   MakeDoubleAccessor (&FqPieQueueDisc::m_b),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxBurstAllowance",
+                   "Current max burst allowance before random drop (PIE)",
+                   TimeValue (MilliSeconds (150)),
+                   MakeTimeAccessor (&FqPieQueueDisc::m_maxBurst),
+                   MakeTimeChecker ())
+    .AddAttribute ("UseTimestamp",
+                   "True to estimate the queue delay from the packet timestamps rather than from the dequeue rate (PIE)",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&FqPieQueueDisc::m_useTimestamp),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseFixedPoint",
+                   "True to update the drop probability and take the drop decisions in the integer arithmetic of the Linux kernel (PIE)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FqPieQueueDisc::m_useFixedPoint),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to use ECN (packets are marked instead of being dropped) (PIE)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FqPieQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkEcnThreshold",
+                   "ECN capable packets are dropped rather than marked if the drop probability exceeds this threshold (PIE)",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&FqPieQueueDisc::m_markEcnTh),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("UseL4s",
+                   "True to mark ECT(1) packets whose sojourn time exceeds CeThreshold (PIE)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FqPieQueueDisc::m_useL4s),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CeThreshold",
+                   "Sojourn time above which ECT(1) packets are marked, if UseL4s is true (PIE)",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&FqPieQueueDisc::m_ceThreshold),
+                   MakeTimeChecker ())
+    .AddAttribute ("Flows",
+                   "The number of queues into which the incoming packets are classified",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FqPieQueueDisc::m_flows),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Perturbation",
+                   "The salt used as an additional input to the hash function used to classify packets",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FqPieQueueDisc::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EnableSetAssociativeHash",
+                   "Enable/Disable the set associative hash",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FqPieQueueDisc::m_enableSetAssociativeHash),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SetWays",
+                   "The size of a set of flow queues used by the set associative hash",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&FqPieQueueDisc::m_setWays),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+FqPieQueueDisc::FqPieQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::MULTIPLE_QUEUES, QueueSizeUnit::PACKETS),
+    m_quantum (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqPieQueueDisc::~FqPieQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqPieQueueDisc::SetQuantum (uint32_t quantum)
+{
+  NS_LOG_FUNCTION (this << quantum);
+  m_quantum = quantum;
+}
+
+uint32_t
+FqPieQueueDisc::GetQuantum (void) const
+{
+  return m_quantum;
+}
+
+bool
+FqPieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t flowHash, h;
+
+  if (GetNPacketFilters () == 0)
+    {
+      flowHash = item->Hash (m_perturbation);
+    }
+  else
+    {
+      int32_t ret = Classify (item);
+
+      if (ret != PacketFilter::PF_NO_MATCH)
+        {
+          flowHash = static_cast<uint32_t> (ret);
+        }
+      else
+        {
+          NS_LOG_ERROR ("No filter has been able to classify this packet, drop it.");
+          DropBeforeEnqueue (item, UNCLASSIFIED_DROP);
+          return false;
+        }
+    }
+
+  // Unlike FqCoDel, the arriving packet is dropped if the queue disc is full
+  if (GetCurrentSize () + item > GetMaxSize ())
+    {
+      NS_LOG_LOGIC ("Queue disc limit exceeded -- dropping packet");
+      DropBeforeEnqueue (item, OVERLIMIT_DROP);
+      return false;
+    }
+
+  if (m_enableSetAssociativeHash)
+    {
+      h = FqCoDelQueueDisc::SetAssociativeHash (this, m_flowsIndices, m_tags, m_setWays, flowHash);
+    }
+  else
+    {
+      h = flowHash % m_flows;
+    }
+
+  Ptr<FqCoDelFlow> flow;
+  if (m_flowsIndices[h] == NO_FLOW_QUEUE)
+    {
+      NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
+      flow = m_flowFactory.Create<FqCoDelFlow> ();
+      Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
+      qd->Initialize ();
+      flow->SetQueueDisc (qd);
+      AddQueueDiscClass (flow);
+
+      m_flowsIndices[h] = GetNQueueDiscClasses () - 1;
+    }
+  else
+    {
+      flow = StaticCast<FqCoDelFlow> (GetQueueDiscClass (m_flowsIndices[h]));
+    }
+
+  // The packet may be dropped by the controller of the flow queue, in which
+  // case the drop is accounted for by the child queue disc drop callback
+  if (!flow->GetQueueDisc ()->Enqueue (item))
+    {
+      NS_LOG_DEBUG ("Packet dropped by flow " << h);
+      return false;
+    }
+
+  if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
+    {
+      flow->SetStatus (FqCoDelFlow::NEW_FLOW);
+      flow->SetDeficit (m_quantum);
+      m_newFlows.push_back (flow);
+    }
+
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << m_flowsIndices[h]);
+
+  return true;
+}
+
+Ptr<QueueDiscItem>
+FqPieQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<FqCoDelFlow> flow;
+  Ptr<QueueDiscItem> item;
+
+  do
+    {
+      bool found = false;
+
+      while (!found && !m_newFlows.empty ())
+        {
+          flow = m_newFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (m_quantum);
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              m_oldFlows.push_back (flow);
+              m_newFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found a new flow with positive deficit");
+              found = true;
+            }
+        }
+
+      while (!found && !m_oldFlows.empty ())
+        {
+          flow = m_oldFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (m_quantum);
+              m_oldFlows.push_back (flow);
+              m_oldFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found an old flow with positive deficit");
+              found = true;
+            }
+        }
+
+      if (!found)
+        {
+          NS_LOG_DEBUG ("No flow found to dequeue a packet");
+          return 0;
+        }
+
+      item = flow->GetQueueDisc ()->Dequeue ();
+
+      if (!item)
+        {
+          NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
+          if (!m_newFlows.empty ())
+            {
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              m_oldFlows.push_back (flow);
+              m_newFlows.pop_front ();
+            }
+          else
+            {
+              flow->SetStatus (FqCoDelFlow::INACTIVE);
+              m_oldFlows.pop_front ();
+            }
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Dequeued packet " << item->GetPacket ());
+        }
+    } while (item == 0);
+
+  flow->IncreaseDeficit (item->GetSize () * -1);
+
+  return item;
+}
+
+bool
+FqPieQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("FqPieQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("FqPieQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  if (m_flows == 0)
+    {
+      NS_LOG_ERROR ("The number of flow queues cannot be null");
+      return false;
+    }
+
+  if (m_enableSetAssociativeHash && (m_setWays == 0 || m_flows % m_setWays != 0))
+    {
+      NS_LOG_ERROR ("The number of flow queues must be a multiple of the size of the sets");
+      return false;
+    }
+
+  // we are at initialization time. If the user has not set a quantum value,
+  // set the quantum to the MTU of the device (if any)
+  if (!m_quantum)
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = GetNetDeviceQueueInterface ();
+      Ptr<NetDevice> dev;
+      // if the NetDeviceQueueInterface object is aggregated to a
+      // NetDevice, get the MTU of such NetDevice
+      if (ndqi && (dev = ndqi->GetObject<NetDevice> ()))
+        {
+          m_quantum = dev->GetMtu ();
+          NS_LOG_DEBUG ("Setting the quantum to the MTU of the device: " << m_quantum);
+        }
+
+      if (!m_quantum)
+        {
+          NS_LOG_ERROR ("The quantum parameter cannot be null");
+          return false;
+        }
+    }
+
+  return true;
+}
+
+void
+FqPieQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flowFactory.SetTypeId ("ns3::FqCoDelFlow");
+
+  // The limit is enforced by this queue disc, hence the flow queues can
+  // hold as many packets as this queue disc
+  if (m_controller == PIE)
+    {
+      // The lazy update mode computes the same drop probability as a timer,
+      // without scheduling events for idle flow queues
+      m_queueDiscFactory.SetTypeId ("ns3::PieQueueDisc");
+      m_queueDiscFactory.Set ("A", DoubleValue (m_a));
+      m_queueDiscFactory.Set ("B", DoubleValue (m_b));
+      m_queueDiscFactory.Set ("MaxBurstAllowance", TimeValue (m_maxBurst));
+      m_queueDiscFactory.Set ("UseTimestamp", BooleanValue (m_useTimestamp));
+      m_queueDiscFactory.Set ("UseFixedPoint", BooleanValue (m_useFixedPoint));
+      m_queueDiscFactory.Set ("UseEcn", BooleanValue (m_useEcn));
+      m_queueDiscFactory.Set ("MarkEcnThreshold", DoubleValue (m_markEcnTh));
+      m_queueDiscFactory.Set ("UseL4s", BooleanValue (m_useL4s));
+      m_queueDiscFactory.Set ("CeThreshold", TimeValue (m_ceThreshold));
+      m_queueDiscFactory.Set ("UseLazyUpdate", BooleanValue (true));
+    }
+  else
+    {
+      m_queueDiscFactory.SetTypeId ("ns3::SelfTuningPiQueueDisc");
+    }
+  m_queueDiscFactory.Set ("MaxSize", QueueSizeValue (GetMaxSize ()));
+  m_queueDiscFactory.Set ("MeanPktSize", UintegerValue (m_meanPktSize));
+  m_queueDiscFactory.Set ("Tupdate", TimeValue (m_tUpdate));
+  m_queueDiscFactory.Set ("QueueDelayReference", TimeValue (m_qDelayRef));
+  m_queueDiscFactory.Set ("DequeueThreshold", UintegerValue (m_dqThreshold));
+
+  m_flowsIndices.assign (m_flows, NO_FLOW_QUEUE);
+  if (m_enableSetAssociativeHash)
+    {
+      m_tags.assign (m_flows, 0);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the Linux FQ-PIE queue disc
+ * (net/sched/sch_fq_pie.c) by Mohit P. Tahiliani, Sachin D. Patil,
+ * V. Saicharan and Gautam Ramakrishnan. The PIE state of each flow is kept
+ * by a child PieQueueDisc, whose drop probability is updated by its own
+ * (lazy) timer rather than by a timer shared by all the flows.
+ */
+
+#ifndef FQ_PIE_QUEUE_DISC
+#define FQ_PIE_QUEUE_DISC
+
+#include "ns3/queue-disc.h"
+#include "ns3/object-factory.h"
+#include "fq-codel-queue-disc.h"
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A FqPie packet queue disc
+ *
+ * Packets are classified into flow queues and the flow queues are scheduled
+ * by the same deficit round robin scheduler as in FqCoDel, with new flows
+ * served before old flows. Each flow queue is a child queue disc running an
+ * AQM controller on the packets of that flow only, which is a PIE queue disc
+ * (as in Linux) or, optionally, a self-tuning PI queue disc. Contrary to
+ * FqCoDel, packets are dropped at enqueue, either by the controller of their
+ * flow or, if the queue disc is full, by the queue disc itself.
+ */
+class FqPieQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqPieQueueDisc constructor
+   */
+  FqPieQueueDisc ();
+
+  virtual ~FqPieQueueDisc ();
+
+  /**
+   * \brief AQM controller run on each flow queue
+   */
+  enum ControllerType
+  {
+    PIE,              //!< PieQueueDisc
+    SELF_TUNING_PI    //!< SelfTuningPiQueueDisc
+  };
+
+  /**
+   * \brief Set the quantum value.
+   *
+   * \param quantum The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  void SetQuantum (uint32_t quantum);
+
+  /**
+   * \brief Get the quantum value.
+   *
+   * \returns The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  uint32_t GetQuantum (void) const;
+
+  // Reasons for dropping packets
+  static constexpr const char* UNCLASSIFIED_DROP = "Unclassified drop";  //!< No packet filter able to classify packet
+  static constexpr const char* OVERLIMIT_DROP = "Overlimit drop";        //!< Overlimit dropped packets
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  // ** Variables supplied by user
+  ControllerType m_controller;  //!< AQM controller of the flow queues
+  uint32_t m_meanPktSize;       //!< Average packet size in bytes
+  Time m_tUpdate;               //!< Time period after which the drop probability is updated
+  Time m_qDelayRef;             //!< Desired queue delay
+  uint32_t m_dqThreshold;       //!< Minimum queue size in bytes before dequeue rate is measured
+  double m_a;                   //!< Parameter alpha of the PIE controller
+  double m_b;                   //!< Parameter beta of the PIE controller
+  Time m_maxBurst;              //!< Maximum burst allowed before random early dropping kicks in (PIE)
+  bool m_useTimestamp;          //!< True to estimate the queue delay from the packet timestamps (PIE)
+  bool m_useFixedPoint;         //!< True to use the integer arithmetic of the Linux kernel (PIE)
+  bool m_useEcn;                //!< True if ECN is used (PIE)
+  double m_markEcnTh;           //!< Drop probability above which ECN capable packets are dropped rather than marked (PIE)
+  bool m_useL4s;                //!< True if ECT(1) packets are marked when their sojourn time exceeds the CE threshold (PIE)
+  Time m_ceThreshold;           //!< Sojourn time above which ECT(1) packets are marked (PIE)
+  uint32_t m_quantum;           //!< Deficit assigned to flows at each round
+  uint32_t m_flows;             //!< Number of flow queues
+  uint32_t m_perturbation;      //!< hash perturbation value
+  bool m_enableSetAssociativeHash;  //!< whether to enable the set associative hash
+  uint32_t m_setWays;           //!< size of a set of flow queues (used by the set associative hash)
+
+  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
+  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+
+  std::vector<uint32_t> m_flowsIndices;    //!< Index of the class of each flow queue, if created
+  std::vector<uint32_t> m_tags;            //!< Hash of the flow assigned to each flow queue (set associative hash)
+
+  ObjectFactory m_flowFactory;         //!< Factory to create a new flow
+  ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
+};
+
+} // namespace ns3
+
+#endif /* FQ_PIE_QUEUE_DISC */
@@ -0,0 +1,860 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the structure of the Linux HTB queue disc
+ * (net/sched/sch_htb.c) by Martin Devera. Red-black trees are replaced by
+ * maps sorted by class identifier and the per-level event budget is not
+ * implemented, i.e., all the pending class mode changes are processed at
+ * every dequeue.
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/object-vector.h"
+#include "htb-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HtbQueueDisc");
+
+namespace {
+/// Maximum time (in nanoseconds) accounted for in a token update, as mbuffer in Linux
+const int64_t MAX_TOKENS_TIME = 60000000000LL;
+
+/**
+ * \brief Compute the transmission time of the given number of bytes at the given rate
+ * \param rate the rate
+ * \param bytes the number of bytes
+ * \return the transmission time, in nanoseconds
+ */
+int64_t
+L2t (const DataRate &rate, uint32_t bytes)
+{
+  return static_cast<int64_t> (bytes) * 8 * 1000000000LL / static_cast<int64_t> (rate.GetBitRate ());
+}
+
+/**
+ * \brief Get the lowest priority in a mask of priorities
+ * \param mask the mask of priorities (must not be null)
+ * \return the lowest priority in the mask
+ */
+uint8_t
+LowestPrio (uint8_t mask)
+{
+  uint8_t prio = 0;
+  while (!(mask & (1 << prio)))
+    {
+      prio++;
+    }
+  return prio;
+}
+} // unnamed namespace
+
+HtbPrio::HtbPrio ()
+  : m_next (0)
+{
+}
+
+constexpr uint8_t HtbClass::MAX_DEPTH;
+constexpr uint8_t HtbClass::NUM_PRIO;
+
+NS_OBJECT_ENSURE_REGISTERED (HtbClass);
+
+TypeId HtbClass::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbClass")
+    .SetParent<QueueDiscClass> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbClass> ()
+    .AddAttribute ("Rate",
+                   "The rate guaranteed to the class.",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&HtbClass::m_rate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Ceil",
+                   "The maximum rate of the class, if bandwidth can be borrowed "
+                   "from its ancestors. Zero means equal to the rate.",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&HtbClass::m_ceil),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Burst",
+                   "Size of the rate bucket in bytes. Zero means the amount of data "
+                   "sent at the rate in 1 ms plus 1600 bytes.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_burst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Cburst",
+                   "Size of the ceil bucket in bytes. Zero means the amount of data "
+                   "sent at the ceil rate in 1 ms plus 1600 bytes.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_cburst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Quantum",
+                   "The deficit round robin quantum in bytes. Zero means a tenth of "
+                   "the bytes sent at the rate in one second, between 1000 and 200000.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_quantum),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Priority",
+                   "The priority of a leaf class (0 is the highest).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_priority),
+                   MakeUintegerChecker<uint8_t> (0, NUM_PRIO - 1))
+    .AddAttribute ("Parent",
+                   "The identifier of the parent inner class, as returned by "
+                   "HtbQueueDisc::AddInnerClass. Zero means no parent.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbClass::m_parentId),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+HtbClass::HtbClass ()
+  : m_id (0),
+    m_parent (0),
+    m_level (0),
+    m_mode (CAN_SEND),
+    m_tokens (0),
+    m_ctokens (0),
+    m_buffer (0),
+    m_cbuffer (0),
+    m_checkpoint (0),
+    m_quantumBytes (0),
+    m_prioActivity (0),
+    m_nBorrows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbClass::~HtbClass ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbClass::Mode
+HtbClass::GetMode (void) const
+{
+  return m_mode;
+}
+
+uint64_t
+HtbClass::GetNBorrows (void) const
+{
+  return m_nBorrows;
+}
+
+// ------------------------------------------------------------------------- //
+
+NS_OBJECT_ENSURE_REGISTERED (HtbQueueDisc);
+
+TypeId HtbQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbQueueDisc> ()
+    .AddAttribute ("DefaultClass",
+                   "The index of the leaf class of the packets not classified by the filters.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&HtbQueueDisc::m_defaultClass),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("InnerClassList", "The list of inner classes.",
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&HtbQueueDisc::m_innerClasses),
+                   MakeObjectVectorChecker<HtbClass> ())
+  ;
+  return tid;
+}
+
+HtbQueueDisc::HtbQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::NO_LIMITS),
+    m_now (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HtbQueueDisc::~HtbQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+HtbQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Remove (m_watchdog);
+  for (uint8_t level = 0; level < HtbClass::MAX_DEPTH; level++)
+    {
+      m_waitQueue[level].clear ();
+      for (uint8_t prio = 0; prio < HtbClass::NUM_PRIO; prio++)
+        {
+          m_rows[level][prio].m_classes.clear ();
+        }
+    }
+  m_leaves.clear ();
+  m_innerClasses.clear ();
+  QueueDisc::DoDispose ();
+}
+
+uint32_t
+HtbQueueDisc::AddInnerClass (Ptr<HtbClass> cl)
+{
+  NS_LOG_FUNCTION (this << cl);
+  m_innerClasses.push_back (cl);
+  return m_innerClasses.size ();
+}
+
+Ptr<HtbClass>
+HtbQueueDisc::GetInnerClass (uint32_t id) const
+{
+  NS_ASSERT (id > 0 && id <= m_innerClasses.size ());
+  return m_innerClasses[id - 1];
+}
+
+std::size_t
+HtbQueueDisc::GetNInnerClasses (void) const
+{
+  return m_innerClasses.size ();
+}
+
+HtbClass::Mode
+HtbQueueDisc::ClassMode (HtbClass *cl, int64_t &diff) const
+{
+  int64_t toks;
+
+  if ((toks = cl->m_ctokens + diff) < 0)
+    {
+      diff = -toks;
+      return HtbClass::CANT_SEND;
+    }
+
+  if ((toks = cl->m_tokens + diff) >= 0)
+    {
+      return HtbClass::CAN_SEND;
+    }
+
+  diff = -toks;
+  return HtbClass::MAY_BORROW;
+}
+
+void
+HtbQueueDisc::ChangeClassMode (HtbClass *cl, int64_t &diff)
+{
+  HtbClass::Mode newMode = ClassMode (cl, diff);
+
+  if (newMode == cl->m_mode)
+    {
+      return;
+    }
+
+  if (cl->m_prioActivity)
+    {
+      if (cl->m_mode != HtbClass::CANT_SEND)
+        {
+          DeactivatePrios (cl);
+        }
+      cl->m_mode = newMode;
+      if (newMode != HtbClass::CANT_SEND)
+        {
+          ActivatePrios (cl);
+        }
+    }
+  else
+    {
+      cl->m_mode = newMode;
+    }
+}
+
+void
+HtbQueueDisc::AddToWaitQueue (HtbClass *cl, int64_t delay)
+{
+  int64_t key = m_now + delay;
+
+  if (key == m_now)
+    {
+      key++;
+    }
+
+  cl->m_waitNode = m_waitQueue[cl->m_level].insert (std::make_pair (key, cl));
+
+  if (m_nearEvent[cl->m_level] > key)
+    {
+      m_nearEvent[cl->m_level] = key;
+    }
+}
+
+void
+HtbQueueDisc::AddClassToRow (HtbClass *cl, uint8_t mask)
+{
+  m_rowMask[cl->m_level] |= mask;
+
+  while (mask)
+    {
+      uint8_t prio = LowestPrio (mask);
+      mask &= ~(1 << prio);
+      m_rows[cl->m_level][prio].m_classes[cl->m_id] = cl;
+    }
+}
+
+void
+HtbQueueDisc::RemoveClassFromRow (HtbClass *cl, uint8_t mask)
+{
+  uint8_t m = 0;
+
+  while (mask)
+    {
+      uint8_t prio = LowestPrio (mask);
+      mask &= ~(1 << prio);
+      HtbPrio &row = m_rows[cl->m_level][prio];
+      row.m_classes.erase (cl->m_id);
+      if (row.m_classes.empty ())
+        {
+          m |= 1 << prio;
+        }
+    }
+
+  m_rowMask[cl->m_level] &= ~m;
+}
+
+void
+HtbQueueDisc::ActivatePrios (HtbClass *cl)
+{
+  HtbClass *p = cl->m_parent;
+  uint8_t mask = cl->m_prioActivity;
+
+  while (cl->m_mode == HtbClass::MAY_BORROW && p && mask)
+    {
+      uint8_t m = mask;
+      while (m)
+        {
+          uint8_t prio = LowestPrio (m);
+          m &= ~(1 << prio);
+
+          // the parent is already active for this priority, stop here
+          if (!p->m_feeds[prio].m_classes.empty ())
+            {
+              mask &= ~(1 << prio);
+            }
+
+          p->m_feeds[prio].m_classes[cl->m_id] = cl;
+        }
+      p->m_prioActivity |= mask;
+
+      cl = p;
+      p = cl->m_parent;
+    }
+
+  if (cl->m_mode == HtbClass::CAN_SEND && mask)
+    {
+      AddClassToRow (cl, mask);
+    }
+}
+
+void
+HtbQueueDisc::DeactivatePrios (HtbClass *cl)
+{
+  HtbClass *p = cl->m_parent;
+  uint8_t mask = cl->m_prioActivity;
+
+  while (cl->m_mode == HtbClass::MAY_BORROW && p && mask)
+    {
+      uint8_t m = mask;
+      mask = 0;
+      while (m)
+        {
+          uint8_t prio = LowestPrio (m);
+          m &= ~(1 << prio);
+
+          p->m_feeds[prio].m_classes.erase (cl->m_id);
+
+          // the parent has no other active children for this priority
+          if (p->m_feeds[prio].m_classes.empty ())
+            {
+              mask |= 1 << prio;
+            }
+        }
+      p->m_prioActivity &= ~mask;
+
+      cl = p;
+      p = cl->m_parent;
+    }
+
+  if (cl->m_mode == HtbClass::CAN_SEND && mask)
+    {
+      RemoveClassFromRow (cl, mask);
+    }
+}
+
+void
+HtbQueueDisc::Activate (HtbClass *cl)
+{
+  if (!cl->m_prioActivity)
+    {
+      cl->m_prioActivity = 1 << cl->m_priority;
+      ActivatePrios (cl);
+    }
+}
+
+void
+HtbQueueDisc::Deactivate (HtbClass *cl)
+{
+  NS_ASSERT (cl->m_prioActivity);
+  DeactivatePrios (cl);
+  cl->m_prioActivity = 0;
+}
+
+void
+HtbQueueDisc::ChargeClass (HtbClass *cl, uint8_t level, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << cl << +level << bytes);
+
+  while (cl)
+    {
+      int64_t diff = std::min (m_now - cl->m_checkpoint, MAX_TOKENS_TIME);
+      int64_t toks;
+
+      if (cl->m_level >= level)
+        {
+          toks = std::min (cl->m_tokens + diff, cl->m_buffer) - L2t (cl->m_rate, bytes);
+          cl->m_tokens = std::max (toks, 1 - MAX_TOKENS_TIME);
+        }
+      else
+        {
+          // the class borrowed, hence it is not charged, but its
+          // checkpoint is moved
+          cl->m_nBorrows++;
+          cl->m_tokens += diff;
+        }
+
+      toks = std::min (cl->m_ctokens + diff, cl->m_cbuffer) - L2t (cl->m_ceil, bytes);
+      cl->m_ctokens = std::max (toks, 1 - MAX_TOKENS_TIME);
+      cl->m_checkpoint = m_now;
+
+      HtbClass::Mode oldMode = cl->m_mode;
+      diff = 0;
+      ChangeClassMode (cl, diff);
+
+      if (oldMode != cl->m_mode)
+        {
+          if (oldMode != HtbClass::CAN_SEND)
+            {
+              m_waitQueue[cl->m_level].erase (cl->m_waitNode);
+            }
+          if (cl->m_mode != HtbClass::CAN_SEND)
+            {
+              AddToWaitQueue (cl, diff);
+            }
+        }
+
+      cl = cl->m_parent;
+    }
+}
+
+int64_t
+HtbQueueDisc::DoEvents (uint8_t level)
+{
+  std::multimap<int64_t, HtbClass*> &waitQueue = m_waitQueue[level];
+
+  while (!waitQueue.empty ())
+    {
+      std::multimap<int64_t, HtbClass*>::iterator it = waitQueue.begin ();
+      if (it->first > m_now)
+        {
+          return it->first;
+        }
+
+      HtbClass *cl = it->second;
+      waitQueue.erase (it);
+
+      int64_t diff = std::min (m_now - cl->m_checkpoint, MAX_TOKENS_TIME);
+      ChangeClassMode (cl, diff);
+      if (cl->m_mode != HtbClass::CAN_SEND)
+        {
+          AddToWaitQueue (cl, diff);
+        }
+    }
+
+  return 0;
+}
+
+HtbClass*
+HtbQueueDisc::LookupLeaf (HtbPrio *hprio, uint8_t prio)
+{
+  HtbPrio *stack[HtbClass::MAX_DEPTH];
+  uint8_t sp = 0;
+  stack[0] = hprio;
+
+  for (uint32_t i = 0; i < 65535; i++)
+    {
+      std::map<uint32_t, HtbClass*> &classes = stack[sp]->m_classes;
+      std::map<uint32_t, HtbClass*>::iterator it = classes.lower_bound (stack[sp]->m_next);
+
+      if (it == classes.end ())
+        {
+          // we are at the right end: rewind and go up
+          stack[sp]->m_next = 0;
+          if (sp > 0)
+            {
+              sp--;
+              it = stack[sp]->m_classes.lower_bound (stack[sp]->m_next);
+              if (it == stack[sp]->m_classes.end ())
+                {
+                  NS_LOG_ERROR ("Inconsistent class tree");
+                  return 0;
+                }
+              stack[sp]->m_next = it->first + 1;
+            }
+          else if (classes.empty ())
+            {
+              return 0;
+            }
+        }
+      else
+        {
+          stack[sp]->m_next = it->first;
+          HtbClass *cl = it->second;
+          if (cl->m_level == 0)
+            {
+              return cl;
+            }
+          NS_ASSERT (sp + 1 < HtbClass::MAX_DEPTH);
+          stack[++sp] = &cl->m_feeds[prio];
+        }
+    }
+
+  return 0;
+}
+
+void
+HtbQueueDisc::NextLeaf (HtbClass *cl, uint8_t level, uint8_t prio)
+{
+  HtbPrio &list = (level ? cl->m_parent->m_feeds[prio] : m_rows[0][prio]);
+  list.m_next = cl->m_id + 1;
+}
+
+Ptr<QueueDiscItem>
+HtbQueueDisc::DequeueTree (uint8_t prio, uint8_t level)
+{
+  NS_LOG_FUNCTION (this << +prio << +level);
+
+  HtbPrio *hprio = &m_rows[level][prio];
+  HtbClass *start = LookupLeaf (hprio, prio);
+  HtbClass *cl = start;
+  Ptr<QueueDiscItem> item;
+
+  while (true)
+    {
+      if (!cl)
+        {
+          return 0;
+        }
+
+      // the class can be empty if its child queue disc dropped packets
+      // when dequeuing. Simply deactivate and skip such class
+      if (cl->GetQueueDisc ()->GetNPackets () == 0)
+        {
+          Deactivate (cl);
+          // the row might become empty
+          if (!(m_rowMask[level] & (1 << prio)))
+            {
+              return 0;
+            }
+          HtbClass *next = LookupLeaf (hprio, prio);
+          if (cl == start)
+            {
+              start = next;
+            }
+          cl = next;
+          continue;
+        }
+
+      item = cl->GetQueueDisc ()->Dequeue ();
+      if (item)
+        {
+          break;
+        }
+
+      NS_LOG_DEBUG ("The child queue disc of a backlogged class returned no packet");
+      NextLeaf (cl, level, prio);
+      cl = LookupLeaf (hprio, prio);
+      if (cl == start)
+        {
+          return 0;
+        }
+    }
+
+  cl->m_deficit[level] -= item->GetSize ();
+  if (cl->m_deficit[level] < 0)
+    {
+      cl->m_deficit[level] += cl->m_quantumBytes;
+      NextLeaf (cl, level, prio);
+    }
+
+  if (cl->GetQueueDisc ()->GetNPackets () == 0)
+    {
+      Deactivate (cl);
+    }
+
+  ChargeClass (cl, level, item->GetSize ());
+
+  return item;
+}
+
+bool
+HtbQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t leaf = m_defaultClass;
+  int32_t ret = Classify (item);
+
+  if (ret == PacketFilter::PF_NO_MATCH)
+    {
+      NS_LOG_DEBUG ("No filter has been able to classify this packet, using the default class.");
+    }
+  else if (ret >= 0 && static_cast<uint32_t> (ret) < m_leaves.size ())
+    {
+      leaf = ret;
+    }
+
+  HtbClass *cl = m_leaves[leaf];
+  bool retval = cl->GetQueueDisc ()->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the child queue disc
+  // because QueueDisc::AddQueueDiscClass sets the drop callback
+
+  if (retval)
+    {
+      Activate (cl);
+    }
+
+  NS_LOG_LOGIC ("Number packets class " << leaf << ": " << cl->GetQueueDisc ()->GetNPackets ());
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+HtbQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetNPackets () == 0)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  m_now = Simulator::Now ().GetNanoSeconds ();
+  int64_t nextEvent = m_now + 5000000000LL;
+
+  for (uint8_t level = 0; level < HtbClass::MAX_DEPTH; level++)
+    {
+      int64_t event = m_nearEvent[level];
+
+      if (m_now >= event)
+        {
+          event = DoEvents (level);
+          if (!event)
+            {
+              event = m_now + 1000000000LL;
+            }
+          m_nearEvent[level] = event;
+        }
+
+      if (nextEvent > event)
+        {
+          nextEvent = event;
+        }
+
+      for (uint8_t prio = 0; prio < HtbClass::NUM_PRIO; prio++)
+        {
+          if (m_rowMask[level] & (1 << prio))
+            {
+              Ptr<QueueDiscItem> item = DequeueTree (prio, level);
+              if (item)
+                {
+                  return item;
+                }
+            }
+        }
+    }
+
+  // no class can send now, wake up when the next class may change mode
+  Simulator::Remove (m_watchdog);
+  m_watchdog = Simulator::Schedule (NanoSeconds (nextEvent - m_now), &QueueDisc::Run, this);
+  NS_LOG_LOGIC ("Waking Event Scheduled in " << NanoSeconds (nextEvent - m_now));
+
+  return 0;
+}
+
+bool
+HtbQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("HtbQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  if (GetNQueueDiscClasses () == 0)
+    {
+      NS_LOG_ERROR ("HtbQueueDisc needs at least one leaf class");
+      return false;
+    }
+
+  if (m_defaultClass >= GetNQueueDiscClasses ())
+    {
+      NS_LOG_ERROR ("The default class is not a leaf class");
+      return false;
+    }
+
+  m_leaves.clear ();
+  std::vector<HtbClass*> classes;
+
+  for (std::size_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      Ptr<HtbClass> cl = DynamicCast<HtbClass> (GetQueueDiscClass (i));
+      if (!cl)
+        {
+          NS_LOG_ERROR ("The classes of HtbQueueDisc must be HtbClass objects");
+          return false;
+        }
+      m_leaves.push_back (PeekPointer (cl));
+      classes.push_back (PeekPointer (cl));
+    }
+
+  for (std::size_t i = 0; i < m_innerClasses.size (); i++)
+    {
+      classes.push_back (PeekPointer (m_innerClasses[i]));
+    }
+
+  for (std::size_t i = 0; i < classes.size (); i++)
+    {
+      HtbClass *cl = classes[i];
+      cl->m_id = i;
+
+      if (cl->m_rate.GetBitRate () == 0)
+        {
+          NS_LOG_ERROR ("The rate of a class must be positive");
+          return false;
+        }
+
+      if (cl->m_ceil.GetBitRate () > 0 && cl->m_ceil < cl->m_rate)
+        {
+          NS_LOG_ERROR ("The ceil rate of a class cannot be lower than its rate");
+          return false;
+        }
+
+      if (cl->m_parentId > m_innerClasses.size ())
+        {
+          NS_LOG_ERROR ("The parent of a class is not an inner class");
+          return false;
+        }
+
+      cl->m_parent = (cl->m_parentId ? PeekPointer (m_innerClasses[cl->m_parentId - 1]) : 0);
+    }
+
+  // Inner classes without parent are at the highest level and the level of
+  // the other inner classes is one less than that of their parent
+  for (std::size_t i = 0; i < m_innerClasses.size (); i++)
+    {
+      uint8_t depth = 0;
+      for (HtbClass *p = PeekPointer (m_innerClasses[i]); p; p = p->m_parent)
+        {
+          if (++depth >= HtbClass::MAX_DEPTH)
+            {
+              NS_LOG_ERROR ("The class hierarchy is too deep or has loops");
+              return false;
+            }
+        }
+      m_innerClasses[i]->m_level = HtbClass::MAX_DEPTH - depth;
+    }
+
+  for (std::size_t i = 0; i < m_leaves.size (); i++)
+    {
+      m_leaves[i]->m_level = 0;
+    }
+
+  return true;
+}
+
+void
+HtbQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_now = Simulator::Now ().GetNanoSeconds ();
+
+  for (uint8_t level = 0; level < HtbClass::MAX_DEPTH; level++)
+    {
+      m_rowMask[level] = 0;
+      m_nearEvent[level] = 0;
+    }
+
+  std::vector<HtbClass*> classes (m_leaves);
+  for (std::size_t i = 0; i < m_innerClasses.size (); i++)
+    {
+      classes.push_back (PeekPointer (m_innerClasses[i]));
+    }
+
+  for (std::size_t i = 0; i < classes.size (); i++)
+    {
+      HtbClass *cl = classes[i];
+
+      if (cl->m_ceil.GetBitRate () == 0)
+        {
+          cl->m_ceil = cl->m_rate;
+        }
+
+      // as done by tc, the default bucket size is the amount of data sent
+      // in a tick (1 ms) plus an mtu
+      uint32_t burst = cl->m_burst;
+      if (!burst)
+        {
+          burst = cl->m_rate.GetBitRate () / 8000 + 1600;
+        }
+      uint32_t cburst = cl->m_cburst;
+      if (!cburst)
+        {
+          cburst = cl->m_ceil.GetBitRate () / 8000 + 1600;
+        }
+      cl->m_buffer = L2t (cl->m_rate, burst);
+      cl->m_cbuffer = L2t (cl->m_ceil, cburst);
+
+      cl->m_quantumBytes = cl->m_quantum;
+      if (!cl->m_quantumBytes)
+        {
+          cl->m_quantumBytes = std::min<uint64_t> (std::max<uint64_t> (cl->m_rate.GetBitRate () / 80, 1000), 200000);
+        }
+
+      cl->m_tokens = cl->m_buffer;
+      cl->m_ctokens = cl->m_cbuffer;
+      cl->m_checkpoint = m_now;
+      cl->m_mode = HtbClass::CAN_SEND;
+      cl->m_prioActivity = 0;
+      cl->m_nBorrows = 0;
+      for (uint8_t level = 0; level < HtbClass::MAX_DEPTH; level++)
+        {
+          cl->m_deficit[level] = 0;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the structure of the Linux HTB queue disc
+ * (net/sched/sch_htb.c) by Martin Devera. Red-black trees are replaced by
+ * maps sorted by class identifier and the per-level event budget is not
+ * implemented, i.e., all the pending class mode changes are processed at
+ * every dequeue.
+ */
+
+#ifndef HTB_QUEUE_DISC_H
+#define HTB_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class HtbClass;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Round robin list of the active classes having a given priority
+ *
+ * Classes are sorted by identifier. The round robin pointer is the identifier
+ * of the next class to serve, hence it stays valid when classes are added to
+ * or removed from the list.
+ */
+struct HtbPrio
+{
+  HtbPrio ();
+
+  std::map<uint32_t, HtbClass*> m_classes;  //!< Active classes, sorted by identifier
+  uint32_t m_next;                           //!< Identifier of the next class to serve
+};
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A class of the HTB queue disc
+ *
+ * A class is guaranteed its rate and can borrow the unused bandwidth of its
+ * ancestors up to its ceil rate. Leaf classes are the queue disc classes of
+ * the HTB queue disc and store packets in their child queue disc, while inner
+ * classes are added by means of HtbQueueDisc::AddInnerClass and only share
+ * their bandwidth among their children.
+ */
+class HtbClass : public QueueDiscClass
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief HtbClass constructor
+   */
+  HtbClass ();
+
+  virtual ~HtbClass ();
+
+  /// Maximum depth of the class hierarchy
+  static constexpr uint8_t MAX_DEPTH = 8;
+  /// Number of priorities
+  static constexpr uint8_t NUM_PRIO = 8;
+
+  /**
+   * \brief Modes of a class
+   */
+  enum Mode
+  {
+    CANT_SEND,    //!< The class exceeded its ceil rate
+    MAY_BORROW,   //!< The class exceeded its rate but not its ceil rate
+    CAN_SEND      //!< The class did not exceed its rate
+  };
+
+  /**
+   * \brief Get the mode of the class, as of its last update
+   * \return the mode of the class
+   */
+  Mode GetMode (void) const;
+
+  /**
+   * \brief Get the number of packets sent by borrowing from an ancestor
+   * \return the number of packets sent by borrowing from an ancestor
+   */
+  uint64_t GetNBorrows (void) const;
+
+private:
+  friend class HtbQueueDisc;
+
+  // ** Variables supplied by user
+  DataRate m_rate;                      //!< Guaranteed rate
+  DataRate m_ceil;                      //!< Maximum rate (0 means equal to the rate)
+  uint32_t m_burst;                     //!< Size of the rate bucket in bytes (0 means automatic)
+  uint32_t m_cburst;                    //!< Size of the ceil bucket in bytes (0 means automatic)
+  uint32_t m_quantum;                   //!< Deficit round robin quantum in bytes (0 means automatic)
+  uint8_t m_priority;                   //!< Priority of a leaf class (0 is the highest)
+  uint32_t m_parentId;                  //!< Identifier of the parent inner class (0 means none)
+
+  // ** Variables maintained by HtbQueueDisc
+  uint32_t m_id;                        //!< Identifier used to sort the classes
+  HtbClass* m_parent;                   //!< Parent class
+  uint8_t m_level;                      //!< Level of the class (0 for leaf classes)
+  Mode m_mode;                          //!< Current mode
+  int64_t m_tokens;                     //!< Rate tokens, in nanoseconds
+  int64_t m_ctokens;                    //!< Ceil tokens, in nanoseconds
+  int64_t m_buffer;                     //!< Size of the rate bucket, in nanoseconds
+  int64_t m_cbuffer;                    //!< Size of the ceil bucket, in nanoseconds
+  int64_t m_checkpoint;                 //!< Time of the last token update, in nanoseconds
+  int32_t m_deficit[MAX_DEPTH];         //!< Deficit of a leaf class at each level
+  int32_t m_quantumBytes;               //!< Quantum used by the deficit round robin
+  uint8_t m_prioActivity;               //!< Priorities for which the class is active
+  std::multimap<int64_t, HtbClass*>::iterator m_waitNode;  //!< Position in the wait queue
+  HtbPrio m_feeds[NUM_PRIO];            //!< Children of an inner class borrowing from it
+  uint64_t m_nBorrows;                  //!< Number of packets sent by borrowing
+};
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Implements the Hierarchical Token Bucket queue disc
+ *
+ * Classes form a tree whose leaves are the queue disc classes of HTB, each
+ * with a child queue disc of any type (e.g., PIE, CoDel or a self-tuning PI
+ * queue disc). Packets are assigned to a leaf class by the packet filters
+ * (which return the index of the leaf class) or to the default class.
+ *
+ * Each class has a rate bucket and a ceil bucket. Leaf classes are served at
+ * their rate first, in priority order and by deficit round robin among
+ * classes of the same priority. Then, classes that exceeded their rate but
+ * not their ceil rate borrow the tokens of the closest ancestor that did not
+ * exceed its rate, the lowest levels being served first.
+ *
+ * Tokens are refilled lazily, based on the time elapsed since the last update
+ * of a class, when the class is charged for a packet or when its mode may
+ * change. The times at which throttled classes may change mode are kept in a
+ * per-level wait queue, hence a single timer is used to wake the queue disc
+ * regardless of the number of classes.
+ */
+class HtbQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief HtbQueueDisc constructor
+   */
+  HtbQueueDisc ();
+
+  virtual ~HtbQueueDisc ();
+
+  /**
+   * \brief Add an inner class to the class hierarchy.
+   *
+   * The Parent attribute of a class set to the identifier returned by this
+   * method makes such class a child of the added inner class.
+   *
+   * \param cl the inner class
+   * \return the identifier of the inner class (starting from 1)
+   */
+  uint32_t AddInnerClass (Ptr<HtbClass> cl);
+
+  /**
+   * \brief Get the inner class with the given identifier
+   * \param id the identifier of the inner class
+   * \return the inner class
+   */
+  Ptr<HtbClass> GetInnerClass (uint32_t id) const;
+
+  /**
+   * \brief Get the number of inner classes
+   * \return the number of inner classes
+   */
+  std::size_t GetNInnerClasses (void) const;
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Compute the mode a class would have after the given time.
+   *
+   * Modelled after the Linux function htb_class_mode (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   * \param diff the time elapsed since the last update (in nanoseconds). Set
+   *        to the time until the mode may change, if the class cannot send
+   * \return the mode of the class
+   */
+  HtbClass::Mode ClassMode (HtbClass *cl, int64_t &diff) const;
+  /**
+   * \brief Update the mode of a class and its position in the trees.
+   *
+   * Modelled after the Linux function htb_change_class_mode (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   * \param diff the time elapsed since the last update (in nanoseconds)
+   */
+  void ChangeClassMode (HtbClass *cl, int64_t &diff);
+  /**
+   * \brief Schedule the mode update of a class.
+   *
+   * Modelled after the Linux function htb_add_to_wait_tree (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   * \param delay the time until the mode of the class may change
+   */
+  void AddToWaitQueue (HtbClass *cl, int64_t delay);
+  /**
+   * \brief Add a class to the rows of the given priorities at its level.
+   *
+   * Modelled after the Linux function htb_add_class_to_row (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   * \param mask the priorities
+   */
+  void AddClassToRow (HtbClass *cl, uint8_t mask);
+  /**
+   * \brief Remove a class from the rows of the given priorities at its level.
+   *
+   * Modelled after the Linux function htb_remove_class_from_row (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   * \param mask the priorities
+   */
+  void RemoveClassFromRow (HtbClass *cl, uint8_t mask);
+  /**
+   * \brief Add a class to the feeds of its ancestors or to a row.
+   *
+   * Modelled after the Linux function htb_activate_prios (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   */
+  void ActivatePrios (HtbClass *cl);
+  /**
+   * \brief Remove a class from the feeds of its ancestors or from a row.
+   *
+   * Modelled after the Linux function htb_deactivate_prios (net/sched/sch_htb.c)
+   *
+   * \param cl the class
+   */
+  void DeactivatePrios (HtbClass *cl);
+  /**
+   * \brief Make a leaf class with backlogged packets active.
+   * \param cl the leaf class
+   */
+  void Activate (HtbClass *cl);
+  /**
+   * \brief Make an empty leaf class inactive.
+   * \param cl the leaf class
+   */
+  void Deactivate (HtbClass *cl);
+  /**
+   * \brief Charge a leaf class and its ancestors for a packet.
+   *
+   * Modelled after the Linux function htb_charge_class (net/sched/sch_htb.c)
+   *
+   * \param cl the leaf class
+   * \param level the level at which the packet has been dequeued
+   * \param bytes the size of the packet
+   */
+  void ChargeClass (HtbClass *cl, uint8_t level, uint32_t bytes);
+  /**
+   * \brief Update the mode of the classes of a level whose time has come.
+   *
+   * Modelled after the Linux function htb_do_events (net/sched/sch_htb.c)
+   *
+   * \param level the level
+   * \return the time of the next mode update at the given level, or 0
+   */
+  int64_t DoEvents (uint8_t level);
+  /**
+   * \brief Find the next leaf class to serve in a round robin list.
+   *
+   * Modelled after the Linux function htb_lookup_leaf (net/sched/sch_htb.c)
+   *
+   * \param hprio the round robin list
+   * \param prio the priority of the list
+   * \return the leaf class, or 0
+   */
+  HtbClass* LookupLeaf (HtbPrio *hprio, uint8_t prio);
+  /**
+   * \brief Move the round robin pointer past the given leaf class.
+   * \param cl the leaf class
+   * \param level the level at which the leaf class is served
+   * \param prio the priority
+   */
+  void NextLeaf (HtbClass *cl, uint8_t level, uint8_t prio);
+  /**
+   * \brief Dequeue a packet from the classes of the given priority and level.
+   *
+   * Modelled after the Linux function htb_dequeue_tree (net/sched/sch_htb.c)
+   *
+   * \param prio the priority
+   * \param level the level
+   * \return the dequeued packet, or 0
+   */
+  Ptr<QueueDiscItem> DequeueTree (uint8_t prio, uint8_t level);
+
+  // ** Variables supplied by user
+  uint32_t m_defaultClass;                    //!< Leaf class of the unclassified packets
+  std::vector<Ptr<HtbClass> > m_innerClasses; //!< Inner classes
+
+  // ** Variables maintained by HTB
+  std::vector<HtbClass*> m_leaves;            //!< Leaf classes
+  HtbPrio m_rows[HtbClass::MAX_DEPTH][HtbClass::NUM_PRIO];  //!< Classes able to send, per level and priority
+  uint8_t m_rowMask[HtbClass::MAX_DEPTH];    //!< Priorities of the non-empty rows of each level
+  std::multimap<int64_t, HtbClass*> m_waitQueue[HtbClass::MAX_DEPTH];  //!< Throttled classes of each level, by time of the mode update
+  int64_t m_nearEvent[HtbClass::MAX_DEPTH];  //!< Time of the next mode update of each level
+  int64_t m_now;                              //!< Time of the current dequeue, in nanoseconds
+  EventId m_watchdog;                         //!< Event waking the queue disc
+};
+
+} // namespace ns3
+
+#endif /* HTB_QUEUE_DISC_H */
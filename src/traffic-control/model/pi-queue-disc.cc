@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the PI controller of ns-2.35 (queue/pi.cc).
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "pi-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PiQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (PiQueueDisc);
+
+TypeId PiQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PiQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<PiQueueDisc> ()
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&PiQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueRef",
+                   "Desired queue size, in packets or bytes",
+                   QueueSizeValue (QueueSize ("50p")),
+                   MakeQueueSizeAccessor (&PiQueueDisc::m_qRef),
+                   MakeQueueSizeChecker ())
+    .AddAttribute ("A",
+                   "Value of alpha",
+                   DoubleValue (0.00001822),
+                   MakeDoubleAccessor (&PiQueueDisc::m_a),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("B",
+                   "Value of beta",
+                   DoubleValue (0.00001816),
+                   MakeDoubleAccessor (&PiQueueDisc::m_b),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("W",
+                   "Sampling frequency",
+                   DoubleValue (170),
+                   MakeDoubleAccessor (&PiQueueDisc::m_w),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("UseTimestamp",
+                   "True to control the sojourn time of the packet at the head of the queue rather than the queue length",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PiQueueDisc::m_useTimestamp),
+                   MakeBooleanChecker ())
+    .AddAttribute ("QueueDelayReference",
+                   "Desired queue delay, corresponding to QueueRef (timestamp mode only)",
+                   TimeValue (Seconds (0.02)),
+                   MakeTimeAccessor (&PiQueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxSize",
+                   "The maximum number of packets accepted by this queue disc",
+                   QueueSizeValue (QueueSize ("50p")),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+  ;
+
+  return tid;
+}
+
+PiQueueDisc::PiQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+}
+
+PiQueueDisc::~PiQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PiQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = 0;
+  Simulator::Remove (m_rtrsEvent);
+  QueueDisc::DoDispose ();
+}
+
+double
+PiQueueDisc::GetDropProbability (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_dropProb;
+}
+
+QueueDisc::ControllerState
+PiQueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ControllerState state;
+  // the PI controller is driven by the queue length rather than the queue delay
+  state.queueDelay = Time (0);
+  state.probability = m_dropProb;
+  return state;
+}
+
+int64_t
+PiQueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+bool
+PiQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  if (GetCurrentSize () + item > GetMaxSize ())
+    {
+      // Drops due to queue limit: reactive
+      DropBeforeEnqueue (item, FORCED_DROP);
+      return false;
+    }
+  else if (DropEarly (item))
+    {
+      // Early probability drop: proactive
+      DropBeforeEnqueue (item, UNFORCED_DROP);
+      return false;
+    }
+
+  // No drop
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
+  // internal queue because QueueDisc::AddInternalQueue sets the trace callback
+
+  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+
+  return retval;
+}
+
+void
+PiQueueDisc::InitializeParams (void)
+{
+  m_dropProb = 0;
+  m_qLenOld = 0;
+  // The controller works in packets, hence convert the reference if needed
+  if (m_qRef.GetUnit () == QueueSizeUnit::BYTES)
+    {
+      m_qRefPkts = static_cast<double> (m_qRef.GetValue ()) / m_meanPktSize;
+    }
+  else
+    {
+      m_qRefPkts = m_qRef.GetValue ();
+    }
+  // The first sample is taken one sampling period after initialization
+  m_rtrsEvent = Simulator::Schedule (Seconds (1.0 / m_w), &PiQueueDisc::CalculateP, this);
+}
+
+bool PiQueueDisc::DropEarly (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  double p = m_dropProb;
+
+  if (GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES)
+    {
+      p = p * item->GetSize () / m_meanPktSize;
+    }
+  p = std::min (p, 1.0);
+
+  return m_uv->GetValue () < p;
+}
+
+void PiQueueDisc::CalculateP ()
+{
+  NS_LOG_FUNCTION (this);
+
+  double qLen;
+  if (m_useTimestamp)
+    {
+      // Packets are timestamped when enqueued. The sojourn time of the packet
+      // at the head of the queue is expressed as a queue length in packets
+      Ptr<const QueueDiscItem> head = GetInternalQueue (0)->Peek ();
+      Time qDelay = (head ? Simulator::Now () - head->GetTimeStamp () : Time (Seconds (0)));
+      qLen = m_qRefPkts * qDelay.GetSeconds () / m_qDelayRef.GetSeconds ();
+    }
+  else if (GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES)
+    {
+      qLen = static_cast<double> (GetInternalQueue (0)->GetNBytes ()) / m_meanPktSize;
+    }
+  else
+    {
+      qLen = GetInternalQueue (0)->GetNPackets ();
+    }
+
+  double p = m_a * (qLen - m_qRefPkts) - m_b * (m_qLenOld - m_qRefPkts) + m_dropProb;
+  m_dropProb = std::min (std::max (p, 0.0), 1.0);
+  m_qLenOld = qLen;
+
+  NS_LOG_DEBUG ("\t qLen " << qLen << " dropProb " << m_dropProb);
+
+  m_rtrsEvent = Simulator::Schedule (Seconds (1.0 / m_w), &PiQueueDisc::CalculateP, this);
+}
+
+Ptr<QueueDiscItem>
+PiQueueDisc::DoDequeue ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  return GetInternalQueue (0)->Dequeue ();
+}
+
+bool
+PiQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("PiQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("PiQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // add  a DropTail queue
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> >
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("PiQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  if (m_w <= 0)
+    {
+      NS_LOG_ERROR ("The sampling frequency must be positive");
+      return false;
+    }
+
+  if (m_useTimestamp && !m_qDelayRef.IsStrictlyPositive ())
+    {
+      NS_LOG_ERROR ("The queue delay reference must be positive");
+      return false;
+    }
+
+  return true;
+}
+
+} //namespace ns3
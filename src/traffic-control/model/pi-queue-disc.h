@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PORT NOTE: This code follows the PI controller of ns-2.35 (queue/pi.cc).
+ */
+
+#ifndef PI_QUEUE_DISC_H
+#define PI_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Implements the Proportional Integral (PI) Active Queue Management discipline
+ *
+ * The PI controller proposed by Hollot et al. samples the queue length with
+ * frequency W and updates the drop probability as
+ * p(kT) = a (q(kT) - q_ref) - b (q((k-1)T) - q_ref) + p((k-1)T),
+ * where the queue length and the reference are expressed in packets (byte
+ * quantities are divided by the mean packet size).
+ *
+ * If the UseTimestamp attribute is set, the queue length is replaced by the
+ * sojourn time d of the packet at the head of the queue, scaled so that the
+ * reference delay corresponds to the reference queue length, i.e.,
+ * q = q_ref * d / d_ref. Hence, the gains keep their meaning and the
+ * controller tracks the reference delay whatever the rate of the link.
+ */
+class PiQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief PiQueueDisc Constructor
+   */
+  PiQueueDisc ();
+
+  /**
+   * \brief PiQueueDisc Destructor
+   */
+  virtual ~PiQueueDisc ();
+
+  /**
+   * \brief Get the current drop probability.
+   *
+   * \returns The current drop probability.
+   */
+  double GetDropProbability (void);
+
+  /**
+   * \brief Get the state of the controller.
+   *
+   * \returns The current queue delay and drop probability.
+   */
+  virtual ControllerState GetControllerState (void);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  // Reasons for dropping packets
+  static constexpr const char* UNFORCED_DROP = "Unforced drop";  //!< Early probability drops: proactive
+  static constexpr const char* FORCED_DROP = "Forced drop";      //!< Drops due to queue limit: reactive
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+
+  /**
+   * \brief Initialize the queue parameters.
+   */
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Check if a packet needs to be dropped due to probability drop
+   * \param item queue item
+   * \returns false for no drop, true for drop
+   */
+  bool DropEarly (Ptr<QueueDiscItem> item);
+
+  /**
+   * Periodically update the drop probability, with frequency W
+   */
+  void CalculateP ();
+
+  // ** Variables supplied by user
+  uint32_t m_meanPktSize;                       //!< Average packet size in bytes
+  QueueSize m_qRef;                             //!< Desired queue length
+  double m_a;                                   //!< Parameter a of the PI controller
+  double m_b;                                   //!< Parameter b of the PI controller
+  double m_w;                                   //!< Sampling frequency (in Hz) of the PI controller
+  bool m_useTimestamp;                          //!< True to control the sojourn time of the head packet rather than the queue length
+  Time m_qDelayRef;                             //!< Desired queue delay (timestamp mode)
+
+  // ** Variables maintained by PI
+  double m_qRefPkts;                            //!< Desired queue length (in packets)
+  double m_dropProb;                            //!< Drop probability
+  double m_qLenOld;                             //!< Queue length (in packets) at the previous sample
+  EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
+};
+
+};   // namespace ns3
+
+#endif
@@ -34,11 +34,28 @@
 #include "pie-queue-disc.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/link-estimator.h"
+#include <cmath>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PieQueueDisc");
 
+/**
+ * Returns the given time translated in Linux psched ticks (64 ns)
+ * \param t the time
+ * \return the number of psched ticks
+ */
+static inline uint64_t Time2Psched (Time t)
+{
+  return static_cast<uint64_t> (t.GetNanoSeconds ()) >> 6;
+}
+
+/**
+ * Number of psched ticks per second
+ */
+static const uint64_t PSCHED_TICKS_PER_SEC = 1000000000ULL >> 6;
+
 NS_OBJECT_ENSURE_REGISTERED (PieQueueDisc);
 
 TypeId PieQueueDisc::GetTypeId (void)
@@ -93,6 +110,41 @@ TypeId PieQueueDisc::GetTypeId (void)
                    TimeValue (Seconds (0.1)),
                    MakeTimeAccessor (&PieQueueDisc::m_maxBurst),
                    MakeTimeChecker ())
+    .AddAttribute ("UseLazyUpdate",
+                   "True to update the drop probability when packets are enqueued or dequeued rather than with a periodic timer",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useLazyUpdate),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseTimestamp",
+                   "True to estimate the queue delay as the sojourn time of the packet at the head of the queue rather than from the dequeue rate",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useTimestamp),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseFixedPoint",
+                   "True to update the drop probability and take the drop decisions in the integer arithmetic of the Linux kernel",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useFixedPoint),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseEcn",
+                   "True to use ECN (packets are marked instead of being dropped)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkEcnThreshold",
+                   "ECN capable packets are dropped rather than marked if the drop probability exceeds this threshold",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&PieQueueDisc::m_markEcnTh),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("UseL4s",
+                   "True to mark ECT(1) packets whose sojourn time exceeds CeThreshold",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useL4s),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CeThreshold",
+                   "Sojourn time above which ECT(1) packets are marked, if UseL4s is true",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&PieQueueDisc::m_ceThreshold),
+                   MakeTimeChecker ())
   ;
 
   return tid;
@@ -103,7 +155,6 @@ PieQueueDisc::PieQueueDisc ()
 {
   NS_LOG_FUNCTION (this);
   m_uv = CreateObject<UniformRandomVariable> ();
-  m_rtrsEvent = Simulator::Schedule (m_sUpdate, &PieQueueDisc::CalculateP, this);
 }
 
 PieQueueDisc::~PieQueueDisc ()
@@ -124,9 +175,42 @@ Time
 PieQueueDisc::GetQueueDelay (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_useLazyUpdate)
+    {
+      LazyUpdate ();
+    }
+  if (m_useFixedPoint)
+    {
+      return NanoSeconds (m_qDelayTicks << 6);
+    }
   return m_qDelay;
 }
 
+double
+PieQueueDisc::GetDropProbability (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_useLazyUpdate)
+    {
+      LazyUpdate ();
+    }
+  if (m_useFixedPoint)
+    {
+      return static_cast<double> (m_prob) / MAX_PROB;
+    }
+  return m_dropProb;
+}
+
+QueueDisc::ControllerState
+PieQueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ControllerState state;
+  state.queueDelay = GetQueueDelay ();
+  state.probability = GetDropProbability ();
+  return state;
+}
+
 int64_t
 PieQueueDisc::AssignStreams (int64_t stream)
 {
@@ -140,19 +224,32 @@ PieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
+  if (m_useLazyUpdate)
+    {
+      LazyUpdate ();
+    }
+
   QueueSize nQueued = GetCurrentSize ();
 
   if (nQueued + item > GetMaxSize ())
     {
       // Drops due to queue limit: reactive
+      m_accuProb = 0;
       DropBeforeEnqueue (item, FORCED_DROP);
       return false;
     }
-  else if (DropEarly (item, nQueued.GetValue ()))
+  else if (m_useFixedPoint ? DropEarlyFixedPoint (item) : DropEarly (item, nQueued.GetValue ()))
     {
-      // Early probability drop: proactive
-      DropBeforeEnqueue (item, UNFORCED_DROP);
-      return false;
+      // If the packet is ECN capable, mark it if the drop probability is
+      // low enough, else drop it
+      double p = (m_useFixedPoint ? static_cast<double> (m_prob) / MAX_PROB : m_dropProb);
+      if (!m_useEcn || p > m_markEcnTh || !Mark (item, UNFORCED_MARK))
+        {
+          // Early probability drop: proactive
+          m_accuProb = 0;
+          DropBeforeEnqueue (item, UNFORCED_DROP);
+          return false;
+        }
     }
 
   // No drop
@@ -178,6 +275,27 @@ PieQueueDisc::InitializeParams (void)
   m_dqStart = 0;
   m_burstState = NO_BURST;
   m_qDelayOld = Time (Seconds (0));
+
+  // alpha and beta are passed to the Linux kernel as integers between 0 and 32
+  m_alpha = static_cast<uint64_t> (std::round (m_a * 16));
+  m_beta = static_cast<uint64_t> (std::round (m_b * 16));
+  m_target = Time2Psched (m_qDelayRef);
+  m_prob = 0;
+  m_qDelayTicks = 0;
+  m_qDelayOldTicks = 0;
+  ResetFixedPointVars ();
+
+  // The update timer is started when the queue disc is initialized, so
+  // that a queue disc which is never used does not run periodic updates
+  if (m_useLazyUpdate)
+    {
+      // The first update is due when the update timer would have expired
+      m_nextUpdate = Simulator::Now () + m_sUpdate;
+    }
+  else
+    {
+      m_rtrsEvent = Simulator::Schedule (m_sUpdate, &PieQueueDisc::PeriodicUpdate, this);
+    }
 }
 
 bool PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
@@ -231,15 +349,345 @@ bool PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
   return true;
 }
 
-void PieQueueDisc::CalculateP ()
+bool PieQueueDisc::DropEarlyFixedPoint (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint64_t localProb = m_prob;
+  uint32_t mtu = m_meanPktSize;
+
+  // If there is still burst allowance left skip random early drop
+  if (m_burstTime > 0)
+    {
+      return false;
+    }
+
+  // If current delay is less than half of target, and
+  // if drop prob is low already, disable early_drop
+  if (m_qDelayTicks < m_target / 2 && m_prob < MAX_PROB / 5)
+    {
+      return false;
+    }
+
+  // If we have fewer than 2 mtu-sized packets, disable pie_drop_early,
+  // similar to min_th in RED
+  if (GetInternalQueue (0)->GetNBytes () < 2 * mtu)
+    {
+      return false;
+    }
+
+  // If bytemode is turned on, use packet size to compute new
+  // probablity. Smaller packets will have lower drop prob in this case
+  if (GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES && item->GetSize () <= mtu)
+    {
+      localProb = static_cast<uint64_t> (item->GetSize ()) * (localProb / mtu);
+    }
+
+  if (localProb == 0)
+    {
+      m_accuProb = 0;
+    }
+  else
+    {
+      m_accuProb += localProb;
+    }
+
+  if (m_accuProb < (MAX_PROB / 100) * 85)
+    {
+      return false;
+    }
+  if (m_accuProb >= (MAX_PROB / 2) * 17)
+    {
+      return true;
+    }
+
+  // 56 random bits, as (rnd >> BITS_PER_BYTE) in the kernel
+  uint64_t rnd = (static_cast<uint64_t> (m_uv->GetInteger (0, 0xffffff)) << 32)
+                 | m_uv->GetInteger (0, 0xffffffff);
+  if (rnd < localProb)
+    {
+      m_accuProb = 0;
+      return true;
+    }
+
+  return false;
+}
+
+void PieQueueDisc::CalculatePFixedPoint ()
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t backlog = GetInternalQueue (0)->GetNBytes ();
+  uint64_t qDelay = 0;
+  uint64_t qDelayOld = 0;
+  int64_t delta = 0;
+  bool updateProb = true;
+
+  if (!m_useTimestamp)
+    {
+      qDelayOld = m_qDelayTicks;
+      m_qDelayOldTicks = m_qDelayTicks;
+
+      if (m_avgDqRateTicks > 0)
+        {
+          qDelay = (backlog << PIE_SCALE) / m_avgDqRateTicks;
+        }
+    }
+  else
+    {
+      qDelay = m_qDelayTicks;
+      qDelayOld = m_qDelayOldTicks;
+    }
+
+  // If qdelay is zero and backlog is not, it means backlog is very small,
+  // so we do not update probabilty in this round.
+  if (qDelay == 0 && backlog != 0)
+    {
+      updateProb = false;
+    }
+
+  // alpha and beta have unit of HZ and need to be scaled before they can be
+  // used to update the probability, and are scaled down by 16 to come to the
+  // 0-2 range
+  uint64_t alpha = (m_alpha * (MAX_PROB / PSCHED_TICKS_PER_SEC)) >> 4;
+  uint64_t beta = (m_beta * (MAX_PROB / PSCHED_TICKS_PER_SEC)) >> 4;
+
+  // We scale alpha and beta differently depending on how heavy the
+  // congestion is (RFC 8033)
+  if (m_prob < MAX_PROB / 10)
+    {
+      alpha >>= 1;
+      beta >>= 1;
+
+      uint32_t power = 100;
+      while (m_prob < MAX_PROB / power && power <= 1000000)
+        {
+          alpha >>= 2;
+          beta >>= 2;
+          power *= 10;
+        }
+    }
+
+  // The differences are computed modulo 2^64, as in the kernel
+  delta += static_cast<int64_t> (alpha * (qDelay - m_target));
+  delta += static_cast<int64_t> (beta * (qDelay - qDelayOld));
+
+  uint64_t oldProb = m_prob;
+
+  // to ensure we increase probability in steps of no more than 2%
+  if (delta > static_cast<int64_t> (MAX_PROB / (100 / 2)) && m_prob >= MAX_PROB / 10)
+    {
+      delta = (MAX_PROB / 100) * 2;
+    }
+
+  // Non-linear drop: tune drop probability to increase quickly for high
+  // delays (>= 250ms)
+  if (qDelay > Time2Psched (MilliSeconds (250)))
+    {
+      delta += MAX_PROB / (100 / 2);
+    }
+
+  m_prob += delta;
+
+  if (delta > 0)
+    {
+      // prevent overflow
+      if (m_prob < oldProb)
+        {
+          m_prob = MAX_PROB;
+          // Prevent normalization error. If probability is at maximum value
+          // already, we normalize it here, and skip the check to do a
+          // non-linear drop in the next section
+          updateProb = false;
+        }
+    }
+  else
+    {
+      // prevent underflow
+      if (m_prob > oldProb)
+        {
+          m_prob = 0;
+        }
+    }
+
+  // Non-linear drop in probability: reduce drop probability quickly if
+  // delay is 0 for 2 consecutive Tupdate periods
+  if (qDelay == 0 && qDelayOld == 0 && updateProb)
+    {
+      // Reduce drop probability to 98.4%
+      m_prob -= m_prob / 64;
+    }
+
+  m_qDelayTicks = qDelay;
+
+  // We restart the measurement cycle if the delay has been low for 2
+  // consecutive Tupdate periods, the drop probability is zero and, if the
+  // dequeue rate is estimated, we have at least one estimate for it
+  if (m_qDelayTicks < m_target / 2 && m_qDelayOldTicks < m_target / 2 && m_prob == 0
+      && (m_useTimestamp || m_avgDqRateTicks > 0))
+    {
+      ResetFixedPointVars ();
+    }
+
+  if (m_useTimestamp)
+    {
+      m_qDelayOldTicks = qDelay;
+    }
+
+  NS_LOG_DEBUG ("\t qDelay " << qDelay << " ticks, prob " << static_cast<double> (m_prob) / MAX_PROB);
+}
+
+void
+PieQueueDisc::ProcessDequeueFixedPoint (Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint64_t now = Time2Psched (Simulator::Now ());
+  uint32_t backlog = GetInternalQueue (0)->GetNBytes ();
+  uint32_t dtime = 0;
+
+  if (m_useTimestamp)
+    {
+      // calculate qdelay using the packet timestamp
+      m_qDelayTicks = now - Time2Psched (item->GetTimeStamp ());
+
+      if (m_dqTstamp != DTIME_INVALID)
+        {
+          dtime = static_cast<uint32_t> (now - m_dqTstamp);
+        }
+
+      m_dqTstamp = now;
+
+      if (backlog == 0)
+        {
+          m_qDelayTicks = 0;
+        }
+
+      if (dtime == 0)
+        {
+          return;
+        }
+    }
+  else
+    {
+      // If the queue has built up to the threshold and dq_count is unset, we
+      // have enough packets to calculate the drain rate. Save current time as
+      // dq_tstamp and start measurement cycle
+      if (backlog >= m_dqThreshold && m_dqCount == DQCOUNT_INVALID)
+        {
+          m_dqTstamp = now;
+          m_dqCount = 0;
+        }
+
+      // Calculate the average drain rate from this value. If queue length has
+      // receded below the threshold, reset dq_count as we don't have enough
+      // packets to calculate the drain rate anymore. dq_count is in bytes,
+      // time difference in psched ticks, hence rate is in bytes per tick
+      if (m_dqCount == DQCOUNT_INVALID)
+        {
+          return;
+        }
+
+      m_dqCount += item->GetSize ();
+
+      if (m_dqCount < m_dqThreshold)
+        {
+          return;
+        }
+
+      uint32_t count = static_cast<uint32_t> (m_dqCount << PIE_SCALE);
+
+      dtime = static_cast<uint32_t> (now - m_dqTstamp);
+
+      if (dtime == 0)
+        {
+          return;
+        }
+
+      count = count / dtime;
+
+      if (m_avgDqRateTicks == 0)
+        {
+          m_avgDqRateTicks = count;
+        }
+      else
+        {
+          m_avgDqRateTicks = (m_avgDqRateTicks - (m_avgDqRateTicks >> 3)) + (count >> 3);
+        }
+
+      // If the queue has receded below the threshold, we hold on to the last
+      // drain rate calculated, else we reset dq_count to 0 to re-enter the
+      // measurement when the next packet is dequeued
+      if (backlog < m_dqThreshold)
+        {
+          m_dqCount = DQCOUNT_INVALID;
+        }
+      else
+        {
+          m_dqCount = 0;
+          m_dqTstamp = now;
+        }
+    }
+
+  // reduce the burst allowance
+  if (m_burstTime > 0)
+    {
+      if (m_burstTime > dtime)
+        {
+          m_burstTime -= dtime;
+        }
+      else
+        {
+          m_burstTime = 0;
+        }
+    }
+}
+
+void
+PieQueueDisc::ResetFixedPointVars ()
 {
   NS_LOG_FUNCTION (this);
+  m_burstTime = Time2Psched (m_maxBurst);
+  m_dqTstamp = DTIME_INVALID;
+  m_accuProb = 0;
+  m_dqCount = DQCOUNT_INVALID;
+  m_avgDqRateTicks = 0;
+}
+
+double
+PieQueueDisc::GetDepartureRate (void) const
+{
+  Ptr<LinkEstimator> estimator = GetLinkEstimator ();
+  if (estimator && estimator->GetDrainRate ().GetBitRate () > 0)
+    {
+      return estimator->GetDrainRate ().GetBitRate () / 8.0;
+    }
+  return m_avgDqRate;
+}
+
+void PieQueueDisc::CalculateP (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+
+  if (m_useFixedPoint)
+    {
+      CalculatePFixedPoint ();
+      return;
+    }
+
   Time qDelay;
   double p = 0.0;
   bool missingInitFlag = false;
-  if (m_avgDqRate > 0)
+  if (m_useTimestamp)
+    {
+      // Packets are timestamped when enqueued, hence the queue delay is the
+      // time spent in the queue by the packet at the head (RFC 8033, Sec. 5.2)
+      Ptr<const QueueDiscItem> head = GetInternalQueue (0)->Peek ();
+      qDelay = (head ? now - head->GetTimeStamp () : Time (Seconds (0)));
+    }
+  else if (GetDepartureRate () > 0)
     {
-      qDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / m_avgDqRate));
+      qDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / GetDepartureRate ()));
     }
   else
     {
@@ -310,7 +758,7 @@ void PieQueueDisc::CalculateP ()
     }
 
   uint32_t burstResetLimit = static_cast<uint32_t>(BURST_RESET_TIMEOUT / m_tUpdate.GetSeconds ());
-  if ( (qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && !missingInitFlag )
+  if (!m_useTimestamp && (qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && !missingInitFlag )
     {
       m_dqCount = DQCOUNT_INVALID;
       m_avgDqRate = 0.0;
@@ -338,7 +786,60 @@ void PieQueueDisc::CalculateP ()
     }
 
   m_qDelayOld = qDelay;
-  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
+}
+
+void
+PieQueueDisc::PeriodicUpdate ()
+{
+  NS_LOG_FUNCTION (this);
+  CalculateP (Simulator::Now ());
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::PeriodicUpdate, this);
+}
+
+void
+PieQueueDisc::LazyUpdate ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // An update due at the current time is performed after the packets
+  // enqueued or dequeued at the same time, as the timer does
+  Time now = Simulator::Now ();
+  while (m_nextUpdate < now)
+    {
+      double dropProb = m_dropProb;
+      Time qDelayOld = m_qDelayOld;
+      Time burstAllowance = m_burstAllowance;
+      BurstStateT burstState = m_burstState;
+      uint32_t burstReset = m_burstReset;
+      double avgDqRate = m_avgDqRate;
+      uint64_t dqCount = m_dqCount;
+      uint64_t prob = m_prob;
+      uint64_t qDelayTicks = m_qDelayTicks;
+      uint64_t qDelayOldTicks = m_qDelayOldTicks;
+      uint64_t burstTime = m_burstTime;
+      uint64_t dqTstamp = m_dqTstamp;
+      uint64_t accuProb = m_accuProb;
+      uint32_t avgDqRateTicks = m_avgDqRateTicks;
+
+      CalculateP (m_nextUpdate);
+      m_nextUpdate += m_tUpdate;
+
+      if (dropProb == m_dropProb && qDelayOld == m_qDelayOld && burstAllowance == m_burstAllowance
+          && burstState == m_burstState && burstReset == m_burstReset
+          && avgDqRate == m_avgDqRate && dqCount == m_dqCount && prob == m_prob
+          && qDelayTicks == m_qDelayTicks && qDelayOldTicks == m_qDelayOldTicks
+          && burstTime == m_burstTime && dqTstamp == m_dqTstamp && accuProb == m_accuProb
+          && avgDqRateTicks == m_avgDqRateTicks && m_nextUpdate < now)
+        {
+          // CalculateP only depends on the state above and on the queue length,
+          // which does not change until now, hence the remaining updates are no-ops
+          // (in timestamp mode, the state only stays unchanged if the queue is empty)
+          int64_t period = m_tUpdate.GetTimeStep ();
+          int64_t missed = ((now - m_nextUpdate).GetTimeStep () + period - 1) / period;
+          NS_LOG_LOGIC ("Skipping " << missed << " updates leaving the state unchanged");
+          m_nextUpdate = TimeStep (m_nextUpdate.GetTimeStep () + missed * period);
+        }
+    }
 }
 
 Ptr<QueueDiscItem>
@@ -346,6 +847,11 @@ PieQueueDisc::DoDequeue ()
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_useLazyUpdate)
+    {
+      LazyUpdate ();
+    }
+
   if (GetInternalQueue (0)->IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
@@ -353,6 +859,28 @@ PieQueueDisc::DoDequeue ()
     }
 
   Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+
+  uint8_t tos;
+  // ECT(1) (01) and CE (11) packets are L4S packets
+  if (m_useL4s && Simulator::Now () - item->GetTimeStamp () > m_ceThreshold
+      && item->GetUint8Value (QueueItem::IP_DSFIELD, tos) && (tos & 0x01) == 0x01)
+    {
+      Mark (item, CE_THRESHOLD_EXCEEDED_MARK);
+    }
+
+  if (m_useFixedPoint)
+    {
+      ProcessDequeueFixedPoint (item);
+      return item;
+    }
+
+  if (m_useTimestamp)
+    {
+      // The queue delay is estimated from the timestamps, hence there is
+      // no need to measure the dequeue rate
+      return item;
+    }
+
   double now = Simulator::Now ().GetSeconds ();
   uint32_t pktSize = item->GetSize ();
 
@@ -23,6 +23,8 @@
 /*
  * PORT NOTE: This code was ported from ns-2.36rc1 (queue/pie.h).
  * Most of the comments are also ported from the same.
+ * The fixed-point mode follows the Linux PIE queue disc (net/sched/sch_pie.c
+ * and include/net/pie.h).
  */
 
 #ifndef PIE_QUEUE_DISC_H
@@ -47,6 +49,24 @@ class UniformRandomVariable;
  * \ingroup traffic-control
  *
  * \brief Implements PIE Active Queue Management discipline
+ *
+ * If the UseFixedPoint attribute is set, the drop probability is updated and
+ * the drop decisions are taken in integer arithmetic, as the Linux kernel
+ * does: times are expressed in psched ticks (64 ns), the drop probability is
+ * scaled by MAX_PROB and random drops are derandomized by accumulating the
+ * drop probability.
+ *
+ * If the UseEcn attribute is set, ECN capable packets selected by the random
+ * early drop are marked instead of being dropped, as long as the drop
+ * probability does not exceed MarkEcnThreshold. If the UseL4s attribute is
+ * set, ECT(1) packets are also marked when they leave the queue after a
+ * sojourn time larger than CeThreshold, which provides scalable congestion
+ * controls with an immediate and shallow congestion signal.
+ *
+ * Unless timestamps or fixed-point arithmetic are used, the queue delay is
+ * the queue size divided by the departure rate, which is the drain rate
+ * measured by the LinkEstimator of the device, if any. In lazy update mode,
+ * the missed updates use the drain rate measured when they are performed.
  */
 class PieQueueDisc : public QueueDisc
 {
@@ -84,6 +104,20 @@ public:
    */
   Time GetQueueDelay (void);
 
+  /**
+   * \brief Get the current drop probability.
+   *
+   * \returns The current drop probability.
+   */
+  double GetDropProbability (void);
+
+  /**
+   * \brief Get the state of the controller.
+   *
+   * \returns The current queue delay and drop probability.
+   */
+  virtual ControllerState GetControllerState (void);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -97,6 +131,9 @@ public:
   // Reasons for dropping packets
   static constexpr const char* UNFORCED_DROP = "Unforced drop";  //!< Early probability drops: proactive
   static constexpr const char* FORCED_DROP = "Forced drop";      //!< Drops due to queue limit: reactive
+  // Reasons for marking packets
+  static constexpr const char* UNFORCED_MARK = "Unforced mark";  //!< Early probability marks: proactive
+  static constexpr const char* CE_THRESHOLD_EXCEEDED_MARK = "CE threshold exceeded mark";  //!< Sojourn time above CE threshold (L4S)
 
 protected:
   /**
@@ -123,13 +160,76 @@ private:
   bool DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize);
 
   /**
-   * Periodically update the drop probability based on the delay samples:
+   * Get the departure rate used to estimate the queue delay: the drain rate
+   * measured by the link estimator of the device, if any, or the average
+   * dequeue rate measured by this queue disc
+   * \return the departure rate in bytes per second, or zero if not known yet
+   */
+  double GetDepartureRate (void) const;
+
+  /**
+   * Update the drop probability based on the delay samples:
    * not only the current delay sample but also the trend where the delay
    * is going, up or down
+   *
+   * \param now the time of the update
+   */
+  void CalculateP (Time now);
+
+  /**
+   * \brief Check if a packet needs to be dropped due to probability drop (fixed-point mode)
+   *
+   * Modelled after the Linux function pie_drop_early (net/sched/sch_pie.c)
+   *
+   * \param item queue item
+   * \returns false for no drop, true for drop
    */
-  void CalculateP ();
+  bool DropEarlyFixedPoint (Ptr<QueueDiscItem> item);
+
+  /**
+   * Update the drop probability (fixed-point mode)
+   *
+   * Modelled after the Linux function pie_calculate_probability (net/sched/sch_pie.c)
+   */
+  void CalculatePFixedPoint ();
+
+  /**
+   * Update the queue delay or the dequeue rate and the burst allowance after
+   * a packet is dequeued (fixed-point mode)
+   *
+   * Modelled after the Linux function pie_process_dequeue (net/sched/sch_pie.c)
+   *
+   * \param item the dequeued item
+   */
+  void ProcessDequeueFixedPoint (Ptr<const QueueDiscItem> item);
+
+  /**
+   * Reset the variables of the fixed-point mode which are reset when the
+   * measurement cycle is restarted
+   *
+   * Modelled after the Linux function pie_vars_init (include/net/pie.h)
+   */
+  void ResetFixedPointVars ();
+
+  /**
+   * Handler of the update timer: update the drop probability and restart
+   * the timer (periodic update mode)
+   */
+  void PeriodicUpdate ();
+
+  /**
+   * Perform the updates of the drop probability that were due since the
+   * last one (lazy update mode). The queue only changes when a packet is
+   * enqueued or dequeued, hence the missed updates can be computed right
+   * before the queue changes. Once an update leaves the state unchanged,
+   * the remaining missed updates are skipped.
+   */
+  void LazyUpdate ();
 
   static const uint64_t DQCOUNT_INVALID = std::numeric_limits<uint64_t>::max();  //!< Invalid dqCount value
+  static const uint64_t MAX_PROB = std::numeric_limits<uint64_t>::max() >> 8;     //!< Drop probability of 1 in fixed-point mode
+  static const uint64_t DTIME_INVALID = std::numeric_limits<uint64_t>::max();    //!< Invalid dqTstamp value
+  static const uint32_t PIE_SCALE = 8;                                           //!< Scaling of the dequeue rate in fixed-point mode
 
   // ** Variables supplied by user
   Time m_sUpdate;                               //!< Start time of the update timer
@@ -140,6 +240,13 @@ private:
   double m_a;                                   //!< Parameter to pie controller
   double m_b;                                   //!< Parameter to pie controller
   uint32_t m_dqThreshold;                       //!< Minimum queue size in bytes before dequeue rate is measured
+  bool m_useLazyUpdate;                         //!< True to compute the missed updates on enqueue/dequeue rather than with a timer
+  bool m_useTimestamp;                          //!< True to use the sojourn time of the head packet rather than the dequeue rate
+  bool m_useFixedPoint;                         //!< True to use the integer arithmetic of the Linux kernel
+  bool m_useEcn;                                //!< True if ECN is used (packets are marked instead of being dropped)
+  double m_markEcnTh;                           //!< Drop probability above which ECN capable packets are dropped rather than marked
+  bool m_useL4s;                                //!< True if ECT(1) packets are marked when their sojourn time exceeds the CE threshold
+  Time m_ceThreshold;                           //!< Sojourn time above which ECT(1) packets are marked (L4S)
 
   // ** Variables maintained by PIE
   double m_dropProb;                            //!< Variable used in calculation of drop probability
@@ -153,6 +260,19 @@ private:
   double m_dqStart;                             //!< Start timestamp of current measurement cycle
   uint64_t m_dqCount;                           //!< Number of bytes departed since current measurement cycle starts
   EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Time m_nextUpdate;                            //!< Time of the next update of the drop probability (lazy update mode)
+
+  // ** Variables maintained by PIE in fixed-point mode
+  uint64_t m_alpha;                             //!< Alpha, in units of 1/16
+  uint64_t m_beta;                              //!< Beta, in units of 1/16
+  uint64_t m_target;                            //!< Desired queue delay (in psched ticks)
+  uint64_t m_prob;                              //!< Drop probability (scaled by MAX_PROB)
+  uint64_t m_accuProb;                          //!< Drop probability accumulated since the last drop
+  uint64_t m_qDelayTicks;                       //!< Current value of queue delay (in psched ticks)
+  uint64_t m_qDelayOldTicks;                    //!< Old value of queue delay (in psched ticks)
+  uint64_t m_burstTime;                         //!< Current burst allowance (in psched ticks)
+  uint64_t m_dqTstamp;                          //!< Start of the measurement cycle or time of the last dequeue (in psched ticks)
+  uint32_t m_avgDqRateTicks;                    //!< Time averaged dequeue rate (in bytes per psched tick, scaled by 2^PIE_SCALE)
   Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
 };
 
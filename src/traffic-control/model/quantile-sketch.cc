@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "quantile-sketch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QuantileSketch");
+
+QuantileSketch::QuantileSketch (uint8_t precision)
+  : m_precision (precision),
+    m_count (0),
+    m_sum (0),
+    m_min (0),
+    m_max (0)
+{
+  NS_ABORT_MSG_IF (precision < 1 || precision > 16, "The precision must be between 1 and 16 bits");
+}
+
+uint32_t
+QuantileSketch::GetBucket (uint64_t value) const
+{
+  if (value < (1ULL << m_precision))
+    {
+      return static_cast<uint32_t> (value);
+    }
+
+  // the bucket is identified by the position of the most significant bit
+  // and by the following m_precision - 1 bits of the value
+  uint32_t exponent = 63 - __builtin_clzll (value) - m_precision + 1;
+  return (exponent << (m_precision - 1)) + static_cast<uint32_t> (value >> exponent);
+}
+
+uint64_t
+QuantileSketch::GetLowerBound (uint32_t bucket) const
+{
+  if (bucket < (1U << m_precision))
+    {
+      return bucket;
+    }
+
+  uint32_t exponent = (bucket >> (m_precision - 1)) - 1;
+  uint64_t mantissa = bucket - (exponent << (m_precision - 1));
+  return mantissa << exponent;
+}
+
+void
+QuantileSketch::Add (uint64_t value)
+{
+  uint32_t bucket = GetBucket (value);
+
+  if (bucket >= m_counts.size ())
+    {
+      m_counts.resize (bucket + 1, 0);
+    }
+  m_counts[bucket]++;
+
+  if (m_count == 0 || value < m_min)
+    {
+      m_min = value;
+    }
+  if (m_count == 0 || value > m_max)
+    {
+      m_max = value;
+    }
+  m_count++;
+  m_sum += value;
+}
+
+void
+QuantileSketch::Merge (const QuantileSketch &other)
+{
+  NS_ABORT_MSG_IF (other.m_precision != m_precision, "Cannot merge sketches with different precision");
+
+  if (other.m_count == 0)
+    {
+      return;
+    }
+
+  if (other.m_counts.size () > m_counts.size ())
+    {
+      m_counts.resize (other.m_counts.size (), 0);
+    }
+  for (uint32_t i = 0; i < other.m_counts.size (); i++)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+
+  m_min = (m_count == 0 ? other.m_min : std::min (m_min, other.m_min));
+  m_max = (m_count == 0 ? other.m_max : std::max (m_max, other.m_max));
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+}
+
+void
+QuantileSketch::Reset (void)
+{
+  m_counts.clear ();
+  m_count = 0;
+  m_sum = 0;
+  m_min = 0;
+  m_max = 0;
+}
+
+uint64_t
+QuantileSketch::GetCount (void) const
+{
+  return m_count;
+}
+
+uint64_t
+QuantileSketch::GetMin (void) const
+{
+  return m_min;
+}
+
+uint64_t
+QuantileSketch::GetMax (void) const
+{
+  return m_max;
+}
+
+double
+QuantileSketch::GetMean (void) const
+{
+  return (m_count ? m_sum / m_count : 0);
+}
+
+uint64_t
+QuantileSketch::GetQuantile (double q) const
+{
+  NS_ASSERT_MSG (q >= 0 && q <= 1, "The quantile must be between 0 and 1");
+
+  if (m_count == 0)
+    {
+      return 0;
+    }
+
+  uint64_t rank = std::max<uint64_t> (static_cast<uint64_t> (std::ceil (q * m_count)), 1);
+  uint64_t cumulative = 0;
+  uint32_t bucket = 0;
+
+  for (; bucket < m_counts.size (); bucket++)
+    {
+      cumulative += m_counts[bucket];
+      if (cumulative >= rank)
+        {
+          break;
+        }
+    }
+
+  uint64_t lower = GetLowerBound (bucket);
+  uint64_t width = GetLowerBound (bucket + 1) - lower;
+  uint64_t estimate = lower + width / 2;
+
+  return std::min (std::max (estimate, m_min), m_max);
+}
+
+} // namespace ns3
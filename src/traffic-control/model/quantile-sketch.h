@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Sketch of the distribution of a stream of non-negative integer values
+ *
+ * Values are counted in log-linear buckets, as in HDR histograms. Given the
+ * precision p (in bits) of the sketch, values lower than 2^p are counted
+ * exactly, while larger values are counted in buckets whose width is 2^(1-p)
+ * times their lower bound. Hence, the quantiles are estimated with a relative
+ * error lower than 2^-p and the memory used by the sketch does not depend on
+ * the number of values, but only on the largest value, being bounded by
+ * (66 - p) * 2^(p-1) counters.
+ *
+ * The count, the minimum and the maximum of the values are exact.
+ */
+class QuantileSketch
+{
+public:
+  /**
+   * \brief Constructor
+   * \param precision the number of significant bits of the buckets (between 1 and 16)
+   */
+  QuantileSketch (uint8_t precision = 7);
+
+  /**
+   * \brief Add a value to the sketch
+   * \param value the value
+   */
+  void Add (uint64_t value);
+
+  /**
+   * \brief Add all the values counted by another sketch with the same precision
+   * \param other the other sketch
+   */
+  void Merge (const QuantileSketch &other);
+
+  /**
+   * \brief Remove all the values from the sketch
+   */
+  void Reset (void);
+
+  /**
+   * \brief Get the number of values added to the sketch
+   * \return the number of values
+   */
+  uint64_t GetCount (void) const;
+
+  /**
+   * \brief Get the smallest value added to the sketch
+   * \return the smallest value, or 0 if the sketch is empty
+   */
+  uint64_t GetMin (void) const;
+
+  /**
+   * \brief Get the largest value added to the sketch
+   * \return the largest value, or 0 if the sketch is empty
+   */
+  uint64_t GetMax (void) const;
+
+  /**
+   * \brief Get the mean of the values added to the sketch
+   * \return the mean, or 0 if the sketch is empty
+   */
+  double GetMean (void) const;
+
+  /**
+   * \brief Estimate a quantile of the values added to the sketch
+   *
+   * The estimate is the midpoint of the bucket holding the value of rank
+   * ceil (q * count), clamped between the minimum and the maximum values.
+   *
+   * \param q the quantile (between 0 and 1)
+   * \return the estimated quantile, or 0 if the sketch is empty
+   */
+  uint64_t GetQuantile (double q) const;
+
+private:
+  /**
+   * \brief Get the bucket counting the given value
+   * \param value the value
+   * \return the index of the bucket
+   */
+  uint32_t GetBucket (uint64_t value) const;
+  /**
+   * \brief Get the smallest value counted by the given bucket
+   * \param bucket the index of the bucket
+   * \return the smallest value counted by the bucket
+   */
+  uint64_t GetLowerBound (uint32_t bucket) const;
+
+  uint8_t m_precision;               //!< Number of significant bits of the buckets
+  std::vector<uint64_t> m_counts;    //!< Counters, grown up to the bucket of the largest value
+  uint64_t m_count;                  //!< Number of values
+  double m_sum;                      //!< Sum of the values
+  uint64_t m_min;                    //!< Smallest value
+  uint64_t m_max;                    //!< Largest value
+};
+
+} // namespace ns3
+
+#endif /* QUANTILE_SKETCH_H */
@@ -0,0 +1,239 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "queue-disc-sampler.h"
+#include "queue-disc.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include <sstream>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QueueDiscSampler");
+
+NS_OBJECT_ENSURE_REGISTERED (QueueDiscSampler);
+
+TypeId
+QueueDiscSampler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QueueDiscSampler")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<QueueDiscSampler> ()
+    .AddAttribute ("Interval",
+                   "Time between two samples.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&QueueDiscSampler::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BufferSize",
+                   "Number of samples held in memory.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&QueueDiscSampler::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FileName",
+                   "Name of the file the samples are written to (if empty, "
+                   "the most recent samples are kept in memory).",
+                   StringValue (""),
+                   MakeStringAccessor (&QueueDiscSampler::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("Binary",
+                   "True to write the samples in binary format rather than in CSV format.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QueueDiscSampler::m_binary),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+QueueDiscSampler::QueueDiscSampler ()
+  : Object (),
+    m_head (0),
+    m_nSamples (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+QueueDiscSampler::~QueueDiscSampler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+QueueDiscSampler::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  DoStop ();
+  m_queueDisc = 0;
+  Object::DoDispose ();
+}
+
+void
+QueueDiscSampler::SetQueueDisc (Ptr<QueueDisc> qd)
+{
+  NS_LOG_FUNCTION (this << qd);
+  m_queueDisc = qd;
+}
+
+void
+QueueDiscSampler::Start (Time time)
+{
+  NS_LOG_FUNCTION (this << time);
+  NS_ABORT_MSG_IF (m_queueDisc == 0, "No queue disc to sample");
+
+  m_buffer.resize (m_bufferSize);
+  m_head = 0;
+  m_nSamples = 0;
+
+  if (!m_fileName.empty () && !m_file.is_open ())
+    {
+      m_file.open (m_fileName.c_str (), m_binary ? std::ios::out | std::ios::binary : std::ios::out);
+      NS_ABORT_MSG_UNLESS (m_file.is_open (), "Cannot open file " << m_fileName);
+      if (!m_binary)
+        {
+          WriteCsvHeader (m_file);
+        }
+    }
+
+  m_sampleEvent.Cancel ();
+  m_sampleEvent = Simulator::Schedule (time, &QueueDiscSampler::TakeSample, this);
+}
+
+void
+QueueDiscSampler::Stop (Time time)
+{
+  NS_LOG_FUNCTION (this << time);
+  Simulator::Schedule (time, &QueueDiscSampler::DoStop, this);
+}
+
+void
+QueueDiscSampler::DoStop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sampleEvent.Cancel ();
+  if (m_file.is_open ())
+    {
+      Flush ();
+      m_file.close ();
+    }
+}
+
+void
+QueueDiscSampler::TakeSample (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_nSamples == m_buffer.size ())
+    {
+      if (m_file.is_open ())
+        {
+          Flush ();
+        }
+      else
+        {
+          // overwrite the oldest sample
+          m_head = (m_head + 1) % m_buffer.size ();
+          m_nSamples--;
+        }
+    }
+
+  QueueDisc::ControllerState state = m_queueDisc->GetControllerState ();
+  Sample &sample = m_buffer[(m_head + m_nSamples) % m_buffer.size ()];
+  sample.time = Simulator::Now ().GetNanoSeconds ();
+  sample.nPackets = m_queueDisc->GetNPackets ();
+  sample.nBytes = m_queueDisc->GetNBytes ();
+  sample.queueDelay = state.queueDelay.GetNanoSeconds ();
+  sample.probability = state.probability;
+  m_nSamples++;
+
+  m_sampleEvent = Simulator::Schedule (m_interval, &QueueDiscSampler::TakeSample, this);
+}
+
+void
+QueueDiscSampler::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+
+  // the samples are written by at most two large writes, as the buffer can wrap
+  uint32_t first = std::min<uint32_t> (m_nSamples, m_buffer.size () - m_head);
+  uint32_t chunks[2][2] = {{m_head, first}, {0, m_nSamples - first}};
+
+  for (auto &chunk : chunks)
+    {
+      if (chunk[1] == 0)
+        {
+          continue;
+        }
+      if (m_binary)
+        {
+          m_file.write (reinterpret_cast<const char*> (&m_buffer[chunk[0]]), chunk[1] * sizeof (Sample));
+        }
+      else
+        {
+          WriteCsv (m_file, &m_buffer[chunk[0]], chunk[1]);
+        }
+    }
+  m_file.flush ();
+
+  m_head = 0;
+  m_nSamples = 0;
+}
+
+uint32_t
+QueueDiscSampler::GetNSamples (void) const
+{
+  return m_nSamples;
+}
+
+const QueueDiscSampler::Sample&
+QueueDiscSampler::GetSample (uint32_t i) const
+{
+  NS_ASSERT_MSG (i < m_nSamples, "Sample " << i << " not stored");
+  return m_buffer[(m_head + i) % m_buffer.size ()];
+}
+
+void
+QueueDiscSampler::WriteCsvHeader (std::ostream &os)
+{
+  os << "time,packets,bytes,delay,probability\n";
+}
+
+void
+QueueDiscSampler::WriteCsv (std::ostream &os, const Sample *samples, uint32_t n)
+{
+  // the lines are formatted in memory and written by a single large write
+  std::ostringstream oss;
+  oss.precision (9);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      const Sample &s = samples[i];
+      oss << s.time << ',' << s.nPackets << ',' << s.nBytes << ','
+          << s.queueDelay << ',' << s.probability << '\n';
+    }
+  const std::string str = oss.str ();
+  os.write (str.data (), str.size ());
+}
+
+} // namespace ns3
@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_DISC_SAMPLER_H
+#define QUEUE_DISC_SAMPLER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class QueueDisc;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Periodic sampler of the state of a queue disc
+ *
+ * Connecting trace sinks to the per-packet traces of a queue disc to obtain
+ * the time series of its length or of the state of its controller may cost
+ * more than the queue disc itself. Instead, a QueueDiscSampler reads the
+ * number of packets and bytes stored in the queue disc and the state of its
+ * controller (see QueueDisc::GetControllerState) every Interval, regardless
+ * of the number of packets going through the queue disc.
+ *
+ * Samples are stored in a ring buffer holding BufferSize samples, which is
+ * allocated when the sampler is started. If a FileName is set, the buffer is
+ * written to the file (in CSV or in binary format) each time it is full, when
+ * the sampler is stopped and when the sampler is disposed of. Otherwise, the
+ * buffer keeps the most recent samples, which can be retrieved by GetSample.
+ *
+ * In binary format, each sample is written as a Sample structure in the
+ * byte order of the host.
+ */
+class QueueDiscSampler : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief QueueDiscSampler constructor
+   */
+  QueueDiscSampler ();
+
+  virtual ~QueueDiscSampler ();
+
+  /**
+   * \brief A sample of the state of a queue disc
+   *
+   * Times are in nanoseconds, so that the structure can be written as is.
+   */
+  struct Sample
+  {
+    int64_t time;         //!< Time at which the sample was taken, in ns
+    uint32_t nPackets;    //!< Number of packets stored in the queue disc
+    uint32_t nBytes;      //!< Number of bytes stored in the queue disc
+    int64_t queueDelay;   //!< Queue delay estimated by the controller, in ns
+    double probability;   //!< Drop probability computed by the controller
+  };
+
+  /**
+   * \brief Set the queue disc to sample
+   * \param qd the queue disc
+   */
+  void SetQueueDisc (Ptr<QueueDisc> qd);
+
+  /**
+   * \brief Start sampling the queue disc
+   * \param time the delay after which the first sample is taken
+   */
+  void Start (Time time);
+
+  /**
+   * \brief Stop sampling the queue disc
+   * \param time the delay after which no more samples are taken
+   */
+  void Stop (Time time);
+
+  /**
+   * \brief Write the samples stored in the buffer to the file, if any, and
+   *        empty the buffer
+   */
+  void Flush (void);
+
+  /**
+   * \brief Get the number of samples stored in the buffer
+   * \return the number of samples stored in the buffer
+   */
+  uint32_t GetNSamples (void) const;
+
+  /**
+   * \brief Get a sample stored in the buffer
+   * \param i the index of the sample, from 0 (the oldest sample)
+   * \return the sample
+   */
+  const Sample& GetSample (uint32_t i) const;
+
+  /**
+   * \brief Write the header line of the CSV format
+   * \param os the output stream
+   */
+  static void WriteCsvHeader (std::ostream &os);
+
+  /**
+   * \brief Write samples in CSV format, one line per sample
+   * \param os the output stream
+   * \param samples the first sample to write
+   * \param n the number of samples to write
+   */
+  static void WriteCsv (std::ostream &os, const Sample *samples, uint32_t n);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Take a sample and schedule the next one
+   */
+  void TakeSample (void);
+  /**
+   * \brief Stop taking samples and write the samples stored in the buffer
+   */
+  void DoStop (void);
+
+  Ptr<QueueDisc> m_queueDisc;     //!< The queue disc to sample
+  Time m_interval;                //!< Time between two samples
+  uint32_t m_bufferSize;          //!< Number of samples held by the buffer
+  std::string m_fileName;         //!< Name of the output file
+  bool m_binary;                  //!< True to write samples in binary format
+  std::vector<Sample> m_buffer;   //!< Ring buffer of samples
+  uint32_t m_head;                //!< Index of the oldest sample in the buffer
+  uint32_t m_nSamples;            //!< Number of samples in the buffer
+  std::ofstream m_file;           //!< Output file
+  EventId m_sampleEvent;          //!< Event to take the next sample
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_DISC_SAMPLER_H */
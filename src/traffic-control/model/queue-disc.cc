@@ -20,15 +20,20 @@
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/object-vector.h"
 #include "ns3/packet.h"
 #include "ns3/socket.h"
 #include "ns3/unused.h"
 #include "ns3/simulator.h"
+#include "ns3/system-mutex.h"
 #include "queue-disc.h"
 #include <ns3/drop-tail-queue.h>
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/link-estimator.h"
+#include <deque>
+#include <limits>
 
 namespace ns3 {
 
@@ -109,80 +114,168 @@ QueueDisc::Stats::Stats ()
 {
 }
 
-uint32_t
-QueueDisc::Stats::GetNDroppedPackets (std::string reason) const
+namespace {
+
+/**
+ * \ingroup traffic-control
+ *
+ * Registry of the reasons why packets are dropped or marked by queue discs.
+ * Reasons are stored in a deque, so that the addresses of the registered
+ * strings never change. Queue discs may register reasons from several
+ * threads (e.g., with the multithreaded simulator), hence every access
+ * is protected by a mutex.
+ */
+struct QueueDiscReasonRegistry
+{
+  std::deque<std::string> names;              //!< Registered reasons, indexed by ID
+  std::map<std::string, uint16_t> ids;        //!< ID of each registered reason
+  SystemMutex mutex;                          //!< Mutex protecting the registry
+};
+
+/**
+ * \brief Get the registry of the reasons why packets are dropped or marked
+ * \return the registry
+ */
+QueueDiscReasonRegistry &
+GetReasonRegistry (void)
+{
+  static QueueDiscReasonRegistry registry;
+  return registry;
+}
+
+/**
+ * \brief Get the value of a per-reason counter
+ * \param counters the per-reason counters
+ * \param reason the reason
+ * \return the value of the counter, or zero if the reason was never counted
+ */
+template <typename T>
+T
+GetReasonCounter (const std::vector<T> &counters, const std::string &reason)
 {
-  uint32_t count = 0;
-  auto it = nDroppedPacketsBeforeEnqueue.find (reason);
+  QueueDiscReasonRegistry &registry = GetReasonRegistry ();
+  CriticalSection cs (registry.mutex);
+  auto it = registry.ids.find (reason);
 
-  if (it != nDroppedPacketsBeforeEnqueue.end ())
+  if (it == registry.ids.end () || it->second >= counters.size ())
     {
-      count += it->second;
+      return 0;
     }
 
-  it = nDroppedPacketsAfterDequeue.find (reason);
+  return counters[it->second];
+}
 
-  if (it != nDroppedPacketsAfterDequeue.end ())
+/**
+ * \brief Increase a per-reason counter, growing the counters if needed
+ * \param counters the per-reason counters
+ * \param id the ID of the reason
+ * \param value the increment
+ */
+template <typename T>
+void
+IncreaseReasonCounter (std::vector<T> &counters, uint16_t id, T value)
+{
+  if (id >= counters.size ())
     {
-      count += it->second;
+      counters.resize (id + 1, 0);
     }
-
-  return count;
+  counters[id] += value;
 }
 
-uint64_t
-QueueDisc::Stats::GetNDroppedBytes (std::string reason) const
+/**
+ * \brief Print the per-reason counters of packets and bytes, sorted by reason
+ * \param os the output stream
+ * \param packets the per-reason packet counters
+ * \param bytes the per-reason byte counters
+ */
+void
+PrintReasonCounters (std::ostream &os, const std::vector<uint32_t> &packets,
+                     const std::vector<uint64_t> &bytes)
 {
-  uint64_t count = 0;
-  auto it = nDroppedBytesBeforeEnqueue.find (reason);
+  NS_ASSERT (packets.size () == bytes.size ());
 
-  if (it != nDroppedBytesBeforeEnqueue.end ())
+  std::map<std::string, uint16_t> sorted;
+  for (uint16_t id = 0; id < packets.size (); id++)
     {
-      count += it->second;
+      if (packets[id] > 0)
+        {
+          sorted[QueueDisc::Stats::GetReasonName (id)] = id;
+        }
     }
 
-  it = nDroppedBytesAfterDequeue.find (reason);
-
-  if (it != nDroppedBytesAfterDequeue.end ())
+  for (auto& reason : sorted)
     {
-      count += it->second;
+      os << std::endl << "  " << reason.first << ": "
+         << packets[reason.second] << " / " << bytes[reason.second];
     }
-
-  return count;
 }
 
-uint32_t
-QueueDisc::Stats::GetNMarkedPackets (std::string reason) const
+} // unnamed namespace
+
+uint16_t
+QueueDisc::Stats::GetReasonId (const std::string &reason)
 {
-  auto it = nMarkedPackets.find (reason);
+  QueueDiscReasonRegistry &registry = GetReasonRegistry ();
+  CriticalSection cs (registry.mutex);
+  auto it = registry.ids.find (reason);
 
-  if (it != nMarkedPackets.end ())
+  if (it != registry.ids.end ())
     {
       return it->second;
     }
 
-  return 0;
+  NS_ABORT_MSG_IF (registry.names.size () > std::numeric_limits<uint16_t>::max (),
+                   "Too many reasons for dropping or marking packets");
+  uint16_t id = static_cast<uint16_t> (registry.names.size ());
+  registry.names.push_back (reason);
+  registry.ids[reason] = id;
+  return id;
+}
+
+const std::string &
+QueueDisc::Stats::GetReasonName (uint16_t id)
+{
+  QueueDiscReasonRegistry &registry = GetReasonRegistry ();
+  CriticalSection cs (registry.mutex);
+  NS_ASSERT_MSG (id < registry.names.size (), "Unknown reason ID " << id);
+  return registry.names[id];
+}
+
+uint32_t
+QueueDisc::Stats::GetNDroppedPackets (std::string reason) const
+{
+  return GetReasonCounter (nDroppedPacketsBeforeEnqueue, reason)
+         + GetReasonCounter (nDroppedPacketsAfterDequeue, reason);
 }
 
 uint64_t
-QueueDisc::Stats::GetNMarkedBytes (std::string reason) const
+QueueDisc::Stats::GetNDroppedBytes (std::string reason) const
 {
-  auto it = nMarkedBytes.find (reason);
+  return GetReasonCounter (nDroppedBytesBeforeEnqueue, reason)
+         + GetReasonCounter (nDroppedBytesAfterDequeue, reason);
+}
 
-  if (it != nMarkedBytes.end ())
-    {
-      return it->second;
-    }
+uint32_t
+QueueDisc::Stats::GetNMarkedPackets (std::string reason) const
+{
+  return GetReasonCounter (nMarkedPackets, reason);
+}
+
+uint64_t
+QueueDisc::Stats::GetNMarkedBytes (std::string reason) const
+{
+  return GetReasonCounter (nMarkedBytes, reason);
+}
 
-  return 0;
+Time
+QueueDisc::Stats::GetSojournTimeQuantile (double q) const
+{
+  return NanoSeconds (sojournTime.GetQuantile (q));
 }
 
 void
 QueueDisc::Stats::Print (std::ostream &os) const
 {
-  std::map<std::string, uint32_t>::const_iterator itp;
-  std::map<std::string, uint64_t>::const_iterator itb;
-
   os << std::endl << "Packets/Bytes received: "
                   << nTotalReceivedPackets << " / "
                   << nTotalReceivedBytes
@@ -202,35 +295,13 @@ QueueDisc::Stats::Print (std::ostream &os) const
                   << nTotalDroppedPacketsBeforeEnqueue << " / "
                   << nTotalDroppedBytesBeforeEnqueue;
 
-  itp = nDroppedPacketsBeforeEnqueue.begin ();
-  itb = nDroppedBytesBeforeEnqueue.begin ();
-
-  while (itp != nDroppedPacketsBeforeEnqueue.end () &&
-         itb != nDroppedBytesBeforeEnqueue.end ())
-    {
-      NS_ASSERT (itp->first.compare (itb->first) == 0);
-      os << std::endl << "  " << itp->first << ": "
-         << itp->second << " / " << itb->second;
-      itp++;
-      itb++;
-    }
+  PrintReasonCounters (os, nDroppedPacketsBeforeEnqueue, nDroppedBytesBeforeEnqueue);
 
   os << std::endl << "Packets/Bytes dropped after dequeue: "
                   << nTotalDroppedPacketsAfterDequeue << " / "
                   << nTotalDroppedBytesAfterDequeue;
 
-  itp = nDroppedPacketsAfterDequeue.begin ();
-  itb = nDroppedBytesAfterDequeue.begin ();
-
-  while (itp != nDroppedPacketsAfterDequeue.end () &&
-         itb != nDroppedBytesAfterDequeue.end ())
-    {
-      NS_ASSERT (itp->first.compare (itb->first) == 0);
-      os << std::endl << "  " << itp->first << ": "
-         << itp->second << " / " << itb->second;
-      itp++;
-      itb++;
-    }
+  PrintReasonCounters (os, nDroppedPacketsAfterDequeue, nDroppedBytesAfterDequeue);
 
   os << std::endl << "Packets/Bytes sent: "
                   << nTotalSentPackets << " / "
@@ -239,17 +310,16 @@ QueueDisc::Stats::Print (std::ostream &os) const
                   << nTotalMarkedPackets << " / "
                   << nTotalMarkedBytes;
 
-  itp = nMarkedPackets.begin ();
-  itb = nMarkedBytes.begin ();
+  PrintReasonCounters (os, nMarkedPackets, nMarkedBytes);
 
-  while (itp != nMarkedPackets.end () &&
-         itb != nMarkedBytes.end ())
+  if (sojournTime.GetCount ())
     {
-      NS_ASSERT (itp->first.compare (itb->first) == 0);
-      os << std::endl << "  " << itp->first << ": "
-         << itp->second << " / " << itb->second;
-      itp++;
-      itb++;
+      os << std::endl << "Sojourn time (ms) mean/p50/p99/p99.9/max: "
+                      << sojournTime.GetMean () / 1e6 << " / "
+                      << GetSojournTimeQuantile (0.5).GetSeconds () * 1e3 << " / "
+                      << GetSojournTimeQuantile (0.99).GetSeconds () * 1e3 << " / "
+                      << GetSojournTimeQuantile (0.999).GetSeconds () * 1e3 << " / "
+                      << sojournTime.GetMax () / 1e6;
     }
 
   os << std::endl;
@@ -273,6 +343,13 @@ TypeId QueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&QueueDisc::SetQuota,
                                          &QueueDisc::GetQuota),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BulkDequeue",
+                   "Whether to dequeue as many packets as the device queue can take "
+                   "and send them to the device in a batch (root queue disc of a "
+                   "single-queue device only)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QueueDisc::m_bulkDequeue),
+                   MakeBooleanChecker ())
     .AddAttribute ("InternalQueueList", "The list of internal queues.",
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_queues),
@@ -355,13 +432,11 @@ QueueDisc::QueueDisc (QueueDiscSizePolicy policy)
   // the packet is dropped.
   m_childQueueDiscDbeFunctor = [this] (Ptr<const QueueDiscItem> item, const char* r)
     {
-      return DropBeforeEnqueue (item,
-                                m_childQueueDiscDropMsg.assign (CHILD_QUEUE_DISC_DROP).append (r).data ());
+      return DropBeforeEnqueue (item, LookupChildQueueDiscDropReason (r));
     };
   m_childQueueDiscDadFunctor = [this] (Ptr<const QueueDiscItem> item, const char* r)
     {
-      return DropAfterDequeue (item,
-                               m_childQueueDiscDropMsg.assign (CHILD_QUEUE_DISC_DROP).append (r).data ());
+      return DropAfterDequeue (item, LookupChildQueueDiscDropReason (r));
     };
 }
 
@@ -385,7 +460,10 @@ QueueDisc::DoDispose (void)
   m_filters.clear ();
   m_classes.clear ();
   m_devQueueIface = 0;
+  m_linkEstimator = 0;
   m_send = nullptr;
+  m_sendMany = nullptr;
+  m_batch.clear ();
   m_requeued = 0;
   m_internalQueueDbeFunctor = nullptr;
   m_internalQueueDadFunctor = nullptr;
@@ -547,6 +625,25 @@ QueueDisc::GetNetDeviceQueueInterface (void) const
   return m_devQueueIface;
 }
 
+void
+QueueDisc::SetLinkEstimator (Ptr<LinkEstimator> estimator)
+{
+  NS_LOG_FUNCTION (this << estimator);
+  m_linkEstimator = estimator;
+
+  for (auto& cl : m_classes)
+    {
+      cl->GetQueueDisc ()->SetLinkEstimator (estimator);
+    }
+}
+
+Ptr<LinkEstimator>
+QueueDisc::GetLinkEstimator (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_linkEstimator;
+}
+
 void
 QueueDisc::SetSendCallback (SendCallback func)
 {
@@ -561,6 +658,20 @@ QueueDisc::GetSendCallback (void) const
   return m_send;
 }
 
+void
+QueueDisc::SetSendManyCallback (SendManyCallback func)
+{
+  NS_LOG_FUNCTION (this);
+  m_sendMany = func;
+}
+
+QueueDisc::SendManyCallback
+QueueDisc::GetSendManyCallback (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sendMany;
+}
+
 void
 QueueDisc::SetQuota (const uint32_t quota)
 {
@@ -650,6 +761,12 @@ QueueDisc::AddQueueDiscClass (Ptr<QueueDiscClass> qdClass)
   qdClass->GetQueueDisc ()->TraceConnectWithoutContext ("DropAfterDequeue",
                                      MakeCallback (&ChildQueueDiscDropFunctor::operator(),
                                                    &m_childQueueDiscDadFunctor));
+  // child queue discs created at run time (e.g., flow queues) share the link
+  // estimator of the parent queue disc
+  if (m_linkEstimator)
+    {
+      qdClass->GetQueueDisc ()->SetLinkEstimator (m_linkEstimator);
+    }
   m_classes.push_back (qdClass);
 }
 
@@ -686,6 +803,16 @@ QueueDisc::GetWakeMode (void) const
   return WAKE_ROOT;
 }
 
+QueueDisc::ControllerState
+QueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ControllerState state;
+  state.queueDelay = Time (0);
+  state.probability = 0;
+  return state;
+}
+
 void
 QueueDisc::PacketEnqueued (Ptr<const QueueDiscItem> item)
 {
@@ -713,7 +840,9 @@ QueueDisc::PacketDequeued (Ptr<const QueueDiscItem> item)
       m_stats.nTotalDequeuedPackets++;
       m_stats.nTotalDequeuedBytes += item->GetSize ();
 
-      m_sojourn (Simulator::Now () - item->GetTimeStamp ());
+      Time sojourn = Simulator::Now () - item->GetTimeStamp ();
+      m_stats.sojournTime.Add (sojourn.GetNanoSeconds ());
+      m_sojourn (sojourn);
 
       NS_LOG_LOGIC ("m_traceDequeue (p)");
       m_traceDequeue (item);
@@ -730,26 +859,10 @@ QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
   m_stats.nTotalDroppedPacketsBeforeEnqueue++;
   m_stats.nTotalDroppedBytesBeforeEnqueue += item->GetSize ();
 
-  // update the number of packets dropped for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsBeforeEnqueue.find (reason);
-  if (itp != m_stats.nDroppedPacketsBeforeEnqueue.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nDroppedPacketsBeforeEnqueue[reason] = 1;
-    }
-  // update the amount of bytes dropped for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesBeforeEnqueue.find (reason);
-  if (itb != m_stats.nDroppedBytesBeforeEnqueue.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nDroppedBytesBeforeEnqueue[reason] = item->GetSize ();
-    }
+  // update the number of packets and the amount of bytes dropped for the given reason
+  uint16_t id = LookupReason (reason);
+  IncreaseReasonCounter (m_stats.nDroppedPacketsBeforeEnqueue, id, 1u);
+  IncreaseReasonCounter (m_stats.nDroppedBytesBeforeEnqueue, id, static_cast<uint64_t> (item->GetSize ()));
 
   NS_LOG_DEBUG ("Total packets/bytes dropped before enqueue: "
                 << m_stats.nTotalDroppedPacketsBeforeEnqueue << " / "
@@ -769,26 +882,10 @@ QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
   m_stats.nTotalDroppedPacketsAfterDequeue++;
   m_stats.nTotalDroppedBytesAfterDequeue += item->GetSize ();
 
-  // update the number of packets dropped for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsAfterDequeue.find (reason);
-  if (itp != m_stats.nDroppedPacketsAfterDequeue.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nDroppedPacketsAfterDequeue[reason] = 1;
-    }
-  // update the amount of bytes dropped for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesAfterDequeue.find (reason);
-  if (itb != m_stats.nDroppedBytesAfterDequeue.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nDroppedBytesAfterDequeue[reason] = item->GetSize ();
-    }
+  // update the number of packets and the amount of bytes dropped for the given reason
+  uint16_t id = LookupReason (reason);
+  IncreaseReasonCounter (m_stats.nDroppedPacketsAfterDequeue, id, 1u);
+  IncreaseReasonCounter (m_stats.nDroppedBytesAfterDequeue, id, static_cast<uint64_t> (item->GetSize ()));
 
   // if in the context of a peek request a dequeued packet is dropped, we need
   // to update the statistics and fire the dequeue trace before firing the drop
@@ -824,26 +921,10 @@ QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
   m_stats.nTotalMarkedPackets++;
   m_stats.nTotalMarkedBytes += item->GetSize ();
 
-  // update the number of packets marked for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nMarkedPackets.find (reason);
-  if (itp != m_stats.nMarkedPackets.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nMarkedPackets[reason] = 1;
-    }
-  // update the amount of bytes marked for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nMarkedBytes.find (reason);
-  if (itb != m_stats.nMarkedBytes.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nMarkedBytes[reason] = item->GetSize ();
-    }
+  // update the number of packets and the amount of bytes marked for the given reason
+  uint16_t id = LookupReason (reason);
+  IncreaseReasonCounter (m_stats.nMarkedPackets, id, 1u);
+  IncreaseReasonCounter (m_stats.nMarkedBytes, id, static_cast<uint64_t> (item->GetSize ()));
 
   NS_LOG_DEBUG ("Total packets/bytes marked: "
                 << m_stats.nTotalMarkedPackets << " / "
@@ -852,6 +933,41 @@ QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
   return true;
 }
 
+uint16_t
+QueueDisc::LookupReason (const char* reason)
+{
+  for (auto& r : m_reasonIds)
+    {
+      if (r.first == reason)
+        {
+          return r.second;
+        }
+    }
+
+  uint16_t id = Stats::GetReasonId (reason);
+  NS_LOG_DEBUG ("Registered reason \"" << reason << "\" with ID " << id);
+  m_reasonIds.push_back (std::make_pair (reason, id));
+  return id;
+}
+
+const char*
+QueueDisc::LookupChildQueueDiscDropReason (const char* reason)
+{
+  for (auto& r : m_childQueueDiscDropReasons)
+    {
+      if (r.first == reason)
+        {
+          return r.second;
+        }
+    }
+
+  // the registered string is never moved, hence its address can be cached
+  uint16_t id = Stats::GetReasonId (std::string (CHILD_QUEUE_DISC_DROP).append (reason));
+  const char* childReason = Stats::GetReasonName (id).c_str ();
+  m_childQueueDiscDropReasons.push_back (std::make_pair (reason, childReason));
+  return childReason;
+}
+
 bool
 QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
 {
@@ -954,14 +1070,15 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      uint32_t packets;
+      while (Restart (packets))
         {
-          quota -= 1;
-          if (quota <= 0)
+          if (packets >= quota)
             {
               /// \todo netif_schedule (q);
               break;
             }
+          quota -= packets;
         }
       RunEnd ();
     }
@@ -988,7 +1105,7 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t &packets)
 {
   NS_LOG_FUNCTION (this);
   Ptr<QueueDiscItem> item = DequeuePacket();
@@ -998,6 +1115,16 @@ QueueDisc::Restart (void)
       return false;
     }
 
+  // As in Linux, bulk dequeue is only performed if the queue disc feeds a single
+  // transmission queue, whose state is checked by DequeuePacket
+  if (m_bulkDequeue && m_sendMany && m_devQueueIface && m_devQueueIface->GetNTxQueues () == 1)
+    {
+      BulkDequeue (item);
+      packets = m_batch.size ();
+      return TransmitBatch ();
+    }
+
+  packets = 1;
   return Transmit (item);
 }
 
@@ -1113,4 +1240,59 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   return true;
 }
 
+void
+QueueDisc::BulkDequeue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  Ptr<NetDevice> device = m_devQueueIface->GetObject<NetDevice> ();
+  uint32_t mtu = (device ? device->GetMtu () : 0);
+  Ptr<NetDeviceQueue> txq = m_devQueueIface->GetTxQueue (0);
+
+  NS_ASSERT (m_batch.empty ());
+  m_batch.push_back (item);
+  uint32_t nBytes = item->GetSize ();
+
+  // stop when the device queue would be stopped by the batch, as it happens
+  // when packets are sent one at a time, or when the quota is reached
+  while (m_batch.size () < m_quota && !txq->WouldStop (m_batch.size (), nBytes, mtu))
+    {
+      item = Dequeue ();
+      if (item == 0)
+        {
+          break;
+        }
+      item->AddHeader ();
+      m_batch.push_back (item);
+      nBytes += item->GetSize ();
+    }
+
+  NS_LOG_LOGIC ("Dequeued a batch of " << m_batch.size () << " packets");
+}
+
+bool
+QueueDisc::TransmitBatch (void)
+{
+  NS_LOG_FUNCTION (this << m_batch.size ());
+
+  // a single queue device makes no use of the priority tag
+  SocketPriorityTag priorityTag;
+  for (auto& item : m_batch)
+    {
+      item->GetPacket ()->RemovePacketTag (priorityTag);
+    }
+
+  m_sendMany (m_batch);
+  m_batch.clear ();
+
+  // as in Transmit, packets sent to the device are never requeued. Return false
+  // if the queue disc is empty or the device queue is now stopped
+  if (GetNPackets () == 0 || m_devQueueIface->GetTxQueue (0)->IsStopped ())
+    {
+      return false;
+    }
+
+  return true;
+}
+
 } // namespace ns3
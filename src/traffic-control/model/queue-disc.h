@@ -31,12 +31,14 @@
 #include <functional>
 #include <string>
 #include "packet-filter.h"
+#include "quantile-sketch.h"
 
 namespace ns3 {
 
 class QueueDisc;
 template <typename Item> class Queue;
 class NetDeviceQueueInterface;
+class LinkEstimator;
 
 /**
  * \ingroup traffic-control
@@ -174,7 +176,10 @@ enum QueueDiscSizePolicy
  * that are dropped or requeued after being dequeued. The sojourn time is taken
  * when the packet is dequeued from the queue disc, hence it does not account for
  * the additional time the packet is retained within the traffic control
- * infrastructure in case it is requeued.
+ * infrastructure in case it is requeued. The sojourn times are also counted,
+ * in constant memory, by the sojournTime sketch of the statistics, which allows
+ * to estimate their quantiles (e.g., the 99th percentile) by means of
+ * Stats::GetSojournTimeQuantile.
  *
  * The design and implementation of this class is heavily inspired by Linux.
  * For more details, see the traffic-control model page.
@@ -205,34 +210,36 @@ public:
     uint32_t nTotalDroppedPackets;
     /// Total packets dropped before enqueue
     uint32_t nTotalDroppedPacketsBeforeEnqueue;
-    /// Packets dropped before enqueue, for each reason
-    std::map<std::string, uint32_t> nDroppedPacketsBeforeEnqueue;
+    /// Packets dropped before enqueue, indexed by reason ID
+    std::vector<uint32_t> nDroppedPacketsBeforeEnqueue;
     /// Total packets dropped after dequeue
     uint32_t nTotalDroppedPacketsAfterDequeue;
-    /// Packets dropped after dequeue, for each reason
-    std::map<std::string, uint32_t> nDroppedPacketsAfterDequeue;
+    /// Packets dropped after dequeue, indexed by reason ID
+    std::vector<uint32_t> nDroppedPacketsAfterDequeue;
     /// Total dropped bytes
     uint64_t nTotalDroppedBytes;
     /// Total bytes dropped before enqueue
     uint64_t nTotalDroppedBytesBeforeEnqueue;
-    /// Bytes dropped before enqueue, for each reason
-    std::map<std::string, uint64_t> nDroppedBytesBeforeEnqueue;
+    /// Bytes dropped before enqueue, indexed by reason ID
+    std::vector<uint64_t> nDroppedBytesBeforeEnqueue;
     /// Total bytes dropped after dequeue
     uint64_t nTotalDroppedBytesAfterDequeue;
-    /// Bytes dropped after dequeue, for each reason
-    std::map<std::string, uint64_t> nDroppedBytesAfterDequeue;
+    /// Bytes dropped after dequeue, indexed by reason ID
+    std::vector<uint64_t> nDroppedBytesAfterDequeue;
     /// Total requeued packets
     uint32_t nTotalRequeuedPackets;
     /// Total requeued bytes
     uint64_t nTotalRequeuedBytes;
     /// Total marked packets
     uint32_t nTotalMarkedPackets;
-    /// Marked packets, for each reason
-    std::map<std::string, uint32_t> nMarkedPackets;
+    /// Marked packets, indexed by reason ID
+    std::vector<uint32_t> nMarkedPackets;
     /// Total marked bytes
     uint32_t nTotalMarkedBytes;
-    /// Marked bytes, for each reason
-    std::map<std::string, uint64_t> nMarkedBytes;
+    /// Marked bytes, indexed by reason ID
+    std::vector<uint64_t> nMarkedBytes;
+    /// Sojourn time (in nanoseconds) of the dequeued packets
+    QuantileSketch sojournTime;
 
     /// constructor
     Stats ();
@@ -261,11 +268,35 @@ public:
      * \return the amount of bytes marked for the given reason
      */
     uint64_t GetNMarkedBytes (std::string reason) const;
+    /**
+     * \brief Estimate a quantile of the sojourn time of the dequeued packets
+     * \param q the quantile (e.g., 0.99 for the 99th percentile)
+     * \return the estimated quantile of the sojourn time
+     */
+    Time GetSojournTimeQuantile (double q) const;
     /**
      * \brief Print the statistics.
      * \param os output stream in which the data should be printed.
      */
     void Print (std::ostream &os) const;
+
+    /**
+     * \brief Get the ID of a reason why packets are dropped or marked
+     *
+     * Reasons are registered the first time they are used by any queue disc
+     * and keep the same ID for the whole program. The ID of a reason is the
+     * index of the counters associated with the reason.
+     *
+     * \param reason the reason why packets are dropped or marked
+     * \return the ID of the reason
+     */
+    static uint16_t GetReasonId (const std::string &reason);
+    /**
+     * \brief Get the reason having the given ID
+     * \param id the ID of the reason
+     * \return the reason having the given ID
+     */
+    static const std::string & GetReasonName (uint16_t id);
   };
 
   /**
@@ -354,6 +385,23 @@ public:
    */
   Ptr<NetDeviceQueueInterface> GetNetDeviceQueueInterface (void) const;
 
+  /**
+   * \param estimator the link estimator of the device
+   *
+   * Set the link estimator of the device this queue disc is installed on. This
+   * method is called by the traffic control layer on the root queue disc and
+   * the link estimator is passed on to the child queue discs.
+   */
+  void SetLinkEstimator (Ptr<LinkEstimator> estimator);
+
+  /**
+   * \return the link estimator of the device, or a null pointer if none
+   *
+   * Get the link estimator of the device this queue disc is installed on,
+   * which provides an estimate of the drain rate and of the RTT.
+   */
+  Ptr<LinkEstimator> GetLinkEstimator (void) const;
+
   /// Callback invoked to send a packet to the receiving object when Run is called
   typedef std::function<void (Ptr<QueueDiscItem>)> SendCallback;
 
@@ -373,6 +421,25 @@ public:
    */
   SendCallback GetSendCallback (void) const;
 
+  /// Callback invoked to send a batch of packets to the receiving object when Run is called
+  typedef std::function<void (const std::vector<Ptr<QueueDiscItem> > &)> SendManyCallback;
+
+  /**
+   * \param func the callback to send a batch of packets to the receiving object.
+   *
+   * Set the callback used by the Run method to send a batch of packets to the
+   * receiving object, if bulk dequeue is enabled.
+   */
+  void SetSendManyCallback (SendManyCallback func);
+
+  /**
+   * \return the callback to send a batch of packets to the receiving object.
+   *
+   * Get the callback used by the Run method to send a batch of packets to the
+   * receiving object, if bulk dequeue is enabled.
+   */
+  SendManyCallback GetSendManyCallback (void) const;
+
   /**
    * \brief Set the maximum number of dequeue operations following a packet enqueue
    * \param quota the maximum number of dequeue operations following a packet enqueue.
@@ -513,6 +580,26 @@ public:
    */
   virtual WakeMode GetWakeMode (void) const;
 
+  /**
+   * \brief State of the controller of an AQM queue disc
+   */
+  struct ControllerState
+  {
+    Time queueDelay;      //!< queue delay estimated by the controller
+    double probability;   //!< drop (or mark) probability computed by the controller
+  };
+
+  /**
+   * Get the current state of the AQM controller of this queue disc, e.g., to
+   * sample it periodically by means of a QueueDiscSampler. The implementation
+   * of this method for the base class returns a null queue delay and a null
+   * probability. Subclasses implementing an AQM algorithm redefine this method
+   * to return their estimate of the queue delay and their drop probability.
+   *
+   * \return the state of the controller of this queue disc.
+   */
+  virtual ControllerState GetControllerState (void);
+
   // Reasons for dropping packets
   static constexpr const char* INTERNAL_QUEUE_DROP = "Dropped by internal queue";    //!< Packet dropped by an internal queue
   static constexpr const char* CHILD_QUEUE_DISC_DROP = "(Dropped by child queue disc) "; //!< Packet dropped by a child queue disc
@@ -641,9 +728,12 @@ private:
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
    * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
+   * If bulk dequeue is enabled, further packets are dequeued (by calling BulkDequeue)
+   * and the whole batch is sent to the device (by calling TransmitBatch).
+   * \param packets the number of packets sent to the device
    * \return true if a packet is successfully sent to the device.
    */
-  bool Restart (void);
+  bool Restart (uint32_t &packets);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
@@ -667,6 +757,21 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
+  /**
+   * Modelled after the Linux function try_bulk_dequeue_skb (net/sched/sch_generic.c)
+   * Store the given packet and the packets dequeued after it into the batch, as
+   * long as the device queue has room for them.
+   * \param item the first packet of the batch
+   */
+  void BulkDequeue (Ptr<QueueDiscItem> item);
+
+  /**
+   * Modelled after the Linux function sch_direct_xmit (net/sched/sch_generic.c)
+   * Sends the batch of packets to the device through the send many callback.
+   * \return true if the device queue is not stopped and the queue disc is not empty
+   */
+  bool TransmitBatch (void);
+
   /**
    *  \brief Perform the actions required when the queue disc is notified of
    *         a packet enqueue
@@ -681,6 +786,28 @@ private:
    */
   void PacketDequeued (Ptr<const QueueDiscItem> item);
 
+  /**
+   *  \brief Get the ID of the given reason
+   *
+   *  The IDs of the reasons used by this queue disc are cached, so that the
+   *  reason is only registered the first time it is used. Reasons are cached
+   *  based on their address, hence the reasons passed to DropBeforeEnqueue,
+   *  DropAfterDequeue and Mark must be strings that are never modified (such
+   *  as the static constants defined by queue discs).
+   *
+   *  \param reason the reason why packets are dropped or marked
+   *  \return the ID of the given reason
+   */
+  uint16_t LookupReason (const char* reason);
+
+  /**
+   *  \brief Get the reason used to record a packet dropped by a child queue disc
+   *
+   *  \param reason the reason why the child queue disc dropped the packet
+   *  \return the concatenation of CHILD_QUEUE_DISC_DROP and the given reason
+   */
+  const char* LookupChildQueueDiscDropReason (const char* reason);
+
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<InternalQueue> > m_queues;    //!< Internal queues
@@ -695,11 +822,18 @@ private:
   Stats m_stats;                    //!< The collected statistics
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
+  Ptr<LinkEstimator> m_linkEstimator;   //!< Link estimator of the device
   SendCallback m_send;              //!< Callback used to send a packet to the receiving object
+  bool m_bulkDequeue;               //!< True if packets are dequeued and sent in batches
+  SendManyCallback m_sendMany;      //!< Callback used to send a batch of packets to the receiving object
+  std::vector<Ptr<QueueDiscItem> > m_batch;   //!< Batch of packets to send to the receiving object
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
   Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
   bool m_peeked;                    //!< A packet was dequeued because Peek was called
-  std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
+  /// IDs of the reasons used by this queue disc, cached by address
+  std::vector<std::pair<const char*, uint16_t> > m_reasonIds;
+  /// Reasons used for the packets dropped by child queue discs, cached by address
+  std::vector<std::pair<const char*, const char*> > m_childQueueDiscDropReasons;
   QueueDiscSizePolicy m_sizePolicy;     //!< The queue disc size policy
   bool m_prohibitChangeMode;            //!< True if changing mode is prohibited
 
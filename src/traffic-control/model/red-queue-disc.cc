@@ -329,6 +329,17 @@ RedQueueDisc::SetTh (double minTh, double maxTh)
   m_maxTh = maxTh;
 }
 
+QueueDisc::ControllerState
+RedQueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ControllerState state;
+  // RED is driven by the average queue length rather than the queue delay
+  state.queueDelay = Time (0);
+  state.probability = m_vProb;
+  return state;
+}
+
 int64_t 
 RedQueueDisc::AssignStreams (int64_t stream)
 {
@@ -174,6 +174,13 @@ public:
     */
    double GetFengAdaptiveB (void);
 
+  /**
+   * \brief Get the state of the controller.
+   *
+   * \returns The current queue delay and drop probability.
+   */
+  virtual ControllerState GetControllerState (void);
+
   /**
    * \brief Set the thresh limits of RED.
    *
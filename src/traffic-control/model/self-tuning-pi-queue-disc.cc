@@ -0,0 +1,415 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "self-tuning-pi-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/link-estimator.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SelfTuningPiQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (SelfTuningPiQueueDisc);
+
+TypeId SelfTuningPiQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SelfTuningPiQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<SelfTuningPiQueueDisc> ()
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&SelfTuningPiQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Tupdate",
+                   "Time period to calculate drop probability",
+                   TimeValue (Seconds (0.03)),
+                   MakeTimeAccessor (&SelfTuningPiQueueDisc::m_tUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("Supdate",
+                   "Start time of the update timer",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SelfTuningPiQueueDisc::m_sUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxSize",
+                   "The maximum number of packets accepted by this queue disc",
+                   QueueSizeValue (QueueSize ("25p")),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+    .AddAttribute ("DequeueThreshold",
+                   "Minimum queue size in bytes before dequeue rate is measured",
+                   UintegerValue (10000),
+                   MakeUintegerAccessor (&SelfTuningPiQueueDisc::m_dqThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueDelayReference",
+                   "Desired queue delay",
+                   TimeValue (Seconds (0.02)),
+                   MakeTimeAccessor (&SelfTuningPiQueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("BaseRtt",
+                   "Round trip time of the flows, excluding the queue delay of this queue disc, "
+                   "used until the link estimator of the device, if any, measures the RTT",
+                   TimeValue (Seconds (0.1)),
+                   MakeTimeAccessor (&SelfTuningPiQueueDisc::m_baseRtt),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxWindow",
+                   "Largest congestion window (in packets) assumed for a single flow",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&SelfTuningPiQueueDisc::m_maxWindow),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CrossoverFactor",
+                   "Ratio between the unity gain crossover frequency and the TCP pole",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SelfTuningPiQueueDisc::m_crossover),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("ProportionalGain",
+                     "Proportional gain of the controller",
+                     MakeTraceSourceAccessor (&SelfTuningPiQueueDisc::m_kp),
+                     "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("IntegralGain",
+                     "Integral gain of the controller",
+                     MakeTraceSourceAccessor (&SelfTuningPiQueueDisc::m_ki),
+                     "ns3::TracedValueCallback::Double")
+  ;
+
+  return tid;
+}
+
+SelfTuningPiQueueDisc::SelfTuningPiQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+  m_rtrsEvent = Simulator::Schedule (m_sUpdate, &SelfTuningPiQueueDisc::CalculateP, this);
+}
+
+SelfTuningPiQueueDisc::~SelfTuningPiQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+SelfTuningPiQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = 0;
+  Simulator::Remove (m_rtrsEvent);
+  QueueDisc::DoDispose ();
+}
+
+Time
+SelfTuningPiQueueDisc::GetQueueDelay (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_qDelay;
+}
+
+double
+SelfTuningPiQueueDisc::GetDropProbability (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_dropProb;
+}
+
+QueueDisc::ControllerState
+SelfTuningPiQueueDisc::GetControllerState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ControllerState state;
+  state.queueDelay = m_qDelay;
+  state.probability = m_dropProb;
+  return state;
+}
+
+int64_t
+SelfTuningPiQueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+bool
+SelfTuningPiQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  QueueSize nQueued = GetCurrentSize ();
+
+  if (nQueued + item > GetMaxSize ())
+    {
+      // Drops due to queue limit: reactive
+      DropBeforeEnqueue (item, FORCED_DROP);
+      return false;
+    }
+  else if (DropEarly (item, nQueued.GetValue ()))
+    {
+      // Early probability drop: proactive
+      DropBeforeEnqueue (item, UNFORCED_DROP);
+      return false;
+    }
+
+  // No drop
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
+  // internal queue because QueueDisc::AddInternalQueue sets the trace callback
+
+  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+
+  return retval;
+}
+
+void
+SelfTuningPiQueueDisc::InitializeParams (void)
+{
+  // Initially queue is empty so variables are initialize to zero except m_dqCount
+  m_inMeasurement = false;
+  m_dqCount = DQCOUNT_INVALID;
+  m_dropProb = 0;
+  m_nFlows = 0;
+  m_kp = 0;
+  m_ki = 0;
+  m_avgDqRate = 0.0;
+  m_dqStart = 0;
+  m_qDelayOld = Time (Seconds (0));
+}
+
+bool SelfTuningPiQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
+{
+  NS_LOG_FUNCTION (this << item << qSize);
+
+  if ((m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb < 0.2))
+    {
+      return false;
+    }
+  else if (GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES && qSize <= 2 * m_meanPktSize)
+    {
+      return false;
+    }
+  else if (GetMaxSize ().GetUnit () == QueueSizeUnit::PACKETS && qSize <= 2)
+    {
+      return false;
+    }
+
+  double p = m_dropProb;
+
+  if (GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES)
+    {
+      p = p * item->GetSize () / m_meanPktSize;
+    }
+
+  return m_uv->GetValue () < p;
+}
+
+double
+SelfTuningPiQueueDisc::GetCapacity (void) const
+{
+  Ptr<LinkEstimator> estimator = GetLinkEstimator ();
+  if (estimator && estimator->GetDrainRate ().GetBitRate () > 0)
+    {
+      return estimator->GetDrainRate ().GetBitRate () / 8.0;
+    }
+  return m_avgDqRate;
+}
+
+Time
+SelfTuningPiQueueDisc::GetRtt (Time qDelay) const
+{
+  Ptr<LinkEstimator> estimator = GetLinkEstimator ();
+  if (estimator && estimator->GetRtt ().IsStrictlyPositive ())
+    {
+      // the measured RTT already includes the queue delay
+      return estimator->GetRtt ();
+    }
+  return m_baseRtt + qDelay;
+}
+
+void
+SelfTuningPiQueueDisc::TuneGains (Time qDelay)
+{
+  NS_LOG_FUNCTION (this << qDelay);
+
+  // Link capacity (packets per second) and round trip time (seconds)
+  double c = GetCapacity () / m_meanPktSize;
+  double r = GetRtt (qDelay).GetSeconds ();
+  double t = m_tUpdate.GetSeconds ();
+
+  // At the equilibrium of the TCP fluid model, p = 2 N^2 / (R C)^2. The
+  // estimate is bounded by assuming that the window of a flow is never
+  // larger than MaxWindow packets
+  m_nFlows = std::max (r * c * std::sqrt (m_dropProb / 2), r * c / m_maxWindow);
+
+  // Hollot et al.: place the zero z of the PI controller on the TCP pole
+  // 2N/(R^2 C), which it cancels, take the unity gain crossover frequency wg
+  // as a fraction of z and choose the loop gain K so that the open loop gain
+  // is one at wg
+  double z = 2 * m_nFlows / (r * r * c);
+  double wg = m_crossover * z;
+  double k = wg * std::sqrt (std::pow (wg * r, 2) + 1)
+    * std::pow (2 * m_nFlows, 2) / std::pow (r * c, 3);
+
+  // C(s) = K (s/z + 1) / s, i.e., Kp = K/z and Ki = K sampled with period T,
+  // with the gains converted from packets to seconds of queue delay
+  m_ki = k * t * c;
+  m_kp = k / z * c;
+
+  NS_LOG_DEBUG ("C=" << c << " pkt/s, R=" << r << " s, N=" << m_nFlows
+                << ", Kp=" << m_kp << ", Ki=" << m_ki);
+}
+
+void SelfTuningPiQueueDisc::CalculateP ()
+{
+  NS_LOG_FUNCTION (this);
+  Time qDelay;
+  double capacity = GetCapacity ();
+
+  if (capacity > 0)
+    {
+      qDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / capacity));
+      TuneGains (qDelay);
+    }
+  else
+    {
+      qDelay = Time (Seconds (0));
+    }
+
+  m_qDelay = qDelay;
+
+  double p = m_dropProb + m_ki * (qDelay.GetSeconds () - m_qDelayRef.GetSeconds ())
+    + m_kp * (qDelay.GetSeconds () - m_qDelayOld.GetSeconds ());
+
+  // Decay the drop probability while the queue stays empty
+  if (qDelay.GetSeconds () == 0 && m_qDelayOld.GetSeconds () == 0)
+    {
+      p *= 0.98;
+    }
+
+  m_dropProb = std::min (std::max (p, 0.0), 1.0);
+
+  m_qDelayOld = qDelay;
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &SelfTuningPiQueueDisc::CalculateP, this);
+}
+
+Ptr<QueueDiscItem>
+SelfTuningPiQueueDisc::DoDequeue ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+  double now = Simulator::Now ().GetSeconds ();
+  uint32_t pktSize = item->GetSize ();
+
+  // if not in a measurement cycle and the queue has built up to dq_threshold,
+  // start the measurement cycle
+
+  if ( (GetInternalQueue (0)->GetNBytes () >= m_dqThreshold) && (!m_inMeasurement) )
+    {
+      m_dqStart = now;
+      m_dqCount = 0;
+      m_inMeasurement = true;
+    }
+
+  if (m_inMeasurement)
+    {
+      m_dqCount += pktSize;
+
+      // done with a measurement cycle
+      if (m_dqCount >= m_dqThreshold)
+        {
+
+          double tmp = now - m_dqStart;
+
+          if (tmp > 0)
+            {
+              if (m_avgDqRate == 0)
+                {
+                  m_avgDqRate = m_dqCount / tmp;
+                }
+              else
+                {
+                  m_avgDqRate = (0.5 * m_avgDqRate) + (0.5 * (m_dqCount / tmp));
+                }
+            }
+
+          // restart a measurement cycle if there is enough data
+          if (GetInternalQueue (0)->GetNBytes () > m_dqThreshold)
+            {
+              m_dqStart = now;
+              m_dqCount = 0;
+              m_inMeasurement = true;
+            }
+          else
+            {
+              m_dqCount = 0;
+              m_inMeasurement = false;
+            }
+        }
+    }
+
+  return item;
+}
+
+bool
+SelfTuningPiQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("SelfTuningPiQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("SelfTuningPiQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // add  a DropTail queue
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> >
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("SelfTuningPiQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  return true;
+}
+
+} //namespace ns3
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SELF_TUNING_PI_QUEUE_DISC_H
+#define SELF_TUNING_PI_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Implements the Self-Tuning PI (STPI) Active Queue Management discipline
+ *
+ * STPI is a Proportional Integral controller acting on the queue delay whose
+ * gains are not fixed but are periodically recomputed from online estimates
+ * of the bottleneck capacity C, of the round trip time R and of the number of
+ * TCP flows N (obtained by inverting the TCP equilibrium relation
+ * p = 2 N^2 / (R C)^2). C and R are measured by the LinkEstimator of the
+ * device, if any. Otherwise, C is the dequeue rate (as in PIE) and R is the
+ * configured base RTT plus the current queue delay. The gains are derived
+ * with the design rules of Hollot et al. for the linearized TCP/AQM fluid
+ * model, so that the controller keeps the same stability margins when the
+ * capacity or the load of the bottleneck change. The estimated number of
+ * flows is bounded from below by assuming that no flow has a congestion
+ * window larger than MaxWindow packets, which makes the gains used at low
+ * load independent of the link capacity.
+ */
+class SelfTuningPiQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief SelfTuningPiQueueDisc Constructor
+   */
+  SelfTuningPiQueueDisc ();
+
+  /**
+   * \brief SelfTuningPiQueueDisc Destructor
+   */
+  virtual ~SelfTuningPiQueueDisc ();
+
+  /**
+   * \brief Get queue delay.
+   *
+   * \returns The current queue delay.
+   */
+  Time GetQueueDelay (void);
+
+  /**
+   * \brief Get the current drop probability.
+   *
+   * \returns The current drop probability.
+   */
+  double GetDropProbability (void);
+
+  /**
+   * \brief Get the state of the controller.
+   *
+   * \returns The current queue delay and drop probability.
+   */
+  virtual ControllerState GetControllerState (void);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  // Reasons for dropping packets
+  static constexpr const char* UNFORCED_DROP = "Unforced drop";  //!< Early probability drops: proactive
+  static constexpr const char* FORCED_DROP = "Forced drop";      //!< Drops due to queue limit: reactive
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual bool CheckConfig (void);
+
+  /**
+   * \brief Initialize the queue parameters.
+   */
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Check if a packet needs to be dropped due to probability drop
+   * \param item queue item
+   * \param qSize queue size
+   * \returns 0 for no drop, 1 for drop
+   */
+  bool DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize);
+
+  /**
+   * Get the estimated link capacity: the drain rate measured by the link
+   * estimator of the device, if any, or the dequeue rate of this queue disc
+   * \return the link capacity in bytes per second, or zero if not known yet
+   */
+  double GetCapacity (void) const;
+
+  /**
+   * Get the estimated round trip time: the RTT measured by the link estimator
+   * of the device, if any, or the sum of BaseRtt and of the queue delay
+   * \param qDelay the current queue delay
+   * \return the round trip time
+   */
+  Time GetRtt (Time qDelay) const;
+
+  /**
+   * Recompute the proportional and integral gains from the current estimates
+   * of the link capacity, of the round trip time and of the number of flows.
+   * \param qDelay the current queue delay
+   */
+  void TuneGains (Time qDelay);
+
+  /**
+   * Periodically update the drop probability based on the delay samples,
+   * using the gains computed by TuneGains
+   */
+  void CalculateP ();
+
+  static const uint64_t DQCOUNT_INVALID = std::numeric_limits<uint64_t>::max();  //!< Invalid dqCount value
+
+  // ** Variables supplied by user
+  Time m_sUpdate;                               //!< Start time of the update timer
+  Time m_tUpdate;                               //!< Sampling period of the controller
+  Time m_qDelayRef;                             //!< Desired queue delay
+  uint32_t m_meanPktSize;                       //!< Average packet size in bytes
+  uint32_t m_dqThreshold;                       //!< Minimum queue size in bytes before dequeue rate is measured
+  Time m_baseRtt;                               //!< Round trip time excluding the queue delay of this queue disc
+  uint32_t m_maxWindow;                         //!< Largest congestion window (in packets) assumed for a flow
+  double m_crossover;                           //!< Ratio between the unity gain crossover frequency and the TCP pole
+
+  // ** Variables maintained by STPI
+  TracedValue<double> m_kp;                     //!< Proportional gain (in delay units)
+  TracedValue<double> m_ki;                     //!< Integral gain (in delay units)
+  double m_dropProb;                            //!< Drop probability
+  double m_nFlows;                              //!< Estimated number of flows
+  Time m_qDelayOld;                             //!< Old value of queue delay
+  Time m_qDelay;                                //!< Current value of queue delay
+  bool m_inMeasurement;                         //!< Indicates whether we are in a measurement cycle
+  double m_avgDqRate;                           //!< Time averaged dequeue rate
+  double m_dqStart;                             //!< Start timestamp of current measurement cycle
+  uint64_t m_dqCount;                           //!< Number of bytes departed since current measurement cycle starts
+  EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
+  Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
+};
+
+};   // namespace ns3
+
+#endif
@@ -259,8 +259,13 @@ TbfQueueDisc::DoDequeue (void)
       schedule the waking of queue when enough tokens are available. */
       if (m_id.IsExpired () == true)
         {
-          Time requiredDelayTime = std::max (m_rate.CalculateBytesTxTime (-btoks),
-                                             m_peakRate.CalculateBytesTxTime (-ptoks));
+          Time requiredDelayTime = m_rate.CalculateBytesTxTime (-btoks);
+          // the time to fill the second bucket is undefined if there is no second bucket
+          if (m_peakRate > DataRate ("0bps"))
+            {
+              requiredDelayTime = std::max (requiredDelayTime,
+                                            m_peakRate.CalculateBytesTxTime (-ptoks));
+            }
 
           m_id = Simulator::Schedule (requiredDelayTime, &QueueDisc::Run, this);
           NS_LOG_LOGIC("Waking Event Scheduled in " << requiredDelayTime);
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "token-bucket-policer.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TokenBucketPolicer");
+
+NS_OBJECT_ENSURE_REGISTERED (TokenBucketPolicer);
+
+TypeId
+TokenBucketPolicer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TokenBucketPolicer")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<TokenBucketPolicer> ()
+    .AddAttribute ("Rate",
+                   "Rate at which tokens enter the bucket.",
+                   DataRateValue (DataRate ("125KB/s")),
+                   MakeDataRateAccessor (&TokenBucketPolicer::m_rate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Burst",
+                   "Size of the bucket in bytes.",
+                   UintegerValue (125000),
+                   MakeUintegerAccessor (&TokenBucketPolicer::m_burst),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Drop",
+                     "Packet that does not conform to the configured rate",
+                     MakeTraceSourceAccessor (&TokenBucketPolicer::m_dropTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+TokenBucketPolicer::TokenBucketPolicer ()
+  : Object (),
+    m_tokens (0),
+    m_full (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TokenBucketPolicer::~TokenBucketPolicer ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TokenBucketPolicer::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  if (m_full)
+    {
+      m_tokens = m_burst;
+      m_full = false;
+    }
+  else
+    {
+      m_tokens += (now - m_lastUpdate).GetSeconds () * m_rate.GetBitRate () / 8;
+      m_tokens = std::min (m_tokens, static_cast<double> (m_burst));
+    }
+  m_lastUpdate = now;
+}
+
+uint32_t
+TokenBucketPolicer::GetTokens (void)
+{
+  NS_LOG_FUNCTION (this);
+  Refill ();
+  return static_cast<uint32_t> (m_tokens);
+}
+
+bool
+TokenBucketPolicer::Conform (Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  Refill ();
+
+  if (p->GetSize () > m_tokens)
+    {
+      NS_LOG_LOGIC ("Packet of " << p->GetSize () << " bytes exceeds the " << m_tokens << " tokens");
+      m_dropTrace (p);
+      return false;
+    }
+
+  m_tokens -= p->GetSize ();
+  return true;
+}
+
+} // namespace ns3
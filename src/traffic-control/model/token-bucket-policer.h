@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TOKEN_BUCKET_POLICER_H
+#define TOKEN_BUCKET_POLICER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A token bucket policer
+ *
+ * Modelled after the Linux police action (net/sched/act_police.c). The bucket
+ * holds at most Burst bytes and is filled at the configured Rate. A packet
+ * conforms if the bucket holds at least as many tokens as the packet size,
+ * in which case the tokens are consumed. Contrary to a TBF queue disc, a
+ * policer has no queue: packets that do not conform are dropped.
+ *
+ * A policer can be set on the ingress of a device by means of
+ * TrafficControlLayer::SetIngressPolicerOnDevice.
+ */
+class TokenBucketPolicer : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief TokenBucketPolicer constructor
+   */
+  TokenBucketPolicer ();
+
+  virtual ~TokenBucketPolicer ();
+
+  /**
+   * \brief Check whether a packet conforms to the configured rate
+   *
+   * If the packet conforms, its size is subtracted from the tokens in the
+   * bucket. Otherwise, the Drop trace is fired.
+   *
+   * \param p the packet
+   * \return true if the packet conforms, false if it must be dropped
+   */
+  bool Conform (Ptr<const Packet> p);
+
+  /**
+   * \brief Get the current number of tokens in the bucket
+   * \return the number of tokens in bytes
+   */
+  uint32_t GetTokens (void);
+
+private:
+  /**
+   * \brief Add the tokens accumulated since the last update to the bucket
+   */
+  void Refill (void);
+
+  DataRate m_rate;          //!< Rate at which the bucket is filled
+  uint32_t m_burst;         //!< Size of the bucket in bytes
+  double m_tokens;          //!< Current number of tokens in bytes
+  Time m_lastUpdate;        //!< Time of the last update of the tokens
+  bool m_full;              //!< True until the bucket is first used (it starts full)
+
+  TracedCallback<Ptr<const Packet> > m_dropTrace;  //!< Trace of non-conforming packets
+};
+
+} // namespace ns3
+
+#endif /* TOKEN_BUCKET_POLICER_H */
@@ -24,12 +24,75 @@
 #include "ns3/packet.h"
 #include "ns3/socket.h"
 #include "ns3/queue-disc.h"
+#include "token-bucket-policer.h"
+#include "ns3/link-estimator.h"
 #include <tuple>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TrafficControlLayer");
 
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Queue disc item storing a received packet in an ingress queue disc
+ *
+ * The item stores the arguments of TrafficControlLayer::Receive, so that the
+ * packet can be passed to the upper layers when it is dequeued. The packet
+ * still includes the network header, hence the item cannot be classified by
+ * the packet filters of the network protocols.
+ */
+class IngressQueueDiscItem : public QueueDiscItem
+{
+public:
+  /**
+   * \brief Create an ingress queue disc item
+   * \param p the packet
+   * \param protocol next header value
+   * \param from address of the correspondent
+   * \param to address of the destination
+   * \param packetType type of the packet
+   */
+  IngressQueueDiscItem (Ptr<Packet> p, uint16_t protocol, const Address &from,
+                        const Address &to, NetDevice::PacketType packetType)
+    : QueueDiscItem (p, from, protocol),
+      m_to (to),
+      m_packetType (packetType)
+  {
+  }
+
+  /**
+   * \brief Get the address of the destination
+   * \return the address of the destination
+   */
+  const Address & GetTo (void) const
+  {
+    return m_to;
+  }
+
+  /**
+   * \brief Get the type of the packet
+   * \return the type of the packet
+   */
+  NetDevice::PacketType GetPacketType (void) const
+  {
+    return m_packetType;
+  }
+
+  virtual void AddHeader (void)
+  {
+  }
+
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+
+private:
+  Address m_to;                          //!< address of the destination
+  NetDevice::PacketType m_packetType;    //!< type of the packet
+};
+
 NS_OBJECT_ENSURE_REGISTERED (TrafficControlLayer);
 
 TypeId
@@ -71,6 +134,13 @@ TrafficControlLayer::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_node = 0;
   m_handlers.clear ();
+  for (auto& ndi : m_netDevices)
+    {
+      if (ndi.m_ingressQueueDisc)
+        {
+          ndi.m_ingressQueueDisc->SetSendCallback (nullptr);
+        }
+    }
   m_netDevices.clear ();
   Object::DoDispose ();
 }
@@ -82,12 +152,16 @@ TrafficControlLayer::DoInitialize (void)
 
   ScanDevices ();
 
-  // initialize the root queue discs
+  // initialize the root and ingress queue discs
   for (auto& ndi : m_netDevices)
     {
-      if (ndi.second.m_rootQueueDisc)
+      if (ndi.m_rootQueueDisc)
         {
-          ndi.second.m_rootQueueDisc->Initialize ();
+          ndi.m_rootQueueDisc->Initialize ();
+        }
+      if (ndi.m_ingressQueueDisc)
+        {
+          ndi.m_ingressQueueDisc->Initialize ();
         }
     }
 
@@ -112,6 +186,22 @@ TrafficControlLayer::RegisterProtocolHandler (Node::ProtocolHandler handler,
                 protocolType << ".");
 }
 
+TrafficControlLayer::NetDeviceInfo&
+TrafficControlLayer::GetNetDeviceInfo (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+
+  NS_ASSERT_MSG (device->GetNode () == m_node, "Device " << device << " is not attached to the node "
+                 "this Traffic Control layer is aggregated to");
+
+  uint32_t ifIndex = device->GetIfIndex ();
+  if (ifIndex >= m_netDevices.size ())
+    {
+      m_netDevices.resize (ifIndex + 1);
+    }
+  return m_netDevices[ifIndex];
+}
+
 void
 TrafficControlLayer::ScanDevices (void)
 {
@@ -119,73 +209,79 @@ TrafficControlLayer::ScanDevices (void)
 
   NS_ASSERT_MSG (m_node, "Cannot run ScanDevices without an aggregated node");
 
+  if (m_netDevices.size () < m_node->GetNDevices ())
+    {
+      m_netDevices.resize (m_node->GetNDevices ());
+    }
+
   for (uint32_t i = 0; i < m_node->GetNDevices (); i++)
     {
       Ptr<NetDevice> dev = m_node->GetDevice (i);
+      NetDeviceInfo& ndi = m_netDevices[i];
 
-      // note: there may be no NetDeviceQueueInterface aggregated to the device
+      // note: there may be no NetDeviceQueueInterface aggregated to the device.
+      // Store a pointer to the NetDeviceQueueInterface object even if no queue
+      // disc is installed, because the Traffic Control layer checks whether the
+      // device queue is stopped even when there is no queue disc.
       Ptr<NetDeviceQueueInterface> ndqi = dev->GetObject<NetDeviceQueueInterface> ();
+      ndi.m_ndqi = ndqi;
 
-      std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (dev);
-
-      if (ndi != m_netDevices.end ())
+      // the link estimator, if any, is aggregated to the NetDeviceQueueInterface
+      ndi.m_linkEstimator = (ndqi ? ndqi->GetObject<LinkEstimator> () : nullptr);
+      if (ndi.m_rootQueueDisc)
         {
-          ndi->second.m_ndqi = ndqi;
+          ndi.m_rootQueueDisc->SetLinkEstimator (ndi.m_linkEstimator);
         }
-      else if (ndqi)
-      // if no entry for the device is found, it means that no queue disc has been
-      // installed. Nonetheless, create an entry for the device and store a pointer
-      // to the NetDeviceQueueInterface object if the latter is not null, because
-      // the Traffic Control layer checks whether the device queue is stopped even
-      // when there is no queue disc.
+      if (ndi.m_ingressQueueDisc)
         {
-          m_netDevices[dev] = {nullptr, ndqi, QueueDiscVector ()};
-          ndi = m_netDevices.find (dev);
+          ndi.m_ingressQueueDisc->SetLinkEstimator (ndi.m_linkEstimator);
         }
 
       // if a queue disc is installed, set the wake callbacks on netdevice queues
-      if (ndi != m_netDevices.end () && ndi->second.m_rootQueueDisc)
+      if (ndi.m_rootQueueDisc)
         {
-          ndi->second.m_queueDiscsToWake.clear ();
+          ndi.m_queueDiscsToWake.clear ();
 
           if (ndqi)
             {
-              for (uint16_t i = 0; i < ndqi->GetNTxQueues (); i++)
+              for (uint16_t q = 0; q < ndqi->GetNTxQueues (); q++)
                 {
                   Ptr<QueueDisc> qd;
 
-                  if (ndi->second.m_rootQueueDisc->GetWakeMode () == QueueDisc::WAKE_ROOT)
+                  if (ndi.m_rootQueueDisc->GetWakeMode () == QueueDisc::WAKE_ROOT)
                     {
-                      qd = ndi->second.m_rootQueueDisc;
+                      qd = ndi.m_rootQueueDisc;
                     }
-                  else if (ndi->second.m_rootQueueDisc->GetWakeMode () == QueueDisc::WAKE_CHILD)
+                  else if (ndi.m_rootQueueDisc->GetWakeMode () == QueueDisc::WAKE_CHILD)
                     {
-                      NS_ABORT_MSG_IF (ndi->second.m_rootQueueDisc->GetNQueueDiscClasses () != ndqi->GetNTxQueues (),
+                      NS_ABORT_MSG_IF (ndi.m_rootQueueDisc->GetNQueueDiscClasses () != ndqi->GetNTxQueues (),
                                       "The number of child queue discs does not match the number of netdevice queues");
 
-                      qd = ndi->second.m_rootQueueDisc->GetQueueDiscClass (i)->GetQueueDisc ();
+                      qd = ndi.m_rootQueueDisc->GetQueueDiscClass (q)->GetQueueDisc ();
                     }
                   else
                     {
                       NS_ABORT_MSG ("Invalid wake mode");
                     }
 
-                  ndqi->GetTxQueue (i)->SetWakeCallback (MakeCallback (&QueueDisc::Run, qd));
-                  ndi->second.m_queueDiscsToWake.push_back (qd);
+                  ndqi->GetTxQueue (q)->SetWakeCallback (MakeCallback (&QueueDisc::Run, qd));
+                  ndi.m_queueDiscsToWake.push_back (qd);
                 }
             }
           else
             {
-              ndi->second.m_queueDiscsToWake.push_back (ndi->second.m_rootQueueDisc);
+              ndi.m_queueDiscsToWake.push_back (ndi.m_rootQueueDisc);
             }
 
           // set the NetDeviceQueueInterface object and the SendCallback on the queue discs
           // into which packets are enqueued and dequeued by calling Run
-          for (auto& q : ndi->second.m_queueDiscsToWake)
+          for (auto& q : ndi.m_queueDiscsToWake)
             {
               q->SetNetDeviceQueueInterface (ndqi);
               q->SetSendCallback ([dev] (Ptr<QueueDiscItem> item)
                                   { dev->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ()); });
+              q->SetSendManyCallback ([dev] (const std::vector<Ptr<QueueDiscItem> > &items)
+                                      { dev->SendMany (items); });
             }
         }
     }
@@ -196,42 +292,32 @@ TrafficControlLayer::SetRootQueueDiscOnDevice (Ptr<NetDevice> device, Ptr<QueueD
 {
   NS_LOG_FUNCTION (this << device << qDisc);
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
+  NetDeviceInfo& ndi = GetNetDeviceInfo (device);
 
-  if (ndi == m_netDevices.end ())
-    {
-      // No entry found for this device. Create one.
-      m_netDevices[device] = {qDisc, nullptr, QueueDiscVector ()};
-    }
-  else
-    {
-      NS_ABORT_MSG_IF (ndi->second.m_rootQueueDisc,
-                       "Cannot install a root queue disc on a device already having one. "
-                       "Delete the existing queue disc first.");
+  NS_ABORT_MSG_IF (ndi.m_rootQueueDisc,
+                   "Cannot install a root queue disc on a device already having one. "
+                   "Delete the existing queue disc first.");
 
-      ndi->second.m_rootQueueDisc = qDisc;
-    }
+  ndi.m_rootQueueDisc = qDisc;
 }
 
 Ptr<QueueDisc>
 TrafficControlLayer::GetRootQueueDiscOnDevice (Ptr<NetDevice> device) const
 {
   NS_LOG_FUNCTION (this << device);
-
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::const_iterator ndi = m_netDevices.find (device);
-
-  if (ndi == m_netDevices.end ())
-    {
-      return 0;
-    }
-  return ndi->second.m_rootQueueDisc;
+  return GetRootQueueDiscOnDeviceByIndex (device->GetIfIndex ());
 }
 
 Ptr<QueueDisc>
 TrafficControlLayer::GetRootQueueDiscOnDeviceByIndex (uint32_t index) const
 {
   NS_LOG_FUNCTION (this << index);
-  return GetRootQueueDiscOnDevice (m_node->GetDevice (index));
+
+  if (index >= m_netDevices.size ())
+    {
+      return 0;
+    }
+  return m_netDevices[index].m_rootQueueDisc;
 }
 
 void
@@ -239,21 +325,24 @@ TrafficControlLayer::DeleteRootQueueDiscOnDevice (Ptr<NetDevice> device)
 {
   NS_LOG_FUNCTION (this << device);
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
+  uint32_t ifIndex = device->GetIfIndex ();
 
-  NS_ASSERT_MSG (ndi != m_netDevices.end () && ndi->second.m_rootQueueDisc != 0,
+  NS_ASSERT_MSG (ifIndex < m_netDevices.size () && m_netDevices[ifIndex].m_rootQueueDisc != 0,
                  "No root queue disc installed on device " << device);
 
+  NetDeviceInfo& ndi = m_netDevices[ifIndex];
+
   // remove the root queue disc
-  ndi->second.m_rootQueueDisc = 0;
-  for (auto& q : ndi->second.m_queueDiscsToWake)
+  ndi.m_rootQueueDisc = 0;
+  for (auto& q : ndi.m_queueDiscsToWake)
     {
       q->SetNetDeviceQueueInterface (nullptr);
       q->SetSendCallback (nullptr);
+      q->SetSendManyCallback (nullptr);
     }
-  ndi->second.m_queueDiscsToWake.clear ();
+  ndi.m_queueDiscsToWake.clear ();
 
-  Ptr<NetDeviceQueueInterface> ndqi = ndi->second.m_ndqi;
+  Ptr<NetDeviceQueueInterface> ndqi = ndi.m_ndqi;
   if (ndqi)
     {
       // remove configured callbacks, if any
@@ -262,11 +351,80 @@ TrafficControlLayer::DeleteRootQueueDiscOnDevice (Ptr<NetDevice> device)
           ndqi->GetTxQueue (i)->SetWakeCallback (MakeNullCallback <void> ());
         }
     }
-  else
+}
+
+void
+TrafficControlLayer::SetIngressQueueDiscOnDevice (Ptr<NetDevice> device, Ptr<QueueDisc> qDisc)
+{
+  NS_LOG_FUNCTION (this << device << qDisc);
+
+  NS_ASSERT (qDisc);
+  NetDeviceInfo& ndi = GetNetDeviceInfo (device);
+
+  NS_ABORT_MSG_IF (ndi.m_ingressQueueDisc,
+                   "Cannot install an ingress queue disc on a device already having one. "
+                   "Delete the existing queue disc first.");
+
+  ndi.m_ingressQueueDisc = qDisc;
+  // packets dequeued from the ingress queue disc are passed to the upper layers
+  qDisc->SetSendCallback ([this, device] (Ptr<QueueDiscItem> item)
+                          {
+                            Ptr<IngressQueueDiscItem> ingressItem = DynamicCast<IngressQueueDiscItem> (item);
+                            NS_ASSERT (ingressItem);
+                            ForwardUp (device, ingressItem->GetPacket (), ingressItem->GetProtocol (),
+                                       ingressItem->GetAddress (), ingressItem->GetTo (),
+                                       ingressItem->GetPacketType ());
+                          });
+}
+
+Ptr<QueueDisc>
+TrafficControlLayer::GetIngressQueueDiscOnDevice (Ptr<NetDevice> device) const
+{
+  NS_LOG_FUNCTION (this << device);
+
+  uint32_t ifIndex = device->GetIfIndex ();
+
+  if (ifIndex >= m_netDevices.size ())
+    {
+      return 0;
+    }
+  return m_netDevices[ifIndex].m_ingressQueueDisc;
+}
+
+void
+TrafficControlLayer::DeleteIngressQueueDiscOnDevice (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+
+  uint32_t ifIndex = device->GetIfIndex ();
+
+  NS_ASSERT_MSG (ifIndex < m_netDevices.size () && m_netDevices[ifIndex].m_ingressQueueDisc != 0,
+                 "No ingress queue disc installed on device " << device);
+
+  m_netDevices[ifIndex].m_ingressQueueDisc->SetSendCallback (nullptr);
+  m_netDevices[ifIndex].m_ingressQueueDisc = 0;
+}
+
+void
+TrafficControlLayer::SetIngressPolicerOnDevice (Ptr<NetDevice> device, Ptr<TokenBucketPolicer> policer)
+{
+  NS_LOG_FUNCTION (this << device << policer);
+
+  GetNetDeviceInfo (device).m_ingressPolicer = policer;
+}
+
+Ptr<TokenBucketPolicer>
+TrafficControlLayer::GetIngressPolicerOnDevice (Ptr<NetDevice> device) const
+{
+  NS_LOG_FUNCTION (this << device);
+
+  uint32_t ifIndex = device->GetIfIndex ();
+
+  if (ifIndex >= m_netDevices.size ())
     {
-      // remove the empty entry
-      m_netDevices.erase (ndi);
+      return 0;
     }
+  return m_netDevices[ifIndex].m_ingressPolicer;
 }
 
 void
@@ -307,6 +465,43 @@ TrafficControlLayer::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
 {
   NS_LOG_FUNCTION (this << device << p << protocol << from << to << packetType);
 
+  uint32_t ifIndex = device->GetIfIndex ();
+
+  if (ifIndex >= m_netDevices.size ()
+      || (!m_netDevices[ifIndex].m_ingressPolicer && !m_netDevices[ifIndex].m_ingressQueueDisc))
+    {
+      ForwardUp (device, p, protocol, from, to, packetType);
+      return;
+    }
+
+  const NetDeviceInfo& ndi = m_netDevices[ifIndex];
+
+  if (ndi.m_ingressPolicer && !ndi.m_ingressPolicer->Conform (p))
+    {
+      NS_LOG_LOGIC ("Packet " << p << " dropped by the ingress policer of device " << device);
+      return;
+    }
+
+  if (!ndi.m_ingressQueueDisc)
+    {
+      ForwardUp (device, p, protocol, from, to, packetType);
+      return;
+    }
+
+  // Enqueue the packet in the ingress queue disc and try to dequeue packets
+  // from such queue disc, which are passed to the upper layers
+  Ptr<QueueDisc> qDisc = ndi.m_ingressQueueDisc;
+  qDisc->Enqueue (Create<IngressQueueDiscItem> (p->Copy (), protocol, from, to, packetType));
+  qDisc->Run ();
+}
+
+void
+TrafficControlLayer::ForwardUp (Ptr<NetDevice> device, Ptr<const Packet> p,
+                                uint16_t protocol, const Address &from, const Address &to,
+                                NetDevice::PacketType packetType)
+{
+  NS_LOG_FUNCTION (this << device << p << protocol << from << to << packetType);
+
   bool found = false;
 
   for (ProtocolHandlerList::iterator i = m_handlers.begin ();
@@ -335,17 +530,20 @@ void
 TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << device << item);
+  NS_ASSERT (device->GetNode () == m_node);
+  Send (device->GetIfIndex (), item);
+}
 
-  NS_LOG_DEBUG ("Send packet to device " << device << " protocol number " <<
-                item->GetProtocol ());
+void
+TrafficControlLayer::Send (uint32_t ifIndex, Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << ifIndex << item);
 
-  Ptr<NetDeviceQueueInterface> devQueueIface;
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
+  NS_LOG_DEBUG ("Send packet to device " << ifIndex << " protocol number " <<
+                item->GetProtocol ());
 
-  if (ndi != m_netDevices.end ())
-    {
-      devQueueIface = ndi->second.m_ndqi;
-    }
+  NetDeviceInfo* ndi = (ifIndex < m_netDevices.size () ? &m_netDevices[ifIndex] : nullptr);
+  NetDeviceQueueInterface* devQueueIface = (ndi ? PeekPointer (ndi->m_ndqi) : nullptr);
 
   // determine the transmission queue of the device where the packet will be enqueued
   std::size_t txq = 0;
@@ -362,7 +560,12 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
 
   NS_ASSERT (!devQueueIface || txq < devQueueIface->GetNTxQueues ());
 
-  if (ndi == m_netDevices.end () || ndi->second.m_rootQueueDisc == 0)
+  if (ndi && ndi->m_linkEstimator)
+    {
+      ndi->m_linkEstimator->NotifyEgress (item);
+    }
+
+  if (!ndi || ndi->m_rootQueueDisc == 0)
     {
       // The device has no attached queue disc, thus add the header to the packet and
       // send it directly to the device if the selected queue is not stopped
@@ -375,7 +578,7 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
               SocketPriorityTag priorityTag;
               item->GetPacket ()->RemovePacketTag (priorityTag);
             }
-          device->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ());
+          m_node->GetDevice (ifIndex)->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ());
         }
     }
   else
@@ -384,7 +587,7 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
       // selected for the packet and try to dequeue packets from such queue disc
       item->SetTxQueueIndex (txq);
 
-      Ptr<QueueDisc> qDisc = ndi->second.m_queueDiscsToWake[txq];
+      Ptr<QueueDisc> qDisc = ndi->m_queueDiscsToWake[txq];
       NS_ASSERT (qDisc);
       qDisc->Enqueue (item);
       qDisc->Run ();
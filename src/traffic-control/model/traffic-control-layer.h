@@ -24,7 +24,6 @@
 #include "ns3/net-device.h"
 #include "ns3/node.h"
 #include "ns3/queue-item.h"
-#include <map>
 #include <vector>
 
 namespace ns3 {
@@ -32,6 +31,8 @@ namespace ns3 {
 class Packet;
 class QueueDisc;
 class NetDeviceQueueInterface;
+class TokenBucketPolicer;
+class LinkEstimator;
 
 /**
  * \defgroup traffic-control
@@ -85,6 +86,15 @@ class NetDeviceQueueInterface;
  * Discrimination through callbacks (in other words: what is the right upper-layer
  * callback for this packet?) is done through checks over the device and the
  * protocol number.
+ *
+ * Received packets can be policed and shaped before being passed to the upper
+ * layers. A policer set on the ingress of a device (SetIngressPolicerOnDevice)
+ * drops the packets exceeding the configured rate, as the Linux police action
+ * attached to the ingress qdisc. A queue disc set on the ingress of a device
+ * (SetIngressQueueDiscOnDevice) stores the received packets, which are passed
+ * to the upper layers when they are dequeued. This is the equivalent of
+ * redirecting the received packets to an IFB device in Linux and is typically
+ * used to shape the download traffic of a CPE.
  */
 class TrafficControlLayer : public Object
 {
@@ -165,6 +175,55 @@ public:
    */
   virtual void DeleteRootQueueDiscOnDevice (Ptr<NetDevice> device);
 
+  /**
+   * \brief This method can be used to set the queue disc which the packets
+   *        received by a device are enqueued into
+   *
+   * The packets dequeued from the ingress queue disc are passed to the upper
+   * layers. The ingress queue disc has no NetDeviceQueueInterface, hence it is
+   * never stopped by the device.
+   *
+   * \param device the device on whose ingress the provided queue disc will be installed
+   * \param qDisc the queue disc to be installed on the ingress of device
+   */
+  virtual void SetIngressQueueDiscOnDevice (Ptr<NetDevice> device, Ptr<QueueDisc> qDisc);
+
+  /**
+   * \brief This method can be used to get the queue disc installed on the ingress of a device
+   *
+   * \param device the device on whose ingress the requested queue disc is installed
+   * \return the queue disc installed on the ingress of the given device
+   */
+  virtual Ptr<QueueDisc> GetIngressQueueDiscOnDevice (Ptr<NetDevice> device) const;
+
+  /**
+   * \brief This method can be used to remove the queue disc installed on the
+   *        ingress of a device
+   *
+   * \param device the device on whose ingress the installed queue disc will be deleted
+   */
+  virtual void DeleteIngressQueueDiscOnDevice (Ptr<NetDevice> device);
+
+  /**
+   * \brief This method can be used to set the policer applied to the packets
+   *        received by a device
+   *
+   * The policer is applied before the packets are enqueued into the ingress
+   * queue disc, if any. A null policer removes the policer installed on the device.
+   *
+   * \param device the device on whose ingress the provided policer will be installed
+   * \param policer the policer to be installed on the ingress of device
+   */
+  virtual void SetIngressPolicerOnDevice (Ptr<NetDevice> device, Ptr<TokenBucketPolicer> policer);
+
+  /**
+   * \brief This method can be used to get the policer installed on the ingress of a device
+   *
+   * \param device the device on whose ingress the requested policer is installed
+   * \return the policer installed on the ingress of the given device
+   */
+  virtual Ptr<TokenBucketPolicer> GetIngressPolicerOnDevice (Ptr<NetDevice> device) const;
+
   /**
    * \brief Set node associated with this stack.
    * \param node node to set
@@ -195,6 +254,17 @@ public:
    */
   virtual void Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item);
 
+  /**
+   * \brief Called from upper layer to queue a packet for the transmission.
+   *
+   * This method avoids looking up the device when the upper layer knows the
+   * index of the device in the list of devices of the node.
+   *
+   * \param ifIndex the index of the device the packet must be sent to
+   * \param item a queue item including a packet and additional information
+   */
+  virtual void Send (uint32_t ifIndex, Ptr<QueueDiscItem> item);
+
 protected:
 
   virtual void DoDispose (void);
@@ -232,14 +302,39 @@ private:
     Ptr<QueueDisc> m_rootQueueDisc;       //!< the root queue disc on the device
     Ptr<NetDeviceQueueInterface> m_ndqi;  //!< the netdevice queue interface
     QueueDiscVector m_queueDiscsToWake;   //!< the vector of queue discs to wake
+    Ptr<QueueDisc> m_ingressQueueDisc;    //!< the ingress queue disc on the device
+    Ptr<TokenBucketPolicer> m_ingressPolicer;  //!< the ingress policer on the device
+    Ptr<LinkEstimator> m_linkEstimator;   //!< the link estimator of the device
   };
 
   /// Typedef for protocol handlers container
   typedef std::vector<struct ProtocolHandlerEntry> ProtocolHandlerList;
 
+  /**
+   * \brief Get the information stored for a device, creating it if needed
+   *
+   * \param device the device
+   * \return the information stored for the device
+   */
+  NetDeviceInfo& GetNetDeviceInfo (Ptr<NetDevice> device);
+
+  /**
+   * \brief Pass a received packet to the handlers registered for its protocol and device
+   *
+   * \param device network device
+   * \param p the packet
+   * \param protocol next header value
+   * \param from address of the correspondent
+   * \param to address of the destination
+   * \param packetType type of the packet
+   */
+  void ForwardUp (Ptr<NetDevice> device, Ptr<const Packet> p,
+                  uint16_t protocol, const Address &from,
+                  const Address &to, NetDevice::PacketType packetType);
+
   /**
    * \brief Required by the object map accessor
-   * \return the number of devices in the m_netDevices map
+   * \return the number of devices of the node
    */
   uint32_t GetNDevices (void) const;
   /**
@@ -251,8 +346,8 @@ private:
 
   /// The node this TrafficControlLayer object is aggregated to
   Ptr<Node> m_node;
-  /// Map storing the required information for each device with a queue disc installed
-  std::map<Ptr<NetDevice>, NetDeviceInfo> m_netDevices;
+  /// Information for each device, indexed by the index of the device in the node's device list
+  std::vector<NetDeviceInfo> m_netDevices;
   ProtocolHandlerList m_handlers;  //!< List of upper-layer handlers
 };
 
@@ -0,0 +1,417 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/cake-queue-disc.h"
+#include "ns3/queue.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/integer.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Cake Queue Disc Test Item
+ *
+ * The flow hash is the flow identifier, the host hashes are the source and
+ * destination identifiers and an item with a non-null acknowledgment number
+ * is a pure acknowledgment.
+ */
+class CakeQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param tos the DS field of the packet
+   * \param flow the flow identifier
+   * \param src the source identifier
+   * \param dst the destination identifier
+   * \param ack the acknowledgment number (0 if the packet is not an acknowledgment)
+   */
+  CakeQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint8_t tos, uint32_t flow,
+                         uint32_t src, uint32_t dst, uint32_t ack);
+  virtual ~CakeQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const;
+  virtual uint32_t Hash (uint32_t perturbation = 0) const;
+  virtual uint32_t HostHash (bool source, uint32_t perturbation = 0) const;
+  virtual bool IsRedundantAck (Ptr<const QueueDiscItem> ack) const;
+
+private:
+  CakeQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  CakeQueueDiscTestItem (const CakeQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  CakeQueueDiscTestItem &operator = (const CakeQueueDiscTestItem &);
+  uint8_t m_tos;    //!< DS field
+  uint32_t m_flow;  //!< flow identifier
+  uint32_t m_src;   //!< source identifier
+  uint32_t m_dst;   //!< destination identifier
+  uint32_t m_ack;   //!< acknowledgment number
+};
+
+CakeQueueDiscTestItem::CakeQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint8_t tos,
+                                              uint32_t flow, uint32_t src, uint32_t dst, uint32_t ack)
+  : QueueDiscItem (p, addr, 0),
+    m_tos (tos),
+    m_flow (flow),
+    m_src (src),
+    m_dst (dst),
+    m_ack (ack)
+{
+}
+
+CakeQueueDiscTestItem::~CakeQueueDiscTestItem ()
+{
+}
+
+void
+CakeQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+CakeQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+bool
+CakeQueueDiscTestItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const
+{
+  if (field == QueueItem::IP_DSFIELD)
+    {
+      value = m_tos;
+      return true;
+    }
+  return false;
+}
+
+uint32_t
+CakeQueueDiscTestItem::Hash (uint32_t perturbation) const
+{
+  return m_flow;
+}
+
+uint32_t
+CakeQueueDiscTestItem::HostHash (bool source, uint32_t perturbation) const
+{
+  return (source ? m_src : m_dst);
+}
+
+bool
+CakeQueueDiscTestItem::IsRedundantAck (Ptr<const QueueDiscItem> ack) const
+{
+  Ptr<const CakeQueueDiscTestItem> other = DynamicCast<const CakeQueueDiscTestItem> (ack);
+  return (other && m_ack > 0 && other->m_flow == m_flow && other->m_ack > m_ack);
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Cake Queue Disc Test Case
+ */
+class CakeQueueDiscTestCase : public TestCase
+{
+public:
+  CakeQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param size the size of the packets
+   * \param nPkt the number of packets
+   * \param tos the DS field of the packets
+   * \param flow the flow identifier
+   * \param src the source identifier
+   * \param dst the destination identifier
+   * \param ack the acknowledgment number
+   */
+  void Enqueue (Ptr<CakeQueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t tos,
+                uint32_t flow, uint32_t src, uint32_t dst, uint32_t ack = 0);
+  /**
+   * Check the classification of packets into tins
+   */
+  void RunTinTest (void);
+  /**
+   * Check that the shaper spaces packets by their transmission time
+   */
+  void RunShaperTest (void);
+  /**
+   * Check the share of the bandwidth obtained by hosts with different number of flows
+   * \param mode the flow mode
+   * \param ratio the expected ratio between the bytes sent by the two hosts
+   */
+  void RunHostFairnessTest (CakeQueueDisc::FlowMode mode, double ratio);
+  /**
+   * Check the ACK filter and the overlimit drops
+   */
+  void RunDropTest (void);
+  /**
+   * Check that a flow keeps its flow queue when an inactive queue precedes it in the set
+   */
+  void RunSetAssociativeHashTest (void);
+};
+
+CakeQueueDiscTestCase::CakeQueueDiscTestCase ()
+  : TestCase ("Sanity check on the cake queue disc implementation")
+{
+}
+
+void
+CakeQueueDiscTestCase::Enqueue (Ptr<CakeQueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t tos,
+                                uint32_t flow, uint32_t src, uint32_t dst, uint32_t ack)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<CakeQueueDiscTestItem> (Create<Packet> (size), dest, tos, flow, src, dst, ack));
+    }
+}
+
+void
+CakeQueueDiscTestCase::RunTinTest (void)
+{
+  Ptr<CakeQueueDisc> queue = CreateObjectWithAttributes<CakeQueueDisc> ("DiffServMode", EnumValue (CakeQueueDisc::DIFFSERV3));
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNTins (), 3, "There should be 3 tins");
+
+  Enqueue (queue, 500, 1, 0x00, 1, 1, 1);      // best effort
+  Enqueue (queue, 500, 1, 46 << 2, 2, 1, 1);   // EF
+  Enqueue (queue, 500, 1, 8 << 2, 3, 1, 1);    // CS1
+  Enqueue (queue, 500, 1, 34 << 2, 4, 1, 1);   // AF41
+
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 4, "There should be 4 flow queues");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (0))->GetTin (), 1, "Best effort packets go to tin 1");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (1))->GetTin (), 2, "EF packets go to tin 2");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (2))->GetTin (), 0, "CS1 packets go to tin 0");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (3))->GetTin (), 1, "AF41 packets go to tin 1");
+  queue->Dispose ();
+
+  queue = CreateObjectWithAttributes<CakeQueueDisc> ("DiffServMode", EnumValue (CakeQueueDisc::DIFFSERV4));
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNTins (), 4, "There should be 4 tins");
+
+  Enqueue (queue, 500, 1, 34 << 2, 1, 1, 1);   // AF41
+  Enqueue (queue, 500, 1, 32 << 2, 2, 1, 1);   // CS4
+  Enqueue (queue, 500, 1, 10 << 2, 3, 1, 1);   // AF11
+
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (0))->GetTin (), 2, "AF41 packets go to tin 2");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (1))->GetTin (), 3, "CS4 packets go to tin 3");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<CakeFlow> (queue->GetQueueDiscClass (2))->GetTin (), 1, "AF11 packets go to tin 1");
+  queue->Dispose ();
+
+  // packets of the same flow in different tins are stored in different flow queues
+  queue = CreateObjectWithAttributes<CakeQueueDisc> ("DiffServMode", EnumValue (CakeQueueDisc::BESTEFFORT));
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNTins (), 1, "There should be 1 tin");
+  Enqueue (queue, 500, 1, 46 << 2, 1, 1, 1);
+  Enqueue (queue, 500, 1, 8 << 2, 1, 1, 1);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 1, "There should be 1 flow queue");
+  queue->Dispose ();
+}
+
+void
+CakeQueueDiscTestCase::RunShaperTest (void)
+{
+  Ptr<CakeQueueDisc> queue = CreateObjectWithAttributes<CakeQueueDisc> ("Bandwidth", DataRateValue (DataRate ("1Mbps")),
+                                                                        "DiffServMode", EnumValue (CakeQueueDisc::BESTEFFORT),
+                                                                        "Overhead", IntegerValue (-60));
+  std::vector<Time> txTimes;
+  queue->SetSendCallback ([&txTimes] (Ptr<QueueDiscItem> item) { txTimes.push_back (Simulator::Now ()); });
+  queue->Initialize ();
+
+  // 1060 byte packets count as 1000 bytes, which take 8ms at 1Mbps
+  Enqueue (queue, 1060, 5, 0x00, 1, 1, 1);
+  Simulator::ScheduleNow (&QueueDisc::Run, queue);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (txTimes.size (), 5, "All the packets should have been sent");
+  for (uint32_t i = 0; i < txTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (txTimes[i], MilliSeconds (8 * i), "Packet " << i << " sent at the wrong time");
+    }
+
+  // the shaper does not accumulate credit while the queue disc is idle
+  txTimes.clear ();
+  Simulator::Stop (Seconds (1) - Simulator::Now ());
+  Simulator::Run ();
+  Enqueue (queue, 1060, 2, 0x00, 1, 1, 1);
+  Simulator::ScheduleNow (&QueueDisc::Run, queue);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (txTimes.size (), 2, "All the packets should have been sent");
+  NS_TEST_EXPECT_MSG_EQ (txTimes[0], Seconds (1), "The first packet should be sent immediately");
+  NS_TEST_EXPECT_MSG_EQ (txTimes[1], Seconds (1) + MilliSeconds (8), "The second packet should be delayed");
+
+  Simulator::Destroy ();
+}
+
+void
+CakeQueueDiscTestCase::RunHostFairnessTest (CakeQueueDisc::FlowMode mode, double ratio)
+{
+  Ptr<CakeQueueDisc> queue = CreateObjectWithAttributes<CakeQueueDisc> ("FlowMode", EnumValue (mode),
+                                                                        "DiffServMode", EnumValue (CakeQueueDisc::BESTEFFORT));
+  queue->Initialize ();
+
+  // host 1 has three flows, host 2 has one flow, each flow goes to a different destination
+  Enqueue (queue, 500, 800, 0x00, 1, 1, 11);
+  Enqueue (queue, 500, 800, 0x00, 2, 1, 12);
+  Enqueue (queue, 500, 800, 0x00, 3, 1, 13);
+  Enqueue (queue, 500, 800, 0x00, 4, 2, 14);
+
+  uint32_t bytes[2] = {0, 0};
+  for (uint32_t i = 0; i < 1200; i++)
+    {
+      Ptr<CakeQueueDiscTestItem> item = StaticCast<CakeQueueDiscTestItem> (queue->Dequeue ());
+      NS_TEST_ASSERT_MSG_NE (item, 0, "There should be a packet to dequeue");
+      bytes[item->HostHash (true) - 1] += item->GetSize ();
+    }
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (static_cast<double> (bytes[0]) / bytes[1], ratio, ratio * 0.05,
+                             "Unexpected share of the bandwidth");
+  queue->Dispose ();
+}
+
+void
+CakeQueueDiscTestCase::RunDropTest (void)
+{
+  Ptr<CakeQueueDisc> queue = CreateObjectWithAttributes<CakeQueueDisc> ("AckFilter", BooleanValue (true),
+                                                                        "MaxSize", QueueSizeValue (QueueSize ("5p")));
+  queue->Initialize ();
+
+  // the second and third acknowledgments make the previous ones redundant
+  Enqueue (queue, 40, 1, 0x00, 1, 1, 2, 1000);
+  Enqueue (queue, 40, 1, 0x00, 1, 1, 2, 2000);
+  Enqueue (queue, 40, 1, 0x00, 1, 1, 2, 3000);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 1, "Redundant acknowledgments should have been filtered");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (CakeQueueDisc::ACK_FILTER_DROP), 2,
+                         "There should be 2 acknowledgments dropped by the filter");
+
+  // an older acknowledgment and data packets do not make the queued acknowledgment redundant
+  Enqueue (queue, 40, 1, 0x00, 1, 1, 2, 500);
+  Enqueue (queue, 1000, 2, 0x00, 1, 1, 2);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 4, "No acknowledgment should have been filtered");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (CakeQueueDisc::ACK_FILTER_DROP), 2,
+                         "There should be 2 acknowledgments dropped by the filter");
+
+  // exceeding the limit drops a packet from the head of the fattest flow queue
+  Enqueue (queue, 100, 2, 0x00, 2, 1, 3);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 5, "The queue disc should be full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (CakeQueueDisc::OVERLIMIT_DROP), 1,
+                         "There should be 1 overlimit drop");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3,
+                         "The packet should have been dropped from the fattest flow queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), 2,
+                         "No packet should have been dropped from the other flow queue");
+  queue->Dispose ();
+
+  queue = CreateObjectWithAttributes<CakeQueueDisc> ("AckFilter", BooleanValue (true),
+                                                     "MaxSize", QueueSizeValue (QueueSize ("5p")));
+  queue->Initialize ();
+
+  // duplicate acknowledgments signal losses to the sender and are not filtered
+  Enqueue (queue, 40, 3, 0x00, 1, 1, 2, 1000);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 3, "Duplicate acknowledgments should not have been filtered");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (CakeQueueDisc::ACK_FILTER_DROP), 0,
+                         "There should be no acknowledgment dropped by the filter");
+
+  // a new acknowledgment makes the duplicate acknowledgments redundant, one
+  // of them is filtered per enqueued acknowledgment
+  Enqueue (queue, 40, 1, 0x00, 1, 1, 2, 2000);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 3, "A redundant acknowledgment should have been filtered");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (CakeQueueDisc::ACK_FILTER_DROP), 1,
+                         "There should be 1 acknowledgment dropped by the filter");
+  queue->Dispose ();
+}
+
+void
+CakeQueueDiscTestCase::RunSetAssociativeHashTest (void)
+{
+  Ptr<CakeQueueDisc> queue = CreateObjectWithAttributes<CakeQueueDisc> ("FlowMode", EnumValue (CakeQueueDisc::FLOWS),
+                                                                        "DiffServMode", EnumValue (CakeQueueDisc::BESTEFFORT),
+                                                                        "Flows", UintegerValue (16));
+  queue->Initialize ();
+
+  // flows 16 and 32 belong to the same set. The queue of the first flow
+  // becomes inactive while the second flow still has packets queued
+  Enqueue (queue, 500, 1, 0x00, 16, 1, 1);
+  Enqueue (queue, 500, 10, 0x00, 32, 1, 1);
+  Ptr<CakeFlow> first = StaticCast<CakeFlow> (queue->GetQueueDiscClass (0));
+  while (first->GetStatus () != FqCoDelFlow::INACTIVE)
+    {
+      NS_TEST_ASSERT_MSG_NE (queue->Dequeue (), 0, "There should be a packet to dequeue");
+    }
+
+  // a new packet of the second flow goes to its queue, not to the inactive one
+  Enqueue (queue, 500, 1, 0x00, 32, 1, 1);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 2, "There should be 2 flow queues");
+  NS_TEST_EXPECT_MSG_EQ (first->GetQueueDisc ()->GetNPackets (), 0,
+                         "The inactive flow queue should still be empty");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), queue->GetNPackets (),
+                         "All the packets of the second flow should be in the same flow queue");
+  queue->Dispose ();
+}
+
+void
+CakeQueueDiscTestCase::DoRun (void)
+{
+  RunTinTest ();
+  RunShaperTest ();
+  RunHostFairnessTest (CakeQueueDisc::FLOWS, 3.0);
+  RunHostFairnessTest (CakeQueueDisc::DUAL_SRC, 1.0);
+  RunHostFairnessTest (CakeQueueDisc::TRIPLE_ISOLATE, 1.0);
+  RunDropTest ();
+  RunSetAssociativeHashTest ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Cake Queue Disc Test Suite
+ */
+static class CakeQueueDiscTestSuite : public TestSuite
+{
+public:
+  CakeQueueDiscTestSuite ()
+    : TestSuite ("cake-queue-disc", UNIT)
+  {
+    AddTestCase (new CakeQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_cakeQueueDiscTestSuite; ///< the test suite
@@ -0,0 +1,351 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/dual-pi2-queue-disc.h"
+#include "ns3/queue.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief DualPI2 Queue Disc Test Item
+ */
+class DualPi2QueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param ecn the ECN codepoint of the packet
+   */
+  DualPi2QueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint8_t ecn);
+  virtual ~DualPi2QueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const;
+
+private:
+  DualPi2QueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  DualPi2QueueDiscTestItem (const DualPi2QueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  DualPi2QueueDiscTestItem &operator = (const DualPi2QueueDiscTestItem &);
+  uint8_t m_ecn; //!< ECN codepoint
+};
+
+DualPi2QueueDiscTestItem::DualPi2QueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint8_t ecn)
+  : QueueDiscItem (p, addr, 0),
+    m_ecn (ecn)
+{
+}
+
+DualPi2QueueDiscTestItem::~DualPi2QueueDiscTestItem ()
+{
+}
+
+void
+DualPi2QueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+DualPi2QueueDiscTestItem::Mark (void)
+{
+  if (m_ecn != 0)
+    {
+      m_ecn = 3;
+      return true;
+    }
+  return false;
+}
+
+bool
+DualPi2QueueDiscTestItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t &value) const
+{
+  if (field == QueueItem::IP_DSFIELD)
+    {
+      value = m_ecn;
+      return true;
+    }
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief DualPI2 Queue Disc Test Case
+ */
+class DualPi2QueueDiscTestCase : public TestCase
+{
+public:
+  DualPi2QueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   * \param ecn the ECN codepoint of the packets
+   */
+  void Enqueue (Ptr<DualPi2QueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn);
+  /**
+   * Enqueue with delay function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   * \param ecn the ECN codepoint of the packets
+   */
+  void EnqueueWithDelay (Ptr<DualPi2QueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn);
+  /**
+   * Dequeue function
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Dequeue (Ptr<DualPi2QueueDisc> queue, uint32_t nPkt);
+  /**
+   * Dequeue with delay function
+   * \param queue the queue disc
+   * \param delay the delay
+   * \param nPkt the number of packets
+   */
+  void DequeueWithDelay (Ptr<DualPi2QueueDisc> queue, double delay, uint32_t nPkt);
+  /**
+   * Run test function
+   * \param mode the test mode
+   */
+  void RunDualPi2Test (QueueSizeUnit mode);
+};
+
+DualPi2QueueDiscTestCase::DualPi2QueueDiscTestCase ()
+  : TestCase ("Sanity check on the DualPI2 queue disc implementation")
+{
+}
+
+void
+DualPi2QueueDiscTestCase::RunDualPi2Test (QueueSizeUnit mode)
+{
+  uint32_t pktSize = 0;
+
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = 1;
+
+  uint32_t qSize = 300;
+  Ptr<DualPi2QueueDisc> queue = CreateObject<DualPi2QueueDisc> ();
+
+
+  // test 1: simple enqueue/dequeue with defaults, no drops, L4S packets served first
+  Address dest;
+
+  if (mode == QueueSizeUnit::BYTES)
+    {
+      pktSize = 1000;
+      modeSize = pktSize;
+      qSize = qSize * modeSize;
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+
+  Ptr<Packet> p1, p2, p3, p4;
+  p1 = Create<Packet> (pktSize);
+  p2 = Create<Packet> (pktSize);
+  p3 = Create<Packet> (pktSize);
+  p4 = Create<Packet> (pktSize);
+
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 0 * modeSize, "There should be no packets in there");
+  queue->Enqueue (Create<DualPi2QueueDiscTestItem> (p1, dest, 0));
+  queue->Enqueue (Create<DualPi2QueueDiscTestItem> (p2, dest, 2));
+  queue->Enqueue (Create<DualPi2QueueDiscTestItem> (p3, dest, 1));
+  queue->Enqueue (Create<DualPi2QueueDiscTestItem> (p4, dest, 3));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 4 * modeSize, "There should be four packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueue (0)->GetNPackets (), 2, "Not-ECT and ECT(0) packets go to the classic queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetInternalQueue (1)->GetNPackets (), 2, "ECT(1) and CE packets go to the L4S queue");
+
+  Ptr<QueueDiscItem> item;
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the first packet");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p3->GetUid (), "Was this the first L4S packet ?");
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the second packet");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p4->GetUid (), "Was this the second L4S packet ?");
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the third packet");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p1->GetUid (), "Was this the first classic packet ?");
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the fourth packet");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p2->GetUid (), "Was this the second classic packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
+  QueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no drops");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalMarkedPackets, 0, "There should be no marks");
+
+
+  // test 2: more classic data, unforced drops but no forced drops
+  queue = CreateObject<DualPi2QueueDisc> ();
+  pktSize = 1000;
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 0);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test2 = st.GetNDroppedPackets (DualPi2QueueDisc::UNFORCED_CLASSIC_DROP);
+  NS_TEST_EXPECT_MSG_NE (test2, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (DualPi2QueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalMarkedPackets, 0, "Not-ECT packets cannot be marked");
+
+
+  // test 3: same as test 2, but classic packets are ECN capable
+  queue = CreateObject<DualPi2QueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 2);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (st.GetNMarkedPackets (DualPi2QueueDisc::UNFORCED_CLASSIC_MARK), 0, "There should be some unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (DualPi2QueueDisc::UNFORCED_CLASSIC_DROP), 0, "There should be zero unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (DualPi2QueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 4: same as test 2, but with L4S packets, which are marked as soon as
+  // their sojourn time exceeds the step threshold
+  queue = CreateObject<DualPi2QueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 1);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test4 = st.GetNMarkedPackets (DualPi2QueueDisc::UNFORCED_L4S_MARK);
+  NS_TEST_EXPECT_MSG_GT (test4, test2, "L4S packets should be marked more often than classic packets are dropped");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be zero drops");
+
+
+  // test 5: classic and L4S traffic, the step threshold is disabled so that
+  // L4S packets are only marked with the coupled probability
+  queue = CreateObject<DualPi2QueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("L4sMarkThreshold", TimeValue (Seconds (10))),
+                         true, "Verify that we can actually set the attribute L4sMarkThreshold");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 0);
+  EnqueueWithDelay (queue, pktSize, 400, 1);
+  DequeueWithDelay (queue, 0.006, 800);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t classicDrops = st.GetNDroppedPackets (DualPi2QueueDisc::UNFORCED_CLASSIC_DROP);
+  uint32_t l4sMarks = st.GetNMarkedPackets (DualPi2QueueDisc::UNFORCED_L4S_MARK);
+  NS_TEST_EXPECT_MSG_NE (classicDrops, 0, "There should be some unforced drops of classic packets");
+  NS_TEST_EXPECT_MSG_GT (l4sMarks, classicDrops, "The coupled probability should exceed the classic probability");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (DualPi2QueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+}
+
+void
+DualPi2QueueDiscTestCase::Enqueue (Ptr<DualPi2QueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<DualPi2QueueDiscTestItem> (Create<Packet> (size), dest, ecn));
+    }
+}
+
+void
+DualPi2QueueDiscTestCase::EnqueueWithDelay (Ptr<DualPi2QueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn)
+{
+  double delay = 0.01;  // enqueue packets with delay
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &DualPi2QueueDiscTestCase::Enqueue, this, queue, size, 1, ecn);
+    }
+}
+
+void
+DualPi2QueueDiscTestCase::Dequeue (Ptr<DualPi2QueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+    }
+}
+
+void
+DualPi2QueueDiscTestCase::DequeueWithDelay (Ptr<DualPi2QueueDisc> queue, double delay, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &DualPi2QueueDiscTestCase::Dequeue, this, queue, 1);
+    }
+}
+
+void
+DualPi2QueueDiscTestCase::DoRun (void)
+{
+  RunDualPi2Test (QueueSizeUnit::PACKETS);
+  RunDualPi2Test (QueueSizeUnit::BYTES);
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief DualPI2 Queue Disc Test Suite
+ */
+static class DualPi2QueueDiscTestSuite : public TestSuite
+{
+public:
+  DualPi2QueueDiscTestSuite ()
+    : TestSuite ("dual-pi2-queue-disc", UNIT)
+  {
+    AddTestCase (new DualPi2QueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_dualPi2QueueTestSuite; ///< the test suite
@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/fq-pie-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief FqPie Queue Disc Test Item
+ *
+ * The flow hash is the flow identifier.
+ */
+class FqPieQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param flow the flow identifier
+   */
+  FqPieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint32_t flow);
+  virtual ~FqPieQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual uint32_t Hash (uint32_t perturbation = 0) const;
+
+private:
+  FqPieQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  FqPieQueueDiscTestItem (const FqPieQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  FqPieQueueDiscTestItem &operator = (const FqPieQueueDiscTestItem &);
+  uint32_t m_flow;  //!< flow identifier
+};
+
+FqPieQueueDiscTestItem::FqPieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint32_t flow)
+  : QueueDiscItem (p, addr, 0),
+    m_flow (flow)
+{
+}
+
+FqPieQueueDiscTestItem::~FqPieQueueDiscTestItem ()
+{
+}
+
+void
+FqPieQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+FqPieQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+uint32_t
+FqPieQueueDiscTestItem::Hash (uint32_t perturbation) const
+{
+  return m_flow;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief FqPie Queue Disc Test Case
+ */
+class FqPieQueueDiscTestCase : public TestCase
+{
+public:
+  FqPieQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue a packet
+   * \param queue the queue disc
+   * \param flow the flow identifier
+   */
+  void Enqueue (Ptr<FqPieQueueDisc> queue, uint32_t flow);
+  /**
+   * Enqueue packets periodically
+   * \param queue the queue disc
+   * \param flow the flow identifier
+   * \param interval the time between two packets
+   * \param nPkt the number of packets
+   */
+  void EnqueueWithDelay (Ptr<FqPieQueueDisc> queue, uint32_t flow, Time interval, uint32_t nPkt);
+  /**
+   * Dequeue packets periodically
+   * \param queue the queue disc
+   * \param interval the time between two packets
+   * \param nPkt the number of packets
+   */
+  void DequeueWithDelay (Ptr<FqPieQueueDisc> queue, Time interval, uint32_t nPkt);
+  /**
+   * Count the packets dropped before enqueue for each flow
+   * \param item the dropped item
+   * \param reason the reason why the item was dropped
+   */
+  void DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason);
+  /**
+   * Check that the queue disc drops packets when it is full
+   */
+  void RunLimitTest (void);
+  /**
+   * Check that a light flow is isolated from an unresponsive flow
+   * \param controller the controller of the flow queues
+   * \param useFixedPoint whether PIE uses the fixed-point arithmetic
+   */
+  void RunIsolationTest (FqPieQueueDisc::ControllerType controller, bool useFixedPoint);
+  /**
+   * Check that a flow keeps its flow queue when an inactive queue precedes it in the set
+   */
+  void RunSetAssociativeHashTest (void);
+
+  uint32_t m_drops[2];  //!< Number of packets dropped before enqueue for each flow
+};
+
+FqPieQueueDiscTestCase::FqPieQueueDiscTestCase ()
+  : TestCase ("Sanity check on the FqPie queue disc implementation")
+{
+}
+
+void
+FqPieQueueDiscTestCase::Enqueue (Ptr<FqPieQueueDisc> queue, uint32_t flow)
+{
+  Address dest;
+  queue->Enqueue (Create<FqPieQueueDiscTestItem> (Create<Packet> (1000), dest, flow));
+}
+
+void
+FqPieQueueDiscTestCase::EnqueueWithDelay (Ptr<FqPieQueueDisc> queue, uint32_t flow, Time interval, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (interval * i, &FqPieQueueDiscTestCase::Enqueue, this, queue, flow);
+    }
+}
+
+void
+FqPieQueueDiscTestCase::DequeueWithDelay (Ptr<FqPieQueueDisc> queue, Time interval, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (interval * i + MicroSeconds (500), &QueueDisc::Dequeue, queue);
+    }
+}
+
+void
+FqPieQueueDiscTestCase::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
+{
+  m_drops[item->Hash ()]++;
+}
+
+void
+FqPieQueueDiscTestCase::RunLimitTest (void)
+{
+  Ptr<FqPieQueueDisc> queue = CreateObject<FqPieQueueDisc> ();
+  queue->SetAttribute ("MaxSize", QueueSizeValue (QueueSize ("10p")));
+  queue->SetQuantum (1000);
+  queue->Initialize ();
+
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      Enqueue (queue, i % 2);
+    }
+
+  QueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 10, "There should be ten packets in the queue disc");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 2, "There should be two flow queues");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (FqPieQueueDisc::OVERLIMIT_DROP), 2,
+                         "The packets exceeding the limit should be dropped");
+
+  // the flow queues are served in round robin
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (item->Hash (), i % 2, "Unexpected flow of the dequeued packet");
+    }
+  NS_TEST_EXPECT_MSG_EQ ((queue->Dequeue () == 0), true, "There should be no packets left");
+
+  queue->Dispose ();
+}
+
+void
+FqPieQueueDiscTestCase::RunIsolationTest (FqPieQueueDisc::ControllerType controller, bool useFixedPoint)
+{
+  // An unresponsive flow (0) sends at twice the dequeue rate, while a light
+  // flow (1) sends one packet every 20 ms
+  Ptr<FqPieQueueDisc> queue = CreateObject<FqPieQueueDisc> ();
+  queue->SetAttribute ("Controller", EnumValue (controller));
+  queue->SetAttribute ("UseFixedPoint", BooleanValue (useFixedPoint));
+  queue->SetAttribute ("MaxSize", QueueSizeValue (QueueSize ("1000p")));
+  queue->SetQuantum (1000);
+  queue->TraceConnectWithoutContext ("DropBeforeEnqueue",
+                                     MakeCallback (&FqPieQueueDiscTestCase::DropBeforeEnqueue, this));
+  queue->Initialize ();
+  m_drops[0] = m_drops[1] = 0;
+
+  EnqueueWithDelay (queue, 0, MilliSeconds (1), 5000);
+  EnqueueWithDelay (queue, 1, MilliSeconds (20), 250);
+  DequeueWithDelay (queue, MilliSeconds (2), 2500);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  QueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (FqPieQueueDisc::OVERLIMIT_DROP), 0, "There should be no overlimit drops");
+  NS_TEST_EXPECT_MSG_GT (m_drops[0], 0, "The unresponsive flow should experience drops");
+  NS_TEST_EXPECT_MSG_EQ (m_drops[1], 0, "The light flow should experience no drops");
+
+  // The light flow is served as a new flow, after at most one packet of the
+  // unresponsive flow
+  Ptr<QueueDisc> light = queue->GetQueueDiscClass (1)->GetQueueDisc ();
+  NS_TEST_EXPECT_MSG_EQ (light->GetStats ().sojournTime.GetCount (), 250, "All the packets of the light flow should be dequeued");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (light->GetStats ().sojournTime.GetMax (),
+                               static_cast<uint64_t> (MilliSeconds (4).GetNanoSeconds ()),
+                               "The light flow should not be delayed by the unresponsive flow");
+
+  queue->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+FqPieQueueDiscTestCase::RunSetAssociativeHashTest (void)
+{
+  Ptr<FqPieQueueDisc> queue = CreateObjectWithAttributes<FqPieQueueDisc> ("EnableSetAssociativeHash", BooleanValue (true),
+                                                                          "Flows", UintegerValue (16),
+                                                                          "MaxSize", QueueSizeValue (QueueSize ("100p")));
+  queue->SetQuantum (1000);
+  queue->Initialize ();
+
+  // flows 16 and 32 belong to the same set. The queue of the first flow
+  // becomes inactive while the second flow still has packets queued
+  Enqueue (queue, 16);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Enqueue (queue, 32);
+    }
+  Ptr<FqCoDelFlow> first = StaticCast<FqCoDelFlow> (queue->GetQueueDiscClass (0));
+  while (first->GetStatus () != FqCoDelFlow::INACTIVE)
+    {
+      NS_TEST_ASSERT_MSG_NE (queue->Dequeue (), 0, "There should be a packet to dequeue");
+    }
+
+  // a new packet of the second flow goes to its queue, not to the inactive one
+  Enqueue (queue, 32);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 2, "There should be two flow queues");
+  NS_TEST_EXPECT_MSG_EQ (first->GetQueueDisc ()->GetNPackets (), 0,
+                         "The inactive flow queue should still be empty");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (1)->GetQueueDisc ()->GetNPackets (), queue->GetNPackets (),
+                         "All the packets of the second flow should be in the same flow queue");
+
+  queue->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+FqPieQueueDiscTestCase::DoRun (void)
+{
+  RunLimitTest ();
+  RunIsolationTest (FqPieQueueDisc::PIE, false);
+  RunIsolationTest (FqPieQueueDisc::PIE, true);
+  RunIsolationTest (FqPieQueueDisc::SELF_TUNING_PI, false);
+  RunSetAssociativeHashTest ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief FqPie Queue Disc Test Suite
+ */
+static class FqPieQueueDiscTestSuite : public TestSuite
+{
+public:
+  FqPieQueueDiscTestSuite ()
+    : TestSuite ("fq-pie-queue-disc", UNIT)
+  {
+    AddTestCase (new FqPieQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_fqPieQueueDiscTestSuite; ///< the test suite
@@ -0,0 +1,362 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/htb-queue-disc.h"
+#include "ns3/fifo-queue-disc.h"
+#include "ns3/packet-filter.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Item
+ */
+class HtbQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param leaf the index of the leaf class of the packet
+   */
+  HtbQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint32_t leaf);
+  virtual ~HtbQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  /**
+   * Get the index of the leaf class of the packet
+   * \return the index of the leaf class
+   */
+  uint32_t GetLeaf (void) const;
+
+private:
+  HtbQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  HtbQueueDiscTestItem (const HtbQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  HtbQueueDiscTestItem &operator = (const HtbQueueDiscTestItem &);
+  uint32_t m_leaf;  //!< index of the leaf class
+};
+
+HtbQueueDiscTestItem::HtbQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint32_t leaf)
+  : QueueDiscItem (p, addr, 0),
+    m_leaf (leaf)
+{
+}
+
+HtbQueueDiscTestItem::~HtbQueueDiscTestItem ()
+{
+}
+
+void
+HtbQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+HtbQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+uint32_t
+HtbQueueDiscTestItem::GetLeaf (void) const
+{
+  return m_leaf;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Packet Filter
+ *
+ * Returns the leaf class stored in the test items.
+ */
+class HtbQueueDiscTestFilter : public PacketFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const;
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+};
+
+TypeId
+HtbQueueDiscTestFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HtbQueueDiscTestFilter")
+    .SetParent<PacketFilter> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<HtbQueueDiscTestFilter> ()
+  ;
+  return tid;
+}
+
+bool
+HtbQueueDiscTestFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
+{
+  return true;
+}
+
+int32_t
+HtbQueueDiscTestFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  return StaticCast<HtbQueueDiscTestItem> (item)->GetLeaf ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Case
+ *
+ * Leaf classes are children of a 10Mbps inner class and are backlogged with
+ * 1000 byte packets. The bytes sent by each leaf class in one second are
+ * compared with the expected share of the 10Mbps.
+ */
+class HtbQueueDiscTestCase : public TestCase
+{
+public:
+  HtbQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Create a leaf class with a FIFO child queue disc
+   * \param rate the rate of the class
+   * \param ceil the ceil rate of the class
+   * \param prio the priority of the class
+   * \param parent the parent inner class
+   * \return the leaf class
+   */
+  Ptr<HtbClass> CreateLeaf (std::string rate, std::string ceil, uint8_t prio, uint32_t parent);
+  /**
+   * Send packets for one second and check the bytes sent by each leaf class
+   * \param queue the queue disc
+   * \param nPkts the number of packets enqueued in each leaf class
+   * \param expected the expected number of bytes sent by each leaf class
+   * \param tol the tolerance, relative to the expected number of bytes
+   * \param test the description of the test
+   */
+  void CheckShares (Ptr<HtbQueueDisc> queue, std::vector<uint32_t> nPkts,
+                    std::vector<double> expected, double tol, std::string test);
+  /**
+   * Check the sharing of the bandwidth among leaf classes
+   */
+  void RunShareTest (void);
+  /**
+   * Check a hierarchy of classes with many leaf classes
+   */
+  void RunHierarchyTest (void);
+  /**
+   * Check that leaf classes can use AQM queue discs
+   */
+  void RunAqmLeafTest (void);
+};
+
+HtbQueueDiscTestCase::HtbQueueDiscTestCase ()
+  : TestCase ("Sanity check on the htb queue disc implementation")
+{
+}
+
+Ptr<HtbClass>
+HtbQueueDiscTestCase::CreateLeaf (std::string rate, std::string ceil, uint8_t prio, uint32_t parent)
+{
+  Ptr<HtbClass> c = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate (rate)),
+                                                          "Ceil", DataRateValue (DataRate (ceil)),
+                                                          "Priority", UintegerValue (prio),
+                                                          "Parent", UintegerValue (parent));
+  c->SetQueueDisc (CreateObjectWithAttributes<FifoQueueDisc> ("MaxSize", QueueSizeValue (QueueSize ("10000p"))));
+  return c;
+}
+
+void
+HtbQueueDiscTestCase::CheckShares (Ptr<HtbQueueDisc> queue, std::vector<uint32_t> nPkts,
+                                   std::vector<double> expected, double tol, std::string test)
+{
+  std::vector<uint32_t> bytes (nPkts.size (), 0);
+  queue->SetSendCallback ([&bytes] (Ptr<QueueDiscItem> item)
+                          { bytes[StaticCast<HtbQueueDiscTestItem> (item)->GetLeaf ()] += item->GetSize (); });
+  queue->AddPacketFilter (CreateObject<HtbQueueDiscTestFilter> ());
+  // packets are sent as soon as HTB allows, hence do not stop a run early
+  queue->SetQuota (100000);
+  queue->Initialize ();
+
+  Address dest;
+  for (uint32_t leaf = 0; leaf < nPkts.size (); leaf++)
+    {
+      for (uint32_t i = 0; i < nPkts[leaf]; i++)
+        {
+          queue->Enqueue (Create<HtbQueueDiscTestItem> (Create<Packet> (1000), dest, leaf));
+        }
+    }
+
+  Simulator::ScheduleNow (&QueueDisc::Run, queue);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  for (uint32_t leaf = 0; leaf < nPkts.size (); leaf++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (bytes[leaf], expected[leaf], expected[leaf] * tol + 1,
+                                 test << ": unexpected bytes sent by class " << leaf);
+    }
+
+  queue->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+HtbQueueDiscTestCase::RunShareTest (void)
+{
+  Ptr<HtbQueueDisc> queue;
+  Ptr<HtbClass> root;
+
+  // a single backlogged class borrows all the bandwidth of its parent
+  queue = CreateObject<HtbQueueDisc> ();
+  root = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("10Mbps")));
+  uint32_t rootId = queue->AddInnerClass (root);
+  NS_TEST_EXPECT_MSG_EQ (rootId, 1, "The first inner class should have identifier 1");
+  Ptr<HtbClass> leaf = CreateLeaf ("2Mbps", "10Mbps", 0, rootId);
+  queue->AddQueueDiscClass (leaf);
+  queue->AddQueueDiscClass (CreateLeaf ("8Mbps", "10Mbps", 0, rootId));
+  CheckShares (queue, {2000, 0}, {1250000, 0}, 0.02, "Borrowing");
+  NS_TEST_EXPECT_MSG_GT (leaf->GetNBorrows (), 0, "The class should have borrowed from its parent");
+
+  // backlogged classes get their rate
+  queue = CreateObject<HtbQueueDisc> ();
+  root = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("10Mbps")));
+  rootId = queue->AddInnerClass (root);
+  queue->AddQueueDiscClass (CreateLeaf ("2Mbps", "10Mbps", 0, rootId));
+  queue->AddQueueDiscClass (CreateLeaf ("8Mbps", "10Mbps", 0, rootId));
+  CheckShares (queue, {2000, 2000}, {250000, 1000000}, 0.02, "Rates");
+
+  // the excess bandwidth is shared equally among classes with the same
+  // quantum, but no class exceeds its ceil rate. The quantum is set to a
+  // packet, so that a class does not lose its turn when it reaches the ceil
+  queue = CreateObject<HtbQueueDisc> ();
+  root = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("10Mbps")));
+  rootId = queue->AddInnerClass (root);
+  leaf = CreateLeaf ("2Mbps", "4Mbps", 0, rootId);
+  leaf->SetAttribute ("Quantum", UintegerValue (1000));
+  queue->AddQueueDiscClass (leaf);
+  leaf = CreateLeaf ("2Mbps", "10Mbps", 0, rootId);
+  leaf->SetAttribute ("Quantum", UintegerValue (1000));
+  queue->AddQueueDiscClass (leaf);
+  CheckShares (queue, {2000, 2000}, {500000, 750000}, 0.02, "Ceil rates");
+
+  // the excess bandwidth is given to the classes with the highest priority
+  queue = CreateObject<HtbQueueDisc> ();
+  root = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("10Mbps")));
+  rootId = queue->AddInnerClass (root);
+  queue->AddQueueDiscClass (CreateLeaf ("1Mbps", "10Mbps", 1, rootId));
+  queue->AddQueueDiscClass (CreateLeaf ("1Mbps", "10Mbps", 0, rootId));
+  CheckShares (queue, {2000, 2000}, {125000, 1125000}, 0.03, "Priorities");
+}
+
+void
+HtbQueueDiscTestCase::RunHierarchyTest (void)
+{
+  // two subscribers of 4Mbps and 6Mbps, with 20 and 30 leaf classes each
+  Ptr<HtbQueueDisc> queue = CreateObject<HtbQueueDisc> ();
+  uint32_t rootId = queue->AddInnerClass (CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("10Mbps"))));
+  uint32_t sub1 = queue->AddInnerClass (CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("4Mbps")),
+                                                                              "Ceil", DataRateValue (DataRate ("10Mbps")),
+                                                                              "Parent", UintegerValue (rootId)));
+  uint32_t sub2 = queue->AddInnerClass (CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("6Mbps")),
+                                                                              "Ceil", DataRateValue (DataRate ("10Mbps")),
+                                                                              "Parent", UintegerValue (rootId)));
+  std::vector<uint32_t> nPkts;
+  std::vector<double> expected;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      queue->AddQueueDiscClass (CreateLeaf ("10kbps", "10Mbps", 0, (i < 20 ? sub1 : sub2)));
+      nPkts.push_back (100);
+      // each subscriber gets its rate, shared equally by its backlogged
+      // leaf classes. The last leaf class is not backlogged
+      expected.push_back (i < 20 ? 500000.0 / 20 : 750000.0 / 29);
+    }
+  nPkts.back () = 0;
+  expected.back () = 0;
+  CheckShares (queue, nPkts, expected, 0.1, "Hierarchy");
+}
+
+void
+HtbQueueDiscTestCase::RunAqmLeafTest (void)
+{
+  Ptr<HtbQueueDisc> queue = CreateObject<HtbQueueDisc> ();
+  uint32_t rootId = queue->AddInnerClass (CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("10Mbps"))));
+
+  std::vector<std::string> types = {"ns3::PieQueueDisc", "ns3::CoDelQueueDisc", "ns3::SelfTuningPiQueueDisc"};
+  for (uint32_t i = 0; i < types.size (); i++)
+    {
+      ObjectFactory factory (types[i]);
+      Ptr<HtbClass> c = CreateObjectWithAttributes<HtbClass> ("Rate", DataRateValue (DataRate ("3Mbps")),
+                                                              "Ceil", DataRateValue (DataRate ("10Mbps")),
+                                                              "Parent", UintegerValue (rootId));
+      c->SetQueueDisc (factory.Create<QueueDisc> ());
+      queue->AddQueueDiscClass (c);
+    }
+
+  // 30 packets take 24ms at 10Mbps, hence no AQM drops any packet
+  CheckShares (queue, {10, 10, 10}, {10000, 10000, 10000}, 0.001, "AQM leaves");
+}
+
+void
+HtbQueueDiscTestCase::DoRun (void)
+{
+  RunShareTest ();
+  RunHierarchyTest ();
+  RunAqmLeafTest ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Htb Queue Disc Test Suite
+ */
+static class HtbQueueDiscTestSuite : public TestSuite
+{
+public:
+  HtbQueueDiscTestSuite ()
+    : TestSuite ("htb-queue-disc", UNIT)
+  {
+    AddTestCase (new HtbQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_htbQueueDiscTestSuite; ///< the test suite
@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/pi-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief PI Queue Disc Test Item
+ */
+class PiQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   */
+  PiQueueDiscTestItem (Ptr<Packet> p, const Address & addr);
+  virtual ~PiQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  PiQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  PiQueueDiscTestItem (const PiQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  PiQueueDiscTestItem &operator = (const PiQueueDiscTestItem &);
+};
+
+PiQueueDiscTestItem::PiQueueDiscTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0)
+{
+}
+
+PiQueueDiscTestItem::~PiQueueDiscTestItem ()
+{
+}
+
+void
+PiQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+PiQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief PI Queue Disc Test Case
+ */
+class PiQueueDiscTestCase : public TestCase
+{
+public:
+  PiQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   */
+  void Enqueue (Ptr<PiQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  /**
+   * Enqueue with delay function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   */
+  void EnqueueWithDelay (Ptr<PiQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  /**
+   * Dequeue function
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Dequeue (Ptr<PiQueueDisc> queue, uint32_t nPkt);
+  /**
+   * Dequeue with delay function
+   * \param queue the queue disc
+   * \param delay the delay
+   * \param nPkt the number of packets
+   */
+  void DequeueWithDelay (Ptr<PiQueueDisc> queue, double delay, uint32_t nPkt);
+  /**
+   * Run test function
+   * \param mode the test mode
+   */
+  void RunPiTest (QueueSizeUnit mode);
+};
+
+PiQueueDiscTestCase::PiQueueDiscTestCase ()
+  : TestCase ("Sanity check on the PI queue disc implementation")
+{
+}
+
+void
+PiQueueDiscTestCase::RunPiTest (QueueSizeUnit mode)
+{
+  uint32_t pktSize = 0;
+
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = 1;
+
+  uint32_t qSize = 300;
+  Ptr<PiQueueDisc> queue = CreateObject<PiQueueDisc> ();
+
+
+  // test 1: simple enqueue/dequeue with defaults, no drops
+  Address dest;
+
+  if (mode == QueueSizeUnit::BYTES)
+    {
+      // pktSize should be same as MeanPktSize to avoid performance gap between byte and packet mode
+      pktSize = 1000;
+      modeSize = pktSize;
+      qSize = qSize * modeSize;
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+
+  Ptr<Packet> p1, p2, p3, p4, p5, p6, p7, p8;
+  p1 = Create<Packet> (pktSize);
+  p2 = Create<Packet> (pktSize);
+  p3 = Create<Packet> (pktSize);
+  p4 = Create<Packet> (pktSize);
+  p5 = Create<Packet> (pktSize);
+  p6 = Create<Packet> (pktSize);
+  p7 = Create<Packet> (pktSize);
+  p8 = Create<Packet> (pktSize);
+
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 0 * modeSize, "There should be no packets in there");
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p1, dest));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 1 * modeSize, "There should be one packet in there");
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p2, dest));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 2 * modeSize, "There should be two packets in there");
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p3, dest));
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p4, dest));
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p5, dest));
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p6, dest));
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p7, dest));
+  queue->Enqueue (Create<PiQueueDiscTestItem> (p8, dest));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 8 * modeSize, "There should be eight packets in there");
+
+  Ptr<QueueDiscItem> item;
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the first packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 7 * modeSize, "There should be seven packets in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p1->GetUid (), "was this the first packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the second packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 6 * modeSize, "There should be six packet in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p2->GetUid (), "Was this the second packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the third packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 5 * modeSize, "There should be five packets in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p3->GetUid (), "Was this the third packet ?");
+
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
+
+
+  // test 2: more data, unforced drops but no forced drops
+  queue = CreateObject<PiQueueDisc> ();
+  pktSize = 1000;
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueRef", QueueSizeValue (QueueSize (mode, 20 * modeSize))),
+                         true, "Verify that we can actually set the attribute QueueRef");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.00125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (0.00124)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("W", DoubleValue (170)), true,
+                         "Verify that we can actually set the attribute W");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  QueueDisc::Stats st = queue->GetStats ();
+  uint32_t test2 = st.GetNDroppedPackets (PiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_NE (test2, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 3: same as test 2, but with higher QueueRef
+  queue = CreateObject<PiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueRef", QueueSizeValue (QueueSize (mode, 40 * modeSize))),
+                         true, "Verify that we can actually set the attribute QueueRef");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.00125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (0.00124)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("W", DoubleValue (170)), true,
+                         "Verify that we can actually set the attribute W");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test3 = st.GetNDroppedPackets (PiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_LT (test3, test2, "Test 3 should have less unforced drops than test 2");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 4: same as test 2, but with reduced dequeue rate
+  queue = CreateObject<PiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueRef", QueueSizeValue (QueueSize (mode, 20 * modeSize))),
+                         true, "Verify that we can actually set the attribute QueueRef");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.00125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (0.00124)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("W", DoubleValue (170)), true,
+                         "Verify that we can actually set the attribute W");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400);
+  DequeueWithDelay (queue, 0.015, 400); // delay between two successive dequeue events is increased
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test4 = st.GetNDroppedPackets (PiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_GT (test4, test2, "Test 4 should have more unforced drops than test 2");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 5: same as test 2, but with higher sampling frequency
+  queue = CreateObject<PiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueRef", QueueSizeValue (QueueSize (mode, 20 * modeSize))),
+                         true, "Verify that we can actually set the attribute QueueRef");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.00125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (0.00124)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("W", DoubleValue (1000)), true,
+                         "Verify that we can actually set the attribute W");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test5 = st.GetNDroppedPackets (PiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_GT (test5, test2, "Test 5 should have more unforced drops than test 2");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 6: same as test 2, but controlling the sojourn time of the head packet
+  // with a reference delay of 20 packets at the dequeue rate
+  queue = CreateObject<PiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueRef", QueueSizeValue (QueueSize (mode, 20 * modeSize))),
+                         true, "Verify that we can actually set the attribute QueueRef");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.00125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (0.00124)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("W", DoubleValue (170)), true,
+                         "Verify that we can actually set the attribute W");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseTimestamp", BooleanValue (true)), true,
+                         "Verify that we can actually set the attribute UseTimestamp");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueDelayReference", TimeValue (Seconds (0.24))), true,
+                         "Verify that we can actually set the attribute QueueDelayReference");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test6 = st.GetNDroppedPackets (PiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_NE (test6, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 7: same as test 6, but with higher QueueDelayReference
+  queue = CreateObject<PiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueRef", QueueSizeValue (QueueSize (mode, 20 * modeSize))),
+                         true, "Verify that we can actually set the attribute QueueRef");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("A", DoubleValue (0.00125)), true,
+                         "Verify that we can actually set the attribute A");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("B", DoubleValue (0.00124)), true,
+                         "Verify that we can actually set the attribute B");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("W", DoubleValue (170)), true,
+                         "Verify that we can actually set the attribute W");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseTimestamp", BooleanValue (true)), true,
+                         "Verify that we can actually set the attribute UseTimestamp");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueDelayReference", TimeValue (Seconds (0.48))), true,
+                         "Verify that we can actually set the attribute QueueDelayReference");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test7 = st.GetNDroppedPackets (PiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_LT (test7, test6, "Test 7 should have less unforced drops than test 6");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+}
+
+void
+PiQueueDiscTestCase::Enqueue (Ptr<PiQueueDisc> queue, uint32_t size, uint32_t nPkt)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<PiQueueDiscTestItem> (Create<Packet> (size), dest));
+    }
+}
+
+void
+PiQueueDiscTestCase::EnqueueWithDelay (Ptr<PiQueueDisc> queue, uint32_t size, uint32_t nPkt)
+{
+  double delay = 0.01;  // enqueue packets with delay
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &PiQueueDiscTestCase::Enqueue, this, queue, size, 1);
+    }
+}
+
+void
+PiQueueDiscTestCase::Dequeue (Ptr<PiQueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+    }
+}
+
+void
+PiQueueDiscTestCase::DequeueWithDelay (Ptr<PiQueueDisc> queue, double delay, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &PiQueueDiscTestCase::Dequeue, this, queue, 1);
+    }
+}
+
+void
+PiQueueDiscTestCase::DoRun (void)
+{
+  RunPiTest (QueueSizeUnit::PACKETS);
+  RunPiTest (QueueSizeUnit::BYTES);
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief PI Queue Disc Test Suite
+ */
+static class PiQueueDiscTestSuite : public TestSuite
+{
+public:
+  PiQueueDiscTestSuite ()
+    : TestSuite ("pi-queue-disc", UNIT)
+  {
+    AddTestCase (new PiQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_piQueueTestSuite; ///< the test suite
@@ -29,6 +29,7 @@
 #include "ns3/double.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/link-estimator.h"
 
 using namespace ns3;
 
@@ -46,11 +47,13 @@ public:
    *
    * \param p the packet
    * \param addr the address
+   * \param ecn the ECN codepoint (0 for Not-ECT, 1 for ECT(1), 2 for ECT(0))
    */
-  PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr);
+  PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint8_t ecn);
   virtual ~PieQueueDiscTestItem ();
   virtual void AddHeader (void);
   virtual bool Mark (void);
+  virtual bool GetUint8Value (Uint8Values field, uint8_t &value) const;
 
 private:
   PieQueueDiscTestItem ();
@@ -65,10 +68,12 @@ private:
    * Disable default implementation to avoid misuse
    */
   PieQueueDiscTestItem &operator = (const PieQueueDiscTestItem &);
+  uint8_t m_ecn;  //!< ECN codepoint
 };
 
-PieQueueDiscTestItem::PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr)
-  : QueueDiscItem (p, addr, 0)
+PieQueueDiscTestItem::PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint8_t ecn)
+  : QueueDiscItem (p, addr, 0),
+    m_ecn (ecn)
 {
 }
 
@@ -84,6 +89,23 @@ PieQueueDiscTestItem::AddHeader (void)
 bool
 PieQueueDiscTestItem::Mark (void)
 {
+  if (m_ecn != 0)
+    {
+      // set CE
+      m_ecn = 3;
+      return true;
+    }
+  return false;
+}
+
+bool
+PieQueueDiscTestItem::GetUint8Value (Uint8Values field, uint8_t &value) const
+{
+  if (field == IP_DSFIELD)
+    {
+      value = m_ecn;
+      return true;
+    }
   return false;
 }
 
@@ -104,15 +126,17 @@ private:
    * \param queue the queue disc
    * \param size the size
    * \param nPkt the number of packets
+   * \param ecn the ECN codepoint of the packets
    */
-  void Enqueue (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  void Enqueue (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn);
   /**
    * Enqueue with delay function
    * \param queue the queue disc
    * \param size the size
    * \param nPkt the number of packets
+   * \param ecn the ECN codepoint of the packets
    */
-  void EnqueueWithDelay (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  void EnqueueWithDelay (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn);
   /**
    * Dequeue function
    * \param queue the queue disc
@@ -126,6 +150,15 @@ private:
    * \param nPkt the number of packets
    */
   void DequeueWithDelay (Ptr<PieQueueDisc> queue, double delay, uint32_t nPkt);
+  /**
+   * Notify a link estimator of the transmission of packets by the device,
+   * which stays backlogged
+   * \param estimator the link estimator
+   * \param start the time of the first transmission
+   * \param interval the time between two transmissions
+   * \param nPkt the number of packets
+   */
+  void Transmit (Ptr<LinkEstimator> estimator, Time start, Time interval, uint32_t nPkt);
   /**
    * Run test function
    * \param mode the test mode
@@ -176,16 +209,16 @@ PieQueueDiscTestCase::RunPieTest (QueueSizeUnit mode)
 
   queue->Initialize ();
   NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 0 * modeSize, "There should be no packets in there");
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p1, dest));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p1, dest, 0));
   NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 1 * modeSize, "There should be one packet in there");
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p2, dest));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p2, dest, 0));
   NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 2 * modeSize, "There should be two packets in there");
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p3, dest));
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p4, dest));
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p5, dest));
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p6, dest));
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p7, dest));
-  queue->Enqueue (Create<PieQueueDiscTestItem> (p8, dest));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p3, dest, 0));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p4, dest, 0));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p5, dest, 0));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p6, dest, 0));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p7, dest, 0));
+  queue->Enqueue (Create<PieQueueDiscTestItem> (p8, dest, 0));
   NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 8 * modeSize, "There should be eight packets in there");
 
   Ptr<QueueDiscItem> item;
@@ -235,7 +268,7 @@ PieQueueDiscTestCase::RunPieTest (QueueSizeUnit mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxBurstAllowance", TimeValue (Seconds (0.1))), true,
                          "Verify that we can actually set the attribute MaxBurstAllowance");
   queue->Initialize ();
-  EnqueueWithDelay (queue, pktSize, 400);
+  EnqueueWithDelay (queue, pktSize, 400, 0);
   DequeueWithDelay (queue, 0.012, 400);
   Simulator::Stop (Seconds (8.0));
   Simulator::Run ();
@@ -264,7 +297,7 @@ PieQueueDiscTestCase::RunPieTest (QueueSizeUnit mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxBurstAllowance", TimeValue (Seconds (0.1))), true,
                          "Verify that we can actually set the attribute MaxBurstAllowance");
   queue->Initialize ();
-  EnqueueWithDelay (queue, pktSize, 400);
+  EnqueueWithDelay (queue, pktSize, 400, 0);
   DequeueWithDelay (queue, 0.012, 400);
   Simulator::Stop (Seconds (8.0));
   Simulator::Run ();
@@ -293,7 +326,7 @@ PieQueueDiscTestCase::RunPieTest (QueueSizeUnit mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxBurstAllowance", TimeValue (Seconds (0.1))), true,
                          "Verify that we can actually set the attribute MaxBurstAllowance");
   queue->Initialize ();
-  EnqueueWithDelay (queue, pktSize, 400);
+  EnqueueWithDelay (queue, pktSize, 400, 0);
   DequeueWithDelay (queue, 0.015, 400); // delay between two successive dequeue events is increased
   Simulator::Stop (Seconds (8.0));
   Simulator::Run ();
@@ -322,7 +355,7 @@ PieQueueDiscTestCase::RunPieTest (QueueSizeUnit mode)
   NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxBurstAllowance", TimeValue (Seconds (0.1))), true,
                          "Verify that we can actually set the attribute MaxBurstAllowance");
   queue->Initialize ();
-  EnqueueWithDelay (queue, pktSize, 400);
+  EnqueueWithDelay (queue, pktSize, 400, 0);
   DequeueWithDelay (queue, 0.015, 400);
   Simulator::Stop (Seconds (8.0));
   Simulator::Run ();
@@ -330,26 +363,336 @@ PieQueueDiscTestCase::RunPieTest (QueueSizeUnit mode)
   uint32_t test5 = st.GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP);
   NS_TEST_EXPECT_MSG_LT (test5, test4, "Test 5 should have less unforced drops than test 4");
   NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PieQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 6: same as test 4, followed by an idle period and by a second burst;
+  // the lazy update mode must behave exactly as the periodic update mode
+  Ptr<PieQueueDisc> periodicQueue = CreateObject<PieQueueDisc> ();
+  Ptr<PieQueueDisc> lazyQueue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (periodicQueue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->SetAttributeFailSafe ("UseLazyUpdate", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseLazyUpdate");
+  periodicQueue->AssignStreams (1);
+  lazyQueue->AssignStreams (1);
+  periodicQueue->Initialize ();
+  lazyQueue->Initialize ();
+  for (auto q : {periodicQueue, lazyQueue})
+    {
+      EnqueueWithDelay (q, pktSize, 400, 0);
+      DequeueWithDelay (q, 0.015, 400);
+      Simulator::Schedule (Seconds (30.0), &PieQueueDiscTestCase::EnqueueWithDelay, this, q, pktSize, 200, 0);
+      Simulator::Schedule (Seconds (30.0), &PieQueueDiscTestCase::DequeueWithDelay, this, q, 0.015, 200);
+    }
+  Simulator::Stop (Seconds (34.0));
+  Simulator::Run ();
+  uint32_t test6Periodic = periodicQueue->GetStats ().GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP);
+  uint32_t test6Lazy = lazyQueue->GetStats ().GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_NE (test6Periodic, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (test6Lazy, test6Periodic, "The lazy and the periodic update modes should drop the same packets");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->GetQueueDelay (), periodicQueue->GetQueueDelay (),
+                         "The lazy and the periodic update modes should compute the same queue delay");
+
+
+  // test 7: in timestamp mode, the queue delay is the sojourn time of the head
+  // packet at the last update, even if no packet has ever been dequeued
+  Ptr<PieQueueDisc> rateQueue = CreateObject<PieQueueDisc> ();
+  periodicQueue = CreateObject<PieQueueDisc> ();
+  lazyQueue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (periodicQueue->SetAttributeFailSafe ("UseTimestamp", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseTimestamp");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->SetAttributeFailSafe ("UseTimestamp", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseTimestamp");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->SetAttributeFailSafe ("UseLazyUpdate", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseLazyUpdate");
+  for (auto q : {rateQueue, periodicQueue, lazyQueue})
+    {
+      q->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (mode, qSize)));
+      q->Initialize ();
+      // updates are performed every 30 ms since now, the last one 89 ms after the enqueue
+      Simulator::Schedule (MilliSeconds (1), &PieQueueDiscTestCase::Enqueue, this, q, pktSize, 10, 0);
+    }
+  Simulator::Stop (MilliSeconds (100));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (rateQueue->GetQueueDelay (), Seconds (0),
+                         "The dequeue rate is unknown, hence the queue delay should be zero");
+  NS_TEST_EXPECT_MSG_EQ_TOL (periodicQueue->GetQueueDelay (), MilliSeconds (89), MicroSeconds (1),
+                             "The queue delay should be the sojourn time of the head packet");
+  NS_TEST_EXPECT_MSG_EQ_TOL (lazyQueue->GetQueueDelay (), MilliSeconds (89), MicroSeconds (1),
+                             "The queue delay should be the sojourn time of the head packet");
+
+
+  // test 8: same as test 4, but the queue delay is estimated in timestamp mode
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseTimestamp", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseTimestamp");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 0);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (st.GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP), 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PieQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 9: same as test 4, but in fixed-point mode
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseFixedPoint", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseFixedPoint");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 0);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test9 = st.GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_NE (test9, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PieQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 10: same as test 9, but with higher QueueDelayReference
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseFixedPoint", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseFixedPoint");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueDelayReference", TimeValue (Seconds (0.08))), true,
+                         "Verify that we can actually set the attribute QueueDelayReference");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 0);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test10 = st.GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_LT (test10, test9, "Test 10 should have less unforced drops than test 9");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PieQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 11: same as test 4, but with ECN capable packets, ECN enabled and a
+  // marking threshold of 1, hence packets are marked rather than dropped
+  // until the drop probability exceeds 1
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseEcn");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkEcnThreshold", DoubleValue (1.0)),
+                         true, "Verify that we can actually set the attribute MarkEcnThreshold");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 2);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (st.GetNMarkedPackets (PieQueueDisc::UNFORCED_MARK), 0, "There should be some unforced marks");
+  NS_TEST_EXPECT_MSG_LT (st.GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP), test4,
+                         "Test 11 should have less unforced drops than test 4");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNMarkedPackets (PieQueueDisc::CE_THRESHOLD_EXCEEDED_MARK), 0,
+                         "There should be zero CE threshold marks");
+
+
+  // test 12: same as test 11, but in fixed-point mode
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseFixedPoint", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseFixedPoint");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseEcn");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkEcnThreshold", DoubleValue (1.0)),
+                         true, "Verify that we can actually set the attribute MarkEcnThreshold");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 2);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (st.GetNMarkedPackets (PieQueueDisc::UNFORCED_MARK), 0, "There should be some unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (PieQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 13: same as test 11, but with packets that are not ECN capable and
+  // with L4S marking enabled, hence packets are dropped and never marked
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseEcn", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseEcn");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseL4s", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseL4s");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 0);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalMarkedPackets, 0, "There should be zero marks");
+  NS_TEST_EXPECT_MSG_NE (st.GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP), 0, "There should be some unforced drops");
+
+
+  // test 14: same as test 13, but with ECT(1) packets, which are marked when
+  // their sojourn time exceeds the CE threshold
+  queue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("UseL4s", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseL4s");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("CeThreshold", TimeValue (MilliSeconds (1))),
+                         true, "Verify that we can actually set the attribute CeThreshold");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 400, 1);
+  DequeueWithDelay (queue, 0.015, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_NE (st.GetNMarkedPackets (PieQueueDisc::CE_THRESHOLD_EXCEEDED_MARK), 0,
+                         "There should be some CE threshold marks");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNMarkedPackets (PieQueueDisc::UNFORCED_MARK), 0,
+                         "There should be zero unforced marks");
+
+
+  // test 15: same as test 4, but the drop probability only changes when the
+  // queue delay exceeds 200 ms (A and B are zero), hence it decays by 0.98 at
+  // every update during the following idle period; after a long idle period,
+  // the lazy update mode must give the same drop probability as the periodic
+  // update mode
+  periodicQueue = CreateObject<PieQueueDisc> ();
+  lazyQueue = CreateObject<PieQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->SetAttributeFailSafe ("UseLazyUpdate", BooleanValue (true)),
+                         true, "Verify that we can actually set the attribute UseLazyUpdate");
+  for (auto q : {periodicQueue, lazyQueue})
+    {
+      q->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (mode, qSize)));
+      q->SetAttribute ("A", DoubleValue (0));
+      q->SetAttribute ("B", DoubleValue (0));
+      q->AssignStreams (1);
+      q->Initialize ();
+      EnqueueWithDelay (q, pktSize, 400, 0);
+      DequeueWithDelay (q, 0.015, 400);
+    }
+  Simulator::Stop (Seconds (10.0));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_GT (periodicQueue->GetDropProbability (), 0, "The drop probability should still be decaying");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->GetDropProbability (), periodicQueue->GetDropProbability (),
+                         "The lazy and the periodic update modes should compute the same drop probability");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->GetStats ().GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP),
+                         periodicQueue->GetStats ().GetNDroppedPackets (PieQueueDisc::UNFORCED_DROP),
+                         "The lazy and the periodic update modes should drop the same packets");
+  Simulator::Stop (Seconds (30.0));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->GetDropProbability (), periodicQueue->GetDropProbability (),
+                         "The lazy and the periodic update modes should compute the same drop probability");
+  Simulator::Stop (Seconds (1000.0));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (periodicQueue->GetDropProbability (), 0, 1e-10, "The drop probability should be negligible");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->GetDropProbability (), periodicQueue->GetDropProbability (),
+                         "The lazy and the periodic update modes should compute the same drop probability");
+  NS_TEST_EXPECT_MSG_EQ (lazyQueue->GetQueueDelay (), Seconds (0), "The queue delay should be zero");
+
+
+  // test 16: the departure rate is measured by the link estimator of the
+  // device rather than by the queue disc. 40 packets are queued and never
+  // dequeued; the device drains 8 Mbps for the first queue disc and 2 Mbps
+  // for the second one, hence the second queue disc estimates a larger queue
+  // delay and drops more. The drain rate seen by the first queue disc then
+  // drops to 2 Mbps, and its queue delay follows
+  Ptr<PieQueueDisc> fastQueue = CreateObject<PieQueueDisc> ();
+  Ptr<PieQueueDisc> slowQueue = CreateObject<PieQueueDisc> ();
+  Ptr<LinkEstimator> fastEstimator = CreateObject<LinkEstimator> ();
+  Ptr<LinkEstimator> slowEstimator = CreateObject<LinkEstimator> ();
+  fastQueue->SetLinkEstimator (fastEstimator);
+  slowQueue->SetLinkEstimator (slowEstimator);
+  for (auto q : {fastQueue, slowQueue})
+    {
+      q->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (mode, qSize)));
+      q->Initialize ();
+      Simulator::Schedule (Seconds (0.5), &PieQueueDiscTestCase::Enqueue, this, q, 1000, 40, 0);
+    }
+  Transmit (fastEstimator, Seconds (0), MilliSeconds (1), 1500);
+  Transmit (fastEstimator, Seconds (1.5), MilliSeconds (4), 375);
+  Transmit (slowEstimator, Seconds (0), MilliSeconds (4), 750);
+  Simulator::Stop (Seconds (1.45));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (fastQueue->GetQueueDelay (), MilliSeconds (40), MicroSeconds (1),
+                             "The queue delay should be computed from the drain rate of the device");
+  NS_TEST_EXPECT_MSG_EQ_TOL (slowQueue->GetQueueDelay (), MilliSeconds (160), MicroSeconds (1),
+                             "The queue delay should be computed from the drain rate of the device");
+  NS_TEST_EXPECT_MSG_GT (slowQueue->GetDropProbability (), fastQueue->GetDropProbability (),
+                         "A slower link should yield a higher drop probability");
+  Simulator::Stop (Seconds (1.55));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (fastQueue->GetQueueDelay (), MilliSeconds (160), MicroSeconds (1),
+                             "The queue delay should follow the drain rate of the device");
+
+
+  // test 17: the update timer starts Supdate after the initialization of the
+  // queue disc, not at its construction. The queue discs are initialized
+  // 200 ms after their construction, with Supdate set to 100 ms, and 20
+  // packets are enqueued 10 ms later in timestamp mode: no update takes place
+  // in the following 80 ms, the first one measures a sojourn time of 90 ms
+  periodicQueue = CreateObject<PieQueueDisc> ();
+  lazyQueue = CreateObject<PieQueueDisc> ();
+  lazyQueue->SetAttribute ("UseLazyUpdate", BooleanValue (true));
+  for (auto q : {periodicQueue, lazyQueue})
+    {
+      q->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (mode, qSize)));
+      q->SetAttribute ("UseTimestamp", BooleanValue (true));
+      NS_TEST_EXPECT_MSG_EQ (q->SetAttributeFailSafe ("Supdate", TimeValue (MilliSeconds (100))),
+                             true, "Verify that we can actually set the attribute Supdate");
+      Simulator::Schedule (MilliSeconds (200), &PieQueueDisc::Initialize, q);
+      Simulator::Schedule (MilliSeconds (210), &PieQueueDiscTestCase::Enqueue, this, q, 1000, 20, 0);
+    }
+  Simulator::Stop (MilliSeconds (290));
+  Simulator::Run ();
+  for (auto q : {periodicQueue, lazyQueue})
+    {
+      NS_TEST_EXPECT_MSG_EQ (q->GetQueueDelay (), Seconds (0),
+                             "No update should take place before Supdate has elapsed since the initialization");
+    }
+  Simulator::Stop (MilliSeconds (20));
+  Simulator::Run ();
+  for (auto q : {periodicQueue, lazyQueue})
+    {
+      NS_TEST_EXPECT_MSG_EQ (q->GetQueueDelay (), MilliSeconds (90),
+                             "The first update should take place Supdate after the initialization");
+    }
+}
+
+void
+PieQueueDiscTestCase::Transmit (Ptr<LinkEstimator> estimator, Time start, Time interval, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (start + interval * i, &LinkEstimator::NotifyTransmittedBytes, estimator, 1000, true);
+    }
 }
 
 void
-PieQueueDiscTestCase::Enqueue (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt)
+PieQueueDiscTestCase::Enqueue (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn)
 {
   Address dest;
   for (uint32_t i = 0; i < nPkt; i++)
     {
-      queue->Enqueue (Create<PieQueueDiscTestItem> (Create<Packet> (size), dest));
+      queue->Enqueue (Create<PieQueueDiscTestItem> (Create<Packet> (size), dest, ecn));
     }
 }
 
 void
-PieQueueDiscTestCase::EnqueueWithDelay (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt)
+PieQueueDiscTestCase::EnqueueWithDelay (Ptr<PieQueueDisc> queue, uint32_t size, uint32_t nPkt, uint8_t ecn)
 {
   Address dest;
   double delay = 0.01;  // enqueue packets with delay
   for (uint32_t i = 0; i < nPkt; i++)
     {
-      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &PieQueueDiscTestCase::Enqueue, this, queue, size, 1);
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &PieQueueDiscTestCase::Enqueue, this, queue, size, 1, ecn);
     }
 }
 
@@ -379,6 +722,80 @@ PieQueueDiscTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check that the fixed-point mode computes the same drop probability
+ * as the Linux kernel
+ */
+class PieFixedPointTestCase : public TestCase
+{
+public:
+  PieFixedPointTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Enqueue (Ptr<PieQueueDisc> queue, uint32_t nPkt);
+  /**
+   * Check the queue delay and the drop probability
+   * \param queue the queue disc
+   * \param qDelay the expected queue delay
+   * \param prob the expected drop probability, scaled by 2^56 - 1
+   */
+  void Check (Ptr<PieQueueDisc> queue, Time qDelay, uint64_t prob);
+};
+
+PieFixedPointTestCase::PieFixedPointTestCase ()
+  : TestCase ("Check the fixed-point arithmetic of the pie queue disc")
+{
+}
+
+void
+PieFixedPointTestCase::Enqueue (Ptr<PieQueueDisc> queue, uint32_t nPkt)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<PieQueueDiscTestItem> (Create<Packet> (1000), dest, 0));
+    }
+}
+
+void
+PieFixedPointTestCase::Check (Ptr<PieQueueDisc> queue, Time qDelay, uint64_t prob)
+{
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDelay (), qDelay, "Unexpected queue delay");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropProbability (), static_cast<double> (prob) / ((1ULL << 56) - 1),
+                         "Unexpected drop probability");
+}
+
+void
+PieFixedPointTestCase::DoRun (void)
+{
+  // Updates are performed every 30 ms. Twenty packets are enqueued at 1 ms
+  // and one is dequeued at 101 ms, hence the queue delay is 100 ms (1562500
+  // psched ticks) at the updates at 120 ms and 150 ms. The expected drop
+  // probabilities are computed by pie_calculate_probability with alpha = 2,
+  // beta = 20 and a target of 20 ms
+  Ptr<PieQueueDisc> queue = CreateObject<PieQueueDisc> ();
+  queue->SetAttribute ("UseFixedPoint", BooleanValue (true));
+  queue->SetAttribute ("UseTimestamp", BooleanValue (true));
+  queue->Initialize ();
+
+  Simulator::Schedule (MilliSeconds (1), &PieFixedPointTestCase::Enqueue, this, queue, 20);
+  Simulator::Schedule (MilliSeconds (101), &QueueDisc::Dequeue, queue);
+  Simulator::Schedule (MilliSeconds (110), &PieFixedPointTestCase::Check, this, queue, MilliSeconds (100), 0);
+  Simulator::Schedule (MilliSeconds (125), &PieFixedPointTestCase::Check, this, queue, MilliSeconds (100), 4749887812500ULL);
+  Simulator::Schedule (MilliSeconds (155), &PieFixedPointTestCase::Check, this, queue, MilliSeconds (100), 10379386562500ULL);
+  Simulator::Stop (MilliSeconds (160));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -392,5 +809,6 @@ public:
     : TestSuite ("pie-queue-disc", UNIT)
   {
     AddTestCase (new PieQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new PieFixedPointTestCase (), TestCase::QUICK);
   }
 } g_pieQueueTestSuite; ///< the test suite
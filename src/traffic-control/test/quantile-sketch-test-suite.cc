@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/quantile-sketch.h"
+#include "ns3/fifo-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include <cmath>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Quantile Sketch Test Item
+ */
+class QuantileSketchTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   */
+  QuantileSketchTestItem (Ptr<Packet> p, const Address & addr);
+  virtual ~QuantileSketchTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  QuantileSketchTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  QuantileSketchTestItem (const QuantileSketchTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  QuantileSketchTestItem &operator = (const QuantileSketchTestItem &);
+};
+
+QuantileSketchTestItem::QuantileSketchTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0)
+{
+}
+
+QuantileSketchTestItem::~QuantileSketchTestItem ()
+{
+}
+
+void
+QuantileSketchTestItem::AddHeader (void)
+{
+}
+
+bool
+QuantileSketchTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Quantile Sketch Test Case
+ */
+class QuantileSketchTestCase : public TestCase
+{
+public:
+  QuantileSketchTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Check that small values are counted exactly
+   */
+  void RunExactTest (void);
+  /**
+   * Check the relative error of the quantiles of large values and merging
+   */
+  void RunErrorTest (void);
+  /**
+   * Check the sojourn time statistics of a queue disc
+   */
+  void RunQueueDiscTest (void);
+};
+
+QuantileSketchTestCase::QuantileSketchTestCase ()
+  : TestCase ("Sanity check on the quantile sketch")
+{
+}
+
+void
+QuantileSketchTestCase::RunExactTest (void)
+{
+  QuantileSketch sketch;
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetQuantile (0.5), 0, "An empty sketch should return 0");
+
+  for (uint64_t v = 0; v < 100; v++)
+    {
+      sketch.Add (v);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetCount (), 100, "Wrong number of values");
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetMin (), 0, "Wrong minimum");
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetMax (), 99, "Wrong maximum");
+  NS_TEST_EXPECT_MSG_EQ_TOL (sketch.GetMean (), 49.5, 1e-9, "Wrong mean");
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetQuantile (0), 0, "Wrong minimum quantile");
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetQuantile (0.5), 49, "Wrong median");
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetQuantile (0.99), 98, "Wrong 99th percentile");
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetQuantile (1), 99, "Wrong maximum quantile");
+
+  sketch.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (sketch.GetCount (), 0, "The sketch should be empty");
+}
+
+void
+QuantileSketchTestCase::RunErrorTest (void)
+{
+  QuantileSketch sketch;
+  QuantileSketch low;
+  QuantileSketch high;
+
+  // one million values between 1 us and 1 s (in ns), evenly spaced on a log scale
+  const uint32_t n = 1000000;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint64_t v = static_cast<uint64_t> (1e3 * std::pow (1e6, static_cast<double> (i) / (n - 1)));
+      sketch.Add (v);
+      (i < n / 2 ? low : high).Add (v);
+    }
+
+  double quantiles[] = {0.1, 0.5, 0.9, 0.99, 0.999};
+  for (double q : quantiles)
+    {
+      double exact = 1e3 * std::pow (1e6, (std::ceil (q * n) - 1) / (n - 1));
+      NS_TEST_EXPECT_MSG_EQ_TOL (sketch.GetQuantile (q), exact, exact / 128,
+                                 "Relative error too large for quantile " << q);
+    }
+
+  low.Merge (high);
+  NS_TEST_EXPECT_MSG_EQ (low.GetCount (), n, "Wrong number of merged values");
+  NS_TEST_EXPECT_MSG_EQ (low.GetMin (), sketch.GetMin (), "Wrong minimum of merged values");
+  NS_TEST_EXPECT_MSG_EQ (low.GetMax (), sketch.GetMax (), "Wrong maximum of merged values");
+  for (double q : quantiles)
+    {
+      NS_TEST_EXPECT_MSG_EQ (low.GetQuantile (q), sketch.GetQuantile (q),
+                             "Merged sketch differs for quantile " << q);
+    }
+}
+
+void
+QuantileSketchTestCase::RunQueueDiscTest (void)
+{
+  Ptr<FifoQueueDisc> queue = CreateObject<FifoQueueDisc> ();
+  queue->Initialize ();
+
+  // packets enqueued at time 0 and dequeued every millisecond have sojourn
+  // times of 0, 1, ..., 199 ms
+  Address dest;
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      queue->Enqueue (Create<QuantileSketchTestItem> (Create<Packet> (100), dest));
+    }
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &QueueDisc::Dequeue, queue);
+    }
+  Simulator::Run ();
+
+  const QueueDisc::Stats &stats = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.sojournTime.GetCount (), 200, "Wrong number of sojourn times");
+  NS_TEST_EXPECT_MSG_EQ (stats.sojournTime.GetMax (), static_cast<uint64_t> (MilliSeconds (199).GetNanoSeconds ()),
+                         "Wrong maximum sojourn time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetSojournTimeQuantile (0.5), MilliSeconds (99), MicroSeconds (800),
+                             "Wrong median sojourn time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetSojournTimeQuantile (0.99), MilliSeconds (197), MicroSeconds (1600),
+                             "Wrong 99th percentile of the sojourn time");
+
+  queue->Dispose ();
+  Simulator::Destroy ();
+}
+
+void
+QuantileSketchTestCase::DoRun (void)
+{
+  RunExactTest ();
+  RunErrorTest ();
+  RunQueueDiscTest ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Quantile Sketch Test Suite
+ */
+static class QuantileSketchTestSuite : public TestSuite
+{
+public:
+  QuantileSketchTestSuite ()
+    : TestSuite ("quantile-sketch", UNIT)
+  {
+    AddTestCase (new QuantileSketchTestCase (), TestCase::QUICK);
+  }
+} g_quantileSketchTestSuite; ///< the test suite
@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/queue-disc-sampler.h"
+#include "ns3/fifo-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include <fstream>
+#include <string>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Sampler Test Item
+ */
+class QueueDiscSamplerTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   */
+  QueueDiscSamplerTestItem (Ptr<Packet> p, const Address & addr);
+  virtual ~QueueDiscSamplerTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  QueueDiscSamplerTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  QueueDiscSamplerTestItem (const QueueDiscSamplerTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  QueueDiscSamplerTestItem &operator = (const QueueDiscSamplerTestItem &);
+};
+
+QueueDiscSamplerTestItem::QueueDiscSamplerTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0)
+{
+}
+
+QueueDiscSamplerTestItem::~QueueDiscSamplerTestItem ()
+{
+}
+
+void
+QueueDiscSamplerTestItem::AddHeader (void)
+{
+}
+
+bool
+QueueDiscSamplerTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue disc whose controller state depends on the simulation time
+ */
+class QueueDiscSamplerTestQueueDisc : public FifoQueueDisc
+{
+public:
+  virtual ControllerState GetControllerState (void);
+};
+
+QueueDisc::ControllerState
+QueueDiscSamplerTestQueueDisc::GetControllerState (void)
+{
+  ControllerState state;
+  state.queueDelay = Simulator::Now () / 2;
+  state.probability = 0.25;
+  return state;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Sampler Test Case
+ */
+class QueueDiscSamplerTestCase : public TestCase
+{
+public:
+  QueueDiscSamplerTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Sample a queue disc storing 20 packets, one of which is dequeued every ms,
+   * every ms for 10 ms
+   * \param sampler the sampler
+   */
+  void RunSampler (Ptr<QueueDiscSampler> sampler);
+  /**
+   * Check that the most recent samples are kept in memory
+   */
+  void RunMemoryTest (void);
+  /**
+   * Check the samples written to a CSV file
+   */
+  void RunCsvTest (void);
+  /**
+   * Check the samples written to a binary file
+   */
+  void RunBinaryTest (void);
+};
+
+QueueDiscSamplerTestCase::QueueDiscSamplerTestCase ()
+  : TestCase ("Sanity check on the queue disc sampler")
+{
+}
+
+void
+QueueDiscSamplerTestCase::RunSampler (Ptr<QueueDiscSampler> sampler)
+{
+  Ptr<QueueDisc> queue = CreateObject<QueueDiscSamplerTestQueueDisc> ();
+  queue->Initialize ();
+
+  Address dest;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      queue->Enqueue (Create<QueueDiscSamplerTestItem> (Create<Packet> (1000), dest));
+    }
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (MicroSeconds (500 + 1000 * i), &QueueDisc::Dequeue, queue);
+    }
+
+  sampler->SetAttribute ("Interval", TimeValue (MilliSeconds (1)));
+  sampler->SetAttribute ("BufferSize", UintegerValue (4));
+  sampler->SetQueueDisc (queue);
+  sampler->Start (Seconds (0));
+  sampler->Stop (MilliSeconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+QueueDiscSamplerTestCase::RunMemoryTest (void)
+{
+  Ptr<QueueDiscSampler> sampler = CreateObject<QueueDiscSampler> ();
+  RunSampler (sampler);
+
+  // samples are taken at 0, 1, ..., 9 ms and the buffer keeps the last 4
+  NS_TEST_ASSERT_MSG_EQ (sampler->GetNSamples (), 4, "The buffer should be full");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      const QueueDiscSampler::Sample &sample = sampler->GetSample (i);
+      NS_TEST_EXPECT_MSG_EQ (sample.time, MilliSeconds (6 + i).GetNanoSeconds (), "Wrong sample time");
+      NS_TEST_EXPECT_MSG_EQ (sample.nPackets, 14 - i, "Wrong number of packets");
+      NS_TEST_EXPECT_MSG_EQ (sample.nBytes, 1000 * (14 - i), "Wrong number of bytes");
+      NS_TEST_EXPECT_MSG_EQ (sample.queueDelay, MicroSeconds (500 * (6 + i)).GetNanoSeconds (), "Wrong queue delay");
+      NS_TEST_EXPECT_MSG_EQ (sample.probability, 0.25, "Wrong probability");
+    }
+  sampler->Dispose ();
+}
+
+void
+QueueDiscSamplerTestCase::RunCsvTest (void)
+{
+  std::string fileName = CreateTempDirFilename ("queue-disc-sampler.csv");
+  Ptr<QueueDiscSampler> sampler = CreateObject<QueueDiscSampler> ();
+  sampler->SetAttribute ("FileName", StringValue (fileName));
+  RunSampler (sampler);
+
+  NS_TEST_EXPECT_MSG_EQ (sampler->GetNSamples (), 0, "The buffer should have been flushed");
+
+  std::ifstream file (fileName.c_str ());
+  std::string line;
+  std::getline (file, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "time,packets,bytes,delay,probability", "Wrong header");
+  std::getline (file, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "0,20,20000,0,0.25", "Wrong first sample");
+
+  uint32_t nLines = 1;
+  std::string last;
+  while (std::getline (file, line))
+    {
+      last = line;
+      nLines++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nLines, 10, "All the samples should have been written");
+  NS_TEST_EXPECT_MSG_EQ (last, "9000000,11,11000,4500000,0.25", "Wrong last sample");
+  sampler->Dispose ();
+}
+
+void
+QueueDiscSamplerTestCase::RunBinaryTest (void)
+{
+  std::string fileName = CreateTempDirFilename ("queue-disc-sampler.bin");
+  Ptr<QueueDiscSampler> sampler = CreateObject<QueueDiscSampler> ();
+  sampler->SetAttribute ("FileName", StringValue (fileName));
+  sampler->SetAttribute ("Binary", BooleanValue (true));
+  RunSampler (sampler);
+
+  std::ifstream file (fileName.c_str (), std::ios::binary);
+  QueueDiscSampler::Sample sample;
+  uint32_t nSamples = 0;
+  while (file.read (reinterpret_cast<char*> (&sample), sizeof (sample)))
+    {
+      NS_TEST_EXPECT_MSG_EQ (sample.time, MilliSeconds (nSamples).GetNanoSeconds (), "Wrong sample time");
+      NS_TEST_EXPECT_MSG_EQ (sample.nPackets, 20 - nSamples, "Wrong number of packets");
+      nSamples++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nSamples, 10, "All the samples should have been written");
+  sampler->Dispose ();
+}
+
+void
+QueueDiscSamplerTestCase::DoRun (void)
+{
+  RunMemoryTest ();
+  RunCsvTest ();
+  RunBinaryTest ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Sampler Test Suite
+ */
+static class QueueDiscSamplerTestSuite : public TestSuite
+{
+public:
+  QueueDiscSamplerTestSuite ()
+    : TestSuite ("queue-disc-sampler", UNIT)
+  {
+    AddTestCase (new QueueDiscSamplerTestCase (), TestCase::QUICK);
+  }
+} g_queueDiscSamplerTestSuite; ///< the test suite
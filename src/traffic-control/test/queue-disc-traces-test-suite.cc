@@ -25,6 +25,8 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include <map>
+#include <set>
+#include <thread>
 
 using namespace ns3;
 
@@ -555,9 +557,97 @@ QueueDiscTracesTestCase::DoRun (void)
   CheckDroppedBeforeEnqueue (child, 1, pktSizeUnit * 5);
   CheckDroppedAfterDequeue (child, 2, pktSizeUnit * 3);
 
+  // Check the statistics kept for each reason
+  std::string childDbe = std::string (QueueDisc::CHILD_QUEUE_DISC_DROP) + TestChildQueueDisc::BEFORE_ENQUEUE;
+  std::string childDad = std::string (QueueDisc::CHILD_QUEUE_DISC_DROP) + TestChildQueueDisc::AFTER_DEQUEUE;
+  QueueDisc::Stats rootStats = root->GetStats ();
+  QueueDisc::Stats childStats = child->GetStats ();
+
+  NS_TEST_EXPECT_MSG_EQ (childStats.GetNDroppedPackets (TestChildQueueDisc::BEFORE_ENQUEUE), 1,
+                         "Verify that the packets dropped for each reason are counted correctly");
+  NS_TEST_EXPECT_MSG_EQ (childStats.GetNDroppedBytes (TestChildQueueDisc::AFTER_DEQUEUE), pktSizeUnit * 3,
+                         "Verify that the bytes dropped for each reason are counted correctly");
+  NS_TEST_EXPECT_MSG_EQ (rootStats.GetNDroppedPackets (childDbe), 1,
+                         "Verify that the packets dropped by the child are counted correctly");
+  NS_TEST_EXPECT_MSG_EQ (rootStats.GetNDroppedBytes (childDad), pktSizeUnit * 3,
+                         "Verify that the bytes dropped by the child are counted correctly");
+  NS_TEST_EXPECT_MSG_EQ (rootStats.GetNDroppedPackets (TestChildQueueDisc::BEFORE_ENQUEUE), 0,
+                         "Verify that reasons not used by a queue disc are not counted");
+  NS_TEST_EXPECT_MSG_EQ (rootStats.GetNDroppedPackets ("Unknown reason"), 0,
+                         "Verify that unknown reasons are not counted");
+
+  std::ostringstream oss;
+  rootStats.Print (oss);
+  NS_TEST_EXPECT_MSG_NE (oss.str ().find ("  " + childDbe + ": 1 / " + std::to_string (pktSizeUnit * 5)),
+                         std::string::npos, "Verify that the statistics for each reason are printed");
+
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Check that reasons registered concurrently by several threads get
+ * distinct and consistent IDs
+ */
+class QueueDiscReasonRegistryTestCase : public TestCase
+{
+public:
+  QueueDiscReasonRegistryTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Register a set of reasons, in an order depending on the given thread
+   * \param thread the index of the thread
+   */
+  static void Register (uint32_t thread);
+
+  static const uint32_t N_THREADS = 4;    //!< Number of threads
+  static const uint32_t N_REASONS = 500;  //!< Number of reasons registered by each thread
+};
+
+QueueDiscReasonRegistryTestCase::QueueDiscReasonRegistryTestCase ()
+  : TestCase ("Sanity check on the concurrent registration of reasons")
+{
+}
+
+void
+QueueDiscReasonRegistryTestCase::Register (uint32_t thread)
+{
+  for (uint32_t i = 0; i < N_REASONS; i++)
+    {
+      uint32_t reason = (i + thread * N_REASONS / N_THREADS) % N_REASONS;
+      QueueDisc::Stats::GetReasonId ("Registry test reason " + std::to_string (reason));
+    }
+}
+
+void
+QueueDiscReasonRegistryTestCase::DoRun (void)
+{
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < N_THREADS; t++)
+    {
+      threads.push_back (std::thread (&QueueDiscReasonRegistryTestCase::Register, t));
+    }
+  for (auto& thread : threads)
+    {
+      thread.join ();
+    }
+
+  std::set<uint16_t> ids;
+  for (uint32_t i = 0; i < N_REASONS; i++)
+    {
+      std::string reason = "Registry test reason " + std::to_string (i);
+      uint16_t id = QueueDisc::Stats::GetReasonId (reason);
+      NS_TEST_EXPECT_MSG_EQ (QueueDisc::Stats::GetReasonName (id), reason,
+                             "Verify that the ID of a reason refers to that reason");
+      ids.insert (id);
+    }
+  NS_TEST_EXPECT_MSG_EQ (ids.size (), N_REASONS, "Verify that every reason has a distinct ID");
+}
+
 
 /**
  * \ingroup traffic-control-test
@@ -572,5 +662,6 @@ public:
     : TestSuite ("queue-disc-traces", UNIT)
   {
     AddTestCase (new QueueDiscTracesTestCase (), TestCase::QUICK);
+    AddTestCase (new QueueDiscReasonRegistryTestCase (), TestCase::QUICK);
   }
 } g_queueDiscTracesTestSuite; ///< the test suite
@@ -0,0 +1,507 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/self-tuning-pi-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/link-estimator.h"
+#include <cmath>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Self-Tuning PI Queue Disc Test Item
+ */
+class SelfTuningPiQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   */
+  SelfTuningPiQueueDiscTestItem (Ptr<Packet> p, const Address & addr);
+  virtual ~SelfTuningPiQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  SelfTuningPiQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  SelfTuningPiQueueDiscTestItem (const SelfTuningPiQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  SelfTuningPiQueueDiscTestItem &operator = (const SelfTuningPiQueueDiscTestItem &);
+};
+
+SelfTuningPiQueueDiscTestItem::SelfTuningPiQueueDiscTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0)
+{
+}
+
+SelfTuningPiQueueDiscTestItem::~SelfTuningPiQueueDiscTestItem ()
+{
+}
+
+void
+SelfTuningPiQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+SelfTuningPiQueueDiscTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Self-Tuning PI Queue Disc Test Case
+ */
+class SelfTuningPiQueueDiscTestCase : public TestCase
+{
+public:
+  SelfTuningPiQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   */
+  void Enqueue (Ptr<SelfTuningPiQueueDisc> queue, uint32_t size, uint32_t nPkt);
+  /**
+   * Enqueue with delay function
+   * \param queue the queue disc
+   * \param size the size
+   * \param delay the delay between two successive enqueues
+   * \param nPkt the number of packets
+   */
+  void EnqueueWithDelay (Ptr<SelfTuningPiQueueDisc> queue, uint32_t size, double delay, uint32_t nPkt);
+  /**
+   * Dequeue function
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Dequeue (Ptr<SelfTuningPiQueueDisc> queue, uint32_t nPkt);
+  /**
+   * Dequeue with delay function
+   * \param queue the queue disc
+   * \param delay the delay
+   * \param nPkt the number of packets
+   */
+  void DequeueWithDelay (Ptr<SelfTuningPiQueueDisc> queue, double delay, uint32_t nPkt);
+  /**
+   * Trace sink for the gains of the controller
+   * \param oldValue the previous value of the gain
+   * \param newValue the current value of the gain
+   */
+  void GainTrace (double oldValue, double newValue);
+  /**
+   * Trace sink recording the proportional gain of the controller
+   * \param oldValue the previous value of the gain
+   * \param newValue the current value of the gain
+   */
+  void KpTrace (double oldValue, double newValue);
+  /**
+   * Trace sink recording the integral gain of the controller
+   * \param oldValue the previous value of the gain
+   * \param newValue the current value of the gain
+   */
+  void KiTrace (double oldValue, double newValue);
+  /**
+   * Record the current queue delay estimated by the queue disc
+   * \param queue the queue disc
+   */
+  void SampleQueueDelay (Ptr<SelfTuningPiQueueDisc> queue);
+  /**
+   * Notify a link estimator of the transmission of packets by the device,
+   * which stays backlogged
+   * \param estimator the link estimator
+   * \param start the time of the first transmission
+   * \param interval the time between two transmissions
+   * \param nPkt the number of packets
+   */
+  void Transmit (Ptr<LinkEstimator> estimator, Time start, Time interval, uint32_t nPkt);
+  /**
+   * Run test function
+   * \param mode the test mode
+   */
+  void RunSelfTuningPiTest (QueueSizeUnit mode);
+
+  uint32_t m_gainUpdates;  //!< Number of times a gain changed
+  double m_kp;             //!< Last value of the proportional gain
+  double m_ki;             //!< Last value of the integral gain
+  double m_qDelaySum;      //!< Sum of the queue delay samples, in seconds
+  uint32_t m_qDelayCount;  //!< Number of queue delay samples
+};
+
+SelfTuningPiQueueDiscTestCase::SelfTuningPiQueueDiscTestCase ()
+  : TestCase ("Sanity check on the self-tuning PI queue disc implementation"),
+    m_gainUpdates (0),
+    m_kp (0),
+    m_ki (0),
+    m_qDelaySum (0),
+    m_qDelayCount (0)
+{
+}
+
+void
+SelfTuningPiQueueDiscTestCase::GainTrace (double oldValue, double newValue)
+{
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (newValue, 0, "Gains must not be negative");
+  m_gainUpdates++;
+}
+
+void
+SelfTuningPiQueueDiscTestCase::KpTrace (double oldValue, double newValue)
+{
+  m_kp = newValue;
+}
+
+void
+SelfTuningPiQueueDiscTestCase::KiTrace (double oldValue, double newValue)
+{
+  m_ki = newValue;
+}
+
+void
+SelfTuningPiQueueDiscTestCase::SampleQueueDelay (Ptr<SelfTuningPiQueueDisc> queue)
+{
+  m_qDelaySum += queue->GetQueueDelay ().GetSeconds ();
+  m_qDelayCount++;
+}
+
+void
+SelfTuningPiQueueDiscTestCase::RunSelfTuningPiTest (QueueSizeUnit mode)
+{
+  uint32_t pktSize = 0;
+
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = 1;
+
+  uint32_t qSize = 300;
+  Ptr<SelfTuningPiQueueDisc> queue = CreateObject<SelfTuningPiQueueDisc> ();
+
+
+  // test 1: simple enqueue/dequeue with defaults, no drops
+  Address dest;
+
+  if (mode == QueueSizeUnit::BYTES)
+    {
+      // pktSize should be same as MeanPktSize to avoid performance gap between byte and packet mode
+      pktSize = 1000;
+      modeSize = pktSize;
+      qSize = qSize * modeSize;
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+
+  Ptr<Packet> p1, p2, p3, p4, p5, p6, p7, p8;
+  p1 = Create<Packet> (pktSize);
+  p2 = Create<Packet> (pktSize);
+  p3 = Create<Packet> (pktSize);
+  p4 = Create<Packet> (pktSize);
+  p5 = Create<Packet> (pktSize);
+  p6 = Create<Packet> (pktSize);
+  p7 = Create<Packet> (pktSize);
+  p8 = Create<Packet> (pktSize);
+
+  queue->Initialize ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 0 * modeSize, "There should be no packets in there");
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p1, dest));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 1 * modeSize, "There should be one packet in there");
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p2, dest));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 2 * modeSize, "There should be two packets in there");
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p3, dest));
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p4, dest));
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p5, dest));
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p6, dest));
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p7, dest));
+  queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (p8, dest));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 8 * modeSize, "There should be eight packets in there");
+
+  Ptr<QueueDiscItem> item;
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the first packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 7 * modeSize, "There should be seven packets in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p1->GetUid (), "was this the first packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the second packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 6 * modeSize, "There should be six packet in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p2->GetUid (), "Was this the second packet ?");
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove the third packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 5 * modeSize, "There should be five packets in there");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), p3->GetUid (), "Was this the third packet ?");
+
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+  item = queue->Dequeue ();
+
+  item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
+
+
+  // test 2: more data with defaults, unforced drops but no forced drops
+  queue = CreateObject<SelfTuningPiQueueDisc> ();
+  pktSize = 1000;  // pktSize != 0 because DequeueThreshold always works in bytes
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Tupdate", TimeValue (Seconds (0.03))), true,
+                         "Verify that we can actually set the attribute Tupdate");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Supdate", TimeValue (Seconds (0.0))), true,
+                         "Verify that we can actually set the attribute Supdate");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("DequeueThreshold", UintegerValue (10000)), true,
+                         "Verify that we can actually set the attribute DequeueThreshold");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueDelayReference", TimeValue (Seconds (0.02))), true,
+                         "Verify that we can actually set the attribute QueueDelayReference");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("BaseRtt", TimeValue (Seconds (0.1))), true,
+                         "Verify that we can actually set the attribute BaseRtt");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxWindow", UintegerValue (16)), true,
+                         "Verify that we can actually set the attribute MaxWindow");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("CrossoverFactor", DoubleValue (1.0)), true,
+                         "Verify that we can actually set the attribute CrossoverFactor");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 0.01, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  QueueDisc::Stats st = queue->GetStats ();
+  uint32_t test2 = st.GetNDroppedPackets (SelfTuningPiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_NE (test2, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (SelfTuningPiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 3: same as test 2, but with reduced dequeue rate
+  queue = CreateObject<SelfTuningPiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 0.01, 400);
+  DequeueWithDelay (queue, 0.015, 400); // delay between two successive dequeue events is increased
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test3 = st.GetNDroppedPackets (SelfTuningPiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_GT (test3, test2, "Test 3 should have more unforced drops than test 2");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (SelfTuningPiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 4: same as test 2, but the gains are traced and must be updated
+  queue = CreateObject<SelfTuningPiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  queue->TraceConnectWithoutContext ("ProportionalGain",
+                                     MakeCallback (&SelfTuningPiQueueDiscTestCase::GainTrace, this));
+  queue->TraceConnectWithoutContext ("IntegralGain",
+                                     MakeCallback (&SelfTuningPiQueueDiscTestCase::GainTrace, this));
+  m_gainUpdates = 0;
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 0.01, 400);
+  DequeueWithDelay (queue, 0.012, 400);
+  Simulator::Stop (Seconds (8.0));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_GT (m_gainUpdates, 0, "The gains should have been updated");
+
+
+  // test 5: same load as test 2 on a link ten times faster. The queue delay is
+  // kept under control without changing any parameter: the load lasts 40 s
+  // and the queue delay averaged over the last 10 s, once the controller has
+  // converged, must be close to QueueDelayReference (20 ms)
+  queue = CreateObject<SelfTuningPiQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxSize", QueueSizeValue (QueueSize (mode, qSize * 10))),
+                         true, "Verify that we can actually set the attribute MaxSize");
+  queue->Initialize ();
+  EnqueueWithDelay (queue, pktSize, 0.001, 40000);
+  DequeueWithDelay (queue, 0.0012, 33000);
+  m_qDelaySum = 0;
+  m_qDelayCount = 0;
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::Schedule (Seconds (30.0 + 0.05 * i), &SelfTuningPiQueueDiscTestCase::SampleQueueDelay, this, queue);
+    }
+  Simulator::Stop (Seconds (41.0));
+  Simulator::Run ();
+  st = queue->GetStats ();
+  uint32_t test5 = st.GetNDroppedPackets (SelfTuningPiQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_GT (test5, test2, "Test 5 should have more unforced drops than test 2");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_qDelaySum / m_qDelayCount, 0.02, 0.005,
+                             "The queue delay should have converged to QueueDelayReference");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (SelfTuningPiQueueDisc::FORCED_DROP), 0, "There should be zero forced drops");
+
+
+  // test 6: the capacity is measured by the link estimator of the device
+  // rather than from the dequeue rate. 40 packets are queued and never
+  // dequeued; the device drains 8 Mbps for the first queue disc and 2 Mbps
+  // for the second one, hence the second queue disc estimates a larger queue
+  // delay and drops more. The capacity seen by the first queue disc then
+  // drops to 2 Mbps, and its queue delay follows
+  Ptr<SelfTuningPiQueueDisc> fastQueue = CreateObject<SelfTuningPiQueueDisc> ();
+  Ptr<SelfTuningPiQueueDisc> slowQueue = CreateObject<SelfTuningPiQueueDisc> ();
+  Ptr<LinkEstimator> fastEstimator = CreateObject<LinkEstimator> ();
+  Ptr<LinkEstimator> slowEstimator = CreateObject<LinkEstimator> ();
+  fastQueue->SetLinkEstimator (fastEstimator);
+  slowQueue->SetLinkEstimator (slowEstimator);
+  for (auto q : {fastQueue, slowQueue})
+    {
+      q->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (mode, qSize)));
+      q->Initialize ();
+      Simulator::Schedule (Seconds (0.5), &SelfTuningPiQueueDiscTestCase::Enqueue, this, q, 1000, 40);
+    }
+  Transmit (fastEstimator, Seconds (0), MilliSeconds (1), 1500);
+  Transmit (fastEstimator, Seconds (1.5), MilliSeconds (4), 375);
+  Transmit (slowEstimator, Seconds (0), MilliSeconds (4), 750);
+  Simulator::Stop (Seconds (1.45));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (fastEstimator->GetDrainRate (), DataRate ("8Mbps"), "Unexpected drain rate");
+  NS_TEST_EXPECT_MSG_EQ (slowEstimator->GetDrainRate (), DataRate ("2Mbps"), "Unexpected drain rate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fastQueue->GetQueueDelay (), MilliSeconds (40), MicroSeconds (1),
+                             "The queue delay should be computed from the drain rate of the device");
+  NS_TEST_EXPECT_MSG_EQ_TOL (slowQueue->GetQueueDelay (), MilliSeconds (160), MicroSeconds (1),
+                             "The queue delay should be computed from the drain rate of the device");
+  NS_TEST_EXPECT_MSG_GT (slowQueue->GetDropProbability (), fastQueue->GetDropProbability (),
+                         "A slower link should yield a higher drop probability");
+  Simulator::Stop (Seconds (1.55));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (fastQueue->GetQueueDelay (), MilliSeconds (160), MicroSeconds (1),
+                             "The queue delay should follow the drain rate of the device");
+
+
+  // test 7: check the gains against the design rules. The device drains 1000
+  // packets per second, 20 packets are queued and the drop probability is
+  // null, hence C = 1000 pkt/s, R = BaseRtt + 20 ms = 120 ms and the number
+  // of flows is bounded by R C / MaxWindow. The zero of the controller
+  // cancels the TCP pole z = 2N/(R^2 C) and the crossover frequency is z
+  queue = CreateObject<SelfTuningPiQueueDisc> ();
+  Ptr<LinkEstimator> estimator = CreateObject<LinkEstimator> ();
+  queue->SetLinkEstimator (estimator);
+  queue->SetAttribute ("MaxSize", QueueSizeValue (QueueSize (mode, qSize)));
+  queue->TraceConnectWithoutContext ("ProportionalGain", MakeCallback (&SelfTuningPiQueueDiscTestCase::KpTrace, this));
+  queue->TraceConnectWithoutContext ("IntegralGain", MakeCallback (&SelfTuningPiQueueDiscTestCase::KiTrace, this));
+  queue->Initialize ();
+  Transmit (estimator, Seconds (0), MilliSeconds (1), 1000);
+  // the updates occur every 30 ms from now on, the last one at 510 ms
+  Simulator::Schedule (Seconds (0.5), &SelfTuningPiQueueDiscTestCase::Enqueue, this, queue, 1000, 20);
+  Simulator::Stop (Seconds (0.52));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (queue->GetQueueDelay (), MilliSeconds (20), MicroSeconds (1),
+                             "The queue delay should be computed from the drain rate of the device");
+  double c = 1000;
+  double r = 0.12;
+  double n = r * c / 16;
+  double z = 2 * n / (r * r * c);
+  double k = z * std::sqrt (std::pow (z * r, 2) + 1) * std::pow (2 * n, 2) / std::pow (r * c, 3);
+  // the gains are expressed in seconds of queue delay
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_kp, k / z * c, 1e-9, "The proportional gain should be K/z");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_ki, k * 0.03 * c, 1e-9, "The integral gain should be K T");
+}
+
+void
+SelfTuningPiQueueDiscTestCase::Enqueue (Ptr<SelfTuningPiQueueDisc> queue, uint32_t size, uint32_t nPkt)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<SelfTuningPiQueueDiscTestItem> (Create<Packet> (size), dest));
+    }
+}
+
+void
+SelfTuningPiQueueDiscTestCase::EnqueueWithDelay (Ptr<SelfTuningPiQueueDisc> queue, uint32_t size, double delay, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &SelfTuningPiQueueDiscTestCase::Enqueue, this, queue, size, 1);
+    }
+}
+
+void
+SelfTuningPiQueueDiscTestCase::Dequeue (Ptr<SelfTuningPiQueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+    }
+}
+
+void
+SelfTuningPiQueueDiscTestCase::DequeueWithDelay (Ptr<SelfTuningPiQueueDisc> queue, double delay, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (Time (Seconds ((i + 1) * delay)), &SelfTuningPiQueueDiscTestCase::Dequeue, this, queue, 1);
+    }
+}
+
+void
+SelfTuningPiQueueDiscTestCase::Transmit (Ptr<LinkEstimator> estimator, Time start, Time interval, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Simulator::Schedule (start + interval * i, &LinkEstimator::NotifyTransmittedBytes, estimator, 1000, true);
+    }
+}
+
+void
+SelfTuningPiQueueDiscTestCase::DoRun (void)
+{
+  RunSelfTuningPiTest (QueueSizeUnit::PACKETS);
+  RunSelfTuningPiTest (QueueSizeUnit::BYTES);
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Self-Tuning PI Queue Disc Test Suite
+ */
+static class SelfTuningPiQueueDiscTestSuite : public TestSuite
+{
+public:
+  SelfTuningPiQueueDiscTestSuite ()
+    : TestSuite ("self-tuning-pi-queue-disc", UNIT)
+  {
+    AddTestCase (new SelfTuningPiQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_selfTuningPiQueueTestSuite; ///< the test suite
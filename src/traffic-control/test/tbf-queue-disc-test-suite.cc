@@ -33,6 +33,8 @@
 #include "ns3/simple-channel.h"
 #include "ns3/traffic-control-layer.h"
 #include "ns3/config.h"
+#include "ns3/object-factory.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -432,6 +434,98 @@ TbfQueueDiscTestCase::DoRun (void)
 
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Tbf Queue Disc Watchdog Test Case
+ *
+ * A TBF with no peak rate (hence with a single bucket) is installed on a
+ * device and a burst of packets is sent. The first packet is dequeued at
+ * once and the watchdog must then wake the queue disc up as soon as the
+ * bucket holds enough tokens for the next packet.
+ */
+class TbfQueueDiscWatchdogTestCase : public TestCase
+{
+public:
+  TbfQueueDiscWatchdogTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Send a packet through the traffic control layer
+   * \param tc the traffic control layer
+   * \param device the device
+   */
+  void Send (Ptr<TrafficControlLayer> tc, Ptr<NetDevice> device);
+  /**
+   * Record the time a packet is dequeued
+   * \param item the dequeued item
+   */
+  void Dequeue (Ptr<const QueueDiscItem> item);
+
+  std::vector<Time> m_dequeued; //!< the times the packets are dequeued
+};
+
+TbfQueueDiscWatchdogTestCase::TbfQueueDiscWatchdogTestCase ()
+  : TestCase ("Check the wake up time of TBF without peak rate")
+{
+}
+
+void
+TbfQueueDiscWatchdogTestCase::Send (Ptr<TrafficControlLayer> tc, Ptr<NetDevice> device)
+{
+  tc->Send (device, Create<TbfQueueDiscTestItem> (Create<Packet> (1000), device->GetAddress ()));
+}
+
+void
+TbfQueueDiscWatchdogTestCase::Dequeue (Ptr<const QueueDiscItem> item)
+{
+  m_dequeued.push_back (Simulator::Now ());
+}
+
+void
+TbfQueueDiscWatchdogTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  nodes.Get (0)->AddDevice (txDev);
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  nodes.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+  txDev->SetNode (nodes.Get (0));
+  rxDev->SetNode (nodes.Get (1));
+
+  // one packet of 1000 bytes every 100 ms
+  Ptr<TbfQueueDisc> queue = CreateObjectWithAttributes<TbfQueueDisc> ("Rate", DataRateValue (DataRate ("80kbps")),
+                                                                     "Burst", UintegerValue (1000),
+                                                                     "Mtu", UintegerValue (0),
+                                                                     "PeakRate", DataRateValue (DataRate ("0bps")),
+                                                                     "Quota", UintegerValue (64));
+  queue->TraceConnectWithoutContext ("Dequeue", MakeCallback (&TbfQueueDiscWatchdogTestCase::Dequeue, this));
+
+  Ptr<TrafficControlLayer> tc = CreateObject<TrafficControlLayer> ();
+  nodes.Get (0)->AggregateObject (tc);
+  tc->SetRootQueueDiscOnDevice (txDev, queue);
+  tc->Initialize ();
+
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Simulator::Schedule (Seconds (0.1), &TbfQueueDiscWatchdogTestCase::Send, this, tc, txDev);
+    }
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_dequeued.size (), 4, "All the packets should be dequeued");
+  for (uint32_t i = 0; i < m_dequeued.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_dequeued[i], Seconds (0.1) + MilliSeconds (100) * i,
+                             "Unexpected dequeue time of packet " << i);
+    }
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -445,5 +539,6 @@ public:
     : TestSuite ("tbf-queue-disc", UNIT)
   {
     AddTestCase (new TbfQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new TbfQueueDiscWatchdogTestCase (), TestCase::QUICK);
   }
 } g_tbfQueueTestSuite; ///< the test suite
@@ -21,6 +21,7 @@
 
 #include "ns3/test.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
@@ -102,8 +103,9 @@ public:
    * Constructor
    *
    * \param tt the test type
+   * \param bulk whether the queue disc sends packets to the device in batches
    */
-  TcFlowControlTestCase (QueueSizeUnit tt);
+  TcFlowControlTestCase (QueueSizeUnit tt, bool bulk);
   virtual ~TcFlowControlTestCase ();
 private:
   virtual void DoRun (void);
@@ -135,11 +137,14 @@ private:
    */
   void CheckPacketsInQueueDisc (Ptr<NetDevice> dev, uint16_t nPackets, const char* msg);
   QueueSizeUnit m_type;       //!< the test type
+  bool m_bulk;                //!< whether bulk dequeue is enabled
 };
 
-TcFlowControlTestCase::TcFlowControlTestCase (QueueSizeUnit tt)
-  : TestCase ("Test the operation of the flow control mechanism"),
-    m_type (tt)
+TcFlowControlTestCase::TcFlowControlTestCase (QueueSizeUnit tt, bool bulk)
+  : TestCase (std::string ("Test the operation of the flow control mechanism")
+              + (bulk ? " with bulk dequeue" : "")),
+    m_type (tt),
+    m_bulk (bulk)
 {
 }
 
@@ -205,7 +210,8 @@ TcFlowControlTestCase::DoRun (void)
   txDev->SetMtu (2500);
 
   TrafficControlHelper tch = TrafficControlHelper::Default ();
-  tch.Install (txDev);
+  QueueDiscContainer qdiscs = tch.Install (txDev);
+  qdiscs.Get (0)->SetAttribute ("BulkDequeue", BooleanValue (m_bulk));
 
   // transmit 10 packets at time 0
   Simulator::Schedule (Time (Seconds (0)), &TcFlowControlTestCase::SendPackets,
@@ -374,7 +380,9 @@ public:
   TcFlowControlTestSuite ()
     : TestSuite ("tc-flow-control", UNIT)
   {
-    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS), TestCase::QUICK);
-    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS, false), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES, false), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS, true), TestCase::QUICK);
+    AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES, true), TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/token-bucket-policer.h"
+#include "ns3/queue-disc.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/data-rate.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Ingress Test Case
+ *
+ * Packets are passed to the Receive method of the traffic control layer of a
+ * node and the packets passed to the upper layer handler are recorded.
+ */
+class TcIngressTestCase : public TestCase
+{
+public:
+  TcIngressTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Pass packets to the traffic control layer as if received by a device
+   * \param dev the device
+   * \param nPackets the number of packets
+   */
+  void ReceivePackets (Ptr<NetDevice> dev, uint16_t nPackets);
+  /**
+   * Upper layer handler recording the time the packets are received
+   * \param device network device
+   * \param p the packet
+   * \param protocol next header value
+   * \param from address of the correspondent
+   * \param to address of the destination
+   * \param packetType type of the packet
+   */
+  void Handler (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType packetType);
+  /**
+   * Count the packets dropped by the policer
+   * \param p the dropped packet
+   */
+  void PolicerDrop (Ptr<const Packet> p);
+  /**
+   * Create a node with a device and register the upper layer handler
+   * \return the device
+   */
+  Ptr<NetDevice> Setup (void);
+  /**
+   * Check that the packets exceeding the rate of the policer are dropped
+   */
+  void RunPolicerTest (void);
+  /**
+   * Check that the packets are passed to the upper layer at the rate of an
+   * ingress TBF queue disc
+   */
+  void RunQueueDiscTest (void);
+
+  std::vector<Time> m_received;  //!< Time each packet was passed to the upper layer
+  uint32_t m_policerDrops;       //!< Number of packets dropped by the policer
+};
+
+TcIngressTestCase::TcIngressTestCase ()
+  : TestCase ("Test the policer and the queue disc on the ingress of a device")
+{
+}
+
+void
+TcIngressTestCase::ReceivePackets (Ptr<NetDevice> dev, uint16_t nPackets)
+{
+  Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+  for (uint16_t i = 0; i < nPackets; i++)
+    {
+      tc->Receive (dev, Create<Packet> (1000), 0x0800, Address (), dev->GetAddress (), NetDevice::PACKET_HOST);
+    }
+}
+
+void
+TcIngressTestCase::Handler (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                            const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x0800, "Unexpected protocol");
+  NS_TEST_EXPECT_MSG_EQ (to, device->GetAddress (), "Unexpected destination address");
+  m_received.push_back (Simulator::Now ());
+}
+
+void
+TcIngressTestCase::PolicerDrop (Ptr<const Packet> p)
+{
+  m_policerDrops++;
+}
+
+Ptr<NetDevice>
+TcIngressTestCase::Setup (void)
+{
+  NodeContainer n;
+  n.Create (1);
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  SimpleNetDeviceHelper simple;
+  Ptr<NetDevice> dev = simple.Install (n.Get (0)).Get (0);
+
+  Ptr<TrafficControlLayer> tc = n.Get (0)->GetObject<TrafficControlLayer> ();
+  tc->RegisterProtocolHandler (MakeCallback (&TcIngressTestCase::Handler, this), 0x0800, dev);
+
+  m_received.clear ();
+  m_policerDrops = 0;
+  return dev;
+}
+
+void
+TcIngressTestCase::RunPolicerTest (void)
+{
+  Ptr<NetDevice> dev = Setup ();
+  Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+
+  // the bucket holds three packets and is filled with one packet per second
+  Ptr<TokenBucketPolicer> policer = CreateObject<TokenBucketPolicer> ();
+  policer->SetAttribute ("Rate", DataRateValue (DataRate ("8kbps")));
+  policer->SetAttribute ("Burst", UintegerValue (3000));
+  policer->TraceConnectWithoutContext ("Drop", MakeCallback (&TcIngressTestCase::PolicerDrop, this));
+  tc->SetIngressPolicerOnDevice (dev, policer);
+  NS_TEST_EXPECT_MSG_EQ (tc->GetIngressPolicerOnDevice (dev), policer, "The policer is not installed");
+  NS_TEST_EXPECT_MSG_EQ (tc->GetIngressQueueDiscOnDevice (dev), 0, "No ingress queue disc is installed");
+
+  Simulator::Schedule (Seconds (0.1), &TcIngressTestCase::ReceivePackets, this, dev, 5);
+  Simulator::Schedule (Seconds (1.6), &TcIngressTestCase::ReceivePackets, this, dev, 3);
+  // the policer is removed, hence all the packets are received
+  Simulator::Schedule (Seconds (2), &TrafficControlLayer::SetIngressPolicerOnDevice, tc, dev, Ptr<TokenBucketPolicer> ());
+  Simulator::Schedule (Seconds (2.1), &TcIngressTestCase::ReceivePackets, this, dev, 5);
+  Simulator::Run ();
+
+  // 3 packets conform at 0.1s, then 1.5 packets are accumulated by 1.6s
+  NS_TEST_EXPECT_MSG_EQ (m_received.size (), 3 + 1 + 5, "Unexpected number of packets received");
+  NS_TEST_EXPECT_MSG_EQ (m_policerDrops, 2 + 2, "Unexpected number of packets dropped by the policer");
+  // 500 tokens are left at 1.6s and 500 tokens are accumulated by 2.1s
+  NS_TEST_EXPECT_MSG_EQ (policer->GetTokens (), 1000, "Unexpected number of tokens");
+  NS_TEST_EXPECT_MSG_EQ (tc->GetIngressPolicerOnDevice (dev), 0, "The policer is not removed");
+
+  Simulator::Destroy ();
+}
+
+void
+TcIngressTestCase::RunQueueDiscTest (void)
+{
+  Ptr<NetDevice> dev = Setup ();
+  Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+
+  // shape the received traffic to one packet every 100 ms
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::TbfQueueDisc",
+                        "Rate", DataRateValue (DataRate ("80kbps")),
+                        "Burst", UintegerValue (1000),
+                        "MaxSize", StringValue ("4p"));
+  QueueDiscContainer qdiscs = tch.InstallIngress (dev);
+  NS_TEST_EXPECT_MSG_EQ (tc->GetIngressQueueDiscOnDevice (dev), qdiscs.Get (0), "The queue disc is not installed");
+  NS_TEST_EXPECT_MSG_EQ (tc->GetRootQueueDiscOnDevice (dev), 0, "The egress of the device has no queue disc");
+
+  Simulator::Schedule (Seconds (0.1), &TcIngressTestCase::ReceivePackets, this, dev, 6);
+  Simulator::Run ();
+
+  // the first packet is dequeued at once, the following four are spaced by
+  // 100 ms and the last one is dropped because the queue disc is full
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 5, "Unexpected number of packets received");
+  for (uint32_t i = 0; i < m_received.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], Seconds (0.1) + MilliSeconds (100) * i,
+                             "Unexpected reception time of packet " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (qdiscs.Get (0)->GetStats ().nTotalDroppedPackets, 1,
+                         "The packet exceeding the limit should be dropped");
+
+  tch.UninstallIngress (dev);
+  NS_TEST_EXPECT_MSG_EQ (tc->GetIngressQueueDiscOnDevice (dev), 0, "The queue disc is not removed");
+
+  Simulator::Destroy ();
+}
+
+void
+TcIngressTestCase::DoRun (void)
+{
+  RunPolicerTest ();
+  RunQueueDiscTest ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Ingress Test Suite
+ */
+static class TcIngressTestSuite : public TestSuite
+{
+public:
+  TcIngressTestSuite ()
+    : TestSuite ("tc-ingress", UNIT)
+  {
+    AddTestCase (new TcIngressTestCase (), TestCase::QUICK);
+  }
+} g_tcIngressTestSuite; ///< the test suite
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/queue-disc.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/mac48-address.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue disc item used to pass packets to the traffic control layer
+ */
+class TcSendTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param p the packet
+   * \param addr the destination address
+   */
+  TcSendTestItem (Ptr<Packet> p, const Address & addr);
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+};
+
+TcSendTestItem::TcSendTestItem (Ptr<Packet> p, const Address & addr)
+  : QueueDiscItem (p, addr, 0x800)
+{
+}
+
+void
+TcSendTestItem::AddHeader (void)
+{
+}
+
+bool
+TcSendTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Send Test Case
+ *
+ * A node has three devices, the last two of which have a root queue disc.
+ * Packets are passed to the Send method of the traffic control layer along
+ * with the interface index of a device and the items enqueued in each root
+ * queue disc are recorded.
+ */
+class TcSendTestCase : public TestCase
+{
+public:
+  TcSendTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Pass packets to the traffic control layer for transmission
+   * \param tc the traffic control layer
+   * \param ifIndex the interface index of the device
+   * \param nPackets the number of packets
+   */
+  void SendPackets (Ptr<TrafficControlLayer> tc, uint32_t ifIndex, uint16_t nPackets);
+  /**
+   * Record an item enqueued in a root queue disc
+   * \param context the interface index of the device of the queue disc
+   * \param item the item
+   */
+  void Enqueue (std::string context, Ptr<const QueueDiscItem> item);
+
+  std::vector<Ptr<const QueueDiscItem> > m_sent[3];      //!< Items sent through each device
+  std::vector<Ptr<const QueueDiscItem> > m_enqueued[3];  //!< Items enqueued in the root queue disc of each device
+};
+
+TcSendTestCase::TcSendTestCase ()
+  : TestCase ("Sending packets by interface index reaches the root queue disc of the device")
+{
+}
+
+void
+TcSendTestCase::SendPackets (Ptr<TrafficControlLayer> tc, uint32_t ifIndex, uint16_t nPackets)
+{
+  for (uint16_t i = 0; i < nPackets; i++)
+    {
+      Ptr<QueueDiscItem> item = Create<TcSendTestItem> (Create<Packet> (1000), Mac48Address::GetBroadcast ());
+      m_sent[ifIndex].push_back (item);
+      tc->Send (ifIndex, item);
+    }
+}
+
+void
+TcSendTestCase::Enqueue (std::string context, Ptr<const QueueDiscItem> item)
+{
+  m_enqueued[std::stoul (context)].push_back (item);
+}
+
+void
+TcSendTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (1);
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      devices.Add (simple.Install (n.Get (0)));
+    }
+
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::FifoQueueDisc");
+  QueueDiscContainer qdiscs = tch.Install (NetDeviceContainer (devices.Get (1), devices.Get (2)));
+  for (uint32_t i = 0; i < qdiscs.GetN (); i++)
+    {
+      qdiscs.Get (i)->TraceConnect ("Enqueue", std::to_string (devices.Get (i + 1)->GetIfIndex ()),
+                                    MakeCallback (&TcSendTestCase::Enqueue, this));
+    }
+
+  Ptr<TrafficControlLayer> tc = n.Get (0)->GetObject<TrafficControlLayer> ();
+  Simulator::Schedule (Seconds (0.1), &TcSendTestCase::SendPackets, this, tc, 2, 3);
+  Simulator::Schedule (Seconds (0.2), &TcSendTestCase::SendPackets, this, tc, 1, 2);
+  Simulator::Schedule (Seconds (0.3), &TcSendTestCase::SendPackets, this, tc, 0, 4);
+  Simulator::Schedule (Seconds (0.4), &TcSendTestCase::SendPackets, this, tc, 2, 1);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[0].size (), 0, "The device without queue disc should have no item enqueued");
+  for (uint32_t i = 1; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_enqueued[i].size (), m_sent[i].size (),
+                             "Unexpected number of items enqueued in the queue disc of device " << i);
+      for (uint32_t j = 0; j < m_sent[i].size (); j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (m_enqueued[i][j], m_sent[i][j],
+                                 "Item " << j << " sent through device " << i << " reached the wrong queue disc");
+        }
+      NS_TEST_EXPECT_MSG_EQ (qdiscs.Get (i - 1)->GetStats ().nTotalReceivedPackets, m_sent[i].size (),
+                             "Unexpected number of packets received by the queue disc of device " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[1].size (), 2, "Two items should have been sent through device 1");
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[2].size (), 4, "Four items should have been sent through device 2");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Send Test Suite
+ */
+static class TcSendTestSuite : public TestSuite
+{
+public:
+  TcSendTestSuite ()
+    : TestSuite ("tc-send", UNIT)
+  {
+    AddTestCase (new TcSendTestCase (), TestCase::QUICK);
+  }
+} g_tcSendTestSuite; ///< the test suite
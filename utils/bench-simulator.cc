@@ -146,12 +146,33 @@ Bench::Cb (void)
 
 
 Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+GetRandomStream (std::string filename, std::string dist)
 {
   Ptr<RandomVariableStream> stream = 0;
 
-  if (filename == "")
+  if (filename == "" && dist == "skewed")
     {
+      LOGME ("using skewed (Pareto) distribution");
+      // heavy tailed, with mean 3 * Scale = 100
+      Ptr<ParetoRandomVariable> prv = CreateObject<ParetoRandomVariable> ();
+      prv->SetAttribute ("Scale", DoubleValue (100.0 / 3));
+      prv->SetAttribute ("Shape", DoubleValue (1.5));
+      stream = prv;
+    }
+  else if (filename == "" && dist == "bimodal")
+    {
+      LOGME ("using bimodal distribution");
+      // 90% of the intervals in [0, 20] ns, 10% in [500, 1300] ns: mean 99 ns
+      Ptr<EmpiricalRandomVariable> erv = CreateObject<EmpiricalRandomVariable> ();
+      erv->CDF (0, 0);
+      erv->CDF (20, 0.9);
+      erv->CDF (500, 0.9);
+      erv->CDF (1300, 1);
+      stream = erv;
+    }
+  else if (filename == "")
+    {
+      NS_ABORT_MSG_UNLESS (dist == "exp", "Unknown distribution " << dist);
       LOGME ("using default exponential distribution");
       Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
       erv->SetAttribute ("Mean", DoubleValue (100));
@@ -207,17 +228,23 @@ int main (int argc, char *argv[])
   bool schedHeap = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedLadder = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string dist = "exp";
 
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
              "\n"
              "Event intervals are taken from one of:\n"
-             "  an exponential distribution, with mean 100 ns,\n"
+             "  an exponential distribution, with mean 100 ns (--dist=exp),\n"
+             "  a skewed Pareto distribution, with mean 100 ns and shape 1.5\n"
+             "    (--dist=skewed),\n"
+             "  a bimodal distribution, with 90% of the intervals uniform\n"
+             "    in [0, 20] ns and 10% in [500, 1300] ns (--dist=bimodal),\n"
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
@@ -226,11 +253,13 @@ int main (int argc, char *argv[])
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("dist",  "distribution of the event times: exp, skewed or bimodal", dist);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
@@ -249,6 +278,10 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::ListScheduler");
     }
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
   Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));
@@ -260,7 +293,7 @@ int main (int argc, char *argv[])
   LOGME ("runs: " << runs);
 
   Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetRandomStream (GetRandomStream (filename, dist));
 
   // table header
   LOG ("");